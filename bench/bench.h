@@ -0,0 +1,167 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <e3dmath/simd/cpu.h>
+#include <e3dmath/utils/parallel.h>
+
+/**
+ * A small benchmark harness. Each benchmark is a function that processes `items` things
+ * (matrices, vectors, ...) per call; the harness warms it up, picks how many calls make a
+ * sample long enough to time, then takes a number of samples and reports nanoseconds per
+ * item.
+ *
+ * Command-line options:
+ *
+ *  - `--filter <text>` only runs benchmarks whose name contains the text
+ *  - `--reps <n>` takes n samples per benchmark (default 15)
+ *  - `--sample-ms <ms>` the target length of each sample (default 5)
+ *  - `--json <path>` also writes the results as JSON, for comparing runs
+ */
+namespace e3d::bench {
+
+    /**
+     * Keeps the compiler from optimizing away a value that's never used
+     */
+    template<class T>
+    inline void keep(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "g"(&value) : "memory");
+#else
+        static volatile const void* sink;
+        sink = &value;
+#endif
+    }
+
+    /**
+     * The timings of one benchmark, in nanoseconds per item
+     */
+    struct Result {
+        std::string name;
+        size_t items;
+        size_t calls_per_sample;
+        size_t reps;
+        double min;
+        double median;
+        double mean;
+        double stddev;
+    };
+
+    class Suite {
+    public:
+
+        Suite(int argc, char** argv) {
+            for (int i = 1; i < argc; i++) {
+                std::string arg = argv[i];
+                bool has_value = i + 1 < argc;
+                if (arg == "--filter" && has_value) this->filter = argv[++i];
+                else if (arg == "--reps" && has_value) this->reps = std::max(1, std::atoi(argv[++i]));
+                else if (arg == "--sample-ms" && has_value) this->sample_ms = std::max(0.01, std::atof(argv[++i]));
+                else if (arg == "--json" && has_value) this->json_path = argv[++i];
+                else std::fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            }
+            std::printf("SIMD level: %s, threads: %zu\n\n", simd::level_name(simd::level()), utils::parallel::thread_count());
+            std::printf("%-44s %10s %12s %12s %12s %10s\n", "benchmark", "items", "min ns", "median ns", "mean ns", "stddev");
+        }
+
+        /**
+         * Times `fn`, which processes `items` things per call
+         */
+        template<class Fn>
+        void run(const std::string& name, size_t items, Fn&& fn) {
+            using clock = std::chrono::steady_clock;
+            if (!this->filter.empty() && name.find(this->filter) == std::string::npos) return;
+
+            // Warm up caches and branch predictors, and measure roughly how long a call takes
+            auto start = clock::now();
+            size_t warmup_calls = 0;
+            double elapsed = 0;
+            do {
+                fn();
+                warmup_calls++;
+                elapsed = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+            } while (elapsed < this->sample_ms && warmup_calls < 1000000);
+
+            // Make each sample about `sample_ms` long
+            size_t calls = std::max<size_t>(1, size_t(double(warmup_calls) * this->sample_ms / std::max(elapsed, 1e-6)));
+
+            // Take the samples
+            std::vector<double> samples(this->reps);
+            for (size_t rep = 0; rep < samples.size(); rep++) {
+                auto sample_start = clock::now();
+                for (size_t call = 0; call < calls; call++) fn();
+                double ns = std::chrono::duration<double, std::nano>(clock::now() - sample_start).count();
+                samples[rep] = ns / double(calls * items);
+            }
+
+            // Summarize them
+            Result result;
+            result.name = name;
+            result.items = items;
+            result.calls_per_sample = calls;
+            result.reps = samples.size();
+            std::sort(samples.begin(), samples.end());
+            result.min = samples.front();
+            result.median = samples.size() % 2 == 1
+                ? samples[samples.size() / 2]
+                : (samples[samples.size() / 2 - 1] + samples[samples.size() / 2]) / 2;
+            result.mean = 0;
+            for (double sample : samples) result.mean += sample;
+            result.mean /= double(samples.size());
+            result.stddev = 0;
+            for (double sample : samples) result.stddev += (sample - result.mean) * (sample - result.mean);
+            result.stddev = std::sqrt(result.stddev / double(samples.size()));
+
+            // Print the line, with the spread relative to the mean
+            std::printf("%-44s %10zu %12.3f %12.3f %12.3f %9.1f%%\n", name.c_str(), items, result.min, result.median, result.mean,
+                result.mean > 0 ? 100 * result.stddev / result.mean : 0.0);
+            std::fflush(stdout);
+            this->results.push_back(result);
+        }
+
+        /**
+         * Writes the JSON file, if one was asked for, and returns the exit code
+         */
+        int finish() const {
+            if (this->json_path.empty()) return 0;
+
+            // Open the file
+            FILE* file = std::fopen(this->json_path.c_str(), "w");
+            if (file == nullptr) {
+                std::fprintf(stderr, "Couldn't write %s\n", this->json_path.c_str());
+                return 1;
+            }
+
+            // Write the context, then one object per benchmark. Names are plain identifiers,
+            // so they need no escaping.
+            std::fprintf(file, "{\n  \"simd_level\": \"%s\",\n  \"threads\": %zu,\n  \"unit\": \"ns_per_item\",\n  \"benchmarks\": [\n",
+                simd::level_name(simd::level()), utils::parallel::thread_count());
+            for (size_t i = 0; i < this->results.size(); i++) {
+                const Result& r = this->results[i];
+                std::fprintf(file,
+                    "    { \"name\": \"%s\", \"items\": %zu, \"calls_per_sample\": %zu, \"reps\": %zu, "
+                    "\"min\": %.4f, \"median\": %.4f, \"mean\": %.4f, \"stddev\": %.4f }%s\n",
+                    r.name.c_str(), r.items, r.calls_per_sample, r.reps, r.min, r.median, r.mean, r.stddev,
+                    i + 1 < this->results.size() ? "," : "");
+            }
+            std::fprintf(file, "  ]\n}\n");
+            std::fclose(file);
+            std::printf("\nWrote %s\n", this->json_path.c_str());
+            return 0;
+        }
+
+    private:
+        std::string filter;
+        std::string json_path;
+        size_t reps = 15;
+        double sample_ms = 5;
+        std::vector<Result> results;
+    };
+
+}
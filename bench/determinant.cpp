@@ -0,0 +1,90 @@
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include <e3dmath/e3dmath.h>
+
+using namespace e3d;
+
+/**
+ * The recursive cofactor expansion that `utils::mat::determinant` used to run, kept here as
+ * the baseline. The submatrix lives in a fixed-size array instead of a VLA, so it builds as
+ * standard C++.
+ */
+static float cofactor_det(const float* data, uint8_t size) {
+
+    // Handle the trivial sizes
+    if (size == 0) return 0;
+    if (size == 1) return data[0];
+
+    // Expand along the first row
+    float sum = 0;
+    float subdata[256];
+    for (uint8_t cursor_c = 0; cursor_c < size; cursor_c++) {
+        for (uint8_t c = 0; c < size; c++) {
+            if (c == cursor_c) continue;
+            uint8_t sub_c = c < cursor_c ? c : (c - 1);
+            for (uint8_t r = 0; r < size - 1; r++) subdata[r * (size - 1) + sub_c] = data[(r + 1) * size + c];
+        }
+        float partial = data[cursor_c] * cofactor_det(subdata, size - 1);
+        sum += (cursor_c % 2 == 0) ? partial : -partial;
+    }
+    return sum;
+
+}
+
+/**
+ * Runs `fn` over every matrix until `min_seconds` have passed, and returns nanoseconds per call
+ */
+template<class Fn>
+static double time_per_call(size_t count, Fn&& fn) {
+    using clock = std::chrono::steady_clock;
+    const double min_seconds = 0.2;
+    size_t calls = 0;
+    auto start = clock::now();
+    double elapsed = 0;
+    do {
+        for (size_t i = 0; i < count; i++) fn(i);
+        calls += count;
+        elapsed = std::chrono::duration<double>(clock::now() - start).count();
+    } while (elapsed < min_seconds);
+    return elapsed * 1e9 / double(calls);
+}
+
+template<uint8_t N>
+static void run(size_t count) {
+
+    // Random, well-conditioned matrices and right-hand sides
+    std::mt19937 rng(N);
+    std::uniform_real_distribution<float> dist(-1, 1);
+    std::vector<Mat<N, N>> mats(count);
+    std::vector<Vec<N>> rhs(count);
+    for (size_t i = 0; i < count; i++) {
+        for (int j = 0; j < N * N; j++) mats[i].data[j] = dist(rng) + (j % (N + 1) == 0 ? N : 0);
+        for (int j = 0; j < N; j++) rhs[i].data[j] = dist(rng);
+    }
+
+    // Results are summed so the work can't be optimized away
+    volatile float sink = 0;
+    double cofactor = time_per_call(count, [&](size_t i) { sink = sink + cofactor_det(mats[i].data, N); });
+    double det = time_per_call(count, [&](size_t i) { sink = sink + utils::mat::determinant(mats[i]); });
+    double inv = time_per_call(count, [&](size_t i) { sink = sink + utils::mat::inverse(mats[i]).data[0]; });
+    double solve = time_per_call(count, [&](size_t i) { sink = sink + utils::mat::solve(mats[i], rhs[i]).data[0]; });
+
+    std::printf("%2dx%-2d %14.1f %12.1f %9.1fx %12.1f %12.1f\n", N, N, cofactor, det, cofactor / det, inv, solve);
+
+}
+
+int main() {
+
+    std::printf("ns per call\n");
+    std::printf("%-5s %14s %12s %10s %12s %12s\n", "size", "cofactor det", "determinant", "speedup", "inverse", "solve");
+    run<2>(4096);
+    run<3>(4096);
+    run<4>(4096);
+    run<5>(1024);
+    run<6>(256);
+    run<8>(16);
+    return 0;
+
+}
@@ -0,0 +1,976 @@
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+#include <e3dmath/e3dmath.h>
+#include "bench.h"
+
+using namespace e3d;
+
+/**
+ * The number of objects each single-object benchmark cycles through, which keeps the working
+ * set in L1/L2 like a typical per-frame loop
+ */
+static const size_t batch = 1024;
+
+/**
+ * The number of vectors in the large batch benchmarks
+ */
+static const size_t large_batch = 1 << 20;
+
+static std::mt19937 rng(1234);
+
+static float random_float(float low = -1, float high = 1) {
+    return std::uniform_real_distribution<float>(low, high)(rng);
+}
+
+template<uint8_t R, uint8_t C>
+static std::vector<Mat<R, C>> random_mats(size_t count) {
+    std::vector<Mat<R, C>> mats(count);
+    for (Mat<R, C>& mat : mats) {
+        for (int i = 0; i < R * C; i++) mat.data[i] = random_float();
+    }
+    return mats;
+}
+
+/**
+ * Random square matrices with a heavy diagonal, so they are well conditioned
+ */
+template<uint8_t R>
+static std::vector<Mat<R, R>> random_invertible(size_t count) {
+    std::vector<Mat<R, R>> mats = random_mats<R, R>(count);
+    for (Mat<R, R>& mat : mats) {
+        for (int i = 0; i < R; i++) mat.data[i * R + i] += R;
+    }
+    return mats;
+}
+
+static std::vector<Quat> random_quats(size_t count) {
+    std::vector<Quat> quats(count);
+    for (Quat& quat : quats) quat = utils::quat::normalize(Quat(random_float(), random_float(), random_float(), random_float()));
+    return quats;
+}
+
+template<uint8_t P>
+static std::vector<Polygon<P, 3>> random_polygons(size_t count, bool planar) {
+    std::vector<Polygon<P, 3>> polys(count);
+    for (Polygon<P, 3>& poly : polys) {
+        for (int i = 0; i < P; i++) {
+            float angle = float(i) * 2 * float(M_PI) / P;
+            const float values[3] = { std::cos(angle), std::sin(angle), planar ? 0 : random_float() * 0.1f };
+            poly.points[i] = Point3(values);
+        }
+    }
+    return polys;
+}
+
+/**
+ * Benchmarks `out[i] = a[i] * b[i]` for one shape of matrix product
+ */
+template<uint8_t R, uint8_t K, uint8_t C>
+static void bench_multiply(bench::Suite& suite) {
+    std::vector<Mat<R, K>> a = random_mats<R, K>(batch);
+    std::vector<Mat<K, C>> b = random_mats<K, C>(batch);
+    std::vector<Mat<R, C>> out(batch);
+    std::string name = "mat/multiply/" + std::to_string(R) + "x" + std::to_string(K) + "*" + std::to_string(K) + "x" + std::to_string(C);
+    suite.run(name, batch, [&]() {
+        for (size_t i = 0; i < batch; i++) out[i] = a[i] * b[i];
+        bench::keep(out);
+    });
+}
+
+template<uint8_t R>
+static void bench_square(bench::Suite& suite) {
+    std::string size = std::to_string(R) + "x" + std::to_string(R);
+    std::vector<Mat<R, R>> mats = random_invertible<R>(batch);
+    std::vector<Mat<R, 1>> rhs = random_mats<R, 1>(batch);
+    std::vector<Mat<R, R>> out(batch);
+    std::vector<Mat<R, 1>> solutions(batch);
+    float sum = 0;
+
+    suite.run("mat/determinant/" + size, batch, [&]() {
+        for (size_t i = 0; i < batch; i++) sum += utils::mat::determinant(mats[i]);
+        bench::keep(sum);
+    });
+    suite.run("mat/inverse/" + size, batch, [&]() {
+        for (size_t i = 0; i < batch; i++) out[i] = utils::mat::inverse(mats[i]);
+        bench::keep(out);
+    });
+    suite.run("mat/solve/" + size, batch, [&]() {
+        for (size_t i = 0; i < batch; i++) solutions[i] = utils::mat::solve(mats[i], rhs[i]);
+        bench::keep(solutions);
+    });
+    suite.run("mat/transpose/" + size, batch, [&]() {
+        for (size_t i = 0; i < batch; i++) out[i] = mats[i].transpose();
+        bench::keep(out);
+    });
+}
+
+static void bench_mat(bench::Suite& suite) {
+
+    // Products of every square size, vectors, and a non-square shape
+    bench_multiply<2, 2, 2>(suite);
+    bench_multiply<3, 3, 3>(suite);
+    bench_multiply<4, 4, 4>(suite);
+    bench_multiply<2, 2, 1>(suite);
+    bench_multiply<3, 3, 1>(suite);
+    bench_multiply<4, 4, 1>(suite);
+    bench_multiply<2, 3, 4>(suite);
+
+    // Square matrix operations
+    bench_square<2>(suite);
+    bench_square<3>(suite);
+    bench_square<4>(suite);
+    bench_square<6>(suite);
+
+    // Element-wise arithmetic
+    std::vector<Mat4> a = random_mats<4, 4>(batch), b = random_mats<4, 4>(batch), out(batch);
+    suite.run("mat/add/4x4", batch, [&]() {
+        for (size_t i = 0; i < batch; i++) out[i] = a[i] + b[i];
+        bench::keep(out);
+    });
+    suite.run("mat/subtract/4x4", batch, [&]() {
+        for (size_t i = 0; i < batch; i++) out[i] = a[i] - b[i];
+        bench::keep(out);
+    });
+    suite.run("mat/scale/4x4", batch, [&]() {
+        for (size_t i = 0; i < batch; i++) out[i] = a[i] * 2.5f;
+        bench::keep(out);
+    });
+    suite.run("mat/divide_scalar/4x4", batch, [&]() {
+        for (size_t i = 0; i < batch; i++) out[i] = a[i] / 2.5f;
+        bench::keep(out);
+    });
+    suite.run("mat/fused_expression/4x4", batch, [&]() {
+        for (size_t i = 0; i < batch; i++) out[i] = a[i] * 0.25f + b[i] * 0.75f - a[i];
+        bench::keep(out);
+    });
+
+    // Transform builders
+    std::vector<float> angles(batch);
+    for (float& angle : angles) angle = random_float(-3, 3);
+    suite.run("mat/mat4_create_translation", batch, [&]() {
+        for (size_t i = 0; i < batch; i++) out[i] = utils::mat::mat4_create_translation(angles[i], 1, 2);
+        bench::keep(out);
+    });
+    suite.run("mat/mat4_create_rotation_x", batch, [&]() {
+        for (size_t i = 0; i < batch; i++) out[i] = utils::mat::mat4_create_rotation_x(angles[i]);
+        bench::keep(out);
+    });
+    suite.run("mat/mat4_create_rotation_yxz", batch, [&]() {
+        for (size_t i = 0; i < batch; i++) out[i] = utils::mat::mat4_create_rotation_yxz(angles[i], 0.5f, angles[batch - 1 - i]);
+        bench::keep(out);
+    });
+    suite.run("mat/mat4_create_rotation_yxz/fast", batch, [&]() {
+        for (size_t i = 0; i < batch; i++) out[i] = utils::mat::mat4_create_rotation_yxz(angles[i], 0.5f, angles[batch - 1 - i], FastMath());
+        bench::keep(out);
+    });
+    suite.run("mat/mat4_translate", batch, [&]() {
+        for (size_t i = 0; i < batch; i++) out[i] = utils::mat::mat4_translate(a[i], angles[i], 1, 2);
+        bench::keep(out);
+    });
+    suite.run("mat/mat4_scale", batch, [&]() {
+        for (size_t i = 0; i < batch; i++) out[i] = utils::mat::mat4_scale(a[i], angles[i], 1, 2);
+        bench::keep(out);
+    });
+    suite.run("mat/mat4_rotate_yxz", batch, [&]() {
+        for (size_t i = 0; i < batch; i++) out[i] = utils::mat::mat4_rotate_yxz(a[i], angles[i], 0.5f, 0.25f);
+        bench::keep(out);
+    });
+
+    // Column-major storage, and the conversion it saves before an upload
+    std::vector<Mat4c> ac(a.begin(), a.end()), bc(b.begin(), b.end()), outc(batch);
+    std::vector<Vec4> vecs = random_mats<4, 1>(batch), vecs_out(batch);
+    suite.run("mat/multiply/4x4*4x4/col_major", batch, [&]() {
+        for (size_t i = 0; i < batch; i++) outc[i] = ac[i] * bc[i];
+        bench::keep(outc);
+    });
+    suite.run("mat/multiply/4x4*4x1/col_major", batch, [&]() {
+        for (size_t i = 0; i < batch; i++) vecs_out[i] = ac[i] * vecs[i];
+        bench::keep(vecs_out);
+    });
+    suite.run("mat/mat4_rotate_yxz/col_major", batch, [&]() {
+        for (size_t i = 0; i < batch; i++) outc[i] = utils::mat::mat4_rotate_yxz(ac[i], angles[i], 0.5f, 0.25f);
+        bench::keep(outc);
+    });
+    suite.run("mat/inverse/4x4/col_major", batch, [&]() {
+        for (size_t i = 0; i < batch; i++) outc[i] = utils::mat::inverse(ac[i]);
+        bench::keep(outc);
+    });
+    suite.run("mat/to_col_major/4x4", batch, [&]() {
+        for (size_t i = 0; i < batch; i++) outc[i] = Mat4c(a[i]);
+        bench::keep(outc);
+    });
+
+}
+
+static void bench_projection(bench::Suite& suite) {
+    std::vector<Mat4> out(batch);
+    std::vector<float> fovs(batch);
+    for (float& fov : fovs) fov = random_float(0.5f, 2);
+    suite.run("projection/mat4_create_perspective", batch, [&]() {
+        for (size_t i = 0; i < batch; i++) out[i] = utils::projection::mat4_create_perspective(fovs[i], 16.0f / 9, 0.1f, 100);
+        bench::keep(out);
+    });
+    suite.run("projection/mat4_create_orthographic", batch, [&]() {
+        for (size_t i = 0; i < batch; i++) out[i] = utils::projection::mat4_create_orthographic(-fovs[i], fovs[i], -1, 1, 0.1f, 100);
+        bench::keep(out);
+    });
+}
+
+static void bench_vec(bench::Suite& suite) {
+    std::vector<Vec3> a = random_mats<3, 1>(batch), b = random_mats<3, 1>(batch), out(batch);
+    std::vector<Vec4> a4 = random_mats<4, 1>(batch), out4(batch);
+    std::vector<float> scalars(batch);
+
+    suite.run("vec/dot/3", batch, [&]() {
+        for (size_t i = 0; i < batch; i++) scalars[i] = utils::vec::dot(a[i], b[i]);
+        bench::keep(scalars);
+    });
+    suite.run("vec/cross/3", batch, [&]() {
+        for (size_t i = 0; i < batch; i++) out[i] = utils::vec::cross(a[i], b[i]);
+        bench::keep(out);
+    });
+    suite.run("vec/magnitude/3", batch, [&]() {
+        for (size_t i = 0; i < batch; i++) scalars[i] = utils::vec::magnitude(a[i]);
+        bench::keep(scalars);
+    });
+    suite.run("vec/magnitude/4", batch, [&]() {
+        for (size_t i = 0; i < batch; i++) scalars[i] = utils::vec::magnitude(a4[i]);
+        bench::keep(scalars);
+    });
+    suite.run("vec/normalize/3", batch, [&]() {
+        for (size_t i = 0; i < batch; i++) out[i] = utils::vec::normalize(a[i]);
+        bench::keep(out);
+    });
+    suite.run("vec/normalize/3/fast", batch, [&]() {
+        for (size_t i = 0; i < batch; i++) out[i] = utils::vec::normalize(a[i], FastMath());
+        bench::keep(out);
+    });
+    suite.run("vec/angle_between/3", batch, [&]() {
+        for (size_t i = 0; i < batch; i++) scalars[i] = utils::vec::angle_between(a[i], b[i]);
+        bench::keep(scalars);
+    });
+    suite.run("vec/angle_between/3/fast", batch, [&]() {
+        for (size_t i = 0; i < batch; i++) scalars[i] = utils::vec::angle_between(a[i], b[i], FastMath());
+        bench::keep(scalars);
+    });
+    suite.run("vec/resize/3to4", batch, [&]() {
+        for (size_t i = 0; i < batch; i++) out4[i] = utils::vec::resize<4>(a[i]);
+        bench::keep(out4);
+    });
+    suite.run("vec/i_axis/3", batch, [&]() {
+        for (size_t i = 0; i < batch; i++) out[i] = utils::vec::i_axis<3>(uint8_t(i % 3));
+        bench::keep(out);
+    });
+}
+
+static void bench_point(bench::Suite& suite) {
+    std::vector<Point3> a = random_mats<3, 1>(batch), b = random_mats<3, 1>(batch), c = random_mats<3, 1>(batch), out(batch);
+    std::vector<float> scalars(batch);
+    suite.run("point/between/3", batch, [&]() {
+        for (size_t i = 0; i < batch; i++) out[i] = utils::point::between(a[i], b[i]);
+        bench::keep(out);
+    });
+    suite.run("point/distance/3", batch, [&]() {
+        for (size_t i = 0; i < batch; i++) scalars[i] = utils::point::distance(a[i], b[i]);
+        bench::keep(scalars);
+    });
+    suite.run("point/normal", batch, [&]() {
+        for (size_t i = 0; i < batch; i++) out[i] = utils::point::normal(a[i], b[i], c[i]);
+        bench::keep(out);
+    });
+}
+
+template<uint8_t P>
+static void bench_polygon_size(bench::Suite& suite, const std::string& shape) {
+    std::vector<Polygon<P, 3>> planar = random_polygons<P>(batch, true);
+    std::vector<Polygon<P, 3>> bumpy = random_polygons<P>(batch, false);
+    std::vector<float> areas(batch);
+    std::vector<char> flags(batch);
+    suite.run("polygon/area/" + shape, batch, [&]() {
+        for (size_t i = 0; i < batch; i++) areas[i] = utils::polygon::area(planar[i]);
+        bench::keep(areas);
+    });
+    suite.run("polygon/is_convex/" + shape, batch, [&]() {
+        for (size_t i = 0; i < batch; i++) flags[i] = utils::polygon::is_convex(planar[i]);
+        bench::keep(flags);
+    });
+    suite.run("polygon/is_planar/" + shape, batch, [&]() {
+        for (size_t i = 0; i < batch; i++) flags[i] = utils::polygon::is_planar(bumpy[i]);
+        bench::keep(flags);
+    });
+}
+
+static void bench_polygon(bench::Suite& suite) {
+    std::vector<Tri3> tris = random_polygons<3>(batch, false);
+    std::vector<Vec3> normals(batch);
+    suite.run("polygon/tri_normal", batch, [&]() {
+        for (size_t i = 0; i < batch; i++) normals[i] = utils::polygon::tri_normal(tris[i]);
+        bench::keep(normals);
+    });
+    bench_polygon_size<3>(suite, "tri");
+    bench_polygon_size<4>(suite, "quad");
+    bench_polygon_size<8>(suite, "octagon");
+
+    // Whole soups at once
+    std::vector<Tri3> soup = random_polygons<3>(large_batch, false);
+    std::vector<float> soup_areas(large_batch);
+    suite.run("polygon/batch_area/tri", large_batch, [&]() {
+        float total = utils::polygon::area(soup.data(), soup.size(), soup_areas.data());
+        bench::keep(total);
+        bench::keep(soup_areas);
+    });
+}
+
+static void bench_affine_quat(bench::Suite& suite) {
+    std::vector<Affine3> a(batch), b(batch), out(batch);
+    std::vector<Quat> qa = random_quats(batch), qb = random_quats(batch), qout(batch);
+    std::vector<Vec3> vecs = random_mats<3, 1>(batch), vec_out(batch);
+    for (size_t i = 0; i < batch; i++) {
+        a[i] = utils::affine::affine3_translate(utils::quat::to_affine3(qa[i]), random_float(), random_float(), random_float());
+        b[i] = utils::affine::affine3_translate(utils::quat::to_affine3(qb[i]), random_float(), random_float(), random_float());
+    }
+
+    suite.run("affine/multiply", batch, [&]() {
+        for (size_t i = 0; i < batch; i++) out[i] = a[i] * b[i];
+        bench::keep(out);
+    });
+    suite.run("affine/apply_point", batch, [&]() {
+        for (size_t i = 0; i < batch; i++) vec_out[i] = utils::affine::apply_point(a[i], vecs[i]);
+        bench::keep(vec_out);
+    });
+    suite.run("affine/inverse", batch, [&]() {
+        for (size_t i = 0; i < batch; i++) out[i] = utils::affine::inverse(a[i]);
+        bench::keep(out);
+    });
+    suite.run("affine/inverse_rigid", batch, [&]() {
+        for (size_t i = 0; i < batch; i++) out[i] = utils::affine::inverse_rigid(a[i]);
+        bench::keep(out);
+    });
+    suite.run("quat/multiply", batch, [&]() {
+        for (size_t i = 0; i < batch; i++) qout[i] = qa[i] * qb[i];
+        bench::keep(qout);
+    });
+    suite.run("quat/rotate", batch, [&]() {
+        for (size_t i = 0; i < batch; i++) vec_out[i] = utils::quat::rotate(qa[i], vecs[i]);
+        bench::keep(vec_out);
+    });
+    suite.run("quat/quat_create_rotation_yxz", batch, [&]() {
+        for (size_t i = 0; i < batch; i++) qout[i] = utils::quat::quat_create_rotation_yxz(vecs[i].x(), vecs[i].y(), vecs[i].z());
+        bench::keep(qout);
+    });
+    suite.run("quat/nlerp", batch, [&]() {
+        for (size_t i = 0; i < batch; i++) qout[i] = utils::quat::nlerp(qa[i], qb[i], 0.3f);
+        bench::keep(qout);
+    });
+    suite.run("quat/slerp", batch, [&]() {
+        for (size_t i = 0; i < batch; i++) qout[i] = utils::quat::slerp(qa[i], qb[i], 0.3f);
+        bench::keep(qout);
+    });
+    suite.run("quat/batch_multiply", batch, [&]() {
+        utils::quat::multiply(qa.data(), qb.data(), qout.data(), batch);
+        bench::keep(qout);
+    });
+    suite.run("quat/batch_slerp", batch, [&]() {
+        utils::quat::slerp(qa.data(), qb.data(), 0.3f, qout.data(), batch);
+        bench::keep(qout);
+    });
+}
+
+static void bench_batches(bench::Suite& suite) {
+
+    // Random vectors, both as arrays of Vec3 and as SoA streams
+    std::vector<Point3> points = random_mats<3, 1>(large_batch), points_out(large_batch);
+    Vec3Soa soa, soa_out, soa_other;
+    soa.assign(points.data(), points.size());
+    soa_other.assign(points.data(), points.size());
+    soa_out.resize(large_batch);
+    std::vector<float> scalars(large_batch);
+    Mat4 mat = utils::mat::mat4_rotate_yxz(utils::mat::mat4_create_translation(1, 2, 3), 0.1f, 0.2f, 0.3f);
+
+    suite.run("vec_soa/dot/3", large_batch, [&]() {
+        utils::vec_soa::dot(soa.view(), soa_other.view(), scalars.data());
+        bench::keep(scalars);
+    });
+    suite.run("vec_soa/cross/3", large_batch, [&]() {
+        utils::vec_soa::cross(soa.view(), soa_other.view(), soa_out.span());
+        bench::keep(soa_out);
+    });
+    suite.run("vec_soa/normalize/3", large_batch, [&]() {
+        utils::vec_soa::normalize(soa.view(), soa_out.span());
+        bench::keep(soa_out);
+    });
+    std::vector<Point3> directions = random_mats<3, 1>(large_batch);
+    Vec3Soa soa_directions(directions.data(), directions.size());
+    suite.run("vec_soa/angle_between/3", large_batch, [&]() {
+        utils::vec_soa::angle_between(soa.view(), soa_directions.view(), scalars.data());
+        bench::keep(scalars);
+    });
+    suite.run("vec_soa/angle_between/3/fast", large_batch, [&]() {
+        utils::vec_soa::angle_between(soa.view(), soa_directions.view(), scalars.data(), FastMath());
+        bench::keep(scalars);
+    });
+    suite.run("transform/transform_points/aos", large_batch, [&]() {
+        utils::transform::transform_points(mat, points.data(), points_out.data(), large_batch);
+        bench::keep(points_out);
+    });
+    aligned_vector<Point3Padded> padded(points.begin(), points.end()), padded_out(large_batch);
+    suite.run("transform/transform_points/padded", large_batch, [&]() {
+        utils::transform::transform_points(mat, padded.data(), padded_out.data(), large_batch);
+        bench::keep(padded_out);
+    });
+    suite.run("transform/transform_points/soa", large_batch, [&]() {
+        utils::transform::transform_points(mat, soa.view(), soa_out.span());
+        bench::keep(soa_out);
+    });
+
+}
+
+static void bench_hierarchy(bench::Suite& suite) {
+
+    // A wide, shallow scene like a level full of props with a few children each
+    const size_t nodes = 1 << 16;
+    TransformHierarchy scene;
+    for (size_t i = 0; i < nodes; i++) {
+        TransformHierarchy::Node parent = i < 1024 ? TransformHierarchy::none : TransformHierarchy::Node(rng() % i);
+        TransformHierarchy::Node node = scene.add(parent);
+        const float offset[3] = { random_float(), random_float(), random_float() };
+        scene.set_translation(node, Vec3(offset));
+    }
+    scene.update();
+
+    suite.run("hierarchy/update/static", nodes, [&]() {
+        scene.update();
+        bench::keep(scene);
+    });
+    suite.run("hierarchy/update/all_roots_moved", nodes, [&]() {
+        const float offset[3] = { random_float(), 0, 0 };
+        for (TransformHierarchy::Node node = 0; node < 1024; node++) scene.set_translation(node, Vec3(offset));
+        scene.update();
+        bench::keep(scene);
+    });
+
+}
+
+static void bench_mesh(bench::Suite& suite) {
+
+    // A bumpy 512x512 grid with texture coordinates
+    const uint32_t size = 512;
+    Mesh mesh;
+    for (uint32_t y = 0; y <= size; y++) {
+        for (uint32_t x = 0; x <= size; x++) {
+            const float position[3] = { float(x), float(y), random_float() };
+            const float uv[2] = { float(x) / size, float(y) / size };
+            mesh.add_vertex(Point3(position), Vec2(uv));
+        }
+    }
+    for (uint32_t y = 0; y < size; y++) {
+        for (uint32_t x = 0; x < size; x++) {
+            uint32_t corner = y * (size + 1) + x;
+            mesh.add_triangle(corner, corner + 1, corner + size + 2);
+            mesh.add_triangle(corner, corner + size + 2, corner + size + 1);
+        }
+    }
+    MeshAdjacency adjacency = utils::mesh::build_adjacency(mesh);
+    Vec3Soa face_normals(mesh.triangle_count()), normals(mesh.vertex_count());
+    Vec4Soa tangents(mesh.vertex_count());
+
+    suite.run("mesh/face_normals", mesh.triangle_count(), [&]() {
+        utils::mesh::face_normals(mesh, face_normals.span());
+        bench::keep(face_normals);
+    });
+    suite.run("mesh/area", mesh.triangle_count(), [&]() {
+        float total = utils::mesh::area(mesh);
+        bench::keep(total);
+    });
+    suite.run("mesh/build_adjacency", mesh.triangle_count(), [&]() {
+        MeshAdjacency built = utils::mesh::build_adjacency(mesh);
+        bench::keep(built);
+    });
+    suite.run("mesh/vertex_normals", mesh.vertex_count(), [&]() {
+        utils::mesh::vertex_normals(mesh, adjacency, normals.span());
+        bench::keep(normals);
+    });
+    suite.run("mesh/tangents", mesh.vertex_count(), [&]() {
+        utils::mesh::tangents(mesh, adjacency, normals.view(), tangents.span());
+        bench::keep(tangents);
+    });
+
+}
+
+static void bench_bvh(bench::Suite& suite) {
+
+    // A bumpy 256x256 grid, with rays cast down onto it from random points above
+    const uint32_t size = 256;
+    Mesh mesh;
+    for (uint32_t y = 0; y <= size; y++) {
+        for (uint32_t x = 0; x <= size; x++) {
+            const float position[3] = { float(x), float(y), random_float() };
+            mesh.add_vertex(Point3(position));
+        }
+    }
+    for (uint32_t y = 0; y < size; y++) {
+        for (uint32_t x = 0; x < size; x++) {
+            uint32_t corner = y * (size + 1) + x;
+            mesh.add_triangle(corner, corner + 1, corner + size + 2);
+            mesh.add_triangle(corner, corner + size + 2, corner + size + 1);
+        }
+    }
+    std::vector<Ray3> rays(batch);
+    std::vector<Point3> points(batch);
+    for (size_t i = 0; i < batch; i++) {
+        const float origin[3] = { random_float(0, size), random_float(0, size), 10 };
+        const float direction[3] = { random_float(), random_float(), -1 };
+        rays[i] = Ray3(Point3(origin), Vec3(direction));
+        const float point[3] = { random_float(0, size), random_float(0, size), random_float(-5, 5) };
+        points[i] = Point3(point);
+    }
+    Bvh bvh(mesh);
+    std::vector<RayHit> hits(batch);
+    std::vector<uint8_t> occluded(batch);
+    PointHit closest;
+
+    suite.run("bvh/build", mesh.triangle_count(), [&]() {
+        Bvh built(mesh);
+        bench::keep(built);
+    });
+    suite.run("bvh/refit", mesh.triangle_count(), [&]() {
+        bvh.refit(mesh);
+        bench::keep(bvh);
+    });
+    suite.run("bvh/intersect", batch, [&]() {
+        for (size_t i = 0; i < batch; i++) bvh.intersect(rays[i], hits[i]);
+        bench::keep(hits);
+    });
+    suite.run("bvh/intersect/batch", batch, [&]() {
+        bvh.intersect(rays.data(), hits.data(), batch);
+        bench::keep(hits);
+    });
+    suite.run("bvh/occluded", batch, [&]() {
+        for (size_t i = 0; i < batch; i++) occluded[i] = bvh.occluded(rays[i]);
+        bench::keep(occluded);
+    });
+    suite.run("bvh/closest_point", batch, [&]() {
+        for (size_t i = 0; i < batch; i++) bvh.closest_point(points[i], closest);
+        bench::keep(closest);
+    });
+
+}
+
+static void bench_ray(bench::Suite& suite) {
+
+    // Random triangles near the origin, and rays cast at them from one side
+    std::vector<Tri3> tris = random_polygons<3>(large_batch, false);
+    Vec3Soa origins(batch), directions(batch);
+    std::vector<Ray3> rays(batch);
+    for (size_t i = 0; i < batch; i++) {
+        const float origin[3] = { random_float(), random_float(), -3 };
+        const float direction[3] = { random_float(-0.1f, 0.1f), random_float(-0.1f, 0.1f), 1 };
+        rays[i] = Ray3(Point3(origin), Vec3(direction));
+        origins.set(i, rays[i].origin);
+        directions.set(i, rays[i].direction);
+    }
+    std::vector<float> t(large_batch), u(large_batch), v(large_batch);
+    std::vector<RayHit> hits(batch);
+    RayHit hit;
+
+    suite.run("ray/intersect", batch, [&]() {
+        for (size_t i = 0; i < batch; i++) utils::ray::intersect(rays[i], tris[i], hits[i]);
+        bench::keep(hits);
+    });
+    suite.run("ray/intersect/rays", batch, [&]() {
+        utils::ray::intersect(origins.view(), directions.view(), tris[0], t.data(), u.data(), v.data());
+        bench::keep(t);
+    });
+    suite.run("ray/intersect/triangles", large_batch, [&]() {
+        utils::ray::intersect(rays[0], tris.data(), large_batch, t.data(), u.data(), v.data());
+        bench::keep(t);
+    });
+    suite.run("ray/closest", large_batch, [&]() {
+        utils::ray::closest(rays[0], tris.data(), large_batch, hit);
+        bench::keep(hit);
+    });
+    suite.run("ray/closest/rays", batch * 1024, [&]() {
+        utils::ray::closest(origins.view(), directions.view(), tris.data(), 1024, hits.data());
+        bench::keep(hits);
+    });
+
+}
+
+static void bench_frustum(bench::Suite& suite) {
+
+    // Bounding volumes scattered around a camera looking down -z, about a tenth of them visible
+    Frustum frustum = utils::frustum::extract(utils::projection::mat4_create_perspective(60, 1.5f, 0.1f, 100));
+    Vec3Soa centers(large_batch), mins(large_batch), maxs(large_batch);
+    std::vector<float> radii(large_batch);
+    for (size_t i = 0; i < large_batch; i++) {
+        const float center[3] = { random_float(-100, 100), random_float(-100, 100), random_float(-100, 100) };
+        const float extent[3] = { random_float(0, 2), random_float(0, 2), random_float(0, 2) };
+        const float min[3] = { center[0] - extent[0], center[1] - extent[1], center[2] - extent[2] };
+        const float max[3] = { center[0] + extent[0], center[1] + extent[1], center[2] + extent[2] };
+        centers.set(i, Point3(center));
+        radii[i] = random_float(0, 2);
+        mins.set(i, Point3(min));
+        maxs.set(i, Point3(max));
+    }
+    std::vector<uint32_t> visible(large_batch);
+    size_t count = 0;
+
+    suite.run("frustum/extract", 1, [&]() {
+        Frustum extracted = utils::frustum::extract(utils::projection::mat4_create_perspective(60, 1.5f, 0.1f, 100));
+        bench::keep(extracted);
+    });
+    suite.run("frustum/visible/sphere", batch, [&]() {
+        count = 0;
+        for (size_t i = 0; i < batch; i++) count += utils::frustum::visible(frustum, centers.get(i), radii[i]);
+        bench::keep(count);
+    });
+    suite.run("frustum/cull/spheres", large_batch, [&]() {
+        count = utils::frustum::cull(frustum, centers.view(), radii.data(), visible.data());
+        bench::keep(visible);
+    });
+    suite.run("frustum/cull/boxes", large_batch, [&]() {
+        count = utils::frustum::cull(frustum, mins.view(), maxs.view(), visible.data());
+        bench::keep(visible);
+    });
+
+}
+
+static void bench_bounds(bench::Suite& suite) {
+
+    // A large cloud of points, both as SoA streams and packed
+    Vec3Soa points(large_batch);
+    std::vector<Point3> packed(large_batch);
+    for (size_t i = 0; i < large_batch; i++) {
+        const float point[3] = { random_float(-100, 100), random_float(-50, 50), random_float(-10, 10) };
+        packed[i] = Point3(point);
+        points.set(i, packed[i]);
+    }
+    Aabb3 box = utils::bounds::aabb(points.view());
+    Mat4 transform = random_mats<4, 4>(1)[0];
+    Sphere3 sphere;
+
+    suite.run("bounds/aabb/soa", large_batch, [&]() {
+        box = utils::bounds::aabb(points.view());
+        bench::keep(box);
+    });
+    suite.run("bounds/aabb/points", large_batch, [&]() {
+        box = utils::bounds::aabb(packed.data(), large_batch);
+        bench::keep(box);
+    });
+    suite.run("bounds/ritter", large_batch, [&]() {
+        sphere = utils::bounds::ritter(points.view());
+        bench::keep(sphere);
+    });
+    suite.run("bounds/minimal", large_batch, [&]() {
+        sphere = utils::bounds::minimal(points.view());
+        bench::keep(sphere);
+    });
+    suite.run("bounds/transform", 1, [&]() {
+        Aabb3 transformed = utils::bounds::transform(transform, box);
+        bench::keep(transformed);
+    });
+
+}
+
+static void bench_kd_tree(bench::Suite& suite) {
+
+    // A large cloud of points, and queries scattered among them
+    std::vector<Point3> points(large_batch), queries(batch);
+    for (Point3& point : points) {
+        const float position[3] = { random_float(-100, 100), random_float(-100, 100), random_float(-100, 100) };
+        point = Point3(position);
+    }
+    for (Point3& query : queries) {
+        const float position[3] = { random_float(-100, 100), random_float(-100, 100), random_float(-100, 100) };
+        query = Point3(position);
+    }
+    KdTree tree(points.data(), large_batch);
+    const size_t k = 8;
+    std::vector<uint32_t> indices(batch * k), offsets;
+    std::vector<float> distances2(batch * k);
+    std::vector<uint32_t> around;
+
+    suite.run("kd_tree/build", large_batch, [&]() {
+        KdTree built(points.data(), large_batch);
+        bench::keep(built);
+    });
+    suite.run("kd_tree/nearest", batch, [&]() {
+        for (size_t i = 0; i < batch; i++) tree.nearest(queries[i], 1, &indices[i], &distances2[i]);
+        bench::keep(indices);
+    });
+    suite.run("kd_tree/nearest/k8", batch, [&]() {
+        for (size_t i = 0; i < batch; i++) tree.nearest(queries[i], k, &indices[i * k], &distances2[i * k]);
+        bench::keep(indices);
+    });
+    suite.run("kd_tree/nearest/k8/batch", batch, [&]() {
+        tree.nearest(queries.data(), batch, k, indices.data(), distances2.data());
+        bench::keep(indices);
+    });
+    suite.run("kd_tree/within", batch, [&]() {
+        for (size_t i = 0; i < batch; i++) tree.within(queries[i], 5, around);
+        bench::keep(around);
+    });
+    suite.run("kd_tree/within/batch", batch, [&]() {
+        tree.within(queries.data(), batch, 5, offsets, indices);
+        bench::keep(indices);
+    });
+
+}
+
+static void bench_spatial_hash(bench::Suite& suite) {
+
+    // A large crowd of entities, and two frames of them drifting a little
+    std::vector<Point3> points(large_batch), moved(large_batch), queries(batch);
+    for (size_t i = 0; i < large_batch; i++) {
+        const float position[3] = { random_float(-200, 200), random_float(-200, 200), random_float(-200, 200) };
+        const float step[3] = { random_float(-0.05f, 0.05f), random_float(-0.05f, 0.05f), random_float(-0.05f, 0.05f) };
+        points[i] = Point3(position);
+        moved[i] = points[i] + Vec3(step);
+    }
+    for (size_t i = 0; i < batch; i++) queries[i] = points[i * 97];
+    SpatialHash grid(4.0f, points.data(), large_batch);
+    std::vector<uint32_t> around, offsets, indices;
+    bool flip = false;
+
+    suite.run("spatial_hash/build", large_batch, [&]() {
+        grid.build(points.data(), large_batch);
+        bench::keep(grid);
+    });
+    suite.run("spatial_hash/update", large_batch, [&]() {
+        grid.update(flip ? points.data() : moved.data());
+        flip = !flip;
+        bench::keep(grid);
+    });
+    suite.run("spatial_hash/within", batch, [&]() {
+        for (size_t i = 0; i < batch; i++) grid.within(queries[i], 4, around);
+        bench::keep(around);
+    });
+    suite.run("spatial_hash/within/batch", batch, [&]() {
+        grid.within(queries.data(), batch, 4, offsets, indices);
+        bench::keep(indices);
+    });
+
+}
+
+static void bench_raster(bench::Suite& suite) {
+
+    // A bumpy 512x512 terrain seen from above at 720p, and a cloud of small triangles
+    const uint32_t size = 512;
+    Mesh terrain;
+    for (uint32_t y = 0; y <= size; y++) {
+        for (uint32_t x = 0; x <= size; x++) {
+            const float position[3] = { float(x) - size / 2.0f, random_float(), float(y) - size / 2.0f };
+            terrain.add_vertex(Point3(position));
+        }
+    }
+    for (uint32_t y = 0; y < size; y++) {
+        for (uint32_t x = 0; x < size; x++) {
+            uint32_t corner = y * (size + 1) + x;
+            terrain.add_triangle(corner, corner + 1, corner + size + 2);
+            terrain.add_triangle(corner, corner + size + 2, corner + size + 1);
+        }
+    }
+    std::vector<Tri3> triangles(large_batch / 8);
+    for (Tri3& tri : triangles) {
+        const float center[3] = { random_float(-60, 60), random_float(-40, 40), random_float(-150, -5) };
+        for (int k = 0; k < 3; k++) {
+            const float offset[3] = { random_float(-1, 1), random_float(-1, 1), random_float(-1, 1) };
+            tri.points[k] = Point3(center) + Vec3(offset);
+        }
+    }
+    Mat4 projection = utils::projection::mat4_create_perspective(60, 16.0f / 9, 0.1f, 1000);
+    Mat4 view = utils::mat::mat4_translate(utils::mat::mat4_create_rotation_x(0.6f), 0, -120, -100);
+    DepthBuffer target(1280, 720, true);
+
+    suite.run("raster/draw/mesh", terrain.triangle_count(), [&]() {
+        target.clear();
+        utils::raster::draw(terrain, projection * view, target);
+        bench::keep(target);
+    });
+    suite.run("raster/draw/triangles", triangles.size(), [&]() {
+        target.clear();
+        utils::raster::draw(triangles.data(), triangles.size(), projection, target);
+        bench::keep(target);
+    });
+
+}
+
+static void bench_geometry_file(bench::Suite& suite) {
+
+    // A large point cloud with one extra stream, saved once
+    const char* path = "e3d_bench_geometry.e3dg";
+    Vec3Soa points(large_batch);
+    std::vector<float> intensities(large_batch);
+    for (size_t i = 0; i < large_batch; i++) {
+        const float position[3] = { random_float(-100, 100), random_float(-100, 100), random_float(-100, 100) };
+        points.set(i, Point3(position));
+        intensities[i] = random_float();
+    }
+    utils::geometry_file::Stream extra = utils::geometry_file::stream("intensity", intensities.data(), large_batch);
+    utils::geometry_file::write(path, points.view(), &extra, 1);
+    GeometryFile file;
+
+    suite.run("geometry_file/write", large_batch, [&]() {
+        bench::keep(utils::geometry_file::write(path, points.view(), &extra, 1));
+    });
+    suite.run("geometry_file/open", large_batch, [&]() {
+        file.open(path);
+        bench::keep(file.positions());
+        file.close();
+    });
+    std::remove(path);
+
+}
+
+static void bench_mesh_import(bench::Suite& suite) {
+
+    // The same grid of quads as OBJ, ASCII PLY and binary PLY text
+    const size_t side = 256, vertices = side * side, quads = (side - 1) * (side - 1);
+    std::string obj, ply = "ply\nformat ascii 1.0\nelement vertex " + std::to_string(vertices)
+        + "\nproperty float x\nproperty float y\nproperty float z\nelement face " + std::to_string(quads)
+        + "\nproperty list uchar int vertex_indices\nend_header\n";
+    std::string binary = "ply\nformat binary_little_endian 1.0\nelement vertex " + std::to_string(vertices)
+        + "\nproperty float x\nproperty float y\nproperty float z\nelement face " + std::to_string(quads)
+        + "\nproperty list uchar int vertex_indices\nend_header\n";
+    char line[128];
+    for (size_t i = 0; i < vertices; i++) {
+        const float position[3] = { float(i % side), random_float(-1, 1), float(i / side) };
+        std::snprintf(line, sizeof(line), "%.6f %.6f %.6f\n", position[0], position[1], position[2]);
+        obj += std::string("v ") + line;
+        ply += line;
+        binary.append(reinterpret_cast<const char*>(position), sizeof(position));
+    }
+    for (size_t z = 0; z + 1 < side; z++) {
+        for (size_t x = 0; x + 1 < side; x++) {
+            const int32_t corners[4] = { int32_t(z * side + x), int32_t(z * side + x + 1), int32_t((z + 1) * side + x + 1), int32_t((z + 1) * side + x) };
+            std::snprintf(line, sizeof(line), "%d %d %d %d\n", corners[0] + 1, corners[1] + 1, corners[2] + 1, corners[3] + 1);
+            obj += std::string("f ") + line;
+            std::snprintf(line, sizeof(line), "4 %d %d %d %d\n", corners[0], corners[1], corners[2], corners[3]);
+            ply += line;
+            binary += char(4);
+            binary.append(reinterpret_cast<const char*>(corners), sizeof(corners));
+        }
+    }
+    Mesh mesh;
+
+    suite.run("mesh_import/obj", vertices, [&]() {
+        bench::keep(utils::mesh_import::parse_obj(obj.data(), obj.size(), mesh));
+    });
+    suite.run("mesh_import/ply_ascii", vertices, [&]() {
+        bench::keep(utils::mesh_import::parse_ply(ply.data(), ply.size(), mesh));
+    });
+    suite.run("mesh_import/ply_binary", vertices, [&]() {
+        bench::keep(utils::mesh_import::parse_ply(binary.data(), binary.size(), mesh));
+    });
+
+}
+
+static void bench_fast_math(bench::Suite& suite) {
+    std::vector<float> angles(large_batch), sines(large_batch), cosines(large_batch);
+    for (float& angle : angles) angle = random_float(-10, 10);
+
+    suite.run("fast_math/sincos/libm", large_batch, [&]() {
+        for (size_t i = 0; i < large_batch; i++) {
+            sines[i] = std::sin(angles[i]);
+            cosines[i] = std::cos(angles[i]);
+        }
+        bench::keep(sines);
+        bench::keep(cosines);
+    });
+    suite.run("fast_math/sincos", large_batch, [&]() {
+        for (size_t i = 0; i < large_batch; i++) utils::fast_math::sincos(angles[i], sines[i], cosines[i]);
+        bench::keep(sines);
+        bench::keep(cosines);
+    });
+    suite.run("fast_math/sincos/batch", large_batch, [&]() {
+        utils::fast_math::sincos(angles.data(), sines.data(), cosines.data(), large_batch);
+        bench::keep(sines);
+        bench::keep(cosines);
+    });
+    suite.run("fast_math/acos/batch", large_batch, [&]() {
+        utils::fast_math::acos(sines.data(), cosines.data(), large_batch);
+        bench::keep(cosines);
+    });
+
+}
+
+/**
+ * Benchmarks one matrix at a time against MatBatch for one size of square matrix
+ */
+template<uint8_t R>
+static void bench_mat_batch_size(bench::Suite& suite) {
+    std::string size = std::to_string(R) + "x" + std::to_string(R);
+    std::vector<Mat<R, R>> mats = random_invertible<R>(large_batch), others = random_invertible<R>(large_batch), out(large_batch);
+    std::vector<Vec<R>> vecs = random_mats<R, 1>(large_batch);
+    std::vector<float> dets(large_batch);
+    MatBatch<R, R> batch_mats(mats.data(), large_batch), batch_others(others.data(), large_batch), batch_out(large_batch);
+    VecSoa<R> batch_vecs(vecs.data(), large_batch), batch_vecs_out(large_batch);
+
+    suite.run("mat_batch/pack/" + size, large_batch, [&]() {
+        batch_out.assign(mats.data(), large_batch);
+        bench::keep(batch_out);
+    });
+    suite.run("mat_batch/multiply/" + size + "/each", large_batch, [&]() {
+        for (size_t i = 0; i < large_batch; i++) out[i] = mats[i] * others[i];
+        bench::keep(out);
+    });
+    suite.run("mat_batch/multiply/" + size, large_batch, [&]() {
+        utils::mat_batch::multiply<R, R, R>(batch_mats, batch_others, batch_out.span());
+        bench::keep(batch_out);
+    });
+    suite.run("mat_batch/multiply_vec/" + size, large_batch, [&]() {
+        utils::mat_batch::multiply<R, R>(batch_mats, batch_vecs, batch_vecs_out.span());
+        bench::keep(batch_vecs_out);
+    });
+    suite.run("mat_batch/determinant/" + size + "/each", large_batch, [&]() {
+        for (size_t i = 0; i < large_batch; i++) dets[i] = utils::mat::determinant(mats[i]);
+        bench::keep(dets);
+    });
+    suite.run("mat_batch/determinant/" + size, large_batch, [&]() {
+        utils::mat_batch::determinant<R>(batch_mats, dets.data());
+        bench::keep(dets);
+    });
+    suite.run("mat_batch/inverse/" + size + "/each", large_batch, [&]() {
+        for (size_t i = 0; i < large_batch; i++) out[i] = utils::mat::inverse(mats[i]);
+        bench::keep(out);
+    });
+    suite.run("mat_batch/inverse/" + size, large_batch, [&]() {
+        utils::mat_batch::inverse<R>(batch_mats, batch_out.span());
+        bench::keep(batch_out);
+    });
+}
+
+static void bench_mat_batch(bench::Suite& suite) {
+    bench_mat_batch_size<3>(suite);
+    bench_mat_batch_size<4>(suite);
+}
+
+int main(int argc, char** argv) {
+
+    // Run every group, then write the results
+    bench::Suite suite(argc, argv);
+    bench_mat(suite);
+    bench_projection(suite);
+    bench_vec(suite);
+    bench_point(suite);
+    bench_polygon(suite);
+    bench_affine_quat(suite);
+    bench_batches(suite);
+    bench_hierarchy(suite);
+    bench_mesh(suite);
+    bench_bvh(suite);
+    bench_ray(suite);
+    bench_frustum(suite);
+    bench_bounds(suite);
+    bench_kd_tree(suite);
+    bench_spatial_hash(suite);
+    bench_raster(suite);
+    bench_geometry_file(suite);
+    bench_mesh_import(suite);
+    bench_fast_math(suite);
+    bench_mat_batch(suite);
+    return suite.finish();
+
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+/**
+ * SIMD kernels are only compiled for x86 with GCC or Clang, where per-function target
+ * attributes let us emit SSE/AVX code without raising the instruction set baseline of the
+ * whole build. Everywhere else (or with E3D_NO_SIMD defined) the scalar paths are used.
+ */
+#if !defined(E3D_NO_SIMD) && (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define E3D_SIMD_X86 1
+#else
+#define E3D_SIMD_X86 0
+#endif
+
+/**
+ * Marks a function as compiled for the given instruction set, ie. E3D_TARGET("avx2,fma")
+ */
+#if E3D_SIMD_X86
+#define E3D_TARGET(isa) __attribute__((target(isa)))
+#else
+#define E3D_TARGET(isa)
+#endif
+
+/**
+ * True while a constexpr function is being evaluated at compile-time, so it can skip runtime
+ * only paths such as SIMD dispatch. Compilers without the builtin always take the constexpr
+ * safe path.
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#define E3D_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#else
+#define E3D_CONSTANT_EVALUATED() true
+#endif
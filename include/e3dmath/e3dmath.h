@@ -4,8 +4,38 @@
 #include "types/vec.h"
 #include "types/point.h"
 #include "types/polygon.h"
+#include "types/vec_soa.h"
+#include "types/mat_batch.h"
+#include "types/affine.h"
+#include "types/quat.h"
+#include "types/transform_hierarchy.h"
+#include "types/mesh.h"
+#include "types/ray.h"
+#include "types/bvh.h"
+#include "types/frustum.h"
+#include "types/aabb.h"
+#include "types/sphere.h"
+#include "types/kd_tree.h"
+#include "types/spatial_hash.h"
+#include "types/depth_buffer.h"
+#include "types/geometry_file.h"
+#include "types/layout.h"
+#include "utils/fast_math.h"
 #include "utils/mat.h"
 #include "utils/vec.h"
 #include "utils/point.h"
 #include "utils/polygon.h"
 #include "utils/projection.h"
+#include "utils/affine.h"
+#include "utils/quat.h"
+#include "utils/vec_soa.h"
+#include "utils/mat_batch.h"
+#include "utils/parallel.h"
+#include "utils/transform.h"
+#include "utils/mesh.h"
+#include "utils/ray.h"
+#include "utils/frustum.h"
+#include "utils/bounds.h"
+#include "utils/raster.h"
+#include "utils/geometry_file.h"
+#include "utils/mesh_import.h"
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+namespace e3d::simd {
+
+    /**
+     * The alignment used for batch buffers. 64 bytes is one cache line, and the width of an
+     * AVX-512 register, so any vector load from the start of a buffer is aligned.
+     */
+    constexpr size_t buffer_alignment = 64;
+
+    /**
+     * The number of floats in one aligned block. Batch containers pad their streams to a
+     * multiple of this so that each stream starts on an aligned boundary.
+     */
+    constexpr size_t buffer_lanes = buffer_alignment / sizeof(float);
+
+    /**
+     * Rounds a count of floats up to a whole number of aligned blocks
+     */
+    constexpr size_t pad_lanes(size_t count) {
+        return (count + buffer_lanes - 1) / buffer_lanes * buffer_lanes;
+    }
+
+    /**
+     * Allocator for standard containers which aligns its storage to `Align` bytes
+     */
+    template<class T, size_t Align = buffer_alignment>
+    struct AlignedAllocator {
+
+        using value_type = T;
+
+        template<class U>
+        struct rebind { using other = AlignedAllocator<U, Align>; };
+
+        AlignedAllocator() noexcept = default;
+
+        template<class U>
+        AlignedAllocator(const AlignedAllocator<U, Align>&) noexcept {}
+
+        T* allocate(size_t count) {
+            return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(Align)));
+        }
+
+        void deallocate(T* ptr, size_t) noexcept {
+            ::operator delete(ptr, std::align_val_t(Align));
+        }
+
+        template<class U>
+        bool operator==(const AlignedAllocator<U, Align>&) const noexcept { return true; }
+
+        template<class U>
+        bool operator!=(const AlignedAllocator<U, Align>&) const noexcept { return false; }
+
+    };
+
+    template<class T> using aligned_vector = std::vector<T, AlignedAllocator<T>>;
+
+}
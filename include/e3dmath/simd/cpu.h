@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <cinttypes>
+#include <cstdlib>
+#include <cstring>
+#include "../config.h"
+
+namespace e3d::simd {
+
+    /**
+     * Instruction set levels that kernels may be specialized for, ordered so that each
+     * level implies every level before it.
+     */
+    enum class Level : uint8_t {
+        scalar = 0,
+        sse2,
+        avx,
+        avx2,       // AVX2 + FMA
+        avx512,     // AVX-512F
+    };
+
+    /**
+     * Gets the printable name of a SIMD level
+     */
+    static const char* level_name(Level level) {
+        switch (level) {
+            case Level::sse2: return "sse2";
+            case Level::avx: return "avx";
+            case Level::avx2: return "avx2";
+            case Level::avx512: return "avx512";
+            default: return "scalar";
+        }
+    }
+
+    /**
+     * Detects the best level supported by the CPU we are running on. This is evaluated once.
+     */
+    inline Level detected_level() {
+        static const Level detected = []() {
+#if E3D_SIMD_X86
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return Level::avx512;
+            if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return Level::avx2;
+            if (__builtin_cpu_supports("avx")) return Level::avx;
+            if (__builtin_cpu_supports("sse2")) return Level::sse2;
+#endif
+            return Level::scalar;
+        }();
+        return detected;
+    }
+
+    /**
+     * The level currently used by the dispatching kernels. This starts at the detected level,
+     * lowered by the E3D_SIMD_LEVEL environment variable if it is set (ie. "sse2").
+     */
+    inline std::atomic<Level>& _active_level() {
+        static std::atomic<Level> active([]() {
+            Level level = detected_level();
+            const char* env = std::getenv("E3D_SIMD_LEVEL");
+            if (env == nullptr) return level;
+            for (uint8_t i = 0; i <= uint8_t(level); i++) {
+                if (std::strcmp(env, level_name(Level(i))) == 0) return Level(i);
+            }
+            return level;
+        }());
+        return active;
+    }
+
+    /**
+     * Gets the level the dispatching kernels will use
+     */
+    inline Level level() {
+        return _active_level().load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Requests a specific level, ie. to compare kernels against each other. The request is
+     * clamped to what the CPU supports, and the level actually applied is returned.
+     */
+    inline Level set_level(Level requested) {
+        Level applied = uint8_t(requested) <= uint8_t(detected_level()) ? requested : detected_level();
+        _active_level().store(applied, std::memory_order_relaxed);
+        return applied;
+    }
+
+}
@@ -0,0 +1,91 @@
+// No include guard: this file is included once per kernel file.
+//
+// Compiles the kernel file named by E3D_SIMD_KERNELS once for every instruction set we
+// dispatch to. Each copy lives in its own namespace (E3D_SIMD_NS: scalar, sse2, avx2 or
+// avx512) and is compiled with that target enabled, so kernels are written once against the
+// `F32` lane type of their namespace and E3D_SIMD_DISPATCH picks the copy to run.
+//
+//     #define E3D_SIMD_KERNELS "kernels/vec_soa.inl"
+//     #include "../simd/foreach_target.h"
+//
+// The kernel path is relative to this directory. Kernel files must not include anything
+// themselves, since every header they pulled in would be compiled for the target too; the
+// including header is responsible for including simd/lanes.h and any types first.
+
+#ifndef E3D_SIMD_KERNELS
+#error "E3D_SIMD_KERNELS must name the kernel file to compile"
+#endif
+
+#include "../config.h"
+
+#define E3D_SIMD_TARGET_SCALAR 0
+#define E3D_SIMD_TARGET_SSE2 1
+#define E3D_SIMD_TARGET_AVX2 3
+#define E3D_SIMD_TARGET_AVX512 4
+
+// Portable fallback
+#define E3D_SIMD_NS scalar
+#define E3D_SIMD_TARGET E3D_SIMD_TARGET_SCALAR
+#include E3D_SIMD_KERNELS
+#undef E3D_SIMD_NS
+#undef E3D_SIMD_TARGET
+
+#if E3D_SIMD_X86
+
+// SSE2, 4 lanes
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("sse2"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("sse2")
+#endif
+#define E3D_SIMD_NS sse2
+#define E3D_SIMD_TARGET E3D_SIMD_TARGET_SSE2
+#include E3D_SIMD_KERNELS
+#undef E3D_SIMD_NS
+#undef E3D_SIMD_TARGET
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+// AVX2 + FMA, 8 lanes
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2,fma"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+#endif
+#define E3D_SIMD_NS avx2
+#define E3D_SIMD_TARGET E3D_SIMD_TARGET_AVX2
+#include E3D_SIMD_KERNELS
+#undef E3D_SIMD_NS
+#undef E3D_SIMD_TARGET
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+// AVX-512F, 16 lanes
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx512f,avx2,fma"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx2,fma")
+#endif
+#define E3D_SIMD_NS avx512
+#define E3D_SIMD_TARGET E3D_SIMD_TARGET_AVX512
+#include E3D_SIMD_KERNELS
+#undef E3D_SIMD_NS
+#undef E3D_SIMD_TARGET
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+#endif
+
+#undef E3D_SIMD_KERNELS
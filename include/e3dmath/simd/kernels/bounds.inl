@@ -0,0 +1,129 @@
+// Bounding volume kernels, compiled once per target by foreach_target.h. Points are read a
+// register at a time, either from SoA streams or from packed (x, y, z) triples.
+
+namespace e3d::simd::E3D_SIMD_NS::bounds {
+
+    /**
+     * The squared distance of W points from a center
+     */
+    template<class F>
+    static inline typename F::V distance2(typename F::V x, typename F::V y, typename F::V z, const typename F::V* center) {
+        typename F::V dx = F::sub(x, center[0]), dy = F::sub(y, center[1]), dz = F::sub(z, center[2]);
+        return F::fmadd(dz, dz, F::fmadd(dy, dy, F::mul(dx, dx)));
+    }
+
+    template<class F>
+    static inline void extents_range(const float* const* points, float* low, float* high, size_t begin, size_t end) {
+        typename F::V lo[3], hi[3];
+        for (int c = 0; c < 3; c++) {
+            lo[c] = F::set1(low[c]);
+            hi[c] = F::set1(high[c]);
+        }
+        for (size_t i = begin; i + F::W <= end; i += F::W) {
+            for (int c = 0; c < 3; c++) {
+                typename F::V value = F::loadu(points[c] + i);
+                lo[c] = F::min(lo[c], value);
+                hi[c] = F::max(hi[c], value);
+            }
+        }
+        for (int c = 0; c < 3; c++) {
+            low[c] = F::reduce_min(lo[c]);
+            high[c] = F::reduce_max(hi[c]);
+        }
+    }
+
+    template<class F>
+    static inline void extents_aos_range(const float* points, float* low, float* high, size_t begin, size_t end) {
+        typename F::V lo[3], hi[3];
+        for (int c = 0; c < 3; c++) {
+            lo[c] = F::set1(low[c]);
+            hi[c] = F::set1(high[c]);
+        }
+        for (size_t i = begin; i + F::W <= end; i += F::W) {
+            typename F::V value[3];
+            F::load_aos3(points + i * 3, value[0], value[1], value[2]);
+            for (int c = 0; c < 3; c++) {
+                lo[c] = F::min(lo[c], value[c]);
+                hi[c] = F::max(hi[c], value[c]);
+            }
+        }
+        for (int c = 0; c < 3; c++) {
+            low[c] = F::reduce_min(lo[c]);
+            high[c] = F::reduce_max(hi[c]);
+        }
+    }
+
+    template<class F>
+    static inline void farthest_range(const float* const* points, const float* center, float& best, size_t& best_index, size_t begin, size_t end) {
+        typename F::V middle[3] = { F::set1(center[0]), F::set1(center[1]), F::set1(center[2]) };
+        for (size_t i = begin; i + F::W <= end; i += F::W) {
+            typename F::V d2 = distance2<F>(F::loadu(points[0] + i), F::loadu(points[1] + i), F::loadu(points[2] + i), middle);
+            uint32_t bits = F::bits(F::gt(d2, F::set1(best)));
+            if (bits == 0) continue;
+
+            // New maximums get rarer as the scan goes on, so take them one lane at a time
+            alignas(64) float values[F::W];
+            F::store(values, d2);
+            for (size_t lane = 0; lane < F::W; lane++) {
+                if (!(bits & (1u << lane)) || values[lane] <= best) continue;
+                best = values[lane];
+                best_index = i + lane;
+            }
+        }
+    }
+
+    template<class F>
+    static inline size_t outside_range(const float* const* points, const float* center, float limit, size_t begin, size_t end) {
+        typename F::V middle[3] = { F::set1(center[0]), F::set1(center[1]), F::set1(center[2]) };
+        const typename F::V bound = F::set1(limit);
+        for (size_t i = begin; i + F::W <= end; i += F::W) {
+            typename F::V d2 = distance2<F>(F::loadu(points[0] + i), F::loadu(points[1] + i), F::loadu(points[2] + i), middle);
+            uint32_t bits = F::bits(F::gt(d2, bound));
+            if (bits == 0) continue;
+            for (size_t lane = 0; lane < F::W; lane++) {
+                if (bits & (1u << lane)) return i + lane;
+            }
+        }
+        return end;
+    }
+
+    /**
+     * Grows `low` and `high` to the component-wise minimum and maximum of points [begin, end)
+     * of SoA streams
+     */
+    static void extents(const float* const* points, float* low, float* high, size_t begin, size_t end) {
+        size_t main = end - (end - begin) % F32::W;
+        extents_range<F32>(points, low, high, begin, main);
+        extents_range<F1>(points, low, high, main, end);
+    }
+
+    /**
+     * Like `extents`, for packed (x, y, z) points
+     */
+    static void extents_aos(const float* points, float* low, float* high, size_t begin, size_t end) {
+        size_t main = end - (end - begin) % F32::W;
+        extents_aos_range<F32>(points, low, high, begin, main);
+        extents_aos_range<F1>(points, low, high, main, end);
+    }
+
+    /**
+     * Finds the point in [begin, end) furthest from `center`, if it's further than `best`
+     * (a squared distance). Ties go to the lowest index.
+     */
+    static void farthest(const float* const* points, const float* center, float& best, size_t& best_index, size_t begin, size_t end) {
+        size_t main = end - (end - begin) % F32::W;
+        farthest_range<F32>(points, center, best, best_index, begin, main);
+        farthest_range<F1>(points, center, best, best_index, main, end);
+    }
+
+    /**
+     * Finds the first point in [begin, end) whose squared distance from `center` is over
+     * `limit`, or returns `end` if there isn't one
+     */
+    static size_t outside(const float* const* points, const float* center, float limit, size_t begin, size_t end) {
+        size_t main = end - (end - begin) % F32::W;
+        size_t found = outside_range<F32>(points, center, limit, begin, main);
+        return found != main ? found : outside_range<F1>(points, center, limit, main, end);
+    }
+
+}
@@ -0,0 +1,124 @@
+// Batch approximations of trig functions, compiled once per target by foreach_target.h. The
+// polynomials and range reduction are the same as the scalar ones in utils/fast_math.h.
+
+namespace e3d::simd::E3D_SIMD_NS::fast_math {
+
+    /**
+     * Rounds to the nearest integer (ties to even), for |x| < 2^22
+     */
+    template<class F>
+    static inline typename F::V round(typename F::V x) {
+        const typename F::V magic = F::set1(12582912.0f);
+        return F::sub(F::add(x, magic), magic);
+    }
+
+    template<class F>
+    static inline void sincos_at(typename F::V x, typename F::V& s, typename F::V& c) {
+        using V = typename F::V;
+
+        // Reduce into [-pi/4, pi/4] by the nearest multiple of pi/2, in three parts so the
+        // products are exact
+        V q = round<F>(F::mul(x, F::set1(0.636619772f)));
+        V r = F::fnmadd(q, F::set1(1.5703125f), x);
+        r = F::fnmadd(q, F::set1(4.837512969970703125e-4f), r);
+        r = F::fnmadd(q, F::set1(7.54978995489188216e-8f), r);
+
+        // Past 2^16 multiples the reduction isn't exact, so those give NaN like the scalar one
+        r = F::select(F::lt(F::abs(q), F::set1(65536.0f)), r, F::set1(std::numeric_limits<float>::quiet_NaN()));
+
+        // The quadrant is q mod 4
+        V quarter = F::mul(q, F::set1(0.25f));
+        V whole = round<F>(quarter);
+        whole = F::select(F::gt(whole, quarter), F::sub(whole, F::set1(1.0f)), whole);
+        V quadrant = F::fnmadd(whole, F::set1(4.0f), q);
+
+        // Evaluate both polynomials, then swap and negate them for the quadrant
+        V z = F::mul(r, r);
+        V sin_r = F::fmadd(F::fmadd(F::fmadd(F::set1(-1.9515295891e-4f), z, F::set1(8.3321608736e-3f)), z, F::set1(-1.6666654611e-1f)), F::mul(z, r), r);
+        V cos_r = F::fmadd(F::fmadd(F::fmadd(F::set1(2.443315711809948e-5f), z, F::set1(-1.388731625493765e-3f)), z, F::set1(4.166664568298827e-2f)),
+            F::mul(z, z), F::fnmadd(F::set1(0.5f), z, F::set1(1.0f)));
+        typename F::M one = F::eq(quadrant, F::set1(1.0f)), two = F::eq(quadrant, F::set1(2.0f)), three = F::eq(quadrant, F::set1(3.0f));
+        typename F::M odd = F::m_or(one, three);
+        V sin_x = F::select(odd, cos_r, sin_r), cos_x = F::select(odd, sin_r, cos_r);
+        s = F::select(F::m_or(two, three), F::neg(sin_x), sin_x);
+        c = F::select(F::m_or(one, two), F::neg(cos_x), cos_x);
+
+    }
+
+    template<class F>
+    static inline void sincos_range(const float* x, float* s, float* c, size_t begin, size_t end) {
+        for (size_t i = begin; i + F::W <= end; i += F::W) {
+            typename F::V sin_x, cos_x;
+            sincos_at<F>(F::loadu(x + i), sin_x, cos_x);
+            F::storeu(s + i, sin_x);
+            F::storeu(c + i, cos_x);
+        }
+    }
+
+    template<class F>
+    static inline void acos_range(const float* x, float* out, size_t begin, size_t end) {
+        using V = typename F::V;
+        for (size_t i = begin; i + F::W <= end; i += F::W) {
+
+            // sqrt(1 - |x|) times a polynomial, mirrored for negative x
+            V value = F::loadu(x + i), a = F::abs(value);
+            V p = F::fmadd(F::set1(-0.0012624911f), a, F::set1(0.0066700901f));
+            p = F::fmadd(p, a, F::set1(-0.0170881256f));
+            p = F::fmadd(p, a, F::set1(0.0308918810f));
+            p = F::fmadd(p, a, F::set1(-0.0501743046f));
+            p = F::fmadd(p, a, F::set1(0.0889789874f));
+            p = F::fmadd(p, a, F::set1(-0.2145988016f));
+            p = F::fmadd(p, a, F::set1(1.5707963050f));
+            V result = F::mul(F::sqrt(F::sub(F::set1(1.0f), a)), p);
+            F::storeu(out + i, F::select(F::lt(value, F::zero()), F::sub(F::set1(3.14159265f), result), result));
+
+        }
+    }
+
+    template<class F>
+    static inline void atan2_range(const float* y, const float* x, float* out, size_t begin, size_t end) {
+        using V = typename F::V;
+        for (size_t i = begin; i + F::W <= end; i += F::W) {
+
+            // The arc tangent of the smaller over the larger, so the ratio is in [0, 1]
+            V value_y = F::loadu(y + i), value_x = F::loadu(x + i);
+            V abs_y = F::abs(value_y), abs_x = F::abs(value_x);
+            V high = F::max(abs_x, abs_y);
+            V a = F::select(F::eq(high, F::zero()), F::zero(), F::div(F::min(abs_x, abs_y), high));
+            V z = F::mul(a, a);
+            V p = F::fmadd(F::set1(0.0028662257f), z, F::set1(-0.0161657367f));
+            p = F::fmadd(p, z, F::set1(0.0429096138f));
+            p = F::fmadd(p, z, F::set1(-0.0752896400f));
+            p = F::fmadd(p, z, F::set1(0.1065626393f));
+            p = F::fmadd(p, z, F::set1(-0.1420889944f));
+            p = F::fmadd(p, z, F::set1(0.1999355085f));
+            p = F::fmadd(p, z, F::set1(-0.3333314528f));
+            V t = F::fmadd(F::mul(p, z), a, a);
+
+            // Then unfold it into the right octant
+            t = F::select(F::gt(abs_y, abs_x), F::sub(F::set1(1.57079633f), t), t);
+            t = F::select(F::lt(value_x, F::zero()), F::sub(F::set1(3.14159265f), t), t);
+            F::storeu(out + i, F::select(F::lt(value_y, F::zero()), F::neg(t), t));
+
+        }
+    }
+
+    static void sincos(const float* x, float* s, float* c, size_t begin, size_t end) {
+        size_t main = end - (end - begin) % F32::W;
+        sincos_range<F32>(x, s, c, begin, main);
+        sincos_range<F1>(x, s, c, main, end);
+    }
+
+    static void acos(const float* x, float* out, size_t begin, size_t end) {
+        size_t main = end - (end - begin) % F32::W;
+        acos_range<F32>(x, out, begin, main);
+        acos_range<F1>(x, out, main, end);
+    }
+
+    static void atan2(const float* y, const float* x, float* out, size_t begin, size_t end) {
+        size_t main = end - (end - begin) % F32::W;
+        atan2_range<F32>(y, x, out, begin, main);
+        atan2_range<F1>(y, x, out, main, end);
+    }
+
+}
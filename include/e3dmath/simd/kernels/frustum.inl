@@ -0,0 +1,92 @@
+// Frustum culling kernels, compiled once per target by foreach_target.h. A register of
+// bounding volumes is tested against all six planes at once, and the indices of the visible
+// ones are written out in order.
+
+namespace e3d::simd::E3D_SIMD_NS::frustum {
+
+    /**
+     * The signed distance of W points from a plane (a, b, c, d), in the same order of
+     * operations as utils::frustum::distance
+     */
+    template<class F>
+    static inline typename F::V distance(const float* plane, typename F::V x, typename F::V y, typename F::V z) {
+        typename F::V result = F::fmadd(F::set1(plane[0]), x, F::set1(plane[3]));
+        result = F::fmadd(F::set1(plane[1]), y, result);
+        return F::fmadd(F::set1(plane[2]), z, result);
+    }
+
+    /**
+     * Appends the indices of the lanes in `bits` to `out`, without branching on each lane
+     */
+    template<class F>
+    static inline size_t append(uint32_t bits, size_t i, uint32_t* out, size_t count) {
+        for (size_t lane = 0; lane < F::W; lane++) {
+            out[count] = uint32_t(i + lane);
+            count += (bits >> lane) & 1;
+        }
+        return count;
+    }
+
+    template<class F>
+    static inline size_t spheres_range(const float* planes, const float* const* centers, const float* radii,
+        uint32_t* out, size_t count, size_t begin, size_t end) {
+        for (size_t i = begin; i + F::W <= end; i += F::W) {
+
+            // A sphere is culled if it's entirely behind any plane
+            typename F::V x = F::loadu(centers[0] + i), y = F::loadu(centers[1] + i), z = F::loadu(centers[2] + i);
+            typename F::V limit = F::neg(F::loadu(radii + i));
+            typename F::M visible = F::ge(distance<F>(planes, x, y, z), limit);
+            for (int p = 1; p < 6; p++) {
+                visible = F::m_and(visible, F::ge(distance<F>(planes + p * 4, x, y, z), limit));
+            }
+            count = append<F>(F::bits(visible), i, out, count);
+
+        }
+        return count;
+    }
+
+    template<class F>
+    static inline size_t boxes_range(const float* planes, const float* const* mins, const float* const* maxs,
+        uint32_t* out, size_t count, size_t begin, size_t end) {
+
+        // A box is culled if its corner furthest along a plane's normal is behind it, so find
+        // which of the min and max streams make up that corner for each plane
+        const float* corners[6][3];
+        for (int p = 0; p < 6; p++) {
+            for (int c = 0; c < 3; c++) corners[p][c] = planes[p * 4 + c] >= 0 ? maxs[c] : mins[c];
+        }
+
+        for (size_t i = begin; i + F::W <= end; i += F::W) {
+            typename F::M visible;
+            for (int p = 0; p < 6; p++) {
+                typename F::V x = F::loadu(corners[p][0] + i), y = F::loadu(corners[p][1] + i), z = F::loadu(corners[p][2] + i);
+                typename F::M inside = F::ge(distance<F>(planes + p * 4, x, y, z), F::zero());
+                visible = p == 0 ? inside : F::m_and(visible, inside);
+            }
+            count = append<F>(F::bits(visible), i, out, count);
+        }
+        return count;
+
+    }
+
+    /**
+     * Writes the index of each sphere in [begin, end) that's at least partly inside the
+     * frustum to `out`, in order, and returns how many there were. `out` needs room for
+     * end - begin indices.
+     */
+    static size_t spheres(const float* planes, const float* const* centers, const float* radii, uint32_t* out, size_t begin, size_t end) {
+        size_t main = end - (end - begin) % F32::W;
+        size_t count = spheres_range<F32>(planes, centers, radii, out, 0, begin, main);
+        return spheres_range<F1>(planes, centers, radii, out, count, main, end);
+    }
+
+    /**
+     * Like `spheres`, for axis-aligned boxes given by their minimum and maximum corners
+     */
+    static size_t boxes(const float* planes, const float* const* mins, const float* const* maxs, uint32_t* out, size_t begin, size_t end) {
+        size_t main = end - (end - begin) % F32::W;
+        size_t count = boxes_range<F32>(planes, mins, maxs, out, 0, begin, main);
+        return boxes_range<F1>(planes, mins, maxs, out, count, main, end);
+    }
+
+}
@@ -0,0 +1,223 @@
+// Batch matrix kernels over one stream per element (see types/mat_batch.h), compiled once per
+// target by foreach_target.h. Each lane holds a different matrix, so the closed-form
+// determinants and inverses of utils::mat run on W matrices at once, with no shuffles.
+//
+// GCC contracts a * b - c * d into a fused multiply-add wherever FMA is enabled, which rounds
+// differently from utils::mat and leaves exactly singular matrices with tiny non-zero
+// determinants. Contraction is turned off for these kernels, so only the explicit F::fmadd
+// calls in the products fuse.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC push_options
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+namespace e3d::simd::E3D_SIMD_NS::mat_batch {
+
+    template<class F, uint8_t R, uint8_t K, uint8_t C>
+    static inline void multiply_range(const float* const* left, const float* const* right, float* const* out, size_t begin, size_t end) {
+        using V = typename F::V;
+        for (size_t i = begin; i + F::W <= end; i += F::W) {
+
+            // Load the right-hand matrices whole, and the left-hand ones a row at a time, so
+            // the output may be either input
+            V b[K * C];
+            for (int j = 0; j < K * C; j++) b[j] = F::loadu(right[j] + i);
+            for (uint8_t r = 0; r < R; r++) {
+                V a[K];
+                for (uint8_t k = 0; k < K; k++) a[k] = F::loadu(left[r * K + k] + i);
+
+                // Sum in the same order as Mat::multiply
+                for (uint8_t c = 0; c < C; c++) {
+                    V sum = F::zero();
+                    for (uint8_t k = 0; k < K; k++) sum = F::fmadd(a[k], b[k * C + c], sum);
+                    F::storeu(out[r * C + c] + i, sum);
+                }
+
+            }
+
+        }
+    }
+
+    template<class F, uint8_t R, uint8_t C>
+    static inline void transform_range(const float* const* mats, const float* const* vecs, float* const* out, size_t begin, size_t end) {
+        using V = typename F::V;
+        for (size_t i = begin; i + F::W <= end; i += F::W) {
+            V v[C];
+            for (uint8_t c = 0; c < C; c++) v[c] = F::loadu(vecs[c] + i);
+            for (uint8_t r = 0; r < R; r++) {
+                V sum = F::zero();
+                for (uint8_t c = 0; c < C; c++) sum = F::fmadd(F::loadu(mats[r * C + c] + i), v[c], sum);
+                F::storeu(out[r] + i, sum);
+            }
+        }
+    }
+
+    /**
+     * The 2x2 sub-determinants of the top two rows (`s`) and bottom two rows (`c`) of 4x4
+     * matrices, as in utils::mat::determinant
+     */
+    template<class F>
+    static inline void blocks4(const typename F::V* m, typename F::V* s, typename F::V* c) {
+        s[0] = F::sub(F::mul(m[0], m[5]), F::mul(m[4], m[1]));
+        s[1] = F::sub(F::mul(m[0], m[6]), F::mul(m[4], m[2]));
+        s[2] = F::sub(F::mul(m[0], m[7]), F::mul(m[4], m[3]));
+        s[3] = F::sub(F::mul(m[1], m[6]), F::mul(m[5], m[2]));
+        s[4] = F::sub(F::mul(m[1], m[7]), F::mul(m[5], m[3]));
+        s[5] = F::sub(F::mul(m[2], m[7]), F::mul(m[6], m[3]));
+        c[5] = F::sub(F::mul(m[10], m[15]), F::mul(m[14], m[11]));
+        c[4] = F::sub(F::mul(m[9], m[15]), F::mul(m[13], m[11]));
+        c[3] = F::sub(F::mul(m[9], m[14]), F::mul(m[13], m[10]));
+        c[2] = F::sub(F::mul(m[8], m[15]), F::mul(m[12], m[11]));
+        c[1] = F::sub(F::mul(m[8], m[14]), F::mul(m[12], m[10]));
+        c[0] = F::sub(F::mul(m[8], m[13]), F::mul(m[12], m[9]));
+    }
+
+    template<class F>
+    static inline typename F::V combine4(const typename F::V* s, const typename F::V* c) {
+        typename F::V det = F::mul(s[0], c[5]);
+        det = F::sub(det, F::mul(s[1], c[4]));
+        det = F::add(det, F::mul(s[2], c[3]));
+        det = F::add(det, F::mul(s[3], c[2]));
+        det = F::sub(det, F::mul(s[4], c[1]));
+        return F::add(det, F::mul(s[5], c[0]));
+    }
+
+    /**
+     * An element of a 4x4 adjugate: x * p - y * q + z * r, scaled by the inverse determinant
+     */
+    template<class F>
+    static inline typename F::V minor4(typename F::V x, typename F::V p, typename F::V y, typename F::V q, typename F::V z, typename F::V r, typename F::V inv) {
+        return F::mul(F::add(F::sub(F::mul(x, p), F::mul(y, q)), F::mul(z, r)), inv);
+    }
+
+    template<class F, uint8_t R>
+    static inline typename F::V determinant_at(const typename F::V* m) {
+        if constexpr (R == 2) {
+            return F::sub(F::mul(m[0], m[3]), F::mul(m[1], m[2]));
+        } else if constexpr (R == 3) {
+            typename F::V det = F::mul(m[0], F::sub(F::mul(m[4], m[8]), F::mul(m[5], m[7])));
+            det = F::sub(det, F::mul(m[1], F::sub(F::mul(m[3], m[8]), F::mul(m[5], m[6]))));
+            return F::add(det, F::mul(m[2], F::sub(F::mul(m[3], m[7]), F::mul(m[4], m[6]))));
+        } else {
+            typename F::V s[6], c[6];
+            blocks4<F>(m, s, c);
+            return combine4<F>(s, c);
+        }
+    }
+
+    template<class F, uint8_t R>
+    static inline void determinant_range(const float* const* mats, float* out, size_t begin, size_t end) {
+        for (size_t i = begin; i + F::W <= end; i += F::W) {
+            typename F::V m[R * R];
+            for (int j = 0; j < R * R; j++) m[j] = F::loadu(mats[j] + i);
+            F::storeu(out + i, determinant_at<F, R>(m));
+        }
+    }
+
+    template<class F, uint8_t R>
+    static inline size_t inverse_range(const float* const* mats, float* const* out, size_t begin, size_t end) {
+        using V = typename F::V;
+        size_t singular = 0;
+        for (size_t i = begin; i + F::W <= end; i += F::W) {
+            V m[R * R], result[R * R];
+            for (int j = 0; j < R * R; j++) m[j] = F::loadu(mats[j] + i);
+
+            V det;
+            if constexpr (R == 4) {
+                V s[6], c[6];
+                blocks4<F>(m, s, c);
+                det = combine4<F>(s, c);
+                V inv = F::div(F::set1(1.0f), det);
+
+                // Each element of the adjugate is a 3x3 minor, expanded over the blocks
+                result[0] = minor4<F>(m[5], c[5], m[6], c[4], m[7], c[3], inv);
+                result[1] = minor4<F>(F::neg(m[1]), c[5], F::neg(m[2]), c[4], F::neg(m[3]), c[3], inv);
+                result[2] = minor4<F>(m[13], s[5], m[14], s[4], m[15], s[3], inv);
+                result[3] = minor4<F>(F::neg(m[9]), s[5], F::neg(m[10]), s[4], F::neg(m[11]), s[3], inv);
+                result[4] = minor4<F>(F::neg(m[4]), c[5], F::neg(m[6]), c[2], F::neg(m[7]), c[1], inv);
+                result[5] = minor4<F>(m[0], c[5], m[2], c[2], m[3], c[1], inv);
+                result[6] = minor4<F>(F::neg(m[12]), s[5], F::neg(m[14]), s[2], F::neg(m[15]), s[1], inv);
+                result[7] = minor4<F>(m[8], s[5], m[10], s[2], m[11], s[1], inv);
+                result[8] = minor4<F>(m[4], c[4], m[5], c[2], m[7], c[0], inv);
+                result[9] = minor4<F>(F::neg(m[0]), c[4], F::neg(m[1]), c[2], F::neg(m[3]), c[0], inv);
+                result[10] = minor4<F>(m[12], s[4], m[13], s[2], m[15], s[0], inv);
+                result[11] = minor4<F>(F::neg(m[8]), s[4], F::neg(m[9]), s[2], F::neg(m[11]), s[0], inv);
+                result[12] = minor4<F>(F::neg(m[4]), c[3], F::neg(m[5]), c[1], F::neg(m[6]), c[0], inv);
+                result[13] = minor4<F>(m[0], c[3], m[1], c[1], m[2], c[0], inv);
+                result[14] = minor4<F>(F::neg(m[12]), s[3], F::neg(m[13]), s[1], F::neg(m[14]), s[0], inv);
+                result[15] = minor4<F>(m[8], s[3], m[9], s[1], m[10], s[0], inv);
+
+            } else if constexpr (R == 3) {
+
+                // Cofactors of the first row double as the terms of the determinant
+                V c00 = F::sub(F::mul(m[4], m[8]), F::mul(m[5], m[7]));
+                V c01 = F::sub(F::mul(m[5], m[6]), F::mul(m[3], m[8]));
+                V c02 = F::sub(F::mul(m[3], m[7]), F::mul(m[4], m[6]));
+                det = F::add(F::add(F::mul(m[0], c00), F::mul(m[1], c01)), F::mul(m[2], c02));
+                V inv = F::div(F::set1(1.0f), det);
+
+                // The inverse is the transposed cofactor matrix over the determinant
+                result[0] = F::mul(c00, inv);
+                result[1] = F::mul(F::sub(F::mul(m[2], m[7]), F::mul(m[1], m[8])), inv);
+                result[2] = F::mul(F::sub(F::mul(m[1], m[5]), F::mul(m[2], m[4])), inv);
+                result[3] = F::mul(c01, inv);
+                result[4] = F::mul(F::sub(F::mul(m[0], m[8]), F::mul(m[2], m[6])), inv);
+                result[5] = F::mul(F::sub(F::mul(m[2], m[3]), F::mul(m[0], m[5])), inv);
+                result[6] = F::mul(c02, inv);
+                result[7] = F::mul(F::sub(F::mul(m[1], m[6]), F::mul(m[0], m[7])), inv);
+                result[8] = F::mul(F::sub(F::mul(m[0], m[4]), F::mul(m[1], m[3])), inv);
+
+            } else {
+
+                // Swap the diagonal, negate the rest and divide by the determinant
+                det = determinant_at<F, 2>(m);
+                V inv = F::div(F::set1(1.0f), det);
+                result[0] = F::mul(m[3], inv);
+                result[1] = F::mul(F::neg(m[1]), inv);
+                result[2] = F::mul(F::neg(m[2]), inv);
+                result[3] = F::mul(m[0], inv);
+
+            }
+
+            // Singular matrices invert to zero, like utils::mat::inverse, and are counted
+            typename F::M invertible = F::m_not(F::eq(det, F::zero()));
+            uint32_t bits = F::bits(invertible);
+            for (size_t lane = 0; lane < F::W; lane++) singular += ((bits >> lane) & 1) ^ 1;
+            for (int j = 0; j < R * R; j++) F::storeu(out[j] + i, F::select(invertible, result[j], F::zero()));
+
+        }
+        return singular;
+    }
+
+    template<uint8_t R, uint8_t K, uint8_t C>
+    static void multiply(const float* const* left, const float* const* right, float* const* out, size_t count) {
+        size_t main = count - count % F32::W;
+        multiply_range<F32, R, K, C>(left, right, out, 0, main);
+        multiply_range<F1, R, K, C>(left, right, out, main, count);
+    }
+
+    template<uint8_t R, uint8_t C>
+    static void transform(const float* const* mats, const float* const* vecs, float* const* out, size_t count) {
+        size_t main = count - count % F32::W;
+        transform_range<F32, R, C>(mats, vecs, out, 0, main);
+        transform_range<F1, R, C>(mats, vecs, out, main, count);
+    }
+
+    template<uint8_t R>
+    static void determinant(const float* const* mats, float* out, size_t count) {
+        size_t main = count - count % F32::W;
+        determinant_range<F32, R>(mats, out, 0, main);
+        determinant_range<F1, R>(mats, out, main, count);
+    }
+
+    template<uint8_t R>
+    static size_t inverse(const float* const* mats, float* const* out, size_t count) {
+        size_t main = count - count % F32::W;
+        return inverse_range<F32, R>(mats, out, 0, main) + inverse_range<F1, R>(mats, out, main, count);
+    }
+
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC pop_options
+#endif
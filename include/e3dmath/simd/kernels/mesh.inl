@@ -0,0 +1,132 @@
+// Per-triangle kernels over indexed meshes, compiled once per target by foreach_target.h.
+// Vertices are gathered through the index buffer, then the math runs a full register of
+// triangles at once.
+
+namespace e3d::simd::E3D_SIMD_NS::mesh {
+
+    /**
+     * Loads one component of corner `corner` for the W triangles starting at `tri`
+     */
+    template<class F>
+    static inline typename F::V gather(const float* component, const uint32_t* indices, size_t tri, int corner) {
+        return F::gather(component, indices + tri * 3 + corner, 3);
+    }
+
+    /**
+     * Loads the two edges leaving the first corner of W triangles
+     */
+    template<class F>
+    static inline void edges(const float* const* positions, const uint32_t* indices, size_t tri, typename F::V* e1, typename F::V* e2) {
+        for (int c = 0; c < 3; c++) {
+            typename F::V p0 = gather<F>(positions[c], indices, tri, 0);
+            e1[c] = F::sub(gather<F>(positions[c], indices, tri, 1), p0);
+            e2[c] = F::sub(gather<F>(positions[c], indices, tri, 2), p0);
+        }
+    }
+
+    template<class F>
+    static inline void face_normals_range(const float* const* positions, const uint32_t* indices, float* const* out, bool normalize, size_t begin, size_t end) {
+        const typename F::V epsilon = F::set1(0.00001f);
+        for (size_t i = begin; i + F::W <= end; i += F::W) {
+
+            // The cross product of the edges, whose length is twice the area
+            typename F::V e1[3], e2[3];
+            edges<F>(positions, indices, i, e1, e2);
+            typename F::V n[3] = {
+                F::sub(F::mul(e1[1], e2[2]), F::mul(e1[2], e2[1])),
+                F::sub(F::mul(e1[2], e2[0]), F::mul(e1[0], e2[2])),
+                F::sub(F::mul(e1[0], e2[1]), F::mul(e1[1], e2[0])),
+            };
+
+            // Scale to unit length, with degenerate triangles getting a zero normal
+            if (normalize) {
+                typename F::V mag = F::sqrt(F::fmadd(n[2], n[2], F::fmadd(n[1], n[1], F::mul(n[0], n[0]))));
+                typename F::V scale = F::select(F::gt(mag, epsilon), F::div(F::set1(1.0f), mag), F::zero());
+                for (int c = 0; c < 3; c++) n[c] = F::mul(n[c], scale);
+            }
+            for (int c = 0; c < 3; c++) F::storeu(out[c] + i, n[c]);
+
+        }
+    }
+
+    template<class F>
+    static inline float face_areas_range(const float* const* positions, const uint32_t* indices, float* out, size_t begin, size_t end) {
+        const typename F::V half = F::set1(0.5f);
+        typename F::V total = F::zero();
+        for (size_t i = begin; i + F::W <= end; i += F::W) {
+
+            // Half the length of the cross product of the edges
+            typename F::V e1[3], e2[3];
+            edges<F>(positions, indices, i, e1, e2);
+            typename F::V n[3] = {
+                F::sub(F::mul(e1[1], e2[2]), F::mul(e1[2], e2[1])),
+                F::sub(F::mul(e1[2], e2[0]), F::mul(e1[0], e2[2])),
+                F::sub(F::mul(e1[0], e2[1]), F::mul(e1[1], e2[0])),
+            };
+            typename F::V area = F::mul(F::sqrt(F::fmadd(n[2], n[2], F::fmadd(n[1], n[1], F::mul(n[0], n[0])))), half);
+            if (out != nullptr) F::storeu(out + i, area);
+            total = F::add(total, area);
+
+        }
+        return F::reduce_add(total);
+    }
+
+    template<class F>
+    static inline void face_tangents_range(const float* const* positions, const float* const* uvs, const uint32_t* indices,
+        float* const* s_out, float* const* t_out, size_t begin, size_t end) {
+        for (size_t i = begin; i + F::W <= end; i += F::W) {
+
+            // The position and texture coordinate edges
+            typename F::V e1[3], e2[3];
+            edges<F>(positions, indices, i, e1, e2);
+            typename F::V uv0[2], uv1[2], uv2[2];
+            for (int c = 0; c < 2; c++) {
+                uv0[c] = gather<F>(uvs[c], indices, i, 0);
+                uv1[c] = F::sub(gather<F>(uvs[c], indices, i, 1), uv0[c]);
+                uv2[c] = F::sub(gather<F>(uvs[c], indices, i, 2), uv0[c]);
+            }
+
+            // Solve for the directions of increasing u and v, skipping triangles with no UV area
+            typename F::V det = F::sub(F::mul(uv1[0], uv2[1]), F::mul(uv2[0], uv1[1]));
+            typename F::M valid = F::m_not(F::eq(det, F::zero()));
+            typename F::V r = F::select(valid, F::div(F::set1(1.0f), det), F::zero());
+            for (int c = 0; c < 3; c++) {
+                F::storeu(s_out[c] + i, F::mul(F::sub(F::mul(e1[c], uv2[1]), F::mul(e2[c], uv1[1])), r));
+                F::storeu(t_out[c] + i, F::mul(F::sub(F::mul(e2[c], uv1[0]), F::mul(e1[c], uv2[0])), r));
+            }
+
+        }
+    }
+
+    /**
+     * Calculates the unit normal of each triangle in [begin, end). If `normalize` is false
+     * the cross product of the edges is kept as is, with a length of twice the area.
+     */
+    static void face_normals(const float* const* positions, const uint32_t* indices, float* const* out, bool normalize, size_t begin, size_t end) {
+        size_t main = end - (end - begin) % F32::W;
+        face_normals_range<F32>(positions, indices, out, normalize, begin, main);
+        face_normals_range<F1>(positions, indices, out, normalize, main, end);
+    }
+
+    /**
+     * Calculates the area of each triangle in [begin, end) into `out` (unless it's null), and
+     * returns their sum
+     */
+    static float face_areas(const float* const* positions, const uint32_t* indices, float* out, size_t begin, size_t end) {
+        size_t main = end - (end - begin) % F32::W;
+        float total = face_areas_range<F32>(positions, indices, out, begin, main);
+        return total + face_areas_range<F1>(positions, indices, out, main, end);
+    }
+
+    /**
+     * Calculates the directions of increasing u (`s_out`) and v (`t_out`) across each
+     * triangle in [begin, end)
+     */
+    static void face_tangents(const float* const* positions, const float* const* uvs, const uint32_t* indices,
+        float* const* s_out, float* const* t_out, size_t begin, size_t end) {
+        size_t main = end - (end - begin) % F32::W;
+        face_tangents_range<F32>(positions, uvs, indices, s_out, t_out, begin, main);
+        face_tangents_range<F1>(positions, uvs, indices, s_out, t_out, main, end);
+    }
+
+}
@@ -0,0 +1,83 @@
+// Batch polygon area kernels, compiled once per target by foreach_target.h. Polygons are read
+// straight from arrays of Polygon<P, S> (P * S floats each) with strided loads, and the math
+// runs a full register of polygons at once.
+
+namespace e3d::simd::E3D_SIMD_NS::polygon {
+
+    /**
+     * Loads component `c` of point `point`, relative to the first point, for the W polygons
+     * starting at `i`
+     */
+    template<class F, uint8_t P, uint8_t S>
+    static inline typename F::V relative(const float* polys, size_t i, uint8_t point, uint8_t c) {
+        const float* first = polys + i * P * S + c;
+        return F::sub(F::load_strided(first + point * S, P * S), F::load_strided(first, P * S));
+    }
+
+    /**
+     * Twice the signed area of W 2D polygons, by the shoelace formula fanned from the first
+     * point
+     */
+    template<class F, uint8_t P>
+    static inline typename F::V shoelace(const float* polys, size_t i) {
+        typename F::V sum = F::zero();
+        typename F::V a_x = relative<F, P, 2>(polys, i, 1, 0), a_y = relative<F, P, 2>(polys, i, 1, 1);
+        for (uint8_t p = 2; p < P; p++) {
+            typename F::V b_x = relative<F, P, 2>(polys, i, p, 0), b_y = relative<F, P, 2>(polys, i, p, 1);
+            sum = F::add(sum, F::sub(F::mul(a_x, b_y), F::mul(b_x, a_y)));
+            a_x = b_x;
+            a_y = b_y;
+        }
+        return sum;
+    }
+
+    /**
+     * Twice the area of W planar 3D polygons: the length of the sum of the cross products
+     * fanned from the first point
+     */
+    template<class F, uint8_t P>
+    static inline typename F::V vector_area(const float* polys, size_t i) {
+        typename F::V n[3] = { F::zero(), F::zero(), F::zero() };
+        typename F::V a[3], b[3];
+        for (uint8_t c = 0; c < 3; c++) a[c] = relative<F, P, 3>(polys, i, 1, c);
+        for (uint8_t p = 2; p < P; p++) {
+            for (uint8_t c = 0; c < 3; c++) b[c] = relative<F, P, 3>(polys, i, p, c);
+            n[0] = F::add(n[0], F::sub(F::mul(a[1], b[2]), F::mul(a[2], b[1])));
+            n[1] = F::add(n[1], F::sub(F::mul(a[2], b[0]), F::mul(a[0], b[2])));
+            n[2] = F::add(n[2], F::sub(F::mul(a[0], b[1]), F::mul(a[1], b[0])));
+            for (uint8_t c = 0; c < 3; c++) a[c] = b[c];
+        }
+        return F::sqrt(F::fmadd(n[2], n[2], F::fmadd(n[1], n[1], F::mul(n[0], n[0]))));
+    }
+
+    template<class F, uint8_t P, uint8_t S>
+    static inline float area_range(const float* polys, bool sign, float* out, size_t begin, size_t end) {
+        const typename F::V half = F::set1(0.5f);
+        typename F::V total = F::zero();
+        for (size_t i = begin; i + F::W <= end; i += F::W) {
+            typename F::V area;
+            if constexpr (S == 2) {
+                area = F::mul(shoelace<F, P>(polys, i), half);
+                if (!sign) area = F::abs(area);
+            } else {
+                area = F::mul(vector_area<F, P>(polys, i), half);
+            }
+            if (out != nullptr) F::storeu(out + i, area);
+            total = F::add(total, area);
+        }
+        return F::reduce_add(total);
+    }
+
+    /**
+     * Calculates the area of each polygon in [begin, end) into `out` (unless it's null), and
+     * returns their sum. 2D polygons keep their sign if `sign` is set, positive when the
+     * points are counter-clockwise.
+     */
+    template<uint8_t P, uint8_t S>
+    static float area(const float* polys, bool sign, float* out, size_t begin, size_t end) {
+        size_t main = end - (end - begin) % F32::W;
+        float total = area_range<F32, P, S>(polys, sign, out, begin, main);
+        return total + area_range<F1, P, S>(polys, sign, out, main, end);
+    }
+
+}
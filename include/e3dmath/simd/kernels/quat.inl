@@ -0,0 +1,140 @@
+// Batch quaternion kernels over arrays of (x, y, z, w), compiled once per target by
+// foreach_target.h
+
+namespace e3d::simd::E3D_SIMD_NS::quat {
+
+    /**
+     * The number of terms in the slerp polynomial, and the correction applied to the last one.
+     * With these the weights are within 2e-7 of sin(t * theta) / sin(theta).
+     */
+    constexpr int slerp_terms = 16;
+    constexpr float slerp_mu = 1.9166713f;
+
+    template<class F>
+    static inline typename F::V dot(typename F::V ax, typename F::V ay, typename F::V az, typename F::V aw,
+        typename F::V bx, typename F::V by, typename F::V bz, typename F::V bw) {
+        return F::fmadd(aw, bw, F::fmadd(az, bz, F::fmadd(ay, by, F::mul(ax, bx))));
+    }
+
+    /**
+     * Loads the blend weights at `i`, or broadcasts the only one
+     */
+    template<class F>
+    static inline typename F::V weight(const float* t, bool per_element, size_t i) {
+        return per_element ? F::loadu(t + i) : F::set1(t[0]);
+    }
+
+    template<class F>
+    static inline void multiply_range(const float* a, const float* b, float* out, size_t begin, size_t end) {
+        for (size_t i = begin; i + F::W <= end; i += F::W) {
+            typename F::V ax, ay, az, aw, bx, by, bz, bw;
+            F::load_aos4(a + i * 4, ax, ay, az, aw);
+            F::load_aos4(b + i * 4, bx, by, bz, bw);
+
+            // The same sums, in the same order, as Quat::multiply
+            typename F::V x = F::fnmadd(az, by, F::fmadd(ay, bz, F::fmadd(ax, bw, F::mul(aw, bx))));
+            typename F::V y = F::fmadd(az, bx, F::fmadd(ay, bw, F::fnmadd(ax, bz, F::mul(aw, by))));
+            typename F::V z = F::fmadd(az, bw, F::fnmadd(ay, bx, F::fmadd(ax, by, F::mul(aw, bz))));
+            typename F::V w = F::fnmadd(az, bz, F::fnmadd(ay, by, F::fnmadd(ax, bx, F::mul(aw, bw))));
+            F::store_aos4(out + i * 4, x, y, z, w);
+        }
+    }
+
+    template<class F>
+    static inline void nlerp_range(const float* a, const float* b, const float* t, bool per_element, float* out, size_t begin, size_t end) {
+        const typename F::V one = F::set1(1.0f);
+        for (size_t i = begin; i + F::W <= end; i += F::W) {
+            typename F::V ax, ay, az, aw, bx, by, bz, bw;
+            F::load_aos4(a + i * 4, ax, ay, az, aw);
+            F::load_aos4(b + i * 4, bx, by, bz, bw);
+            typename F::V tv = weight<F>(t, per_element, i);
+
+            // Flip the second rotation onto the same hemisphere to take the short way around
+            typename F::V sign = F::select(F::lt(dot<F>(ax, ay, az, aw, bx, by, bz, bw), F::zero()), F::neg(one), one);
+
+            // Blend linearly, then normalize
+            typename F::V x = F::fmadd(tv, F::sub(F::mul(bx, sign), ax), ax);
+            typename F::V y = F::fmadd(tv, F::sub(F::mul(by, sign), ay), ay);
+            typename F::V z = F::fmadd(tv, F::sub(F::mul(bz, sign), az), az);
+            typename F::V w = F::fmadd(tv, F::sub(F::mul(bw, sign), aw), aw);
+            typename F::V mag = F::sqrt(dot<F>(x, y, z, w, x, y, z, w));
+            F::store_aos4(out + i * 4, F::div(x, mag), F::div(y, mag), F::div(z, mag), F::div(w, mag));
+        }
+    }
+
+    template<class F>
+    static inline void slerp_range(const float* a, const float* b, const float* t, bool per_element, float* out, size_t begin, size_t end) {
+
+        // Coefficients of the polynomial, from "A Fast and Accurate Algorithm for Computing
+        // SLERP" (Eberly), with more terms for float precision over the whole half-circle
+        typename F::V u[slerp_terms], v[slerp_terms];
+        for (int k = 0; k < slerp_terms; k++) {
+            float scale = k + 1 == slerp_terms ? slerp_mu : 1.0f;
+            u[k] = F::set1(scale / float((k + 1) * (2 * k + 3)));
+            v[k] = F::set1(scale * float(k + 1) / float(2 * k + 3));
+        }
+
+        const typename F::V one = F::set1(1.0f);
+        for (size_t i = begin; i + F::W <= end; i += F::W) {
+            typename F::V ax, ay, az, aw, bx, by, bz, bw;
+            F::load_aos4(a + i * 4, ax, ay, az, aw);
+            F::load_aos4(b + i * 4, bx, by, bz, bw);
+            typename F::V tv = weight<F>(t, per_element, i);
+
+            // Take the short way around, so the cosine is never negative
+            typename F::V cos_theta = dot<F>(ax, ay, az, aw, bx, by, bz, bw);
+            typename F::M flip = F::lt(cos_theta, F::zero());
+            typename F::V sign = F::select(flip, F::neg(one), one);
+            cos_theta = F::abs(cos_theta);
+
+            // Evaluate sin(t * theta) / sin(theta) for t and for 1 - t, from the innermost term out
+            typename F::V cos_m1 = F::sub(cos_theta, one);
+            typename F::V d = F::sub(one, tv);
+            typename F::V sq_t = F::mul(tv, tv), sq_d = F::mul(d, d);
+            typename F::V b_t = F::mul(F::sub(F::mul(u[slerp_terms - 1], sq_t), v[slerp_terms - 1]), cos_m1);
+            typename F::V b_d = F::mul(F::sub(F::mul(u[slerp_terms - 1], sq_d), v[slerp_terms - 1]), cos_m1);
+            for (int k = slerp_terms - 2; k >= 0; k--) {
+                b_t = F::mul(F::mul(F::sub(F::mul(u[k], sq_t), v[k]), cos_m1), F::add(one, b_t));
+                b_d = F::mul(F::mul(F::sub(F::mul(u[k], sq_d), v[k]), cos_m1), F::add(one, b_d));
+            }
+            typename F::V weight_b = F::mul(F::mul(tv, sign), F::add(one, b_t));
+            typename F::V weight_a = F::mul(d, F::add(one, b_d));
+
+            // Blend the two rotations
+            F::store_aos4(out + i * 4,
+                F::fmadd(weight_b, bx, F::mul(weight_a, ax)),
+                F::fmadd(weight_b, by, F::mul(weight_a, ay)),
+                F::fmadd(weight_b, bz, F::mul(weight_a, az)),
+                F::fmadd(weight_b, bw, F::mul(weight_a, aw)));
+        }
+
+    }
+
+    /**
+     * Multiplies each pair of quaternions in [begin, end)
+     */
+    static void multiply(const float* a, const float* b, float* out, size_t begin, size_t end) {
+        size_t main = end - (end - begin) % F32::W;
+        multiply_range<F32>(a, b, out, begin, main);
+        multiply_range<F1>(a, b, out, main, end);
+    }
+
+    /**
+     * Normalized linear blend of each pair of quaternions in [begin, end)
+     */
+    static void nlerp(const float* a, const float* b, const float* t, bool per_element, float* out, size_t begin, size_t end) {
+        size_t main = end - (end - begin) % F32::W;
+        nlerp_range<F32>(a, b, t, per_element, out, begin, main);
+        nlerp_range<F1>(a, b, t, per_element, out, main, end);
+    }
+
+    /**
+     * Spherical linear blend of each pair of quaternions in [begin, end)
+     */
+    static void slerp(const float* a, const float* b, const float* t, bool per_element, float* out, size_t begin, size_t end) {
+        size_t main = end - (end - begin) % F32::W;
+        slerp_range<F32>(a, b, t, per_element, out, begin, main);
+        slerp_range<F1>(a, b, t, per_element, out, main, end);
+    }
+
+}
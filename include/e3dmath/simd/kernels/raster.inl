@@ -0,0 +1,94 @@
+// Rasterizer kernels, compiled once per target by foreach_target.h. Needs transform.inl to
+// have been compiled first, for its broadcast matrix.
+
+namespace e3d::simd::E3D_SIMD_NS::raster {
+
+    /**
+     * The offsets of the pixel centers in a register, from the first pixel's left edge
+     */
+    alignas(64) static const float centers[16] = {
+        0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f,
+        8.5f, 9.5f, 10.5f, 11.5f, 12.5f, 13.5f, 14.5f, 15.5f
+    };
+
+    template<class F>
+    static inline void clip_range(const float* mat, const float* const* positions, float* const* out, size_t begin, size_t end) {
+        const transform::Columns<F> cols(mat);
+        const typename F::V one = F::set1(1.0f);
+        for (size_t i = begin; i + F::W <= end; i += F::W) {
+            typename F::V r[4];
+            cols.apply4(F::loadu(positions[0] + i), F::loadu(positions[1] + i), F::loadu(positions[2] + i), one, r);
+            for (int c = 0; c < 4; c++) F::storeu(out[c] + i, r[c]);
+        }
+    }
+
+    /**
+     * Tests one edge function against zero, counting exact zeros only on top-left edges
+     */
+    template<class F>
+    static inline typename F::M inside(typename F::V e, bool top_left) {
+        return top_left ? F::ge(e, F::zero()) : F::gt(e, F::zero());
+    }
+
+    /**
+     * Transforms points [begin, end) of SoA streams by `mat` into clip space, with w = 1
+     */
+    static void clip(const float* mat, const float* const* positions, float* const* out, size_t begin, size_t end) {
+        size_t main = end - (end - begin) % F32::W;
+        clip_range<F32>(mat, positions, out, begin, main);
+        clip_range<F1>(mat, positions, out, main, end);
+    }
+
+    /**
+     * Draws one triangle into a tile, over the pixels in columns [x0, x1) and rows [y0, y1)
+     * of it. `edges` holds (a, b, c) for each of its three edge functions `a * x + b * y + c`,
+     * which are positive inside, and `plane` holds (dz/dx, dz/dy, z) for its depth, all
+     * relative to the tile's top-left corner. Pixels pass where they're nearer than the depth
+     * already there, and then take the triangle's depth and `id` (if `ids` isn't null).
+     *
+     * Every pixel is evaluated with full registers starting from a multiple of the register
+     * width, so a pixel comes out the same whichever triangle draws it. `stride` must be a
+     * multiple of the widest register.
+     */
+    static void triangle(const float* edges, uint32_t top_left, const float* plane, uint32_t id,
+        size_t x0, size_t x1, size_t y0, size_t y1, size_t stride, float* depth, uint32_t* ids) {
+        using F = F32;
+        const typename F::V a[3] = { F::set1(edges[0]), F::set1(edges[3]), F::set1(edges[6]) };
+        const typename F::V b[3] = { F::set1(edges[1]), F::set1(edges[4]), F::set1(edges[7]) };
+        const typename F::V c[3] = { F::set1(edges[2]), F::set1(edges[5]), F::set1(edges[8]) };
+        const bool tl[3] = { (top_left & 1u) != 0, (top_left & 2u) != 0, (top_left & 4u) != 0 };
+        const typename F::V dzdx = F::set1(plane[0]), dzdy = F::set1(plane[1]), z0 = F::set1(plane[2]);
+        const typename F::V lanes = F::load(centers), zero = F::zero(), one = F::set1(1.0f);
+        x0 -= x0 % F::W;
+        for (size_t y = y0; y < y1; y++) {
+
+            // Start each row from its left edge
+            typename F::V py = F::set1(float(y) + 0.5f);
+            typename F::V row[3], row_z = F::fmadd(dzdy, py, z0);
+            for (int k = 0; k < 3; k++) row[k] = F::fmadd(b[k], py, c[k]);
+            float* depth_row = depth + y * stride;
+            for (size_t x = x0; x < x1; x += F::W) {
+                typename F::V px = F::add(F::set1(float(x)), lanes);
+                typename F::M covered = F::m_and(
+                    inside<F>(F::fmadd(a[0], px, row[0]), tl[0]),
+                    F::m_and(inside<F>(F::fmadd(a[1], px, row[1]), tl[1]), inside<F>(F::fmadd(a[2], px, row[2]), tl[2]))
+                );
+                if (F::bits(covered) == 0) continue;
+
+                // Depth test against what's already there
+                typename F::V z = F::min(F::max(F::fmadd(dzdx, px, row_z), zero), one);
+                typename F::V old = F::load(depth_row + x);
+                typename F::M pass = F::m_and(covered, F::lt(z, old));
+                uint32_t bits = F::bits(pass);
+                if (bits == 0) continue;
+                F::store(depth_row + x, F::select(pass, z, old));
+                if (ids == nullptr) continue;
+                for (size_t lane = 0; lane < F::W; lane++) {
+                    if (bits & (1u << lane)) ids[y * stride + x + lane] = id;
+                }
+            }
+
+        }
+    }
+
+}
@@ -0,0 +1,239 @@
+// Ray/triangle intersection kernels, compiled once per target by foreach_target.h. Either a
+// register of rays is tested against one triangle, or one ray against a register of triangles
+// read from an array of Tri3 with strided loads.
+
+namespace e3d::simd::E3D_SIMD_NS::ray {
+
+    /**
+     * Sums from +0 like utils::vec::dot, so a zero product gives the same sign of zero
+     */
+    template<class F>
+    static inline typename F::V dot3(const typename F::V* a, const typename F::V* b) {
+        return F::fmadd(a[2], b[2], F::fmadd(a[1], b[1], F::fmadd(a[0], b[0], F::zero())));
+    }
+
+    template<class F>
+    static inline void cross3(const typename F::V* a, const typename F::V* b, typename F::V* out) {
+        out[0] = F::sub(F::mul(a[1], b[2]), F::mul(a[2], b[1]));
+        out[1] = F::sub(F::mul(a[2], b[0]), F::mul(a[0], b[2]));
+        out[2] = F::sub(F::mul(a[0], b[1]), F::mul(a[1], b[0]));
+    }
+
+    /**
+     * Möller–Trumbore, in the same order of operations as utils::ray::intersect. Returns
+     * which lanes hit within [0, t_max].
+     */
+    template<class F>
+    static inline typename F::M triangle(const typename F::V* origin, const typename F::V* direction,
+        const typename F::V* v0, const typename F::V* e1, const typename F::V* e2, typename F::V t_max,
+        typename F::V& t, typename F::V& u, typename F::V& v) {
+        typedef typename F::V V;
+        const V zero = F::zero(), one = F::set1(1.0f);
+
+        // The determinant, which is zero for rays parallel to the triangle
+        V p[3], s[3], q[3];
+        cross3<F>(direction, e2, p);
+        V det = dot3<F>(e1, p);
+        V inverse_det = F::div(one, det);
+
+        // The barycentric coordinates and distance
+        for (int c = 0; c < 3; c++) s[c] = F::sub(origin[c], v0[c]);
+        u = F::mul(dot3<F>(s, p), inverse_det);
+        cross3<F>(s, e1, q);
+        v = F::mul(dot3<F>(direction, q), inverse_det);
+        t = F::mul(dot3<F>(e2, q), inverse_det);
+
+        // Which lanes are inside the triangle, and in range
+        typename F::M hit = F::m_not(F::eq(det, zero));
+        hit = F::m_and(hit, F::m_and(F::ge(u, zero), F::le(u, one)));
+        hit = F::m_and(hit, F::m_and(F::ge(v, zero), F::le(F::add(u, v), one)));
+        return F::m_and(hit, F::m_and(F::ge(t, zero), F::le(t, t_max)));
+
+    }
+
+    /**
+     * Loads W triangles from an array of Tri3, as their first corner and two edges
+     */
+    template<class F>
+    static inline void load_triangles(const float* tris, size_t i, typename F::V* v0, typename F::V* e1, typename F::V* e2) {
+        for (int c = 0; c < 3; c++) {
+            const float* corner = tris + i * 9 + c;
+            v0[c] = F::load_strided(corner, 9);
+            e1[c] = F::sub(F::load_strided(corner + 3, 9), v0[c]);
+            e2[c] = F::sub(F::load_strided(corner + 6, 9), v0[c]);
+        }
+    }
+
+    /**
+     * Tests rays [begin, end) against one triangle (its first corner and two edges). Misses
+     * get a distance of infinity and zero barycentrics.
+     */
+    template<class F>
+    static inline void rays_range(const float* const* origins, const float* const* directions, const float* tri, float t_max,
+        float* t_out, float* u_out, float* v_out, size_t begin, size_t end) {
+        typedef typename F::V V;
+        V v0[3], e1[3], e2[3];
+        for (int c = 0; c < 3; c++) {
+            v0[c] = F::set1(tri[c]);
+            e1[c] = F::set1(tri[3 + c]);
+            e2[c] = F::set1(tri[6 + c]);
+        }
+        const V limit = F::set1(t_max), miss = F::set1(INFINITY);
+        for (size_t i = begin; i + F::W <= end; i += F::W) {
+            V origin[3], direction[3], t, u, v;
+            for (int c = 0; c < 3; c++) {
+                origin[c] = F::loadu(origins[c] + i);
+                direction[c] = F::loadu(directions[c] + i);
+            }
+            typename F::M hit = triangle<F>(origin, direction, v0, e1, e2, limit, t, u, v);
+            F::storeu(t_out + i, F::select(hit, t, miss));
+            F::storeu(u_out + i, F::select(hit, u, F::zero()));
+            F::storeu(v_out + i, F::select(hit, v, F::zero()));
+        }
+    }
+
+    /**
+     * Tests one ray (origin then direction) against triangles [begin, end) of a Tri3 array
+     */
+    template<class F>
+    static inline void triangles_range(const float* ray, const float* tris, float t_max,
+        float* t_out, float* u_out, float* v_out, size_t begin, size_t end) {
+        typedef typename F::V V;
+        V origin[3], direction[3];
+        for (int c = 0; c < 3; c++) {
+            origin[c] = F::set1(ray[c]);
+            direction[c] = F::set1(ray[3 + c]);
+        }
+        const V limit = F::set1(t_max), miss = F::set1(INFINITY);
+        for (size_t i = begin; i + F::W <= end; i += F::W) {
+            V v0[3], e1[3], e2[3], t, u, v;
+            load_triangles<F>(tris, i, v0, e1, e2);
+            typename F::M hit = triangle<F>(origin, direction, v0, e1, e2, limit, t, u, v);
+            F::storeu(t_out + i, F::select(hit, t, miss));
+            F::storeu(u_out + i, F::select(hit, u, F::zero()));
+            F::storeu(v_out + i, F::select(hit, v, F::zero()));
+        }
+    }
+
+    /**
+     * Finds the closest of triangles [begin, end) that one ray hits, improving on `best`
+     * (a distance, barycentrics and index). Ties go to the lowest index.
+     */
+    template<class F>
+    static inline void closest_range(const float* ray, const float* tris, float* best, uint32_t& best_index, size_t begin, size_t end) {
+        typedef typename F::V V;
+        V origin[3], direction[3];
+        for (int c = 0; c < 3; c++) {
+            origin[c] = F::set1(ray[c]);
+            direction[c] = F::set1(ray[3 + c]);
+        }
+        for (size_t i = begin; i + F::W <= end; i += F::W) {
+            V v0[3], e1[3], e2[3], t, u, v;
+            load_triangles<F>(tris, i, v0, e1, e2);
+            uint32_t bits = F::bits(triangle<F>(origin, direction, v0, e1, e2, F::set1(best[0]), t, u, v));
+            if (bits == 0) continue;
+
+            // Hits are rare enough to sort out one lane at a time, in index order
+            alignas(64) float ts[F::W], us[F::W], vs[F::W];
+            F::store(ts, t);
+            F::store(us, u);
+            F::store(vs, v);
+            for (size_t lane = 0; lane < F::W; lane++) {
+                if (!(bits & (1u << lane)) || ts[lane] > best[0] || (ts[lane] == best[0] && i + lane >= best_index)) continue;
+                best[0] = ts[lane];
+                best[1] = us[lane];
+                best[2] = vs[lane];
+                best_index = uint32_t(i + lane);
+            }
+        }
+    }
+
+    /**
+     * Finds the closest triangle each of rays [begin, end) hits, out of a whole Tri3 array.
+     * Misses get a distance of infinity and an index of UINT32_MAX.
+     */
+    template<class F>
+    static inline void closest_rays_range(const float* const* origins, const float* const* directions, const float* tris, size_t count, float t_max,
+        float* t_out, float* u_out, float* v_out, uint32_t* index_out, size_t begin, size_t end) {
+        typedef typename F::V V;
+        for (size_t i = begin; i + F::W <= end; i += F::W) {
+            V origin[3], direction[3];
+            for (int c = 0; c < 3; c++) {
+                origin[c] = F::loadu(origins[c] + i);
+                direction[c] = F::loadu(directions[c] + i);
+            }
+
+            // Keep the closest hit in each lane, replacing it only with strictly closer ones
+            // so that ties keep the lowest index
+            alignas(64) float best_t[F::W], best_u[F::W], best_v[F::W];
+            uint32_t best_index[F::W];
+            for (size_t lane = 0; lane < F::W; lane++) {
+                best_t[lane] = t_max;
+                best_u[lane] = best_v[lane] = 0;
+                best_index[lane] = UINT32_MAX;
+            }
+            V limit = F::set1(t_max);
+            for (size_t tri = 0; tri < count; tri++) {
+                V v0[3], e1[3], e2[3], t, u, v;
+                for (int c = 0; c < 3; c++) {
+                    const float* corners = tris + tri * 9 + c;
+                    v0[c] = F::set1(corners[0]);
+                    e1[c] = F::sub(F::set1(corners[3]), v0[c]);
+                    e2[c] = F::sub(F::set1(corners[6]), v0[c]);
+                }
+                uint32_t bits = F::bits(triangle<F>(origin, direction, v0, e1, e2, limit, t, u, v));
+                if (bits == 0) continue;
+
+                // Hits get rarer as the lanes find closer triangles, so update them one by one
+                alignas(64) float ts[F::W], us[F::W], vs[F::W];
+                F::store(ts, t);
+                F::store(us, u);
+                F::store(vs, v);
+                for (size_t lane = 0; lane < F::W; lane++) {
+                    if (!(bits & (1u << lane)) || (ts[lane] == best_t[lane] && best_index[lane] != UINT32_MAX)) continue;
+                    best_t[lane] = ts[lane];
+                    best_u[lane] = us[lane];
+                    best_v[lane] = vs[lane];
+                    best_index[lane] = uint32_t(tri);
+                }
+                limit = F::load(best_t);
+            }
+
+            // Write out the hits, with misses at infinity
+            for (size_t lane = 0; lane < F::W; lane++) {
+                bool found = best_index[lane] != UINT32_MAX;
+                t_out[i + lane] = found ? best_t[lane] : INFINITY;
+                u_out[i + lane] = best_u[lane];
+                v_out[i + lane] = best_v[lane];
+                index_out[i + lane] = best_index[lane];
+            }
+        }
+    }
+
+    static void rays(const float* const* origins, const float* const* directions, const float* tri, float t_max,
+        float* t_out, float* u_out, float* v_out, size_t begin, size_t end) {
+        size_t main = end - (end - begin) % F32::W;
+        rays_range<F32>(origins, directions, tri, t_max, t_out, u_out, v_out, begin, main);
+        rays_range<F1>(origins, directions, tri, t_max, t_out, u_out, v_out, main, end);
+    }
+
+    static void triangles(const float* ray, const float* tris, float t_max, float* t_out, float* u_out, float* v_out, size_t begin, size_t end) {
+        size_t main = end - (end - begin) % F32::W;
+        triangles_range<F32>(ray, tris, t_max, t_out, u_out, v_out, begin, main);
+        triangles_range<F1>(ray, tris, t_max, t_out, u_out, v_out, main, end);
+    }
+
+    static void closest(const float* ray, const float* tris, float* best, uint32_t& best_index, size_t begin, size_t end) {
+        size_t main = end - (end - begin) % F32::W;
+        closest_range<F32>(ray, tris, best, best_index, begin, main);
+        closest_range<F1>(ray, tris, best, best_index, main, end);
+    }
+
+    static void closest_rays(const float* const* origins, const float* const* directions, const float* tris, size_t count, float t_max,
+        float* t_out, float* u_out, float* v_out, uint32_t* index_out, size_t begin, size_t end) {
+        size_t main = end - (end - begin) % F32::W;
+        closest_rays_range<F32>(origins, directions, tris, count, t_max, t_out, u_out, v_out, index_out, begin, main);
+        closest_rays_range<F1>(origins, directions, tris, count, t_max, t_out, u_out, v_out, index_out, main, end);
+    }
+
+}
@@ -0,0 +1,69 @@
+// Conversions between arrays of vectors and SoA streams, compiled once per target by
+// foreach_target.h
+
+namespace e3d::simd::E3D_SIMD_NS::soa {
+
+    template<class F, uint8_t S>
+    static inline void from_aos_range(const float* aos, float* const* soa, size_t begin, size_t end) {
+        for (size_t i = begin; i + F::W <= end; i += F::W) {
+            if constexpr (S == 3) {
+                typename F::V x, y, z;
+                F::load_aos3(aos + i * 3, x, y, z);
+                F::storeu(soa[0] + i, x);
+                F::storeu(soa[1] + i, y);
+                F::storeu(soa[2] + i, z);
+            } else {
+                typename F::V x, y, z, w;
+                F::load_aos4(aos + i * 4, x, y, z, w);
+                F::storeu(soa[0] + i, x);
+                F::storeu(soa[1] + i, y);
+                F::storeu(soa[2] + i, z);
+                F::storeu(soa[3] + i, w);
+            }
+        }
+    }
+
+    template<class F, uint8_t S>
+    static inline void to_aos_range(const float* const* soa, float* aos, size_t begin, size_t end) {
+        for (size_t i = begin; i + F::W <= end; i += F::W) {
+            if constexpr (S == 3) {
+                F::store_aos3(aos + i * 3, F::loadu(soa[0] + i), F::loadu(soa[1] + i), F::loadu(soa[2] + i));
+            } else {
+                F::store_aos4(aos + i * 4, F::loadu(soa[0] + i), F::loadu(soa[1] + i), F::loadu(soa[2] + i), F::loadu(soa[3] + i));
+            }
+        }
+    }
+
+    /**
+     * Splits `count` interleaved vectors of S components into S separate streams
+     */
+    template<uint8_t S>
+    static void from_aos(const float* aos, float* const* soa, size_t count) {
+        if constexpr (S == 3 || S == 4) {
+            size_t main = count - count % F32::W;
+            from_aos_range<F32, S>(aos, soa, 0, main);
+            from_aos_range<F1, S>(aos, soa, main, count);
+        } else {
+            for (size_t i = 0; i < count; i++) {
+                for (uint8_t c = 0; c < S; c++) soa[c][i] = aos[i * S + c];
+            }
+        }
+    }
+
+    /**
+     * Interleaves S separate streams of `count` components into vectors
+     */
+    template<uint8_t S>
+    static void to_aos(const float* const* soa, float* aos, size_t count) {
+        if constexpr (S == 3 || S == 4) {
+            size_t main = count - count % F32::W;
+            to_aos_range<F32, S>(soa, aos, 0, main);
+            to_aos_range<F1, S>(soa, aos, main, count);
+        } else {
+            for (size_t i = 0; i < count; i++) {
+                for (uint8_t c = 0; c < S; c++) aos[i * S + c] = soa[c][i];
+            }
+        }
+    }
+
+}
@@ -0,0 +1,153 @@
+// Kernels applying one row-major 4x4 matrix to many vectors, compiled once per target by
+// foreach_target.h. Each output component is summed as (((0 + m0*x) + m1*y) + m2*z) + m3*w,
+// the same order as Mat::multiply.
+
+namespace e3d::simd::E3D_SIMD_NS::transform {
+
+    /**
+     * The matrix, with every element broadcast across a register
+     */
+    template<class F>
+    struct Columns {
+
+        typename F::V m[16];
+
+        explicit Columns(const float* mat) {
+            for (int i = 0; i < 16; i++) this->m[i] = F::set1(mat[i]);
+        }
+
+        /**
+         * Transforms xyz with an implicit w of 1 (points) or 0 (directions). The w term is kept
+         * for directions too, so an infinite or NaN translation gives NaN like the Vec product.
+         */
+        template<bool Point>
+        void apply3(typename F::V x, typename F::V y, typename F::V z, typename F::V& rx, typename F::V& ry, typename F::V& rz) const {
+            const typename F::V w = Point ? F::set1(1.0f) : F::zero();
+            rx = this->row(0, x, y, z, w);
+            ry = this->row(1, x, y, z, w);
+            rz = this->row(2, x, y, z, w);
+        }
+
+        /**
+         * Transforms xyzw
+         */
+        void apply4(typename F::V x, typename F::V y, typename F::V z, typename F::V w, typename F::V* out) const {
+            for (int r = 0; r < 4; r++) out[r] = this->row(r, x, y, z, w);
+        }
+
+        /**
+         * One output component, summed from +0 like Mat::multiply, so a zero result has the
+         * same sign
+         */
+        typename F::V row(int r, typename F::V x, typename F::V y, typename F::V z, typename F::V w) const {
+            const typename F::V* row = this->m + r * 4;
+            return F::fmadd(row[3], w, F::fmadd(row[2], z, F::fmadd(row[1], y, F::fmadd(row[0], x, F::zero()))));
+        }
+
+    };
+
+    template<class F, bool Point>
+    static inline void aos3_range(const float* mat, const float* src, float* dst, size_t begin, size_t end) {
+        const Columns<F> cols(mat);
+        for (size_t i = begin; i + F::W <= end; i += F::W) {
+            typename F::V x, y, z, rx, ry, rz;
+            F::load_aos3(src + i * 3, x, y, z);
+            cols.template apply3<Point>(x, y, z, rx, ry, rz);
+            F::store_aos3(dst + i * 3, rx, ry, rz);
+        }
+    }
+
+    template<class F>
+    static inline void aos4_range(const float* mat, const float* src, float* dst, size_t begin, size_t end) {
+        const Columns<F> cols(mat);
+        for (size_t i = begin; i + F::W <= end; i += F::W) {
+            typename F::V x, y, z, w, r[4];
+            F::load_aos4(src + i * 4, x, y, z, w);
+            cols.apply4(x, y, z, w, r);
+            F::store_aos4(dst + i * 4, r[0], r[1], r[2], r[3]);
+        }
+    }
+
+    template<class F, bool Point>
+    static inline void padded3_range(const float* mat, const float* src, float* dst, size_t begin, size_t end) {
+        const Columns<F> cols(mat);
+        for (size_t i = begin; i + F::W <= end; i += F::W) {
+            typename F::V x, y, z, padding, rx, ry, rz;
+            F::load_aos4(src + i * 4, x, y, z, padding);
+            cols.template apply3<Point>(x, y, z, rx, ry, rz);
+            F::store_aos4(dst + i * 4, rx, ry, rz, F::zero());
+        }
+    }
+
+    template<class F, bool Point>
+    static inline void soa3_range(const float* mat, const float* const* src, float* const* dst, size_t begin, size_t end) {
+        const Columns<F> cols(mat);
+        for (size_t i = begin; i + F::W <= end; i += F::W) {
+            typename F::V rx, ry, rz;
+            cols.template apply3<Point>(F::loadu(src[0] + i), F::loadu(src[1] + i), F::loadu(src[2] + i), rx, ry, rz);
+            F::storeu(dst[0] + i, rx);
+            F::storeu(dst[1] + i, ry);
+            F::storeu(dst[2] + i, rz);
+        }
+    }
+
+    template<class F>
+    static inline void soa4_range(const float* mat, const float* const* src, float* const* dst, size_t begin, size_t end) {
+        const Columns<F> cols(mat);
+        for (size_t i = begin; i + F::W <= end; i += F::W) {
+            typename F::V r[4];
+            cols.apply4(F::loadu(src[0] + i), F::loadu(src[1] + i), F::loadu(src[2] + i), F::loadu(src[3] + i), r);
+            for (int c = 0; c < 4; c++) F::storeu(dst[c] + i, r[c]);
+        }
+    }
+
+    /**
+     * Transforms the xyz triples in [begin, end), with an implicit w of 1 or 0
+     */
+    template<bool Point>
+    static void aos3(const float* mat, const float* src, float* dst, size_t begin, size_t end) {
+        size_t main = end - (end - begin) % F32::W;
+        aos3_range<F32, Point>(mat, src, dst, begin, main);
+        aos3_range<F1, Point>(mat, src, dst, main, end);
+    }
+
+    /**
+     * Transforms the xyzw quadruples in [begin, end)
+     */
+    static void aos4(const float* mat, const float* src, float* dst, size_t begin, size_t end) {
+        size_t main = end - (end - begin) % F32::W;
+        aos4_range<F32>(mat, src, dst, begin, main);
+        aos4_range<F1>(mat, src, dst, main, end);
+    }
+
+    /**
+     * Transforms the padded xyz triples in [begin, end), with an implicit w of 1 or 0. Each
+     * triple is loaded whole from its own 16 bytes, and its padding is written as zero.
+     */
+    template<bool Point>
+    static void padded3(const float* mat, const float* src, float* dst, size_t begin, size_t end) {
+        size_t main = end - (end - begin) % F32::W;
+        padded3_range<F32, Point>(mat, src, dst, begin, main);
+        padded3_range<F1, Point>(mat, src, dst, main, end);
+    }
+
+    /**
+     * Transforms the SoA xyz vectors in [begin, end), with an implicit w of 1 or 0
+     */
+    template<bool Point>
+    static void soa3(const float* mat, const float* const* src, float* const* dst, size_t begin, size_t end) {
+        size_t main = end - (end - begin) % F32::W;
+        soa3_range<F32, Point>(mat, src, dst, begin, main);
+        soa3_range<F1, Point>(mat, src, dst, main, end);
+    }
+
+    /**
+     * Transforms the SoA xyzw vectors in [begin, end)
+     */
+    static void soa4(const float* mat, const float* const* src, float* const* dst, size_t begin, size_t end) {
+        size_t main = end - (end - begin) % F32::W;
+        soa4_range<F32>(mat, src, dst, begin, main);
+        soa4_range<F1>(mat, src, dst, main, end);
+    }
+
+}
@@ -0,0 +1,114 @@
+// Batch vector kernels over SoA streams, compiled once per target by foreach_target.h
+
+namespace e3d::simd::E3D_SIMD_NS::vec_soa {
+
+    template<class F, uint8_t S>
+    static inline void dot_range(const float* const* left, const float* const* right, float* out, size_t begin, size_t end) {
+        for (size_t i = begin; i + F::W <= end; i += F::W) {
+            typename F::V sum = F::zero();
+            for (uint8_t c = 0; c < S; c++) sum = F::fmadd(F::loadu(left[c] + i), F::loadu(right[c] + i), sum);
+            F::storeu(out + i, sum);
+        }
+    }
+
+    template<class F>
+    static inline void cross_range(const float* const* left, const float* const* right, float* const* out, size_t begin, size_t end) {
+        for (size_t i = begin; i + F::W <= end; i += F::W) {
+            typename F::V a_x = F::loadu(left[0] + i), a_y = F::loadu(left[1] + i), a_z = F::loadu(left[2] + i);
+            typename F::V b_x = F::loadu(right[0] + i), b_y = F::loadu(right[1] + i), b_z = F::loadu(right[2] + i);
+            F::storeu(out[0] + i, F::sub(F::mul(a_y, b_z), F::mul(a_z, b_y)));
+            F::storeu(out[1] + i, F::sub(F::mul(a_z, b_x), F::mul(a_x, b_z)));
+            F::storeu(out[2] + i, F::sub(F::mul(a_x, b_y), F::mul(a_y, b_x)));
+        }
+    }
+
+    template<class F, uint8_t S>
+    static inline typename F::V magnitude_at(const float* const* vecs, size_t i) {
+        typename F::V sum = F::zero();
+        for (uint8_t c = 0; c < S; c++) {
+            typename F::V value = F::loadu(vecs[c] + i);
+            sum = F::fmadd(value, value, sum);
+        }
+        return F::sqrt(sum);
+    }
+
+    template<class F, uint8_t S>
+    static inline void magnitude_range(const float* const* vecs, float* out, size_t begin, size_t end) {
+        for (size_t i = begin; i + F::W <= end; i += F::W) F::storeu(out + i, magnitude_at<F, S>(vecs, i));
+    }
+
+    template<class F, uint8_t S>
+    static inline void normalize_range(const float* const* vecs, float* const* out, size_t begin, size_t end) {
+        const typename F::V epsilon = F::set1(0.00001f);
+        for (size_t i = begin; i + F::W <= end; i += F::W) {
+
+            // Vectors with a (near) zero magnitude normalize to zero, like utils::vec::normalize
+            typename F::V mag = magnitude_at<F, S>(vecs, i);
+            typename F::M valid = F::gt(mag, epsilon);
+            typename F::V scale = F::select(valid, F::div(F::set1(1.0f), mag), F::zero());
+            for (uint8_t c = 0; c < S; c++) F::storeu(out[c] + i, F::mul(F::loadu(vecs[c] + i), scale));
+
+        }
+    }
+
+    template<class F, uint8_t S, bool Clamp>
+    static inline void cos_between_range(const float* const* left, const float* const* right, float* out, size_t begin, size_t end) {
+        for (size_t i = begin; i + F::W <= end; i += F::W) {
+            typename F::V sum = F::zero();
+            for (uint8_t c = 0; c < S; c++) sum = F::fmadd(F::loadu(left[c] + i), F::loadu(right[c] + i), sum);
+            sum = F::div(F::div(sum, magnitude_at<F, S>(left, i)), magnitude_at<F, S>(right, i));
+
+            // Clamp into [-1, 1] for the approximate arc cosine, keeping NaN (the constant goes
+            // first, since min and max return their second operand for NaN)
+            if constexpr (Clamp) sum = F::min(F::set1(1.0f), F::max(F::set1(-1.0f), sum));
+            F::storeu(out + i, sum);
+
+        }
+    }
+
+    template<uint8_t S>
+    static void dot(const float* const* left, const float* const* right, float* out, size_t count) {
+        size_t main = count - count % F32::W;
+        dot_range<F32, S>(left, right, out, 0, main);
+        dot_range<F1, S>(left, right, out, main, count);
+    }
+
+    static void cross(const float* const* left, const float* const* right, float* const* out, size_t count) {
+        size_t main = count - count % F32::W;
+        cross_range<F32>(left, right, out, 0, main);
+        cross_range<F1>(left, right, out, main, count);
+    }
+
+    template<uint8_t S>
+    static void magnitude(const float* const* vecs, float* out, size_t count) {
+        size_t main = count - count % F32::W;
+        magnitude_range<F32, S>(vecs, out, 0, main);
+        magnitude_range<F1, S>(vecs, out, main, count);
+    }
+
+    template<uint8_t S>
+    static void normalize(const float* const* vecs, float* const* out, size_t count) {
+        size_t main = count - count % F32::W;
+        normalize_range<F32, S>(vecs, out, 0, main);
+        normalize_range<F1, S>(vecs, out, main, count);
+    }
+
+    template<uint8_t S>
+    static void angle_between(const float* const* left, const float* const* right, float* out, size_t count) {
+
+        // The cosines are vectorized, the precise arc cosine is not
+        size_t main = count - count % F32::W;
+        cos_between_range<F32, S, false>(left, right, out, 0, main);
+        cos_between_range<F1, S, false>(left, right, out, main, count);
+        for (size_t i = 0; i < count; i++) out[i] = std::acos(out[i]);
+
+    }
+
+    template<uint8_t S>
+    static void cos_between_clamped(const float* const* left, const float* const* right, float* out, size_t count) {
+        size_t main = count - count % F32::W;
+        cos_between_range<F32, S, true>(left, right, out, 0, main);
+        cos_between_range<F1, S, true>(left, right, out, main, count);
+    }
+
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+#include <cmath>
+#include "cpu.h"
+
+#if E3D_SIMD_X86
+#include <immintrin.h>
+#endif
+
+/**
+ * Defines the lane types for each target namespace:
+ *
+ *  - `e3d::simd::<target>::F32` is a register of `F32::W` floats (1, 4, 8 or 16)
+ *  - `e3d::simd::<target>::F1` is a single float with the same interface, used for tails
+ */
+#define E3D_SIMD_KERNELS "lanes.inl"
+#include "foreach_target.h"
+
+/**
+ * Runs `e3d::simd::<target>::<call>` for the active SIMD level, returning its result.
+ * AVX without AVX2 uses the SSE2 kernels, since the generic kernels assume FMA at 8 lanes.
+ */
+#if E3D_SIMD_X86
+#define E3D_SIMD_DISPATCH(...) \
+    switch (::e3d::simd::level()) { \
+        case ::e3d::simd::Level::avx512: return ::e3d::simd::avx512::__VA_ARGS__; \
+        case ::e3d::simd::Level::avx2: return ::e3d::simd::avx2::__VA_ARGS__; \
+        case ::e3d::simd::Level::avx: \
+        case ::e3d::simd::Level::sse2: return ::e3d::simd::sse2::__VA_ARGS__; \
+        default: return ::e3d::simd::scalar::__VA_ARGS__; \
+    }
+#else
+#define E3D_SIMD_DISPATCH(...) return ::e3d::simd::scalar::__VA_ARGS__;
+#endif
@@ -0,0 +1,343 @@
+// Lane types, compiled once per target by foreach_target.h
+
+namespace e3d::simd::E3D_SIMD_NS {
+
+    /**
+     * A single float lane. Kernels use this for the elements left over after the last full
+     * register, so they never read or write past the end of a buffer.
+     */
+    struct F1 {
+
+        using V = float;
+        using M = bool;
+        static constexpr size_t W = 1;
+
+        static V zero() { return 0.0f; }
+        static V set1(float value) { return value; }
+        static V load(const float* ptr) { return *ptr; }
+        static V loadu(const float* ptr) { return *ptr; }
+        static void store(float* ptr, V v) { *ptr = v; }
+        static void storeu(float* ptr, V v) { *ptr = v; }
+
+        static V add(V a, V b) { return a + b; }
+        static V sub(V a, V b) { return a - b; }
+        static V mul(V a, V b) { return a * b; }
+        static V div(V a, V b) { return a / b; }
+        static V fmadd(V a, V b, V c) { return a * b + c; }
+        static V fnmadd(V a, V b, V c) { return c - a * b; }
+        static V min(V a, V b) { return a < b ? a : b; }
+        static V max(V a, V b) { return a > b ? a : b; }
+        static V sqrt(V a) { return std::sqrt(a); }
+        static V abs(V a) { return std::fabs(a); }
+        static V neg(V a) { return -a; }
+
+        static M lt(V a, V b) { return a < b; }
+        static M le(V a, V b) { return a <= b; }
+        static M gt(V a, V b) { return a > b; }
+        static M ge(V a, V b) { return a >= b; }
+        static M eq(V a, V b) { return a == b; }
+        static M m_and(M a, M b) { return a && b; }
+        static M m_or(M a, M b) { return a || b; }
+        static M m_not(M a) { return !a; }
+        static V select(M m, V a, V b) { return m ? a : b; }
+        static uint32_t bits(M m) { return m ? 1u : 0u; }
+
+        static float reduce_add(V v) { return v; }
+        static float reduce_min(V v) { return v; }
+        static float reduce_max(V v) { return v; }
+
+        static V load_strided(const float* ptr, size_t) { return *ptr; }
+        static V gather(const float* base, const uint32_t* indices, size_t) { return base[*indices]; }
+
+        static void load_aos3(const float* ptr, V& x, V& y, V& z) { x = ptr[0]; y = ptr[1]; z = ptr[2]; }
+        static void store_aos3(float* ptr, V x, V y, V z) { ptr[0] = x; ptr[1] = y; ptr[2] = z; }
+        static void load_aos4(const float* ptr, V& x, V& y, V& z, V& w) { x = ptr[0]; y = ptr[1]; z = ptr[2]; w = ptr[3]; }
+        static void store_aos4(float* ptr, V x, V y, V z, V w) { ptr[0] = x; ptr[1] = y; ptr[2] = z; ptr[3] = w; }
+
+    };
+
+#if E3D_SIMD_TARGET == E3D_SIMD_TARGET_SCALAR
+
+    using F32 = F1;
+
+#else
+
+    /**
+     * A full register of floats for this target
+     */
+    struct F32 {
+
+#if E3D_SIMD_TARGET == E3D_SIMD_TARGET_SSE2
+
+        using V = __m128;
+        using M = __m128;
+        static constexpr size_t W = 4;
+
+        static V zero() { return _mm_setzero_ps(); }
+        static V set1(float value) { return _mm_set1_ps(value); }
+        static V load(const float* ptr) { return _mm_load_ps(ptr); }
+        static V loadu(const float* ptr) { return _mm_loadu_ps(ptr); }
+        static void store(float* ptr, V v) { _mm_store_ps(ptr, v); }
+        static void storeu(float* ptr, V v) { _mm_storeu_ps(ptr, v); }
+
+        static V add(V a, V b) { return _mm_add_ps(a, b); }
+        static V sub(V a, V b) { return _mm_sub_ps(a, b); }
+        static V mul(V a, V b) { return _mm_mul_ps(a, b); }
+        static V div(V a, V b) { return _mm_div_ps(a, b); }
+        static V fmadd(V a, V b, V c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+        static V fnmadd(V a, V b, V c) { return _mm_sub_ps(c, _mm_mul_ps(a, b)); }
+        static V min(V a, V b) { return _mm_min_ps(a, b); }
+        static V max(V a, V b) { return _mm_max_ps(a, b); }
+        static V sqrt(V a) { return _mm_sqrt_ps(a); }
+        static V abs(V a) { return _mm_and_ps(a, _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff))); }
+        static V neg(V a) { return _mm_xor_ps(a, _mm_castsi128_ps(_mm_set1_epi32(int(0x80000000u)))); }
+
+        static M lt(V a, V b) { return _mm_cmplt_ps(a, b); }
+        static M le(V a, V b) { return _mm_cmple_ps(a, b); }
+        static M gt(V a, V b) { return _mm_cmpgt_ps(a, b); }
+        static M ge(V a, V b) { return _mm_cmpge_ps(a, b); }
+        static M eq(V a, V b) { return _mm_cmpeq_ps(a, b); }
+        static M m_and(M a, M b) { return _mm_and_ps(a, b); }
+        static M m_or(M a, M b) { return _mm_or_ps(a, b); }
+        static M m_not(M a) { return _mm_xor_ps(a, _mm_castsi128_ps(_mm_set1_epi32(-1))); }
+        static V select(M m, V a, V b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+        static uint32_t bits(M m) { return uint32_t(_mm_movemask_ps(m)); }
+
+        static float reduce_add(V v) {
+            V pairs = _mm_add_ps(v, _mm_movehl_ps(v, v));
+            return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, 1)));
+        }
+        static float reduce_min(V v) {
+            V pairs = _mm_min_ps(v, _mm_movehl_ps(v, v));
+            return _mm_cvtss_f32(_mm_min_ss(pairs, _mm_shuffle_ps(pairs, pairs, 1)));
+        }
+        static float reduce_max(V v) {
+            V pairs = _mm_max_ps(v, _mm_movehl_ps(v, v));
+            return _mm_cvtss_f32(_mm_max_ss(pairs, _mm_shuffle_ps(pairs, pairs, 1)));
+        }
+
+        // Per-128-bit-block primitives for the AoS transposes below
+        template<int Imm> static V shuffle(V a, V b) { return _mm_shuffle_ps(a, b, Imm); }
+        static V unpacklo(V a, V b) { return _mm_unpacklo_ps(a, b); }
+        static V unpackhi(V a, V b) { return _mm_unpackhi_ps(a, b); }
+        static V load_blocks(const float* ptr, size_t) { return _mm_loadu_ps(ptr); }
+        static void store_blocks(float* ptr, size_t, V v) { _mm_storeu_ps(ptr, v); }
+
+        // Lane i from ptr[i * stride], or from base[indices[i * stride]]
+        static V load_strided(const float* ptr, size_t stride) {
+            return _mm_setr_ps(ptr[0], ptr[stride], ptr[stride * 2], ptr[stride * 3]);
+        }
+        static V gather(const float* base, const uint32_t* indices, size_t stride) {
+            return _mm_setr_ps(base[indices[0]], base[indices[stride]], base[indices[stride * 2]], base[indices[stride * 3]]);
+        }
+
+#elif E3D_SIMD_TARGET == E3D_SIMD_TARGET_AVX2
+
+        using V = __m256;
+        using M = __m256;
+        static constexpr size_t W = 8;
+
+        static V zero() { return _mm256_setzero_ps(); }
+        static V set1(float value) { return _mm256_set1_ps(value); }
+        static V load(const float* ptr) { return _mm256_load_ps(ptr); }
+        static V loadu(const float* ptr) { return _mm256_loadu_ps(ptr); }
+        static void store(float* ptr, V v) { _mm256_store_ps(ptr, v); }
+        static void storeu(float* ptr, V v) { _mm256_storeu_ps(ptr, v); }
+
+        static V add(V a, V b) { return _mm256_add_ps(a, b); }
+        static V sub(V a, V b) { return _mm256_sub_ps(a, b); }
+        static V mul(V a, V b) { return _mm256_mul_ps(a, b); }
+        static V div(V a, V b) { return _mm256_div_ps(a, b); }
+        static V fmadd(V a, V b, V c) { return _mm256_fmadd_ps(a, b, c); }
+        static V fnmadd(V a, V b, V c) { return _mm256_fnmadd_ps(a, b, c); }
+        static V min(V a, V b) { return _mm256_min_ps(a, b); }
+        static V max(V a, V b) { return _mm256_max_ps(a, b); }
+        static V sqrt(V a) { return _mm256_sqrt_ps(a); }
+        static V abs(V a) { return _mm256_and_ps(a, _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff))); }
+        static V neg(V a) { return _mm256_xor_ps(a, _mm256_castsi256_ps(_mm256_set1_epi32(int(0x80000000u)))); }
+
+        static M lt(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+        static M le(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+        static M gt(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+        static M ge(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+        static M eq(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+        static M m_and(M a, M b) { return _mm256_and_ps(a, b); }
+        static M m_or(M a, M b) { return _mm256_or_ps(a, b); }
+        static M m_not(M a) { return _mm256_xor_ps(a, _mm256_castsi256_ps(_mm256_set1_epi32(-1))); }
+        static V select(M m, V a, V b) { return _mm256_blendv_ps(b, a, m); }
+        static uint32_t bits(M m) { return uint32_t(_mm256_movemask_ps(m)); }
+
+        static float reduce_add(V v) {
+            __m128 half = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+            __m128 pairs = _mm_add_ps(half, _mm_movehl_ps(half, half));
+            return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, 1)));
+        }
+        static float reduce_min(V v) {
+            __m128 half = _mm_min_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+            __m128 pairs = _mm_min_ps(half, _mm_movehl_ps(half, half));
+            return _mm_cvtss_f32(_mm_min_ss(pairs, _mm_shuffle_ps(pairs, pairs, 1)));
+        }
+        static float reduce_max(V v) {
+            __m128 half = _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+            __m128 pairs = _mm_max_ps(half, _mm_movehl_ps(half, half));
+            return _mm_cvtss_f32(_mm_max_ss(pairs, _mm_shuffle_ps(pairs, pairs, 1)));
+        }
+
+        // Per-128-bit-block primitives for the AoS transposes below
+        template<int Imm> static V shuffle(V a, V b) { return _mm256_shuffle_ps(a, b, Imm); }
+        static V unpacklo(V a, V b) { return _mm256_unpacklo_ps(a, b); }
+        static V unpackhi(V a, V b) { return _mm256_unpackhi_ps(a, b); }
+        static V load_blocks(const float* ptr, size_t stride) {
+            return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(ptr)), _mm_loadu_ps(ptr + stride), 1);
+        }
+        static void store_blocks(float* ptr, size_t stride, V v) {
+            _mm_storeu_ps(ptr, _mm256_castps256_ps128(v));
+            _mm_storeu_ps(ptr + stride, _mm256_extractf128_ps(v, 1));
+        }
+
+        // Lane i from ptr[i * stride], or from base[indices[i * stride]]
+        static __m256i lane_offsets(size_t stride) {
+            return _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(int(stride)));
+        }
+        static V load_strided(const float* ptr, size_t stride) { return _mm256_i32gather_ps(ptr, lane_offsets(stride), 4); }
+        static V gather(const float* base, const uint32_t* indices, size_t stride) {
+            __m256i offsets = _mm256_i32gather_epi32(reinterpret_cast<const int*>(indices), lane_offsets(stride), 4);
+            return _mm256_i32gather_ps(base, offsets, 4);
+        }
+
+#elif E3D_SIMD_TARGET == E3D_SIMD_TARGET_AVX512
+
+        using V = __m512;
+        using M = __mmask16;
+        static constexpr size_t W = 16;
+
+        static V zero() { return _mm512_setzero_ps(); }
+        static V set1(float value) { return _mm512_set1_ps(value); }
+        static V load(const float* ptr) { return _mm512_load_ps(ptr); }
+        static V loadu(const float* ptr) { return _mm512_loadu_ps(ptr); }
+        static void store(float* ptr, V v) { _mm512_store_ps(ptr, v); }
+        static void storeu(float* ptr, V v) { _mm512_storeu_ps(ptr, v); }
+
+        static V add(V a, V b) { return _mm512_add_ps(a, b); }
+        static V sub(V a, V b) { return _mm512_sub_ps(a, b); }
+        static V mul(V a, V b) { return _mm512_mul_ps(a, b); }
+        static V div(V a, V b) { return _mm512_div_ps(a, b); }
+        static V fmadd(V a, V b, V c) { return _mm512_fmadd_ps(a, b, c); }
+        static V fnmadd(V a, V b, V c) { return _mm512_fnmadd_ps(a, b, c); }
+        static V min(V a, V b) { return _mm512_min_ps(a, b); }
+        static V max(V a, V b) { return _mm512_max_ps(a, b); }
+        static V sqrt(V a) { return _mm512_sqrt_ps(a); }
+        static V abs(V a) { return _mm512_abs_ps(a); }
+        static V neg(V a) {
+            return _mm512_castsi512_ps(_mm512_xor_epi32(_mm512_castps_si512(a), _mm512_set1_epi32(int(0x80000000u))));
+        }
+
+        static M lt(V a, V b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+        static M le(V a, V b) { return _mm512_cmp_ps_mask(a, b, _CMP_LE_OQ); }
+        static M gt(V a, V b) { return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ); }
+        static M ge(V a, V b) { return _mm512_cmp_ps_mask(a, b, _CMP_GE_OQ); }
+        static M eq(V a, V b) { return _mm512_cmp_ps_mask(a, b, _CMP_EQ_OQ); }
+        static M m_and(M a, M b) { return M(a & b); }
+        static M m_or(M a, M b) { return M(a | b); }
+        static M m_not(M a) { return M(~a); }
+        static V select(M m, V a, V b) { return _mm512_mask_blend_ps(m, b, a); }
+        static uint32_t bits(M m) { return uint32_t(m); }
+
+        static float reduce_add(V v) { return _mm512_reduce_add_ps(v); }
+        static float reduce_min(V v) { return _mm512_reduce_min_ps(v); }
+        static float reduce_max(V v) { return _mm512_reduce_max_ps(v); }
+
+        // Per-128-bit-block primitives for the AoS transposes below
+        template<int Imm> static V shuffle(V a, V b) { return _mm512_shuffle_ps(a, b, Imm); }
+        static V unpacklo(V a, V b) { return _mm512_unpacklo_ps(a, b); }
+        static V unpackhi(V a, V b) { return _mm512_unpackhi_ps(a, b); }
+        static V load_blocks(const float* ptr, size_t stride) {
+            V v = _mm512_castps128_ps512(_mm_loadu_ps(ptr));
+            v = _mm512_insertf32x4(v, _mm_loadu_ps(ptr + stride), 1);
+            v = _mm512_insertf32x4(v, _mm_loadu_ps(ptr + stride * 2), 2);
+            return _mm512_insertf32x4(v, _mm_loadu_ps(ptr + stride * 3), 3);
+        }
+        static void store_blocks(float* ptr, size_t stride, V v) {
+            _mm_storeu_ps(ptr, _mm512_castps512_ps128(v));
+            _mm_storeu_ps(ptr + stride, _mm512_extractf32x4_ps(v, 1));
+            _mm_storeu_ps(ptr + stride * 2, _mm512_extractf32x4_ps(v, 2));
+            _mm_storeu_ps(ptr + stride * 3, _mm512_extractf32x4_ps(v, 3));
+        }
+
+        // Lane i from ptr[i * stride], or from base[indices[i * stride]]
+        static __m512i lane_offsets(size_t stride) {
+            return _mm512_mullo_epi32(_mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15), _mm512_set1_epi32(int(stride)));
+        }
+        static V load_strided(const float* ptr, size_t stride) { return _mm512_i32gather_ps(lane_offsets(stride), ptr, 4); }
+        static V gather(const float* base, const uint32_t* indices, size_t stride) {
+            __m512i offsets = _mm512_i32gather_epi32(lane_offsets(stride), reinterpret_cast<const int*>(indices), 4);
+            return _mm512_i32gather_ps(offsets, base, 4);
+        }
+
+#endif
+
+        /**
+         * Loads W consecutive xyz triples and splits them into one register per component.
+         * Each 128-bit block handles four triples, so every target shares these shuffles.
+         */
+        static void load_aos3(const float* ptr, V& x, V& y, V& z) {
+            V a = load_blocks(ptr, 12);
+            V b = load_blocks(ptr + 4, 12);
+            V c = load_blocks(ptr + 8, 12);
+            x = shuffle<_MM_SHUFFLE(3, 0, 3, 0)>(a, shuffle<_MM_SHUFFLE(1, 0, 3, 2)>(b, c));
+            y = shuffle<_MM_SHUFFLE(2, 0, 2, 0)>(shuffle<_MM_SHUFFLE(0, 0, 1, 1)>(a, b), shuffle<_MM_SHUFFLE(2, 2, 3, 3)>(b, c));
+            z = shuffle<_MM_SHUFFLE(2, 0, 2, 0)>(shuffle<_MM_SHUFFLE(1, 1, 2, 2)>(a, b), shuffle<_MM_SHUFFLE(3, 3, 0, 0)>(c, c));
+        }
+
+        /**
+         * Interleaves one register per component back into W consecutive xyz triples
+         */
+        static void store_aos3(float* ptr, V x, V y, V z) {
+            V xy_lo = unpacklo(x, y);
+            V xy_hi = unpackhi(x, y);
+            V a = shuffle<_MM_SHUFFLE(2, 0, 1, 0)>(xy_lo, shuffle<_MM_SHUFFLE(1, 1, 0, 0)>(z, x));
+            V b = shuffle<_MM_SHUFFLE(1, 0, 2, 0)>(shuffle<_MM_SHUFFLE(1, 1, 1, 1)>(y, z), xy_hi);
+            V c = shuffle<_MM_SHUFFLE(2, 0, 2, 0)>(shuffle<_MM_SHUFFLE(3, 3, 2, 2)>(z, x), shuffle<_MM_SHUFFLE(3, 3, 3, 3)>(y, z));
+            store_blocks(ptr, 12, a);
+            store_blocks(ptr + 4, 12, b);
+            store_blocks(ptr + 8, 12, c);
+        }
+
+        /**
+         * Loads W consecutive xyzw quadruples and splits them into one register per component
+         */
+        static void load_aos4(const float* ptr, V& x, V& y, V& z, V& w) {
+            transpose4(load_blocks(ptr, 16), load_blocks(ptr + 4, 16), load_blocks(ptr + 8, 16), load_blocks(ptr + 12, 16), x, y, z, w);
+        }
+
+        /**
+         * Interleaves one register per component back into W consecutive xyzw quadruples
+         */
+        static void store_aos4(float* ptr, V x, V y, V z, V w) {
+            V r0, r1, r2, r3;
+            transpose4(x, y, z, w, r0, r1, r2, r3);
+            store_blocks(ptr, 16, r0);
+            store_blocks(ptr + 4, 16, r1);
+            store_blocks(ptr + 8, 16, r2);
+            store_blocks(ptr + 12, 16, r3);
+        }
+
+        /**
+         * Transposes the 4x4 float block in each 128-bit lane of four registers
+         */
+        static void transpose4(V r0, V r1, V r2, V r3, V& c0, V& c1, V& c2, V& c3) {
+            V t0 = unpacklo(r0, r1);
+            V t1 = unpackhi(r0, r1);
+            V t2 = unpacklo(r2, r3);
+            V t3 = unpackhi(r2, r3);
+            c0 = shuffle<_MM_SHUFFLE(1, 0, 1, 0)>(t0, t2);
+            c1 = shuffle<_MM_SHUFFLE(3, 2, 3, 2)>(t0, t2);
+            c2 = shuffle<_MM_SHUFFLE(1, 0, 1, 0)>(t1, t3);
+            c3 = shuffle<_MM_SHUFFLE(3, 2, 3, 2)>(t1, t3);
+        }
+
+    };
+
+#endif
+
+}
@@ -0,0 +1,274 @@
+#pragma once
+
+#include "cpu.h"
+
+#if E3D_SIMD_X86
+#include <immintrin.h>
+#endif
+
+/**
+ * Kernels for the 4x4 * 4x4 and 4x4 * 4x1 products, operating on raw row-major data. The
+ * `_cols` kernels take a column-major matrix instead; column-major 4x4 products reuse the
+ * row-major kernels with their operands swapped.
+ *
+ * Every kernel accumulates each output element as ((((0 + a0*b0) + a1*b1) + a2*b2) + a3*b3),
+ * the same order as the generic `Mat::multiply` loop, so the scalar, SSE2 and AVX kernels
+ * are bit-for-bit identical to it. The AVX2 kernel fuses each multiply-add, skipping one
+ * rounding per step; its results stay within 4 * FLT_EPSILON * sum(|a_ik * b_kj|) of the
+ * generic path.
+ *
+ * Every buffer must be 16-byte aligned, as the data of Mat4 and Vec4 always is, so the SSE
+ * kernels use aligned loads and stores. The output buffer must not alias either input.
+ */
+namespace e3d::simd::mat4 {
+
+    static inline void multiply_scalar(const float* a, const float* b, float* out) {
+        for (int r = 0; r < 4; r++) {
+            const float* row = a + r * 4;
+            for (int c = 0; c < 4; c++) {
+                float sum = 0;
+                sum += row[0] * b[c];
+                sum += row[1] * b[4 + c];
+                sum += row[2] * b[8 + c];
+                sum += row[3] * b[12 + c];
+                out[r * 4 + c] = sum;
+            }
+        }
+    }
+
+    static inline void transform_scalar(const float* m, const float* v, float* out) {
+        for (int r = 0; r < 4; r++) {
+            const float* row = m + r * 4;
+            float sum = 0;
+            sum += row[0] * v[0];
+            sum += row[1] * v[1];
+            sum += row[2] * v[2];
+            sum += row[3] * v[3];
+            out[r] = sum;
+        }
+    }
+
+    static inline void transform_cols_scalar(const float* m, const float* v, float* out) {
+        for (int r = 0; r < 4; r++) {
+            float sum = 0;
+            sum += m[r] * v[0];
+            sum += m[4 + r] * v[1];
+            sum += m[8 + r] * v[2];
+            sum += m[12 + r] * v[3];
+            out[r] = sum;
+        }
+    }
+
+    static inline void transpose_scalar(const float* m, float* out) {
+        for (int r = 0; r < 4; r++) {
+            for (int c = 0; c < 4; c++) out[c * 4 + r] = m[r * 4 + c];
+        }
+    }
+
+#if E3D_SIMD_X86
+
+    E3D_TARGET("sse2")
+    static inline void multiply_sse2(const float* a, const float* b, float* out) {
+
+        // Rows of the right-hand matrix
+        const __m128 b0 = _mm_load_ps(b);
+        const __m128 b1 = _mm_load_ps(b + 4);
+        const __m128 b2 = _mm_load_ps(b + 8);
+        const __m128 b3 = _mm_load_ps(b + 12);
+
+        // Each output row is a linear combination of the rows of b
+        for (int r = 0; r < 4; r++) {
+            const float* row = a + r * 4;
+            __m128 acc = _mm_setzero_ps();
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(row[0]), b0));
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(row[1]), b1));
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(row[2]), b2));
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(row[3]), b3));
+            _mm_store_ps(out + r * 4, acc);
+        }
+
+    }
+
+    E3D_TARGET("sse2")
+    static inline void transform_sse2(const float* m, const float* v, float* out) {
+
+        // Transpose the matrix so that each register holds a column
+        __m128 c0 = _mm_load_ps(m);
+        __m128 c1 = _mm_load_ps(m + 4);
+        __m128 c2 = _mm_load_ps(m + 8);
+        __m128 c3 = _mm_load_ps(m + 12);
+        _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+        // The result is a linear combination of the columns
+        __m128 acc = _mm_setzero_ps();
+        acc = _mm_add_ps(acc, _mm_mul_ps(c0, _mm_set1_ps(v[0])));
+        acc = _mm_add_ps(acc, _mm_mul_ps(c1, _mm_set1_ps(v[1])));
+        acc = _mm_add_ps(acc, _mm_mul_ps(c2, _mm_set1_ps(v[2])));
+        acc = _mm_add_ps(acc, _mm_mul_ps(c3, _mm_set1_ps(v[3])));
+        _mm_store_ps(out, acc);
+
+    }
+
+    E3D_TARGET("sse2")
+    static inline void transform_cols_sse2(const float* m, const float* v, float* out) {
+
+        // The columns are already in registers, so the result is a linear combination of them
+        __m128 acc = _mm_setzero_ps();
+        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_load_ps(m), _mm_set1_ps(v[0])));
+        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_load_ps(m + 4), _mm_set1_ps(v[1])));
+        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_load_ps(m + 8), _mm_set1_ps(v[2])));
+        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_load_ps(m + 12), _mm_set1_ps(v[3])));
+        _mm_store_ps(out, acc);
+
+    }
+
+    E3D_TARGET("sse2")
+    static inline void transpose_sse2(const float* m, float* out) {
+        __m128 r0 = _mm_load_ps(m);
+        __m128 r1 = _mm_load_ps(m + 4);
+        __m128 r2 = _mm_load_ps(m + 8);
+        __m128 r3 = _mm_load_ps(m + 12);
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+        _mm_store_ps(out, r0);
+        _mm_store_ps(out + 4, r1);
+        _mm_store_ps(out + 8, r2);
+        _mm_store_ps(out + 12, r3);
+    }
+
+    E3D_TARGET("avx")
+    static inline void multiply_avx(const float* a, const float* b, float* out) {
+
+        // Rows of the right-hand matrix, duplicated into both 128-bit lanes
+        const __m256 b0 = _mm256_broadcast_ps((const __m128*)b);
+        const __m256 b1 = _mm256_broadcast_ps((const __m128*)(b + 4));
+        const __m256 b2 = _mm256_broadcast_ps((const __m128*)(b + 8));
+        const __m256 b3 = _mm256_broadcast_ps((const __m128*)(b + 12));
+
+        // Two output rows per iteration, one in each lane
+        for (int r = 0; r < 4; r += 2) {
+            const __m256 rows = _mm256_loadu_ps(a + r * 4);
+            __m256 acc = _mm256_setzero_ps();
+            acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_permute_ps(rows, 0x00), b0));
+            acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_permute_ps(rows, 0x55), b1));
+            acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_permute_ps(rows, 0xAA), b2));
+            acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_permute_ps(rows, 0xFF), b3));
+            _mm256_storeu_ps(out + r * 4, acc);
+        }
+
+    }
+
+    E3D_TARGET("avx2,fma")
+    static inline void multiply_avx2(const float* a, const float* b, float* out) {
+
+        // Rows of the right-hand matrix, duplicated into both 128-bit lanes
+        const __m256 b0 = _mm256_broadcast_ps((const __m128*)b);
+        const __m256 b1 = _mm256_broadcast_ps((const __m128*)(b + 4));
+        const __m256 b2 = _mm256_broadcast_ps((const __m128*)(b + 8));
+        const __m256 b3 = _mm256_broadcast_ps((const __m128*)(b + 12));
+
+        // Two output rows per iteration, one in each lane
+        for (int r = 0; r < 4; r += 2) {
+            const __m256 rows = _mm256_loadu_ps(a + r * 4);
+            __m256 acc = _mm256_mul_ps(_mm256_permute_ps(rows, 0x00), b0);
+            acc = _mm256_fmadd_ps(_mm256_permute_ps(rows, 0x55), b1, acc);
+            acc = _mm256_fmadd_ps(_mm256_permute_ps(rows, 0xAA), b2, acc);
+            acc = _mm256_fmadd_ps(_mm256_permute_ps(rows, 0xFF), b3, acc);
+            _mm256_storeu_ps(out + r * 4, acc);
+        }
+
+    }
+
+    E3D_TARGET("avx2,fma")
+    static inline void transform_avx2(const float* m, const float* v, float* out) {
+
+        // Transpose the matrix so that each register holds a column
+        __m128 c0 = _mm_load_ps(m);
+        __m128 c1 = _mm_load_ps(m + 4);
+        __m128 c2 = _mm_load_ps(m + 8);
+        __m128 c3 = _mm_load_ps(m + 12);
+        _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+        // The result is a linear combination of the columns
+        __m128 acc = _mm_mul_ps(c0, _mm_set1_ps(v[0]));
+        acc = _mm_fmadd_ps(c1, _mm_set1_ps(v[1]), acc);
+        acc = _mm_fmadd_ps(c2, _mm_set1_ps(v[2]), acc);
+        acc = _mm_fmadd_ps(c3, _mm_set1_ps(v[3]), acc);
+        _mm_store_ps(out, acc);
+
+    }
+
+    E3D_TARGET("avx2,fma")
+    static inline void transform_cols_avx2(const float* m, const float* v, float* out) {
+
+        // The columns are already in registers, so the result is a linear combination of them
+        __m128 acc = _mm_mul_ps(_mm_load_ps(m), _mm_set1_ps(v[0]));
+        acc = _mm_fmadd_ps(_mm_load_ps(m + 4), _mm_set1_ps(v[1]), acc);
+        acc = _mm_fmadd_ps(_mm_load_ps(m + 8), _mm_set1_ps(v[2]), acc);
+        acc = _mm_fmadd_ps(_mm_load_ps(m + 12), _mm_set1_ps(v[3]), acc);
+        _mm_store_ps(out, acc);
+
+    }
+
+#endif
+
+    /**
+     * Multiplies two row-major 4x4 matrices, using the best kernel for the active SIMD level
+     */
+    static inline void multiply(const float* a, const float* b, float* out) {
+#if E3D_SIMD_X86
+        switch (level()) {
+            case Level::avx512:
+            case Level::avx2: return multiply_avx2(a, b, out);
+            case Level::avx: return multiply_avx(a, b, out);
+            case Level::sse2: return multiply_sse2(a, b, out);
+            default: break;
+        }
+#endif
+        multiply_scalar(a, b, out);
+    }
+
+    /**
+     * Multiplies a row-major 4x4 matrix with a 4-component vector, using the best kernel for
+     * the active SIMD level
+     */
+    static inline void transform(const float* m, const float* v, float* out) {
+#if E3D_SIMD_X86
+        switch (level()) {
+            case Level::avx512:
+            case Level::avx2: return transform_avx2(m, v, out);
+            case Level::avx:
+            case Level::sse2: return transform_sse2(m, v, out);
+            default: break;
+        }
+#endif
+        transform_scalar(m, v, out);
+    }
+
+    /**
+     * Multiplies a column-major 4x4 matrix with a 4-component vector, using the best kernel
+     * for the active SIMD level
+     */
+    static inline void transform_cols(const float* m, const float* v, float* out) {
+#if E3D_SIMD_X86
+        switch (level()) {
+            case Level::avx512:
+            case Level::avx2: return transform_cols_avx2(m, v, out);
+            case Level::avx:
+            case Level::sse2: return transform_cols_sse2(m, v, out);
+            default: break;
+        }
+#endif
+        transform_cols_scalar(m, v, out);
+    }
+
+    /**
+     * Transposes a 4x4 matrix, which also converts one between row-major and column-major
+     */
+    static inline void transpose(const float* m, float* out) {
+#if E3D_SIMD_X86
+        if (level() != Level::scalar) return transpose_sse2(m, out);
+#endif
+        transpose_scalar(m, out);
+    }
+
+}
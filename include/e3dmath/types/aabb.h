@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cmath>
+#include <algorithm>
+#include "vec.h"
+#include "point.h"
+
+namespace e3d {
+
+    /**
+     * An axis-aligned bounding box, from its minimum to its maximum corner. A default box is
+     * empty, with its minimum at +infinity and its maximum at -infinity, so growing it by
+     * anything gives that thing's bounds.
+     */
+    struct Aabb3 {
+
+        Point3 min;
+        Point3 max;
+
+        Aabb3() {
+            for (uint8_t c = 0; c < 3; c++) {
+                this->min.set(c, INFINITY);
+                this->max.set(c, -INFINITY);
+            }
+        }
+        Aabb3(const Point3& min, const Point3& max) : min(min), max(max) {}
+
+        /**
+         * Checks whether the box contains nothing at all
+         */
+        bool empty() const {
+            return !(this->min.get(0) <= this->max.get(0) && this->min.get(1) <= this->max.get(1) && this->min.get(2) <= this->max.get(2));
+        }
+
+        /**
+         * Gets the point in the middle of the box
+         */
+        Point3 center() const {
+            return (this->min + this->max) * 0.5f;
+        }
+
+        /**
+         * Gets half the size of the box along each axis
+         */
+        Vec3 extent() const {
+            return (this->max - this->min) * 0.5f;
+        }
+
+        /**
+         * Grows the box to contain a point
+         */
+        void grow(const Point3& point) {
+            for (uint8_t c = 0; c < 3; c++) {
+                this->min.set(c, std::min(this->min.get(c), point.get(c)));
+                this->max.set(c, std::max(this->max.get(c), point.get(c)));
+            }
+        }
+
+        /**
+         * Grows the box to contain another box
+         */
+        void grow(const Aabb3& other) {
+            for (uint8_t c = 0; c < 3; c++) {
+                this->min.set(c, std::min(this->min.get(c), other.min.get(c)));
+                this->max.set(c, std::max(this->max.get(c), other.max.get(c)));
+            }
+        }
+
+        /**
+         * Checks whether a point is inside the box or on its surface
+         */
+        bool contains(const Point3& point) const {
+            for (uint8_t c = 0; c < 3; c++) {
+                if (!(point.get(c) >= this->min.get(c) && point.get(c) <= this->max.get(c))) return false;
+            }
+            return true;
+        }
+
+        /**
+         * Checks whether two boxes overlap or touch
+         */
+        bool intersects(const Aabb3& other) const {
+            for (uint8_t c = 0; c < 3; c++) {
+                if (!(other.min.get(c) <= this->max.get(c) && other.max.get(c) >= this->min.get(c))) return false;
+            }
+            return true;
+        }
+
+    };
+
+}
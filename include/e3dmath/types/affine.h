@@ -0,0 +1,181 @@
+#pragma once
+
+#include <iostream>
+#include <cinttypes>
+#include "mat.h"
+#include "vec.h"
+
+namespace e3d {
+
+    /**
+     * An affine transformation in 3-dimensions, stored as the top three rows of a row-major
+     * 4x4 matrix. The bottom row of an affine matrix is always (0, 0, 0, 1), so it isn't
+     * stored, and composing or applying transforms skips the work it would take.
+     *
+     * The left 3x3 block is the linear part (rotation, scale, shear) and the right column is
+     * the translation.
+     */
+    struct Affine3 {
+
+        /**
+         * Constructs the identity transform
+         */
+        static constexpr Affine3 identity();
+
+        /**
+         * Constructs a transform from the top three rows of a 4x4 matrix. The bottom row is
+         * assumed to be (0, 0, 0, 1), which is true for every matrix built by `utils::mat`
+         * apart from projections.
+         */
+        static constexpr Affine3 from_mat4(const Mat4& mat);
+
+        /**
+         * The raw data, 3 rows of 4 values. Aligned to 16 bytes, so each row is aligned.
+         */
+        alignas(16) float data[12];
+
+        /**
+         * Constructs a transform with all values set to zero
+         */
+        constexpr Affine3();
+
+        /**
+         * Constructs a transform with an array of 12 raw values
+         */
+        constexpr Affine3(const float values[12]);
+
+        /**
+         * Gets a value by row and column
+         */
+        constexpr float get(uint8_t r, uint8_t c) const { return this->data[r * 4 + c]; }
+
+        /**
+         * Sets a value by row and column
+         */
+        constexpr void set(uint8_t r, uint8_t c, float value) { this->data[r * 4 + c] = value; }
+
+        /**
+         * Gets the translation column
+         */
+        constexpr Vec3 translation() const;
+
+        /**
+         * Expands the transform into a 4x4 matrix, ie. to combine it with a projection. The
+         * conversion is exact, so `from_mat4(a.to_mat4())` gives back `a`.
+         */
+        constexpr Mat4 to_mat4() const;
+
+        /**
+         * Composes this transform with another, so that the result applies `other` first and
+         * then this one. This is the same as multiplying the 4x4 matrices, with 36
+         * multiplications instead of 64.
+         */
+        constexpr Affine3 multiply(const Affine3& other) const;
+
+        /**
+         * Operator overload for composing with another transform
+         */
+        constexpr Affine3 operator*(const Affine3& other) const { return this->multiply(other); }
+
+        /**
+         * Creates a string representation of the transform
+         */
+        std::string to_str() const { return this->to_mat4().to_str(); }
+
+    };
+
+    constexpr Affine3::Affine3() : data{} {
+
+        // The member initializer sets the data to zero
+
+    }
+
+    constexpr Affine3::Affine3(const float values[12]) : data{} {
+
+        // Copy the values
+        for (int i = 0; i < 12; i++) this->data[i] = values[i];
+
+    }
+
+    constexpr Affine3 Affine3::identity() {
+
+        // Create the transform
+        Affine3 result;
+
+        // Set the diagonal
+        result.set(0, 0, 1);
+        result.set(1, 1, 1);
+        result.set(2, 2, 1);
+
+        // Return the result
+        return result;
+
+    }
+
+    constexpr Affine3 Affine3::from_mat4(const Mat4& mat) {
+
+        // Copy the top three rows
+        return Affine3(mat.data);
+
+    }
+
+    constexpr Vec3 Affine3::translation() const {
+
+        // Create the vector from the last column
+        Vec3 result;
+        result.set(0, this->data[3]);
+        result.set(1, this->data[7]);
+        result.set(2, this->data[11]);
+        return result;
+
+    }
+
+    constexpr Mat4 Affine3::to_mat4() const {
+
+        // Copy the top three rows
+        Mat4 result;
+        for (int i = 0; i < 12; i++) result.data[i] = this->data[i];
+
+        // Fill in the constant bottom row
+        result.data[15] = 1;
+        return result;
+
+    }
+
+    constexpr Affine3 Affine3::multiply(const Affine3& other) const {
+
+        // Create the result transform
+        Affine3 result;
+
+        // Loop through the rows of this transform
+        for (int r = 0; r < 3; r++) {
+
+            // Get the row values
+            const float* row = this->data + r * 4;
+
+            // The linear part only mixes the linear parts
+            for (int c = 0; c < 3; c++) {
+                result.data[r * 4 + c] = row[0] * other.data[c] + row[1] * other.data[4 + c] + row[2] * other.data[8 + c];
+            }
+
+            // The translation is this row applied to the other translation, as a point
+            result.data[r * 4 + 3] = row[0] * other.data[3] + row[1] * other.data[7] + row[2] * other.data[11] + row[3];
+
+        }
+
+        // Return the result
+        return result;
+
+    }
+
+    inline ::std::ostream& operator<<(::std::ostream& out, const Affine3& obj) {
+
+        // Print the buffered string value
+        out << obj.to_str();
+
+        // Return the stream
+        return out;
+
+    }
+
+}
@@ -0,0 +1,788 @@
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+#include <cmath>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+#include "vec.h"
+#include "point.h"
+#include "polygon.h"
+#include "mesh.h"
+#include "ray.h"
+#include "aabb.h"
+#include "../utils/parallel.h"
+
+namespace e3d {
+
+    /**
+     * The closest point on a mesh to a query point
+     */
+    struct PointHit {
+
+        /**
+         * The closest point itself
+         */
+        Point3 point;
+
+        /**
+         * Its distance from the query point
+         */
+        float distance;
+
+        /**
+         * The index of the triangle it's on
+         */
+        uint32_t triangle;
+
+    };
+
+    /**
+     * A bounding volume hierarchy over a triangle mesh, which answers ray casts and
+     * closest-point queries without testing every triangle.
+     *
+     * It's built top-down with the surface area heuristic, evaluated over a fixed number of
+     * bins per axis. Large nodes bin their triangles in parallel, and separate subtrees are
+     * built in parallel across the shared thread pool (see utils/parallel.h). The tree comes
+     * out the same however many threads build it, and ties between equally close triangles
+     * go to the lowest index, so query results are deterministic too.
+     *
+     * The BVH keeps its own copy of the triangles, in leaf order. When a mesh deforms without
+     * changing its triangles, `refit` reloads them and updates the bounds without rebuilding
+     * the tree. Queries stay exact, but get slower as the mesh moves away from the shape it
+     * was built for.
+     */
+    class Bvh {
+    public:
+
+        /**
+         * The triangle of a miss
+         */
+        static constexpr uint32_t none = UINT32_MAX;
+
+        /**
+         * The most triangles a leaf may hold
+         */
+        static constexpr uint32_t max_leaf_size = 8;
+
+        /**
+         * The number of bins per axis when looking for the best split. Nodes with fewer
+         * triangles than this use one bin per triangle.
+         */
+        static constexpr uint32_t bins = 16;
+
+        /**
+         * The number of triangles each thread takes at a time while building. Smaller
+         * subtrees are built on a single thread.
+         */
+        static constexpr size_t grain = 1 << 12;
+
+        /**
+         * The number of rays each thread takes at a time in batch queries
+         */
+        static constexpr size_t query_grain = 256;
+
+        Bvh() {}
+        explicit Bvh(const MeshView& mesh) { this->build(mesh); }
+        Bvh(const Tri3* tris, size_t count) { this->build(tris, count); }
+
+        /**
+         * Builds the tree over an indexed mesh, replacing any previous one
+         */
+        void build(const MeshView& mesh) { this->_build(mesh.triangle_count, _MeshCorners { mesh }); }
+
+        /**
+         * Builds the tree over an array of triangles, replacing any previous one
+         */
+        void build(const Tri3* tris, size_t count) { this->_build(count, _TriCorners { tris }); }
+
+        /**
+         * Updates the tree for new vertex positions. The mesh must have the same triangles,
+         * in the same order, as when it was built.
+         */
+        void refit(const MeshView& mesh) { this->_refit(_MeshCorners { mesh }); }
+
+        /**
+         * Updates the tree for moved triangles. The array must be the same size as when it
+         * was built.
+         */
+        void refit(const Tri3* tris) { this->_refit(_TriCorners { tris }); }
+
+        size_t triangle_count() const { return this->ids.size(); }
+        size_t node_count() const { return this->nodes.size(); }
+
+        /**
+         * Gets the bounding box of every triangle, which is empty if there aren't any
+         */
+        Aabb3 bounds() const {
+            if (this->nodes.empty()) return Aabb3();
+            const _Bounds& root = this->nodes[0].bounds;
+            return Aabb3(Point3(root.min), Point3(root.max));
+        }
+
+        /**
+         * Finds the closest triangle the ray hits within `t_max`. Triangles are double-sided.
+         */
+        bool intersect(const Ray3& ray, RayHit& hit, float t_max = INFINITY) const {
+            hit.t = t_max;
+            hit.triangle = none;
+            return this->_traverse<false>(ray, hit);
+        }
+
+        /**
+         * Checks whether the ray hits any triangle within `t_max`, stopping at the first one
+         * found. This is cheaper than `intersect`, ie. for shadow rays.
+         */
+        bool occluded(const Ray3& ray, float t_max = INFINITY) const {
+            RayHit hit;
+            hit.t = t_max;
+            hit.triangle = none;
+            return this->_traverse<true>(ray, hit);
+        }
+
+        /**
+         * Finds the closest hit of each ray, across the thread pool. Misses get a triangle of
+         * `none`.
+         */
+        void intersect(const Ray3* rays, RayHit* hits, size_t count, float t_max = INFINITY) const {
+            utils::parallel::for_range(0, count, query_grain, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; i++) this->intersect(rays[i], hits[i], t_max);
+            });
+        }
+
+        /**
+         * Checks whether each ray hits anything, across the thread pool
+         */
+        void occluded(const Ray3* rays, uint8_t* out, size_t count, float t_max = INFINITY) const {
+            utils::parallel::for_range(0, count, query_grain, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; i++) out[i] = this->occluded(rays[i], t_max) ? 1 : 0;
+            });
+        }
+
+        /**
+         * Finds the closest point on the mesh to `point`, within `max_distance`. On a miss the
+         * triangle is `none`, the point is `point` and the distance is `max_distance`.
+         */
+        bool closest_point(const Point3& point, PointHit& hit, float max_distance = INFINITY) const {
+            hit.point = point;
+            hit.distance = max_distance;
+            hit.triangle = none;
+            if (this->nodes.empty()) return false;
+
+            // Visit the nearest boxes first, and skip any further than the best point so far
+            float p[3] = { point.data[0], point.data[1], point.data[2] };
+            float best = max_distance * max_distance, best_point[3] = { p[0], p[1], p[2] };
+            _Entry stack[_stack_size];
+            size_t top = 0;
+            stack[top++] = { 0, this->nodes[0].bounds.distance2(p) };
+            while (top > 0) {
+                _Entry entry = stack[--top];
+                if (entry.t > best) continue;
+                const _Node& node = this->nodes[entry.node];
+
+                // Check each triangle in a leaf
+                if (node.count > 0) {
+                    for (uint32_t slot = node.offset; slot < node.offset + node.count; slot++) {
+                        float closest[3];
+                        _closest_on_triangle(this->triangles[slot], p, closest);
+                        float distance2 = 0;
+                        for (int c = 0; c < 3; c++) distance2 += (closest[c] - p[c]) * (closest[c] - p[c]);
+                        if (distance2 < best || (distance2 == best && this->ids[slot] < hit.triangle)) {
+                            best = distance2;
+                            for (int c = 0; c < 3; c++) best_point[c] = closest[c];
+                            hit.triangle = this->ids[slot];
+                        }
+                    }
+                    continue;
+                }
+
+                // Queue the children, nearest on top
+                _Entry left = { entry.node + 1, this->nodes[entry.node + 1].bounds.distance2(p) };
+                _Entry right = { node.offset, this->nodes[node.offset].bounds.distance2(p) };
+                if (right.t < left.t) std::swap(left, right);
+                if (right.t <= best) stack[top++] = right;
+                if (left.t <= best) stack[top++] = left;
+
+            }
+            if (hit.triangle == none) return false;
+
+            // Return the point
+            hit.point = Point3(best_point);
+            hit.distance = sqrtf(best);
+            return true;
+
+        }
+
+    private:
+
+        /**
+         * Splits below this depth only by the surface area heuristic. Deeper nodes split in
+         * half, which bounds the depth of the tree.
+         */
+        static constexpr uint32_t _sah_depth = 64;
+
+        /**
+         * The traversal stack, which never holds more than the depth of the tree plus one
+         */
+        static constexpr size_t _stack_size = 128;
+
+        struct _Bounds {
+
+            float min[3] = { INFINITY, INFINITY, INFINITY };
+            float max[3] = { -INFINITY, -INFINITY, -INFINITY };
+
+            void grow(const float* point) {
+                for (int c = 0; c < 3; c++) {
+                    this->min[c] = std::min(this->min[c], point[c]);
+                    this->max[c] = std::max(this->max[c], point[c]);
+                }
+            }
+
+            void grow(const _Bounds& other) {
+                for (int c = 0; c < 3; c++) {
+                    this->min[c] = std::min(this->min[c], other.min[c]);
+                    this->max[c] = std::max(this->max[c], other.max[c]);
+                }
+            }
+
+            float area() const {
+                if (this->min[0] > this->max[0]) return 0;
+                float x = this->max[0] - this->min[0], y = this->max[1] - this->min[1], z = this->max[2] - this->min[2];
+                return 2 * (x * y + y * z + z * x);
+            }
+
+            /**
+             * The squared distance from a point to the box, or zero if it's inside
+             */
+            float distance2(const float* point) const {
+                float sum = 0;
+                for (int c = 0; c < 3; c++) {
+                    float outside = std::max(std::max(this->min[c] - point[c], point[c] - this->max[c]), 0.0f);
+                    sum += outside * outside;
+                }
+                return sum;
+            }
+
+            /**
+             * Intersects a ray with the box, as the overlap of the ray's spans between each
+             * pair of planes. Components where the ray starts exactly on a plane it runs along
+             * come out as NaN, and the comparisons are ordered so they're ignored.
+             */
+            bool intersect(const float* origin, const float* inverse, float t_max, float& t_entry) const {
+                float t0 = 0, t1 = t_max;
+                for (int c = 0; c < 3; c++) {
+                    float near = (this->min[c] - origin[c]) * inverse[c];
+                    float far = (this->max[c] - origin[c]) * inverse[c];
+                    if (inverse[c] < 0) std::swap(near, far);
+                    t0 = near > t0 ? near : t0;
+                    t1 = far < t1 ? far : t1;
+                }
+                t_entry = t0;
+                return t0 <= t1;
+            }
+
+        };
+
+        /**
+         * A node of the tree. Left children directly follow their parents, so interior nodes
+         * (with a count of zero) only store where their right child is. Leaves store the
+         * range of triangles they hold.
+         */
+        struct _Node {
+            _Bounds bounds;
+            uint32_t offset;
+            uint32_t count;
+        };
+
+        /**
+         * A triangle as its first corner and the two edges from it, ready for intersection
+         */
+        struct _Triangle {
+            float v0[3];
+            float e1[3];
+            float e2[3];
+        };
+
+        /**
+         * A node waiting to be visited, and its distance along the ray (or squared distance
+         * from the point)
+         */
+        struct _Entry {
+            uint32_t node;
+            float t;
+        };
+
+        struct _MeshCorners {
+            MeshView mesh;
+            void operator()(size_t tri, int corner, float* out) const {
+                uint32_t index = this->mesh.indices[tri * 3 + corner];
+                for (int c = 0; c < 3; c++) out[c] = this->mesh.positions.data[c][index];
+            }
+        };
+
+        struct _TriCorners {
+            const Tri3* tris;
+            void operator()(size_t tri, int corner, float* out) const {
+                for (int c = 0; c < 3; c++) out[c] = this->tris[tri].points[corner].data[c];
+            }
+        };
+
+        /**
+         * A triangle while building, with its bounds and centroid. These are moved around
+         * rather than indices to them, so that each node reads its triangles in order.
+         */
+        struct _Ref {
+            _Bounds bounds;
+            float centroid[3];
+            uint32_t id;
+        };
+
+        /**
+         * The bounds of a range of triangles, and of their centroids
+         */
+        struct _RangeBounds {
+            _Bounds bounds;
+            _Bounds centroids;
+            void merge(const _RangeBounds& other) {
+                this->bounds.grow(other.bounds);
+                this->centroids.grow(other.centroids);
+            }
+        };
+
+        /**
+         * The triangles in each bin of each axis
+         */
+        struct _Bins {
+            _Bounds bounds[3][bins];
+            uint32_t counts[3][bins] = {};
+            void merge(const _Bins& other) {
+                for (int axis = 0; axis < 3; axis++) {
+                    for (uint32_t bin = 0; bin < bins; bin++) {
+                        this->bounds[axis][bin].grow(other.bounds[axis][bin]);
+                        this->counts[axis][bin] += other.counts[axis][bin];
+                    }
+                }
+            }
+        };
+
+        /**
+         * The state shared by the tasks building a tree. Nodes are allocated in pairs of
+         * siblings, in whatever order the tasks get to them, and sorted out afterwards.
+         */
+        struct _Builder {
+            std::vector<_Ref> refs;
+            std::vector<_Node> nodes;
+            std::atomic<uint32_t> used { 1 };
+        };
+
+        /**
+         * Runs `fn(begin, end, partial)` over fixed blocks of [begin, end) across the thread
+         * pool, and merges the partial results in block order
+         */
+        template<class T, class Fn>
+        static T _reduce(size_t begin, size_t end, const Fn& fn) {
+
+            // Small ranges run inline
+            if (end - begin <= grain) {
+                T result;
+                fn(begin, end, result);
+                return result;
+            }
+
+            // Otherwise each block gets its own partial result
+            size_t blocks = (end - begin + grain - 1) / grain;
+            std::vector<T> partials(blocks);
+            utils::parallel::for_range(0, blocks, 1, [&](size_t first, size_t last) {
+                for (size_t block = first; block < last; block++) {
+                    size_t block_begin = begin + block * grain;
+                    fn(block_begin, std::min(end, block_begin + grain), partials[block]);
+                }
+            });
+            for (size_t block = 1; block < blocks; block++) partials[0].merge(partials[block]);
+            return partials[0];
+
+        }
+
+        /**
+         * The bin a centroid falls in
+         */
+        static uint32_t _bin(float centroid, float min, float scale, uint32_t count) {
+            return std::min(count - 1, uint32_t((centroid - min) * scale));
+        }
+
+        template<class Corners>
+        void _build(size_t count, const Corners& corners) {
+            this->nodes.clear();
+            this->triangles.clear();
+            this->ids.clear();
+            if (count == 0) return;
+
+            // Find the bounds and centroid of each triangle
+            _Builder builder;
+            builder.refs.resize(count);
+            utils::parallel::for_range(0, count, grain, [&](size_t begin, size_t end) {
+                for (size_t tri = begin; tri < end; tri++) {
+                    _Ref& ref = builder.refs[tri];
+                    for (int corner = 0; corner < 3; corner++) {
+                        float position[3];
+                        corners(tri, corner, position);
+                        ref.bounds.grow(position);
+                    }
+                    for (int c = 0; c < 3; c++) ref.centroid[c] = (ref.bounds.min[c] + ref.bounds.max[c]) * 0.5f;
+                    ref.id = uint32_t(tri);
+                }
+            });
+
+            // Split the triangles recursively, starting with all of them in the root
+            builder.nodes.resize(count * 2 - 1);
+            _split(builder, 0, 0, count, 0);
+            this->ids.resize(count);
+            for (size_t slot = 0; slot < count; slot++) this->ids[slot] = builder.refs[slot].id;
+
+            // Lay the nodes out depth-first, so left children follow their parents. Right
+            // children point their parents at where they land.
+            struct Pending {
+                uint32_t node;
+                uint32_t parent;
+            };
+            this->nodes.reserve(builder.used.load());
+            std::vector<Pending> stack = { { 0, none } };
+            while (!stack.empty()) {
+                Pending pending = stack.back();
+                stack.pop_back();
+                uint32_t index = uint32_t(this->nodes.size());
+                if (pending.parent != none) this->nodes[pending.parent].offset = index;
+                const _Node& node = builder.nodes[pending.node];
+                this->nodes.push_back(node);
+                if (node.count == 0) {
+                    stack.push_back({ node.offset + 1, index });
+                    stack.push_back({ node.offset, none });
+                }
+            }
+
+            // Copy the triangles in leaf order
+            this->_load_triangles(corners, nullptr);
+
+        }
+
+        /**
+         * Makes `index` the node over [begin, end) of the triangles, and splits it further if
+         * that's worth it
+         */
+        static void _split(_Builder& builder, uint32_t index, size_t begin, size_t end, uint32_t depth) {
+            _Node& node = builder.nodes[index];
+            size_t count = end - begin;
+
+            // Find the bounds of the triangles, and of their centroids
+            _RangeBounds range = _reduce<_RangeBounds>(begin, end, [&](size_t first, size_t last, _RangeBounds& partial) {
+                _RangeBounds local;
+                for (size_t i = first; i < last; i++) {
+                    local.bounds.grow(builder.refs[i].bounds);
+                    local.centroids.grow(builder.refs[i].centroid);
+                }
+                partial = local;
+            });
+            node.bounds = range.bounds;
+
+            // Find the cheapest split between bins, by the surface area heuristic
+            int best_axis = -1;
+            uint32_t best_bin = 0;
+            float best_cost = INFINITY;
+            uint32_t bin_count = uint32_t(std::min<size_t>(bins, count));
+            float scales[3];
+            for (int axis = 0; axis < 3; axis++) {
+                float extent = range.centroids.max[axis] - range.centroids.min[axis];
+                scales[axis] = extent > 0 ? float(bin_count) / extent : 0;
+            }
+            if (count > 1 && depth < _sah_depth) {
+
+                // Sort the triangles into bins along each axis
+                _Bins binned = _reduce<_Bins>(begin, end, [&](size_t first, size_t last, _Bins& partial) {
+                    _Bins local;
+                    for (size_t i = first; i < last; i++) {
+                        const _Ref& ref = builder.refs[i];
+                        for (int axis = 0; axis < 3; axis++) {
+                            uint32_t bin = _bin(ref.centroid[axis], range.centroids.min[axis], scales[axis], bin_count);
+                            local.bounds[axis][bin].grow(ref.bounds);
+                            local.counts[axis][bin]++;
+                        }
+                    }
+                    partial = local;
+                });
+
+                // Sweep from the right for the cost of each right side, then from the left
+                for (int axis = 0; axis < 3; axis++) {
+                    if (scales[axis] == 0) continue;
+                    float right_costs[bins];
+                    _Bounds right;
+                    uint32_t right_count = 0;
+                    for (uint32_t bin = bin_count - 1; bin > 0; bin--) {
+                        right.grow(binned.bounds[axis][bin]);
+                        right_count += binned.counts[axis][bin];
+                        right_costs[bin] = right.area() * float(right_count);
+                    }
+                    _Bounds left;
+                    uint32_t left_count = 0;
+                    for (uint32_t bin = 0; bin < bin_count - 1; bin++) {
+                        left.grow(binned.bounds[axis][bin]);
+                        left_count += binned.counts[axis][bin];
+                        if (left_count == 0 || left_count == count) continue;
+                        float cost = left.area() * float(left_count) + right_costs[bin + 1];
+                        if (cost < best_cost) {
+                            best_cost = cost;
+                            best_axis = axis;
+                            best_bin = bin;
+                        }
+                    }
+                }
+
+            }
+
+            // Stop if testing every triangle is cheaper than a split, counting a box test as
+            // costing as much as a triangle test
+            float area = node.bounds.area();
+            if (count <= max_leaf_size && (best_axis < 0 || float(count) * area <= area + best_cost)) {
+                node.offset = uint32_t(begin);
+                node.count = uint32_t(count);
+                return;
+            }
+
+            // Move the triangles on the left of the split to the front
+            size_t mid = begin;
+            if (best_axis >= 0) {
+                float min = range.centroids.min[best_axis], scale = scales[best_axis];
+                mid = std::partition(builder.refs.begin() + begin, builder.refs.begin() + end, [&](const _Ref& ref) {
+                    return _bin(ref.centroid[best_axis], min, scale, bin_count) <= best_bin;
+                }) - builder.refs.begin();
+            }
+
+            // Without a good split (ie. the centroids all coincide, or the tree is too deep),
+            // split in half along the widest axis
+            else {
+                int axis = 0;
+                for (int c = 1; c < 3; c++) {
+                    if (range.centroids.max[c] - range.centroids.min[c] > range.centroids.max[axis] - range.centroids.min[axis]) axis = c;
+                }
+                mid = begin + count / 2;
+                std::nth_element(builder.refs.begin() + begin, builder.refs.begin() + mid, builder.refs.begin() + end, [&](const _Ref& a, const _Ref& b) {
+                    return a.centroid[axis] < b.centroid[axis] || (a.centroid[axis] == b.centroid[axis] && a.id < b.id);
+                });
+            }
+
+            // Build the children, in parallel if they're big enough
+            uint32_t left = builder.used.fetch_add(2);
+            node.offset = left;
+            node.count = 0;
+            if (count < grain) {
+                _split(builder, left, begin, mid, depth + 1);
+                _split(builder, left + 1, mid, end, depth + 1);
+                return;
+            }
+            utils::parallel::for_range(0, 2, 1, [&](size_t first, size_t last) {
+                for (size_t child = first; child < last; child++) {
+                    if (child == 0) _split(builder, left, begin, mid, depth + 1);
+                    else _split(builder, left + 1, mid, end, depth + 1);
+                }
+            });
+
+        }
+
+        /**
+         * Copies the triangles into leaf order, and optionally their bounds
+         */
+        template<class Corners>
+        void _load_triangles(const Corners& corners, std::vector<_Bounds>* bounds) {
+            this->triangles.resize(this->ids.size());
+            utils::parallel::for_range(0, this->ids.size(), grain, [&](size_t begin, size_t end) {
+                for (size_t slot = begin; slot < end; slot++) {
+                    float positions[3][3];
+                    for (int corner = 0; corner < 3; corner++) corners(this->ids[slot], corner, positions[corner]);
+                    _Triangle& tri = this->triangles[slot];
+                    for (int c = 0; c < 3; c++) {
+                        tri.v0[c] = positions[0][c];
+                        tri.e1[c] = positions[1][c] - positions[0][c];
+                        tri.e2[c] = positions[2][c] - positions[0][c];
+                    }
+                    if (bounds == nullptr) continue;
+                    _Bounds& tri_bounds = (*bounds)[slot];
+                    tri_bounds = _Bounds();
+                    for (int corner = 0; corner < 3; corner++) tri_bounds.grow(positions[corner]);
+                }
+            });
+        }
+
+        template<class Corners>
+        void _refit(const Corners& corners) {
+            if (this->nodes.empty()) return;
+
+            // Reload the triangles
+            std::vector<_Bounds> tri_bounds(this->ids.size());
+            this->_load_triangles(corners, &tri_bounds);
+
+            // Children always come after their parents, so walking backwards updates them first
+            for (size_t index = this->nodes.size(); index-- > 0;) {
+                _Node& node = this->nodes[index];
+                node.bounds = _Bounds();
+                if (node.count > 0) {
+                    for (uint32_t slot = node.offset; slot < node.offset + node.count; slot++) node.bounds.grow(tri_bounds[slot]);
+                } else {
+                    node.bounds.grow(this->nodes[index + 1].bounds);
+                    node.bounds.grow(this->nodes[node.offset].bounds);
+                }
+            }
+
+        }
+
+        /**
+         * Möller–Trumbore ray/triangle intersection. Returns the distance along the ray and the
+         * barycentric coordinates of the second and third corners.
+         */
+        static bool _intersect_triangle(const _Triangle& tri, const float* origin, const float* direction, float& t, float& u, float& v) {
+
+            // Rays parallel to the triangle miss it
+            float p[3] = {
+                direction[1] * tri.e2[2] - direction[2] * tri.e2[1],
+                direction[2] * tri.e2[0] - direction[0] * tri.e2[2],
+                direction[0] * tri.e2[1] - direction[1] * tri.e2[0],
+            };
+            float det = tri.e1[0] * p[0] + tri.e1[1] * p[1] + tri.e1[2] * p[2];
+            if (det == 0) return false;
+            float inverse_det = 1.0f / det;
+
+            // Find the barycentric coordinates, and check they're inside the triangle
+            float s[3] = { origin[0] - tri.v0[0], origin[1] - tri.v0[1], origin[2] - tri.v0[2] };
+            u = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) * inverse_det;
+            if (u < 0 || u > 1) return false;
+            float q[3] = {
+                s[1] * tri.e1[2] - s[2] * tri.e1[1],
+                s[2] * tri.e1[0] - s[0] * tri.e1[2],
+                s[0] * tri.e1[1] - s[1] * tri.e1[0],
+            };
+            v = (direction[0] * q[0] + direction[1] * q[1] + direction[2] * q[2]) * inverse_det;
+            if (v < 0 || u + v > 1) return false;
+
+            // Find the distance, which must be ahead of the origin
+            t = (tri.e2[0] * q[0] + tri.e2[1] * q[1] + tri.e2[2] * q[2]) * inverse_det;
+            return t >= 0;
+
+        }
+
+        /**
+         * Finds the closest point on a triangle, by checking which of its corner, edge and
+         * face regions the point is in (Ericson, Real-Time Collision Detection, 5.1.5)
+         */
+        static void _closest_on_triangle(const _Triangle& tri, const float* point, float* out) {
+            auto dot = [](const float* a, const float* b) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; };
+            auto along = [&](const float* from, const float* edge, float t) {
+                for (int c = 0; c < 3; c++) out[c] = from[c] + edge[c] * t;
+            };
+            float b[3], c_corner[3], ap[3], bp[3], cp[3], bc[3];
+            for (int c = 0; c < 3; c++) {
+                b[c] = tri.v0[c] + tri.e1[c];
+                c_corner[c] = tri.v0[c] + tri.e2[c];
+                ap[c] = point[c] - tri.v0[c];
+                bp[c] = ap[c] - tri.e1[c];
+                cp[c] = ap[c] - tri.e2[c];
+                bc[c] = tri.e2[c] - tri.e1[c];
+            }
+
+            // The first corner
+            float d1 = dot(tri.e1, ap), d2 = dot(tri.e2, ap);
+            if (d1 <= 0 && d2 <= 0) return along(tri.v0, tri.e1, 0);
+
+            // The second corner
+            float d3 = dot(tri.e1, bp), d4 = dot(tri.e2, bp);
+            if (d3 >= 0 && d4 <= d3) return along(b, tri.e1, 0);
+
+            // The edge between the first two
+            float vc = d1 * d4 - d3 * d2;
+            if (vc <= 0 && d1 >= 0 && d3 <= 0) return along(tri.v0, tri.e1, d1 / (d1 - d3));
+
+            // The third corner
+            float d5 = dot(tri.e1, cp), d6 = dot(tri.e2, cp);
+            if (d6 >= 0 && d5 <= d6) return along(c_corner, tri.e2, 0);
+
+            // The edge between the first and third
+            float vb = d5 * d2 - d1 * d6;
+            if (vb <= 0 && d2 >= 0 && d6 <= 0) return along(tri.v0, tri.e2, d2 / (d2 - d6));
+
+            // The edge between the second and third
+            float va = d3 * d6 - d5 * d4;
+            if (va <= 0 && d4 - d3 >= 0 && d5 - d6 >= 0) return along(b, bc, (d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+            // Inside the face
+            float sum = va + vb + vc;
+            if (!(sum > 0)) return along(tri.v0, tri.e1, 0);
+            float v = vb / sum, w = vc / sum;
+            for (int c = 0; c < 3; c++) out[c] = tri.v0[c] + tri.e1[c] * v + tri.e2[c] * w;
+
+        }
+
+        /**
+         * Walks the tree along a ray, nearest boxes first, updating `hit` with each closer
+         * triangle. With `any`, stops at the first hit.
+         */
+        template<bool any>
+        bool _traverse(const Ray3& ray, RayHit& hit) const {
+            if (this->nodes.empty()) return false;
+            float origin[3], direction[3], inverse[3];
+            for (int c = 0; c < 3; c++) {
+                origin[c] = ray.origin.data[c];
+                direction[c] = ray.direction.data[c];
+                inverse[c] = 1.0f / direction[c];
+            }
+
+            // Start at the root, if the ray hits it at all
+            _Entry stack[_stack_size];
+            size_t top = 0;
+            float t_root;
+            if (!this->nodes[0].bounds.intersect(origin, inverse, hit.t, t_root)) return false;
+            stack[top++] = { 0, t_root };
+            while (top > 0) {
+                _Entry entry = stack[--top];
+                if (entry.t > hit.t) continue;
+                const _Node& node = this->nodes[entry.node];
+
+                // Test each triangle in a leaf
+                if (node.count > 0) {
+                    for (uint32_t slot = node.offset; slot < node.offset + node.count; slot++) {
+                        float t, u, v;
+                        if (!_intersect_triangle(this->triangles[slot], origin, direction, t, u, v)) continue;
+                        if (t > hit.t || (t == hit.t && this->ids[slot] >= hit.triangle)) continue;
+                        hit.t = t;
+                        hit.u = u;
+                        hit.v = v;
+                        hit.triangle = this->ids[slot];
+                        if (any) return true;
+                    }
+                    continue;
+                }
+
+                // Queue the children the ray hits, nearest on top
+                _Entry left = { entry.node + 1, 0 }, right = { node.offset, 0 };
+                bool hit_left = this->nodes[left.node].bounds.intersect(origin, inverse, hit.t, left.t);
+                bool hit_right = this->nodes[right.node].bounds.intersect(origin, inverse, hit.t, right.t);
+                if (hit_left && hit_right && right.t < left.t) std::swap(left, right);
+                else if (!hit_left) {
+                    left = right;
+                    hit_left = hit_right;
+                    hit_right = false;
+                }
+                if (hit_right) stack[top++] = right;
+                if (hit_left) stack[top++] = left;
+
+            }
+            return hit.triangle != none;
+
+        }
+
+        std::vector<_Node> nodes;
+        std::vector<_Triangle> triangles;
+
+        // The index of each triangle in leaf order
+        std::vector<uint32_t> ids;
+
+    };
+
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+#include <algorithm>
+#include <vector>
+
+namespace e3d {
+
+    /**
+     * A render target for the rasterizer (see utils/raster.h): a float depth per pixel and,
+     * optionally, the index of the triangle drawn there. Pixels are stored row by row, with
+     * row 0 at the top of the image.
+     *
+     * Depths run from 0 at the near plane to 1 at the far plane, and a cleared buffer is 1
+     * everywhere with no triangles.
+     */
+    struct DepthBuffer {
+
+        /**
+         * The triangle index of a pixel nothing has been drawn to
+         */
+        static constexpr uint32_t none = UINT32_MAX;
+
+        size_t width = 0;
+        size_t height = 0;
+        std::vector<float> depth;
+
+        /**
+         * The triangle index of each pixel, or empty if the buffer doesn't keep them
+         */
+        std::vector<uint32_t> ids;
+
+        DepthBuffer() {}
+        DepthBuffer(size_t width, size_t height, bool with_ids = false) :
+            width(width),
+            height(height),
+            depth(width * height, 1.0f),
+            ids(with_ids ? width * height : 0, none) {}
+
+        bool has_ids() const { return !this->ids.empty(); }
+
+        /**
+         * Resets every pixel to the far plane, with no triangle
+         */
+        void clear() {
+            std::fill(this->depth.begin(), this->depth.end(), 1.0f);
+            std::fill(this->ids.begin(), this->ids.end(), none);
+        }
+
+        float depth_at(size_t x, size_t y) const { return this->depth[y * this->width + x]; }
+        uint32_t id_at(size_t x, size_t y) const { return this->ids[y * this->width + x]; }
+
+    };
+
+}
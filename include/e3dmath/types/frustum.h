@@ -0,0 +1,23 @@
+#pragma once
+
+#include "vec.h"
+
+namespace e3d {
+
+    /**
+     * The six planes bounding a view volume. Each plane is stored as (a, b, c, d), with the
+     * normal (a, b, c) pointing into the volume and normalized, so `a * x + b * y + c * z + d`
+     * is the signed distance of a point from the plane, positive inside.
+     */
+    struct Frustum {
+
+        /**
+         * The index of each plane in `planes`
+         */
+        enum Side { left, right, bottom, top, near, far };
+
+        Vec4 planes[6];
+
+    };
+
+}
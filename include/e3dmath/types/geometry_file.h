@@ -0,0 +1,336 @@
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+#include <cstring>
+#include <utility>
+#include "vec_soa.h"
+#include "mesh.h"
+#include "aabb.h"
+#include "../simd/aligned.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#define E3D_UNDEF_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#define E3D_UNDEF_NOMINMAX
+#endif
+#include <windows.h>
+#ifdef E3D_UNDEF_LEAN_AND_MEAN
+#undef WIN32_LEAN_AND_MEAN
+#undef E3D_UNDEF_LEAN_AND_MEAN
+#endif
+#ifdef E3D_UNDEF_NOMINMAX
+#undef NOMINMAX
+#undef E3D_UNDEF_NOMINMAX
+#endif
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace e3d {
+
+    /**
+     * A geometry file mapped into memory. Its streams are exposed where they lie in the
+     * mapping, as views the batch functions and meshes take directly, so opening a file
+     * costs the same however large it is and pages are only read from disk as they're used.
+     * Files are written by utils::geometry_file::write.
+     *
+     * The format is little-endian, laid out as:
+     *
+     *  - a 64-byte `Header`, with the format version and the bounds of the positions
+     *  - a table of `Section`s, one per stream, each naming its stream and where it lies
+     *  - the streams themselves, each starting on a 64-byte boundary and padded with zeros up
+     *    to the next, like the streams of a VecSoa
+     *
+     * Streams are arrays of 32-bit floats or unsigned integers. Meshes and point clouds use
+     * the stream names below, and any others (ie. per-point intensities) are carried along
+     * and can be looked up by name.
+     *
+     * Everything exposed points into the mapping, so it's only valid until the file is
+     * closed.
+     */
+    class GeometryFile {
+    public:
+
+        /**
+         * The current version of the format. Files of later versions aren't opened.
+         */
+        static constexpr uint32_t version = 1;
+
+        /**
+         * The types of a stream's elements
+         */
+        enum Type : uint32_t { float32 = 0, uint32 = 1 };
+
+        /**
+         * The start of every file
+         */
+        struct Header {
+            char magic[8];
+            uint32_t version;
+            uint32_t section_count;
+            uint64_t file_size;
+            float bounds_min[3];
+            float bounds_max[3];
+            uint8_t reserved[16];
+        };
+
+        /**
+         * An entry in the table of streams. The name is padded with zeros, and the offset
+         * is from the start of the file.
+         */
+        struct Section {
+            char name[24];
+            uint32_t type;
+            uint32_t reserved;
+            uint64_t offset;
+            uint64_t count;
+        };
+
+        static_assert(sizeof(Header) == 64, "Header must be 64 bytes");
+        static_assert(sizeof(Section) == 48, "Section must be 48 bytes");
+
+        /**
+         * The magic bytes at the start of every file
+         */
+        static constexpr char magic[8] = { 'E', '3', 'D', 'G', 'E', 'O', 'M', '\0' };
+
+        /**
+         * The names of the standard streams
+         */
+        static constexpr const char* position_names[3] = { "position.x", "position.y", "position.z" };
+        static constexpr const char* uv_names[2] = { "uv.x", "uv.y" };
+        static constexpr const char* index_name = "index";
+
+        /**
+         * The alignment of each stream within the file
+         */
+        static constexpr size_t alignment = simd::buffer_alignment;
+
+        GeometryFile() {}
+        GeometryFile(const GeometryFile&) = delete;
+        GeometryFile& operator=(const GeometryFile&) = delete;
+        GeometryFile(GeometryFile&& other) noexcept { this->_take(other); }
+        GeometryFile& operator=(GeometryFile&& other) noexcept {
+            if (this != &other) {
+                this->close();
+                this->_take(other);
+            }
+            return *this;
+        }
+        ~GeometryFile() { this->close(); }
+
+        /**
+         * Maps a file, closing any open one, and checks that it's a well-formed geometry file
+         * of a version this reader understands. Returns false if it can't be opened or isn't
+         * valid, leaving nothing open.
+         *
+         * Only the header and section table are read. The streams aren't touched, so indices
+         * aren't checked against the number of vertices.
+         */
+        bool open(const char* path) {
+            this->close();
+            if (!this->_map(path)) return false;
+            if (!this->_validate()) {
+                this->close();
+                return false;
+            }
+            return true;
+        }
+
+        /**
+         * Unmaps the file, if one is open
+         */
+        void close() {
+            if (this->bytes != nullptr) {
+#ifdef _WIN32
+                UnmapViewOfFile(this->bytes);
+#else
+                munmap(const_cast<uint8_t*>(this->bytes), this->length);
+#endif
+            }
+            this->bytes = nullptr;
+            this->length = 0;
+        }
+
+        bool is_open() const { return this->bytes != nullptr; }
+        size_t size() const { return this->length; }
+
+        const Header& header() const { return *reinterpret_cast<const Header*>(this->bytes); }
+        size_t section_count() const { return this->header().section_count; }
+        const Section& section(size_t index) const { return reinterpret_cast<const Section*>(this->bytes + sizeof(Header))[index]; }
+
+        /**
+         * Finds a float stream by name, or returns null (with a count of 0) if there isn't one
+         */
+        const float* floats(const char* name, size_t& count) const {
+            return static_cast<const float*>(this->_find(name, float32, count));
+        }
+
+        /**
+         * Finds an unsigned integer stream by name, or returns null (with a count of 0) if
+         * there isn't one
+         */
+        const uint32_t* uints(const char* name, size_t& count) const {
+            return static_cast<const uint32_t*>(this->_find(name, uint32, count));
+        }
+
+        /**
+         * The bounds of the positions, as they were written
+         */
+        Aabb3 bounds() const {
+            const Header& header = this->header();
+            return Aabb3(Point3(header.bounds_min), Point3(header.bounds_max));
+        }
+
+        /**
+         * The vertex positions, or an empty view if there are none
+         */
+        VecSoaView<3> positions() const { return this->_view<3>(position_names); }
+
+        /**
+         * The texture coordinates, or an empty view if there are none
+         */
+        VecSoaView<2> uvs() const { return this->_view<2>(uv_names); }
+
+        /**
+         * A view of the file as a mesh. A point cloud gives a mesh with no triangles.
+         */
+        MeshView mesh() const {
+            size_t count = 0;
+            MeshView view;
+            view.positions = this->positions();
+            view.uvs = this->uvs();
+            view.indices = this->uints(index_name, count);
+            view.triangle_count = count / 3;
+            return view;
+        }
+
+    private:
+
+        const uint8_t* bytes = nullptr;
+        size_t length = 0;
+
+        void _take(GeometryFile& other) {
+            this->bytes = std::exchange(other.bytes, nullptr);
+            this->length = std::exchange(other.length, 0);
+        }
+
+        bool _map(const char* path) {
+#ifdef _WIN32
+            HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (file == INVALID_HANDLE_VALUE) return false;
+            LARGE_INTEGER size;
+            if (!GetFileSizeEx(file, &size) || size.QuadPart < LONGLONG(sizeof(Header))) {
+                CloseHandle(file);
+                return false;
+            }
+            HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            CloseHandle(file);
+            if (mapping == nullptr) return false;
+            void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mapping);
+            if (view == nullptr) return false;
+            this->bytes = static_cast<const uint8_t*>(view);
+            this->length = size_t(size.QuadPart);
+#else
+            int file = ::open(path, O_RDONLY);
+            if (file < 0) return false;
+            struct stat info;
+            if (fstat(file, &info) != 0 || size_t(info.st_size) < sizeof(Header)) {
+                ::close(file);
+                return false;
+            }
+            void* view = mmap(nullptr, size_t(info.st_size), PROT_READ, MAP_SHARED, file, 0);
+            ::close(file);
+            if (view == MAP_FAILED) return false;
+            this->bytes = static_cast<const uint8_t*>(view);
+            this->length = size_t(info.st_size);
+#endif
+            return true;
+        }
+
+        bool _validate() const {
+
+            // The format is little-endian
+            const uint16_t probe = 1;
+            if (*reinterpret_cast<const uint8_t*>(&probe) != 1) return false;
+
+            // Check the header
+            const Header& header = this->header();
+            if (std::memcmp(header.magic, magic, sizeof(magic)) != 0) return false;
+            if (header.version == 0 || header.version > version) return false;
+            if (header.file_size != this->length) return false;
+            if (header.section_count > (this->length - sizeof(Header)) / sizeof(Section)) return false;
+
+            // Then that every section is named, aligned and inside the file
+            for (size_t i = 0; i < header.section_count; i++) {
+                const Section& section = this->section(i);
+                if (std::memchr(section.name, '\0', sizeof(section.name)) == nullptr) return false;
+                if (section.type != float32 && section.type != uint32) return false;
+                if (section.offset % alignment != 0 || section.offset > this->length) return false;
+                if (section.count > (this->length - section.offset) / 4) return false;
+            }
+
+            // And that the standard streams fit together
+            VecSoaView<3> positions = this->positions();
+            VecSoaView<2> uvs = this->uvs();
+            if (positions.size != this->_count(position_names[0])) return false;
+            if (uvs.size != this->_count(uv_names[0]) || (uvs.size != 0 && uvs.size != positions.size)) return false;
+            return this->_count(index_name) % 3 == 0;
+
+        }
+
+        const Section* _section(const char* name) const {
+            for (size_t i = 0; i < this->section_count(); i++) {
+                const Section& section = this->section(i);
+                if (std::strncmp(section.name, name, sizeof(section.name)) == 0) return &section;
+            }
+            return nullptr;
+        }
+
+        size_t _count(const char* name) const {
+            const Section* section = this->_section(name);
+            return section ? size_t(section->count) : 0;
+        }
+
+        const void* _find(const char* name, Type type, size_t& count) const {
+            const Section* section = this->_section(name);
+            if (section == nullptr || section->type != type) {
+                count = 0;
+                return nullptr;
+            }
+            count = size_t(section->count);
+            return this->bytes + section->offset;
+        }
+
+        /**
+         * Views a set of float streams, if they're all there and the same length
+         */
+        template<uint8_t S>
+        VecSoaView<S> _view(const char* const* names) const {
+            VecSoaView<S> view;
+            view.size = 0;
+            for (uint8_t c = 0; c < S; c++) {
+                size_t count = 0;
+                view.data[c] = this->floats(names[c], count);
+                if (view.data[c] == nullptr || (c > 0 && count != view.size)) {
+                    for (uint8_t i = 0; i < S; i++) view.data[i] = nullptr;
+                    view.size = 0;
+                    return view;
+                }
+                view.size = count;
+            }
+            return view;
+        }
+
+    };
+
+}
@@ -0,0 +1,370 @@
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+#include "vec.h"
+#include "point.h"
+#include "vec_soa.h"
+#include "../utils/parallel.h"
+
+namespace e3d {
+
+    /**
+     * A k-d tree over a set of points, for nearest-neighbor and radius queries.
+     *
+     * The tree is implicit: the points are reordered so that each range of them has its
+     * median along the split axis in the middle, with the points below it to the left and the
+     * rest to the right. There are no node pointers, so the tree is just one array of points
+     * (with their original indices alongside) and one split axis per point, and small ranges
+     * at the bottom are scanned straight through. Each range splits its cell (the box it
+     * covers) across the longest side.
+     *
+     * Subtrees are built in parallel across the shared thread pool (see utils/parallel.h),
+     * and the tree comes out the same however many threads build it. Queries only read the
+     * tree, so any number of threads can run them at once. Distances are all squared, and
+     * ties between equally distant points go to the lowest index.
+     */
+    class KdTree {
+    public:
+
+        /**
+         * The index of a missing neighbor
+         */
+        static constexpr uint32_t none = UINT32_MAX;
+
+        /**
+         * The most points in a range that's scanned through rather than split
+         */
+        static constexpr size_t max_leaf_size = 16;
+
+        /**
+         * The number of points each thread takes at a time while building. Smaller subtrees
+         * are built on a single thread.
+         */
+        static constexpr size_t grain = 1 << 12;
+
+        /**
+         * The number of queries each thread takes at a time in batch queries
+         */
+        static constexpr size_t query_grain = 256;
+
+        KdTree() {}
+        KdTree(const Point3* points, size_t count) { this->build(points, count); }
+        explicit KdTree(const VecSoaView<3>& points) { this->build(points); }
+
+        /**
+         * Builds the tree over an array of points, replacing any previous one
+         */
+        void build(const Point3* points, size_t count) {
+            this->_build(count, [&](size_t i, float* out) {
+                for (int c = 0; c < 3; c++) out[c] = points[i].data[c];
+            });
+        }
+
+        /**
+         * Builds the tree over SoA points, replacing any previous one
+         */
+        void build(const VecSoaView<3>& points) {
+            this->_build(points.size, [&](size_t i, float* out) {
+                for (int c = 0; c < 3; c++) out[c] = points.data[c][i];
+            });
+        }
+
+        size_t size() const { return this->items.size(); }
+
+        /**
+         * Finds the `k` nearest points to `query` within `max_distance`, closest first, and
+         * returns how many there were. Their indices go in `indices` and their squared
+         * distances in `distances2`, which both need room for `k` values.
+         */
+        size_t nearest(const Point3& query, size_t k, uint32_t* indices, float* distances2, float max_distance = INFINITY) const {
+            if (k == 0) return 0;
+            _Nearest found { indices, distances2, k, 0, max_distance * max_distance };
+            this->_search(query, found);
+            return found.size;
+        }
+
+        /**
+         * Finds the nearest point to `query` within `max_distance`, or returns `none`
+         */
+        uint32_t nearest(const Point3& query, float& distance2, float max_distance = INFINITY) const {
+            uint32_t index = none;
+            distance2 = INFINITY;
+            this->nearest(query, 1, &index, &distance2, max_distance);
+            return index;
+        }
+
+        /**
+         * Finds the `k` nearest points to each query, across the thread pool. Each query gets
+         * `k` slots in `indices` and `distances2`, closest first, and any it doesn't fill
+         * are set to `none` and infinity.
+         */
+        void nearest(const Point3* queries, size_t count, size_t k, uint32_t* indices, float* distances2, float max_distance = INFINITY) const {
+            utils::parallel::for_range(0, count, query_grain, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; i++) {
+                    size_t found = this->nearest(queries[i], k, indices + i * k, distances2 + i * k, max_distance);
+                    std::fill(indices + i * k + found, indices + (i + 1) * k, none);
+                    std::fill(distances2 + i * k + found, distances2 + (i + 1) * k, INFINITY);
+                }
+            });
+        }
+
+        /**
+         * Finds every point within `radius` of `query`, replacing the contents of `out` with
+         * their indices in increasing order
+         */
+        void within(const Point3& query, float radius, std::vector<uint32_t>& out) const {
+            out.clear();
+            _Within found { &out, radius * radius };
+            this->_search(query, found);
+            std::sort(out.begin(), out.end());
+        }
+
+        /**
+         * Finds every point within `radius` of each query, across the thread pool. The
+         * indices around query `i` are `indices[offsets[i]]` up to `indices[offsets[i + 1]]`,
+         * in increasing order.
+         */
+        void within(const Point3* queries, size_t count, float radius, std::vector<uint32_t>& offsets, std::vector<uint32_t>& indices) const {
+
+            // Each block of queries collects its own results
+            size_t blocks = (count + query_grain - 1) / query_grain;
+            std::vector<std::vector<uint32_t>> found(blocks);
+            offsets.assign(count + 1, 0);
+            utils::parallel::for_range(0, blocks, 1, [&](size_t first, size_t last) {
+                std::vector<uint32_t> around;
+                for (size_t block = first; block < last; block++) {
+                    size_t begin = block * query_grain, end = std::min(count, begin + query_grain);
+                    for (size_t i = begin; i < end; i++) {
+                        this->within(queries[i], radius, around);
+                        found[block].insert(found[block].end(), around.begin(), around.end());
+                        offsets[i + 1] = uint32_t(around.size());
+                    }
+                }
+            });
+
+            // Then they're joined up in order
+            for (size_t i = 0; i < count; i++) offsets[i + 1] += offsets[i];
+            indices.resize(offsets[count]);
+            utils::parallel::for_range(0, blocks, 1, [&](size_t first, size_t last) {
+                for (size_t block = first; block < last; block++) {
+                    std::copy(found[block].begin(), found[block].end(), indices.begin() + offsets[block * query_grain]);
+                }
+            });
+
+        }
+
+    private:
+
+        /**
+         * A point in tree order, with its original index
+         */
+        struct _Item {
+            float point[3];
+            uint32_t id;
+        };
+
+        /**
+         * A range of the tree still to visit, how far the query is outside the range's cell
+         * along each axis, and the squared distance that adds up to
+         */
+        struct _Entry {
+            uint32_t begin;
+            uint32_t end;
+            float offsets[3];
+            float bound;
+        };
+
+        /**
+         * A box around the points in a range of the tree
+         */
+        struct _Cell {
+            float low[3] = { INFINITY, INFINITY, INFINITY };
+            float high[3] = { -INFINITY, -INFINITY, -INFINITY };
+        };
+
+        /**
+         * The k nearest points so far, kept sorted by distance and then index
+         */
+        struct _Nearest {
+
+            uint32_t* indices;
+            float* distances2;
+            size_t k;
+            size_t size;
+            float max_distance2;
+
+            /**
+             * The squared distance beyond which nothing can be added
+             */
+            float limit() const {
+                return this->size == this->k ? this->distances2[this->k - 1] : this->max_distance2;
+            }
+
+            void add(uint32_t id, float distance2) {
+                if (distance2 > this->limit()) return;
+                if (this->size == this->k) {
+                    if (distance2 == this->distances2[this->k - 1] && id > this->indices[this->k - 1]) return;
+                } else {
+                    this->size++;
+                }
+
+                // Shift the further points along, and drop the new one in
+                size_t slot = this->size - 1;
+                while (slot > 0 && (this->distances2[slot - 1] > distance2 || (this->distances2[slot - 1] == distance2 && this->indices[slot - 1] > id))) {
+                    this->distances2[slot] = this->distances2[slot - 1];
+                    this->indices[slot] = this->indices[slot - 1];
+                    slot--;
+                }
+                this->distances2[slot] = distance2;
+                this->indices[slot] = id;
+            }
+
+        };
+
+        /**
+         * Every point within a radius
+         */
+        struct _Within {
+
+            std::vector<uint32_t>* out;
+            float radius2;
+
+            float limit() const { return this->radius2; }
+
+            void add(uint32_t id, float distance2) {
+                if (distance2 <= this->radius2) this->out->push_back(id);
+            }
+
+        };
+
+        /**
+         * The deepest the stack can get: one range per level of the tree, which has at most
+         * 32 levels for a 32-bit count
+         */
+        static constexpr size_t _stack_size = 64;
+
+        std::vector<_Item> items;
+        std::vector<uint8_t> axes;
+
+        template<class Load>
+        void _build(size_t count, const Load& load) {
+
+            // Copy the points in
+            this->items.resize(count);
+            this->axes.assign(count, 0);
+            utils::parallel::for_range(0, count, grain, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; i++) {
+                    load(i, this->items[i].point);
+                    this->items[i].id = uint32_t(i);
+                }
+            });
+
+            // Then sort them into tree order, starting from the bounds of all the points
+            _Cell cell;
+            for (const _Item& item : this->items) {
+                for (int c = 0; c < 3; c++) {
+                    cell.low[c] = std::min(cell.low[c], item.point[c]);
+                    cell.high[c] = std::max(cell.high[c], item.point[c]);
+                }
+            }
+            this->_split(0, count, cell);
+
+        }
+
+        /**
+         * Splits the range [begin, end), whose points are all within `cell`, at its median,
+         * and then each side
+         */
+        void _split(size_t begin, size_t end, const _Cell& cell) {
+            if (end - begin <= max_leaf_size) return;
+
+            // Split the cell across its longest side
+            uint8_t axis = 0;
+            for (uint8_t c = 1; c < 3; c++) {
+                if (cell.high[c] - cell.low[c] > cell.high[axis] - cell.low[axis]) axis = c;
+            }
+
+            // Put the median in the middle, ordering by index on ties so the tree is the same
+            // every time
+            size_t mid = begin + (end - begin) / 2;
+            std::nth_element(this->items.begin() + begin, this->items.begin() + mid, this->items.begin() + end, [&](const _Item& a, const _Item& b) {
+                return a.point[axis] < b.point[axis] || (a.point[axis] == b.point[axis] && a.id < b.id);
+            });
+            this->axes[mid] = axis;
+            _Cell left = cell, right = cell;
+            left.high[axis] = right.low[axis] = this->items[mid].point[axis];
+
+            // Split each side, in parallel if they're big enough
+            if (end - begin < grain) {
+                this->_split(begin, mid, left);
+                this->_split(mid + 1, end, right);
+                return;
+            }
+            utils::parallel::for_range(0, 2, 1, [&](size_t first, size_t last) {
+                for (size_t side = first; side < last; side++) {
+                    if (side == 0) this->_split(begin, mid, left);
+                    else this->_split(mid + 1, end, right);
+                }
+            });
+
+        }
+
+        static float _distance2(const float* a, const float* b) {
+            float dx = a[0] - b[0], dy = a[1] - b[1], dz = a[2] - b[2];
+            return dx * dx + dy * dy + dz * dz;
+        }
+
+        /**
+         * Walks the tree, nearer sides first, offering `found` every point that might be close
+         * enough and skipping ranges that are entirely beyond its limit
+         */
+        template<class Found>
+        void _search(const Point3& query, Found& found) const {
+            if (this->items.empty()) return;
+            float q[3] = { query.data[0], query.data[1], query.data[2] };
+            _Entry stack[_stack_size];
+            size_t top = 0;
+            stack[top++] = { 0, uint32_t(this->items.size()), { 0, 0, 0 }, 0 };
+            while (top > 0) {
+                _Entry entry = stack[--top];
+                if (entry.bound > found.limit()) continue;
+
+                // Scan small ranges straight through
+                if (entry.end - entry.begin <= max_leaf_size) {
+                    for (uint32_t i = entry.begin; i < entry.end; i++) {
+                        found.add(this->items[i].id, _distance2(this->items[i].point, q));
+                    }
+                    continue;
+                }
+
+                // Offer the median, then queue the far side behind the near one. The far side is
+                // at least as far along the split axis as the splitting plane, and at least as
+                // far along the others as the range was.
+                uint32_t mid = entry.begin + (entry.end - entry.begin) / 2;
+                const _Item& median = this->items[mid];
+                found.add(median.id, _distance2(median.point, q));
+                uint8_t axis = this->axes[mid];
+                float offset = q[axis] - median.point[axis];
+                _Entry left = entry, right = entry;
+                left.end = mid;
+                right.begin = mid + 1;
+                _Entry& far = offset < 0 ? right : left;
+                far.offsets[axis] = offset;
+                far.bound = far.offsets[0] * far.offsets[0] + far.offsets[1] * far.offsets[1] + far.offsets[2] * far.offsets[2];
+                if (offset < 0) {
+                    stack[top++] = right;
+                    stack[top++] = left;
+                } else {
+                    stack[top++] = left;
+                    stack[top++] = right;
+                }
+            }
+        }
+
+    };
+
+}
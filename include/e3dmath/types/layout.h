@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vector>
+#include "mat.h"
+#include "vec.h"
+#include "point.h"
+#include "quat.h"
+#include "affine.h"
+#include "polygon.h"
+#include "../simd/aligned.h"
+
+namespace e3d {
+
+    /**
+     * A std::vector whose storage starts on a 64-byte boundary, so that vector loads from the
+     * start of an array of any of the types below are aligned at every SIMD level
+     */
+    template<class T> using aligned_vector = simd::aligned_vector<T>;
+
+    /**
+     * The storage layout of the value types. Batch functions reinterpret arrays of them as
+     * arrays of floats, and the SIMD kernels load Mat4, Vec4, Quat and padded rows with aligned
+     * instructions, so a change to any of these is a breaking one.
+     */
+
+    // Types holding a whole number of SSE registers are aligned to 16 bytes
+    static_assert(sizeof(Vec4) == 16 && alignof(Vec4) == 16, "Vec4 must be 16 bytes, 16-byte aligned");
+    static_assert(sizeof(Mat4) == 64 && alignof(Mat4) == 16, "Mat4 must be 64 bytes, 16-byte aligned");
+    static_assert(sizeof(Mat4c) == 64 && alignof(Mat4c) == 16, "Mat4c must be 64 bytes, 16-byte aligned");
+    static_assert(sizeof(Mat<2, 2>) == 16 && alignof(Mat<2, 2>) == 16, "Mat<2, 2> must be 16 bytes, 16-byte aligned");
+    static_assert(sizeof(Quat) == 16 && alignof(Quat) == 16, "Quat must be 16 bytes, 16-byte aligned");
+    static_assert(sizeof(Affine3) == 48 && alignof(Affine3) == 16, "Affine3 must be 48 bytes, 16-byte aligned");
+    static_assert(sizeof(Vec3Padded) == 16 && alignof(Vec3Padded) == 16, "Vec3Padded must be 16 bytes, 16-byte aligned");
+
+    // Everything else is tightly packed floats
+    static_assert(sizeof(Vec2) == 8 && alignof(Vec2) == alignof(float), "Vec2 must be tightly packed");
+    static_assert(sizeof(Vec3) == 12 && alignof(Vec3) == alignof(float), "Vec3 must be tightly packed");
+    static_assert(sizeof(Point3) == 12, "Point3 must be tightly packed");
+    static_assert(sizeof(Mat<3, 3>) == 36 && alignof(Mat<3, 3>) == alignof(float), "Mat<3, 3> must be tightly packed");
+    static_assert(sizeof(Tri3) == 36, "Tri3 must be tightly packed");
+    static_assert(sizeof(Quad2) == 32, "Quad2 must be tightly packed");
+
+    // Arrays of the aligned types keep every element aligned
+    static_assert(sizeof(Mat4) % alignof(Mat4) == 0 && sizeof(Vec4) % alignof(Vec4) == 0, "Aligned types must tile arrays");
+    static_assert(simd::buffer_alignment % alignof(Mat4) == 0, "Aligned buffers must satisfy the aligned types");
+
+}
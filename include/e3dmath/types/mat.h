@@ -5,156 +5,211 @@
 #include <iomanip>
 #include <cinttypes>
 #include <cmath>
+#include "mat_expr.h"
+#include "../simd/mat4.h"
 
 namespace e3d {
 
-    template <uint8_t R, uint8_t C>
-    struct Mat {
+    /**
+     * The type of a product with `C` columns, which takes the order of its left-hand side.
+     * Vectors are laid out the same in either order, so they're always `Vec`.
+     */
+    template<uint8_t R, uint8_t C, Order O>
+    using MatProduct = Mat<R, C, (C == 1 ? Order::row_major : O)>;
+
+    template <uint8_t R, uint8_t C, Order O>
+    struct Mat : MatExpr<Mat<R, C, O>, R, C> {
 
         /**
          * Constructs an identity matrix
          */
-        static Mat<R, C> identity();
+        static constexpr Mat<R, C, O> identity();
 
         /**
          * Constructs a matrix with all values set to zero
          */
-        static Mat<R, C> zeros();
+        static constexpr Mat<R, C, O> zeros();
+
+        /**
+         * The alignment of the data. Matrices holding a whole number of SSE registers (ie.
+         * Vec4 and Mat4) are aligned to 16 bytes, so their rows can be loaded with aligned
+         * instructions. Everything else (ie. Vec3 and Mat3) stays tightly packed.
+         */
+        static constexpr size_t alignment = (R * C) % 4 == 0 ? 16 : alignof(float);
 
         /**
-         * The raw data in the matrix
+         * The order of the values in `data`
          */
-        float data[R * C];
+        static constexpr Order order = O;
+
+        /**
+         * The raw data in the matrix, in the storage order. A column-major Mat4 is laid out
+         * the way GPU APIs expect, so it can be copied straight into an upload buffer.
+         */
+        alignas(alignment) float data[R * C];
 
         /**
          * Constructs a matrix object, and initializes the values in the underlying
          * data to all-zeros.
          */
-        Mat<R, C>();
+        constexpr Mat();
 
         /**
-         * Constructs a matrix with an array of raw values. This is useful for points or vectors
+         * Constructs a matrix with an array of raw values, in the storage order. This is useful
+         * for points or vectors
          */
-        Mat<R, C>(const float values[R * C]);
+        constexpr Mat(const float values[R * C]);
 
         /**
          * Constructs a matrix object as a copy of another existing matrix.
          */
-        Mat<R, C>(const Mat<R, C>& other);
+        constexpr Mat(const Mat<R, C, O>& other) = default;
+
+        /**
+         * Constructs a matrix as a copy of one stored in the other order, reordering the data
+         */
+        template<Order OtherO>
+        constexpr Mat(const Mat<R, C, OtherO>& other);
+
+        /**
+         * Constructs a matrix by evaluating an element-wise expression, such as `a * 2 + b`,
+         * in a single pass (see mat_expr.h).
+         */
+        template<class E>
+        constexpr Mat(const MatExpr<E, R, C>& expr);
+
+        constexpr Mat<R, C, O>& operator=(const Mat<R, C, O>& other) = default;
+
+        /**
+         * Evaluates an element-wise expression directly into this matrix
+         */
+        template<class E>
+        constexpr Mat<R, C, O>& operator=(const MatExpr<E, R, C>& expr);
+
+        /**
+         * Gets the index in the underlying data buffer of the value at the provided row and
+         * column
+         */
+        static constexpr int index_of(int r, int c) {
+            if constexpr (O == Order::row_major) return r * C + c;
+            else return c * R + r;
+        }
+
+        /**
+         * Gets a value by its row-major index, whatever the storage order. This is what
+         * expressions read matrices through, so matrices of either order can be mixed in them.
+         */
+        constexpr float element(int index) const { return this->data[index_of(index / C, index % C)]; }
 
         /**
          * Gets a value from the matrix at the provided row and column
          */
-        float get(uint8_t r, uint8_t c) const;
+        constexpr float get(uint8_t r, uint8_t c) const;
 
         /**
          * Gets a value from the matrix underlying data buffer, by index
          */
-        float get(uint8_t index) const;
+        constexpr float get(uint8_t index) const;
 
         /**
          * Gets all of the values in a row, and puts them into the `values` array provided
          */
-        void get_row(uint8_t row, float* values) const;
+        constexpr void get_row(uint8_t row, float* values) const;
 
         /**
          * Gets all of the values in a column, and puts them into the `values` array provided
          */
-        void get_col(uint8_t col, float* values) const;
+        constexpr void get_col(uint8_t col, float* values) const;
 
         /**
          * Sets a value in the matrix at the provided row and column
          */
-        void set(uint8_t r, uint8_t c, float value);
+        constexpr void set(uint8_t r, uint8_t c, float value);
 
         /**
          * Sets a value in the underlying data buffer, by index
          */
-        void set(uint8_t index, float value);
+        constexpr void set(uint8_t index, float value);
 
         /**
          * Multiplies this matrix with another matrix and returns the result. This method fails
          * with a static assertion at compile-time if the dimensions don't allow multiplication.
+         * The result has the order of this matrix, except that vectors are always `Vec`.
          */
-        template<uint8_t OtherC>
-        Mat<R, OtherC> multiply(const Mat<C, OtherC>& other) const;
+        template<uint8_t OtherC, Order OtherO>
+        constexpr MatProduct<R, OtherC, O> multiply(const Mat<C, OtherC, OtherO>& other) const;
 
         /**
          * Multiplies this matrix with some scalar value and returns the resultant matrix.
          */
-        Mat<R, C> multiply(float other) const;
+        constexpr Mat<R, C, O> multiply(float other) const;
 
         /**
          * Divides this matrix by another matrix, by transposing the other and then
          * multiplying the two matrices.
          */
-        template<uint8_t OtherR>
-        Mat<R, OtherR> divide(const Mat<OtherR, C>& other) const;
+        template<uint8_t OtherR, Order OtherO>
+        constexpr MatProduct<R, OtherR, O> divide(const Mat<OtherR, C, OtherO>& other) const;
 
         /**
          * Divides this matrix by a scalar value and returns the result
          */
-        Mat<R, C> divide(float other) const;
+        constexpr Mat<R, C, O> divide(float other) const;
 
         /**
          * Transposes this matrix (swaps rows and columns) and returns the resultant matrix
          */
-        Mat<C, R> transpose() const;
+        constexpr Mat<C, R, O> transpose() const;
 
         /**
          * Adds another matrix to this one and returns the result
          */
-        Mat<R, C> add(const Mat<R, C>& other) const;
+        constexpr Mat<R, C, O> add(const Mat<R, C, O>& other) const;
 
-        float x() const { return this->get(0, 0); }
-        float y() const { return this->get(0, 1); }
-        float z() const { return this->get(0, 2); }
-        float w() const { return this->get(0, 3); }
+        constexpr float x() const { return this->data[0]; }
+        constexpr float y() const { return this->data[1]; }
+        constexpr float z() const { return this->data[2]; }
+        constexpr float w() const { return this->data[3]; }
 
         /**
          * Operator overload for multiplication with another matrix
          */
-        template<uint8_t OtherC>
-        Mat<R, OtherC> operator*(const Mat<C, OtherC>& other) const {
+        template<uint8_t OtherC, Order OtherO>
+        constexpr MatProduct<R, OtherC, O> operator*(const Mat<C, OtherC, OtherO>& other) const {
             return this->multiply(other);
         };
 
         /**
-         * Operator overload for multiplication with a scalar value
+         * Operator overload for multiplication with a matrix expression, which is evaluated
+         * first
          */
-        Mat<R, C> operator*(float other) const {
-            return this->multiply(other);
+        template<class E, uint8_t OtherC>
+        constexpr MatProduct<R, OtherC, O> operator*(const MatExpr<E, C, OtherC>& other) const {
+            return this->multiply(MatProduct<C, OtherC, O>(other));
         };
 
         /**
-         * Operator overload for addition with another matrix
+         * In-place element-wise operators. `+`, `-` and scalar `*` and `/` are free functions
+         * that build expressions (see mat_expr.h).
          */
-        Mat<R, C> operator+(const Mat<R, C>& other) const {
-            return this->add(other);
-        };
+        template<class E>
+        constexpr Mat<R, C, O>& operator+=(const MatExpr<E, R, C>& other) { return *this = *this + other; }
 
-        /**
-         * Operator overload for subtraction with another matrix
-         */
-        Mat<R, C> operator-(const Mat<R, C>& other) const {
-            return this->add(other * -1);
-        };
+        template<class E>
+        constexpr Mat<R, C, O>& operator-=(const MatExpr<E, R, C>& other) { return *this = *this - other; }
+
+        constexpr Mat<R, C, O>& operator*=(float other) { return *this = *this * other; }
+
+        constexpr Mat<R, C, O>& operator/=(float other) { return *this = *this / other; }
 
         /**
          * Operator overload for division of this matrix with another
          */
-        template<uint8_t OtherR>
-        Mat<R, OtherR> operator/(const Mat<OtherR, C>& other) const {
+        template<uint8_t OtherR, Order OtherO>
+        constexpr MatProduct<R, OtherR, O> operator/(const Mat<OtherR, C, OtherO>& other) const {
             return this->divide(other);
         };
 
-        /**
-         * Operator overload for division with a scalar value
-         */
-        Mat<R, C> operator/(float other) const {
-            return this->divide(other);
-        }
-
         /**
          * Creates a string representation of the matrix
          */
@@ -164,8 +219,13 @@ namespace e3d {
 
     typedef Mat<4, 4> Mat4;
 
-    template<uint8_t R, uint8_t C>
-    Mat<R, C>::Mat(const float values[R * C]) {
+    /**
+     * A 4x4 matrix stored column-major, as OpenGL, Vulkan and most shader languages expect
+     */
+    typedef Mat<4, 4, Order::col_major> Mat4c;
+
+    template<uint8_t R, uint8_t C, Order O>
+    constexpr Mat<R, C, O>::Mat(const float values[R * C]) : data{} {
 
         // Calculate the total data points
         constexpr int size = R * C;
@@ -175,42 +235,66 @@ namespace e3d {
 
     }
 
-    template<uint8_t R, uint8_t C>
-    Mat<R, C>::Mat() {
+    template<uint8_t R, uint8_t C, Order O>
+    template<Order OtherO>
+    constexpr Mat<R, C, O>::Mat(const Mat<R, C, OtherO>& other) : data{} {
 
-        // Calculate the total data points
-        constexpr int size = R * C;
+        // The same matrix in the other order is the data transposed
+        if (!E3D_CONSTANT_EVALUATED()) {
+            if constexpr (R == 4 && C == 4) {
+                simd::mat4::transpose(other.data, this->data);
+                return;
+            }
+        }
 
-        // Loop through the data and set to zero
-        for (uint8_t i = 0; i < size; i++) this->data[i] = 0;
+        // Copy every value to its position in this order
+        for (uint8_t r = 0; r < R; r++) {
+            for (uint8_t c = 0; c < C; c++) this->set(r, c, other.get(r, c));
+        }
 
     }
 
-    template<uint8_t R, uint8_t C>
-    Mat<R, C>::Mat(const Mat<R, C>& other) {
+    template<uint8_t R, uint8_t C, Order O>
+    template<class E>
+    constexpr Mat<R, C, O>::Mat(const MatExpr<E, R, C>& expr) : data{} {
 
-        // Calculate the total data points
-        constexpr int size = R * C;
+        // Evaluate every element of the expression in one loop
+        for (int i = 0; i < R * C; i++) this->data[index_of(i / C, i % C)] = expr.self().element(i);
 
-        // Loop through the data and copy the value
-        for (uint8_t i = 0; i < size; i++) this->data[i] = other.data[i];
+    }
+
+    template<uint8_t R, uint8_t C, Order O>
+    template<class E>
+    constexpr Mat<R, C, O>& Mat<R, C, O>::operator=(const MatExpr<E, R, C>& expr) {
+
+        // Evaluate every element of the expression in one loop. Element-wise expressions
+        // only read the same index they write, so `a = a * 2 + b` is safe.
+        for (int i = 0; i < R * C; i++) this->data[index_of(i / C, i % C)] = expr.self().element(i);
+        return *this;
+
+    }
+
+    template<uint8_t R, uint8_t C, Order O>
+    constexpr Mat<R, C, O>::Mat() : data{} {
+
+        // The member initializer sets the data to zero
 
     }
 
-    template<uint8_t R, uint8_t C>
-    Mat<R, C> Mat<R, C>::zeros() {
+    template<uint8_t R, uint8_t C, Order O>
+    constexpr Mat<R, C, O> Mat<R, C, O>::zeros() {
 
         // Create the matrix
-        return Mat<R, C>();
+        return Mat<R, C, O>();
 
     }
 
-    template<uint8_t R, uint8_t C>
-    Mat<R, C> Mat<R, C>::identity() {
+    template<uint8_t R, uint8_t C, Order O>
+    constexpr Mat<R, C, O> Mat<R, C, O>::identity() {
         static_assert(C == R, "Matrix identity dimension rows must equal columns");
 
         // Create the matrix
-        Mat<R, C> result;
+        Mat<R, C, O> result;
 
         // Loop through the size
         for (uint8_t i = 0; i < R; i++) result.set(i, i, 1.0);
@@ -220,71 +304,77 @@ namespace e3d {
 
     }
 
-    template<uint8_t R, uint8_t C>
-    float Mat<R, C>::get(uint8_t index) const {
+    template<uint8_t R, uint8_t C, Order O>
+    constexpr float Mat<R, C, O>::get(uint8_t index) const {
         return this->data[index];
     }
 
-    template<uint8_t R, uint8_t C>
-    float Mat<R, C>::get(uint8_t r, uint8_t c) const {
-        return this->data[r * C + c];
+    template<uint8_t R, uint8_t C, Order O>
+    constexpr float Mat<R, C, O>::get(uint8_t r, uint8_t c) const {
+        return this->data[index_of(r, c)];
     }
 
-    template<uint8_t R, uint8_t C>
-    void Mat<R, C>::get_row(uint8_t row, float* values) const {
-
-        // Get the offset for the row
-        uint8_t row_offset = row * C;
+    template<uint8_t R, uint8_t C, Order O>
+    constexpr void Mat<R, C, O>::get_row(uint8_t row, float* values) const {
 
         // Add the values to the array
-        for (uint8_t c = 0; c < C; c++) values[c] = this->data[row_offset + c];
+        for (uint8_t c = 0; c < C; c++) values[c] = this->get(row, c);
 
     }
 
-    template<uint8_t R, uint8_t C>
-    void Mat<R, C>::get_col(uint8_t col, float* values) const {
+    template<uint8_t R, uint8_t C, Order O>
+    constexpr void Mat<R, C, O>::get_col(uint8_t col, float* values) const {
 
         // Add the values to the array
         for (uint8_t r = 0; r < R; r++) values[r] = this->get(r, col);
 
     }
 
-    template<uint8_t R, uint8_t C>
-    void Mat<R, C>::set(uint8_t r, uint8_t c, float value) {
-        this->data[r * C + c] = value;
+    template<uint8_t R, uint8_t C, Order O>
+    constexpr void Mat<R, C, O>::set(uint8_t r, uint8_t c, float value) {
+        this->data[index_of(r, c)] = value;
     }
 
-    template<uint8_t R, uint8_t C>
-    void Mat<R, C>::set(uint8_t index, float value) {
+    template<uint8_t R, uint8_t C, Order O>
+    constexpr void Mat<R, C, O>::set(uint8_t index, float value) {
         this->data[index] = value;
     }
 
-    template<uint8_t R, uint8_t C>
-    template<uint8_t OtherC>
-    Mat<R, OtherC> Mat<R, C>::multiply(const Mat<C, OtherC>& other) const {
+    template<uint8_t R, uint8_t C, Order O>
+    template<uint8_t OtherC, Order OtherO>
+    constexpr MatProduct<R, OtherC, O> Mat<R, C, O>::multiply(const Mat<C, OtherC, OtherO>& other) const {
 
         // Create the result matrix
-        Mat<R, OtherC> result;
-
-        // Arrays for row/col values
-        float row[C];
-        float col[C];
+        MatProduct<R, OtherC, O> result;
+
+        // 4x4 * 4x4 and 4x4 * 4x1 are almost all of the transform work, so at runtime they
+        // have dedicated SIMD kernels (see simd/mat4.h for their accuracy guarantees)
+        if (!E3D_CONSTANT_EVALUATED()) {
+            if constexpr (R == 4 && C == 4 && OtherC == 4 && O == OtherO) {
+
+                // Column-major data is the row-major data of the transpose, so the column-major
+                // product is the row-major one with the operands swapped: (AB)^T = B^T A^T
+                if constexpr (O == Order::row_major) simd::mat4::multiply(this->data, other.data, result.data);
+                else simd::mat4::multiply(other.data, this->data, result.data);
+                return result;
+
+            } else if constexpr (R == 4 && C == 4 && OtherC == 1) {
+                if constexpr (O == Order::row_major) simd::mat4::transform(this->data, other.data, result.data);
+                else simd::mat4::transform_cols(this->data, other.data, result.data);
+                return result;
+            }
+        }
 
         // Loop through the rows
         for (int r = 0; r < R; r++) {
 
-            // Get the values in the column from the first matrix
-            this->get_row(r, row);
-
             // Loop through the columns
             for (int c = 0; c < OtherC; c++) {
 
-                // Get the column
-                other.get_col(c, col);
-
-                // Calculate the dot product
+                // Calculate the dot product of the row with the column, reading the column
+                // in place instead of copying it out
                 float dotProduct = 0;
-                for (int i = 0; i < C; i++) dotProduct += row[i] * col[i];
+                for (int i = 0; i < C; i++) dotProduct += this->data[index_of(r, i)] * other.data[other.index_of(i, c)];
 
                 // Insert the dot product
                 result.set(r, c, dotProduct);
@@ -298,11 +388,11 @@ namespace e3d {
 
     }
 
-    template<uint8_t R, uint8_t C>
-    Mat<R, C> Mat<R, C>::multiply(float other) const {
+    template<uint8_t R, uint8_t C, Order O>
+    constexpr Mat<R, C, O> Mat<R, C, O>::multiply(float other) const {
 
         // Create the result matrix
-        Mat<R, C> result;
+        Mat<R, C, O> result;
 
         // Calculate the total data points
         constexpr uint8_t size = R * C;
@@ -320,22 +410,30 @@ namespace e3d {
 
     }
 
-    template<uint8_t R, uint8_t C>
-    template<uint8_t OtherR>
-    Mat<R, OtherR> Mat<R, C>::divide(const Mat<OtherR, C>& other) const {
+    template<uint8_t R, uint8_t C, Order O>
+    template<uint8_t OtherR, Order OtherO>
+    constexpr MatProduct<R, OtherR, O> Mat<R, C, O>::divide(const Mat<OtherR, C, OtherO>& other) const {
         return this->multiply(other.transpose());
     }
 
-    template<uint8_t R, uint8_t C>
-    Mat<R, C> Mat<R, C>::divide(float other) const {
+    template<uint8_t R, uint8_t C, Order O>
+    constexpr Mat<R, C, O> Mat<R, C, O>::divide(float other) const {
         return this->multiply(1.0 / other);
     }
 
-    template<uint8_t R, uint8_t C>
-    Mat<C, R> Mat<R, C>::transpose() const {
+    template<uint8_t R, uint8_t C, Order O>
+    constexpr Mat<C, R, O> Mat<R, C, O>::transpose() const {
 
         // Create the result matrix
-        Mat<C, R> result;
+        Mat<C, R, O> result;
+
+        // A transposed Mat4 is its data transposed, in either order
+        if (!E3D_CONSTANT_EVALUATED()) {
+            if constexpr (R == 4 && C == 4) {
+                simd::mat4::transpose(this->data, result.data);
+                return result;
+            }
+        }
 
         // Loop through the rows and columns
         for (uint8_t r = 0; r < R; r++) {
@@ -352,11 +450,11 @@ namespace e3d {
 
     }
 
-    template<uint8_t R, uint8_t C>
-    Mat<R, C> Mat<R, C>::add(const Mat<R, C>& other) const {
+    template<uint8_t R, uint8_t C, Order O>
+    constexpr Mat<R, C, O> Mat<R, C, O>::add(const Mat<R, C, O>& other) const {
         
         // Create the result matrix
-        Mat<R, C> result;
+        Mat<R, C, O> result;
 
         // Calculate the total data points
         constexpr uint8_t size = R * C;
@@ -374,8 +472,8 @@ namespace e3d {
 
     }
 
-    template<uint8_t R, uint8_t C>
-    std::string Mat<R, C>::to_str() const {
+    template<uint8_t R, uint8_t C, Order O>
+    std::string Mat<R, C, O>::to_str() const {
 
         // Create the string stream
         std::stringstream ss;
@@ -415,8 +513,8 @@ namespace e3d {
 
     }
 
-    template<uint8_t R, uint8_t C>
-    ::std::ostream& operator<<(::std::ostream& out, Mat<R, C> const& obj) {
+    template<uint8_t R, uint8_t C, Order O>
+    ::std::ostream& operator<<(::std::ostream& out, Mat<R, C, O> const& obj) {
 
         // Print the buffered string value
         out << obj.to_str();
@@ -0,0 +1,223 @@
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+#include "mat.h"
+#include "vec_soa.h"
+
+namespace e3d {
+
+    /**
+     * A read-only view over `size` RxC matrices stored as R * C separate element streams,
+     * row-major (the stream of element (r, c) is `data[r * C + c]`). Views don't own their
+     * memory, so they can point into any buffer.
+     */
+    template<uint8_t R, uint8_t C>
+    struct MatBatchView {
+
+        /**
+         * One pointer per element, each to `size` floats
+         */
+        const float* data[R * C];
+
+        /**
+         * The number of matrices in the view
+         */
+        size_t size;
+
+        /**
+         * Gets the stream holding element (r, c) of every matrix
+         */
+        const float* element(uint8_t r, uint8_t c) const { return this->data[r * C + c]; }
+
+    };
+
+    /**
+     * A writable view over `size` RxC matrices stored as R * C separate element streams
+     */
+    template<uint8_t R, uint8_t C>
+    struct MatBatchSpan {
+
+        /**
+         * One pointer per element, each to `size` floats
+         */
+        float* data[R * C];
+
+        /**
+         * The number of matrices in the span
+         */
+        size_t size;
+
+        /**
+         * Gets the stream holding element (r, c) of every matrix
+         */
+        float* element(uint8_t r, uint8_t c) const { return this->data[r * C + c]; }
+
+        /**
+         * Converts the span into a read-only view
+         */
+        operator MatBatchView<R, C>() const {
+            MatBatchView<R, C> view;
+            for (int i = 0; i < R * C; i++) view.data[i] = this->data[i];
+            view.size = this->size;
+            return view;
+        }
+
+    };
+
+    /**
+     * A structure-of-arrays container of RxC matrices, for running the same operation on
+     * many small matrices at once (ie. one per bone or per instance). Each element has its own
+     * stream (element (0, 0) of every matrix, then element (0, 1), etc.), so the batch kernels
+     * in utils::mat_batch work on 4, 8 or 16 matrices per instruction.
+     *
+     * The streams are laid out like `VecSoa<R * C>`: each starts on a 64-byte boundary and is
+     * padded with zeros up to a multiple of 16 floats.
+     */
+    template<uint8_t R, uint8_t C>
+    class MatBatch {
+    public:
+
+        /**
+         * Constructs an empty container
+         */
+        MatBatch() {}
+
+        /**
+         * Constructs a container of `count` zero matrices
+         */
+        explicit MatBatch(size_t count) : streams(count) {}
+
+        /**
+         * Constructs a container from an array of `count` matrices
+         */
+        MatBatch(const Mat<R, C>* mats, size_t count) : MatBatch(count) { this->assign(mats, count); }
+
+        /**
+         * The number of matrices in the container
+         */
+        size_t size() const { return this->streams.size(); }
+
+        /**
+         * The number of floats reserved per element stream
+         */
+        size_t capacity() const { return this->streams.capacity(); }
+
+        /**
+         * Gets the stream holding element (r, c) of every matrix
+         */
+        float* element(uint8_t r, uint8_t c) { return this->streams.component(r * C + c); }
+        const float* element(uint8_t r, uint8_t c) const { return this->streams.component(r * C + c); }
+
+        /**
+         * Gathers the matrix at an index
+         */
+        Mat<R, C> get(size_t index) const;
+
+        /**
+         * Scatters a matrix into an index
+         */
+        void set(size_t index, const Mat<R, C>& mat);
+
+        /**
+         * Appends a matrix to the end of the container
+         */
+        void push_back(const Mat<R, C>& mat) { this->streams.push_back(Vec<R * C>(mat.data)); }
+
+        /**
+         * Resizes the container, filling any new matrices with zeros
+         */
+        void resize(size_t count) { this->streams.resize(count); }
+
+        /**
+         * Makes sure there is room for `capacity` matrices without moving the streams
+         */
+        void reserve(size_t capacity) { this->streams.reserve(capacity); }
+
+        /**
+         * Removes all of the matrices, keeping the storage
+         */
+        void clear() { this->streams.clear(); }
+
+        /**
+         * Replaces the contents with an array of `count` matrices
+         */
+        void assign(const Mat<R, C>* mats, size_t count);
+
+        /**
+         * Copies the contents out into an array of `size()` matrices
+         */
+        void to_mats(Mat<R, C>* out) const;
+
+        /**
+         * Gets a read-only view of the whole container
+         */
+        MatBatchView<R, C> view() const;
+
+        /**
+         * Gets a writable view of the whole container
+         */
+        MatBatchSpan<R, C> span();
+
+        operator MatBatchView<R, C>() const { return this->view(); }
+
+    private:
+
+        VecSoa<R * C> streams;
+
+    };
+
+    typedef MatBatch<3, 3> Mat3Batch;
+    typedef MatBatch<4, 4> Mat4Batch;
+
+    template<uint8_t R, uint8_t C>
+    Mat<R, C> MatBatch<R, C>::get(size_t index) const {
+        Mat<R, C> result;
+        for (int i = 0; i < R * C; i++) result.data[i] = this->streams.component(i)[index];
+        return result;
+    }
+
+    template<uint8_t R, uint8_t C>
+    void MatBatch<R, C>::set(size_t index, const Mat<R, C>& mat) {
+        for (int i = 0; i < R * C; i++) this->streams.component(i)[index] = mat.data[i];
+    }
+
+    template<uint8_t R, uint8_t C>
+    void MatBatch<R, C>::assign(const Mat<R, C>* mats, size_t count) {
+        static_assert(sizeof(Mat<R, C>) == R * C * sizeof(float), "Matrices must be tightly packed to convert");
+
+        // Size the streams, then split the elements out
+        this->streams.resize(count);
+        if (count == 0) return;
+        MatBatchSpan<R, C> streams = this->span();
+        E3D_SIMD_DISPATCH(soa::from_aos<R * C>(mats->data, streams.data, count));
+
+    }
+
+    template<uint8_t R, uint8_t C>
+    void MatBatch<R, C>::to_mats(Mat<R, C>* out) const {
+        static_assert(sizeof(Mat<R, C>) == R * C * sizeof(float), "Matrices must be tightly packed to convert");
+
+        // Interleave the streams into the output
+        if (this->size() == 0) return;
+        MatBatchView<R, C> streams = this->view();
+        E3D_SIMD_DISPATCH(soa::to_aos<R * C>(streams.data, out->data, this->size()));
+    }
+
+    template<uint8_t R, uint8_t C>
+    MatBatchView<R, C> MatBatch<R, C>::view() const {
+        MatBatchView<R, C> view;
+        for (int i = 0; i < R * C; i++) view.data[i] = this->streams.component(i);
+        view.size = this->size();
+        return view;
+    }
+
+    template<uint8_t R, uint8_t C>
+    MatBatchSpan<R, C> MatBatch<R, C>::span() {
+        MatBatchSpan<R, C> span;
+        for (int i = 0; i < R * C; i++) span.data[i] = this->streams.component(i);
+        span.size = this->size();
+        return span;
+    }
+
+}
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <cinttypes>
+#include <string>
+#include <ostream>
+#include <type_traits>
+
+namespace e3d {
+
+    /**
+     * How a matrix stores its values. Row-major is the default; column-major matches what GPU
+     * APIs expect, so those matrices can be uploaded without reordering.
+     */
+    enum class Order { row_major, col_major };
+
+    template <uint8_t R, uint8_t C, Order O = Order::row_major>
+    struct Mat;
+
+    /**
+     * Base of every element-wise matrix expression. Adding, subtracting and scaling matrices
+     * builds a tree of these instead of computing the result right away; the tree is then
+     * evaluated in a single loop when it's assigned to a `Mat`, with no temporaries between.
+     *
+     * `E` is the concrete expression type, and every expression has a
+     * `constexpr float element(int index) const` giving one value of the result, by its
+     * row-major index (whatever the order the operands are stored in).
+     *
+     * Expressions hold references to the matrices they were built from, so they must be
+     * evaluated before those matrices go out of scope (ie. don't keep one in an `auto`).
+     */
+    template<class E, uint8_t R, uint8_t C>
+    struct MatExpr {
+
+        /**
+         * Gets the concrete expression
+         */
+        constexpr const E& self() const { return static_cast<const E&>(*this); }
+
+        /**
+         * Evaluates the expression into a matrix
+         */
+        constexpr Mat<R, C> eval() const { return Mat<R, C>(*this); }
+
+        /**
+         * Evaluates a single value of the expression, by row and column
+         */
+        constexpr float get(uint8_t r, uint8_t c) const { return this->self().element(r * C + c); }
+
+        /**
+         * Evaluates a single value of the expression, by index
+         */
+        constexpr float get(uint8_t index) const { return this->self().element(index); }
+
+        constexpr float x() const { return this->get(0, 0); }
+        constexpr float y() const { return this->get(0, 1); }
+        constexpr float z() const { return this->get(0, 2); }
+        constexpr float w() const { return this->get(0, 3); }
+
+        /**
+         * Evaluates the expression and transposes the result
+         */
+        constexpr Mat<C, R> transpose() const { return this->eval().transpose(); }
+
+        /**
+         * Evaluates the expression and creates a string representation of the result
+         */
+        std::string to_str() const { return this->eval().to_str(); }
+
+    };
+
+    /**
+     * How an expression stores its operands: matrices by reference, and sub-expressions (which
+     * are small temporaries) by value.
+     */
+    template<class E>
+    struct _expr_operand { using type = const E; };
+
+    template<uint8_t R, uint8_t C, Order O>
+    struct _expr_operand<Mat<R, C, O>> { using type = const Mat<R, C, O>&; };
+
+    template<class E>
+    struct _is_mat : std::false_type {};
+
+    template<uint8_t R, uint8_t C, Order O>
+    struct _is_mat<Mat<R, C, O>> : std::true_type {};
+
+    /**
+     * The sum of two expressions
+     */
+    template<class Lhs, class Rhs, uint8_t R, uint8_t C>
+    struct MatSum : MatExpr<MatSum<Lhs, Rhs, R, C>, R, C> {
+        typename _expr_operand<Lhs>::type left;
+        typename _expr_operand<Rhs>::type right;
+        constexpr MatSum(const Lhs& left, const Rhs& right) : left(left), right(right) {}
+        constexpr float element(int index) const { return this->left.element(index) + this->right.element(index); }
+    };
+
+    /**
+     * The difference of two expressions
+     */
+    template<class Lhs, class Rhs, uint8_t R, uint8_t C>
+    struct MatDifference : MatExpr<MatDifference<Lhs, Rhs, R, C>, R, C> {
+        typename _expr_operand<Lhs>::type left;
+        typename _expr_operand<Rhs>::type right;
+        constexpr MatDifference(const Lhs& left, const Rhs& right) : left(left), right(right) {}
+        constexpr float element(int index) const { return this->left.element(index) - this->right.element(index); }
+    };
+
+    /**
+     * An expression multiplied by a scalar value
+     */
+    template<class E, uint8_t R, uint8_t C>
+    struct MatScale : MatExpr<MatScale<E, R, C>, R, C> {
+        typename _expr_operand<E>::type expr;
+        float scale;
+        constexpr MatScale(const E& expr, float scale) : expr(expr), scale(scale) {}
+        constexpr float element(int index) const { return this->expr.element(index) * this->scale; }
+    };
+
+    /**
+     * Evaluates an expression into a matrix. A matrix is returned by reference, so this costs
+     * nothing when the expression is already a plain `Mat`.
+     */
+    template<class E, uint8_t R, uint8_t C>
+    constexpr decltype(auto) eval(const MatExpr<E, R, C>& expr) {
+        if constexpr (_is_mat<E>::value) return (expr.self());
+        else return Mat<R, C>(expr);
+    }
+
+    /**
+     * Operator overload for addition of two matrices / expressions
+     */
+    template<class Lhs, class Rhs, uint8_t R, uint8_t C>
+    constexpr MatSum<Lhs, Rhs, R, C> operator+(const MatExpr<Lhs, R, C>& left, const MatExpr<Rhs, R, C>& right) {
+        return MatSum<Lhs, Rhs, R, C>(left.self(), right.self());
+    }
+
+    /**
+     * Operator overload for subtraction of two matrices / expressions
+     */
+    template<class Lhs, class Rhs, uint8_t R, uint8_t C>
+    constexpr MatDifference<Lhs, Rhs, R, C> operator-(const MatExpr<Lhs, R, C>& left, const MatExpr<Rhs, R, C>& right) {
+        return MatDifference<Lhs, Rhs, R, C>(left.self(), right.self());
+    }
+
+    /**
+     * Operator overloads for multiplication with a scalar value
+     */
+    template<class E, uint8_t R, uint8_t C>
+    constexpr MatScale<E, R, C> operator*(const MatExpr<E, R, C>& expr, float scale) {
+        return MatScale<E, R, C>(expr.self(), scale);
+    }
+
+    template<class E, uint8_t R, uint8_t C>
+    constexpr MatScale<E, R, C> operator*(float scale, const MatExpr<E, R, C>& expr) {
+        return MatScale<E, R, C>(expr.self(), scale);
+    }
+
+    /**
+     * Operator overload for division with a scalar value. Like `Mat::divide`, this multiplies
+     * by the reciprocal.
+     */
+    template<class E, uint8_t R, uint8_t C>
+    constexpr MatScale<E, R, C> operator/(const MatExpr<E, R, C>& expr, float divisor) {
+        return MatScale<E, R, C>(expr.self(), 1.0 / divisor);
+    }
+
+    /**
+     * Operator overload for matrix multiplication where the left side is an expression. The
+     * operands are evaluated first, since every element of the product reads a whole row and
+     * column.
+     */
+    template<class Lhs, class Rhs, uint8_t R, uint8_t K, uint8_t C>
+    constexpr Mat<R, C> operator*(const MatExpr<Lhs, R, K>& left, const MatExpr<Rhs, K, C>& right) {
+        return eval(left).multiply(eval(right));
+    }
+
+    template<class E, uint8_t R, uint8_t C>
+    ::std::ostream& operator<<(::std::ostream& out, const MatExpr<E, R, C>& expr) {
+
+        // Print the buffered string value
+        out << expr.to_str();
+
+        // Return the stream
+        return out;
+
+    }
+
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+#include <vector>
+#include "vec.h"
+#include "point.h"
+#include "polygon.h"
+#include "vec_soa.h"
+
+namespace e3d {
+
+    /**
+     * A read-only view of an indexed triangle mesh. Like `VecSoaView`, it doesn't own its
+     * memory, so it can point into any buffer.
+     */
+    struct MeshView {
+
+        /**
+         * The shared vertex positions
+         */
+        VecSoaView<3> positions;
+
+        /**
+         * The texture coordinates of each vertex, or an empty view if there are none
+         */
+        VecSoaView<2> uvs;
+
+        /**
+         * Three vertex indices per triangle
+         */
+        const uint32_t* indices;
+
+        /**
+         * The number of triangles
+         */
+        size_t triangle_count;
+
+    };
+
+    /**
+     * An indexed triangle mesh. Vertices are stored once, as SoA streams, and each triangle
+     * refers to its three corners by index, so vertices shared between triangles aren't
+     * duplicated the way they are in an array of `Tri3`.
+     */
+    struct Mesh {
+
+        /**
+         * The vertex positions
+         */
+        Vec3Soa positions;
+
+        /**
+         * The texture coordinates of each vertex. Either empty, or the same size as
+         * `positions`.
+         */
+        VecSoa<2> uvs;
+
+        /**
+         * Three vertex indices per triangle, counter-clockwise when seen from the front
+         */
+        std::vector<uint32_t> indices;
+
+        size_t vertex_count() const { return this->positions.size(); }
+        size_t triangle_count() const { return this->indices.size() / 3; }
+
+        /**
+         * Appends a vertex and returns its index
+         */
+        uint32_t add_vertex(const Point3& position) {
+            this->positions.push_back(position);
+            return uint32_t(this->positions.size() - 1);
+        }
+
+        /**
+         * Appends a vertex with texture coordinates and returns its index
+         */
+        uint32_t add_vertex(const Point3& position, const Vec2& uv) {
+            this->uvs.push_back(uv);
+            return this->add_vertex(position);
+        }
+
+        /**
+         * Appends a triangle between three existing vertices
+         */
+        void add_triangle(uint32_t a, uint32_t b, uint32_t c) {
+            this->indices.push_back(a);
+            this->indices.push_back(b);
+            this->indices.push_back(c);
+        }
+
+        /**
+         * Copies out the corners of a triangle
+         */
+        Tri3 triangle(size_t index) const {
+            Tri3 tri;
+            for (int i = 0; i < 3; i++) tri.points[i] = this->positions.get(this->indices[index * 3 + i]);
+            return tri;
+        }
+
+        /**
+         * Gets a read-only view of the mesh
+         */
+        MeshView view() const {
+            MeshView view;
+            view.positions = this->positions.view();
+            view.uvs = this->uvs.view();
+            view.indices = this->indices.data();
+            view.triangle_count = this->triangle_count();
+            return view;
+        }
+
+        operator MeshView() const { return this->view(); }
+
+    };
+
+    /**
+     * The triangles around each vertex, in compressed sparse row form: the triangles using
+     * vertex `v` are `triangles[offsets[v]]` up to `triangles[offsets[v + 1]]`, in ascending
+     * order. It only depends on the index buffer, so it can be built once and reused while
+     * the vertices move.
+     */
+    struct MeshAdjacency {
+        std::vector<uint32_t> offsets;
+        std::vector<uint32_t> triangles;
+    };
+
+}
@@ -8,5 +8,6 @@ namespace e3d {
 
     typedef Vec<2> Point2;
     typedef Vec<3> Point3;
+    typedef Vec3Padded Point3Padded;
 
 }
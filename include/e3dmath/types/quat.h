@@ -0,0 +1,125 @@
+#pragma once
+
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <cinttypes>
+#include "vec.h"
+
+namespace e3d {
+
+    /**
+     * A quaternion, stored as (x, y, z, w) with the scalar part last so that arrays of
+     * quaternions have the same layout as arrays of `Vec4`. Rotations are unit quaternions.
+     */
+    struct Quat {
+
+        /**
+         * Constructs the identity rotation
+         */
+        static constexpr Quat identity() { return Quat(0, 0, 0, 1); }
+
+        /**
+         * The raw data, in x, y, z, w order. Aligned to 16 bytes like a Vec4.
+         */
+        alignas(16) float data[4];
+
+        /**
+         * Constructs a quaternion with all values set to zero
+         */
+        constexpr Quat() : data{} {}
+
+        /**
+         * Constructs a quaternion from its components
+         */
+        constexpr Quat(float x, float y, float z, float w) : data{ x, y, z, w } {}
+
+        /**
+         * Constructs a quaternion from a Vec4 in x, y, z, w order
+         */
+        constexpr explicit Quat(const Vec4& vec) : data{ vec.get(0), vec.get(1), vec.get(2), vec.get(3) } {}
+
+        constexpr float x() const { return this->data[0]; }
+        constexpr float y() const { return this->data[1]; }
+        constexpr float z() const { return this->data[2]; }
+        constexpr float w() const { return this->data[3]; }
+
+        /**
+         * Gets the vector (x, y, z) part
+         */
+        constexpr Vec3 xyz() const {
+            Vec3 result;
+            for (uint8_t i = 0; i < 3; i++) result.set(i, this->data[i]);
+            return result;
+        }
+
+        /**
+         * Converts the quaternion to a Vec4 in x, y, z, w order
+         */
+        constexpr Vec4 to_vec4() const { return Vec4(this->data); }
+
+        /**
+         * Gets the conjugate, which is the inverse rotation for unit quaternions
+         */
+        constexpr Quat conjugate() const { return Quat(-this->data[0], -this->data[1], -this->data[2], this->data[3]); }
+
+        /**
+         * Multiplies this quaternion with another (the Hamilton product). As a rotation, the
+         * result applies `other` first and then this one, like multiplying matrices.
+         */
+        constexpr Quat multiply(const Quat& other) const;
+
+        /**
+         * Operator overload for the Hamilton product
+         */
+        constexpr Quat operator*(const Quat& other) const { return this->multiply(other); }
+
+        /**
+         * Creates a string representation of the quaternion
+         */
+        std::string to_str() const;
+
+    };
+
+    constexpr Quat Quat::multiply(const Quat& other) const {
+
+        // Get the components of both sides
+        const float ax = this->data[0], ay = this->data[1], az = this->data[2], aw = this->data[3];
+        const float bx = other.data[0], by = other.data[1], bz = other.data[2], bw = other.data[3];
+
+        // Calculate the product
+        return Quat(
+            aw * bx + ax * bw + ay * bz - az * by,
+            aw * by - ax * bz + ay * bw + az * bx,
+            aw * bz + ax * by - ay * bx + az * bw,
+            aw * bw - ax * bx - ay * by - az * bz
+        );
+
+    }
+
+    inline std::string Quat::to_str() const {
+
+        // Print the components in the same format as vectors, scalar part last
+        std::stringstream ss;
+        ss << "[";
+        for (uint8_t i = 0; i < 4; i++) {
+            if (i > 0) ss << ", ";
+            if (this->data[i] >= 0) ss << " ";
+            ss << std::fixed << std::setprecision(3) << this->data[i];
+        }
+        ss << "]";
+        return ss.str();
+
+    }
+
+    inline ::std::ostream& operator<<(::std::ostream& out, const Quat& obj) {
+
+        // Print the buffered string value
+        out << obj.to_str();
+
+        // Return the stream
+        return out;
+
+    }
+
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cinttypes>
+#include "vec.h"
+#include "point.h"
+
+namespace e3d {
+
+    /**
+     * A ray starting at `origin` and extending along `direction`. The direction doesn't have
+     * to be normalized: distances along the ray are measured in multiples of it.
+     */
+    struct Ray3 {
+
+        Point3 origin;
+        Vec3 direction;
+
+        Ray3() {}
+        Ray3(const Point3& origin, const Vec3& direction) : origin(origin), direction(direction) {}
+
+        /**
+         * Gets the point at distance `t` along the ray
+         */
+        Point3 at(float t) const {
+            return this->origin + this->direction * t;
+        }
+
+    };
+
+    /**
+     * Where a ray hit a triangle
+     */
+    struct RayHit {
+
+        /**
+         * The distance along the ray, in multiples of its direction
+         */
+        float t;
+
+        /**
+         * The barycentric coordinates of the hit, weighting the second and third corners. The
+         * hit point is `(1 - u - v) * a + u * b + v * c`.
+         */
+        float u;
+        float v;
+
+        /**
+         * The index of the triangle that was hit
+         */
+        uint32_t triangle;
+
+    };
+
+}
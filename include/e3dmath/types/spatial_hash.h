@@ -0,0 +1,383 @@
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+#include "vec.h"
+#include "point.h"
+#include "aabb.h"
+#include "../utils/point.h"
+#include "../utils/parallel.h"
+
+namespace e3d {
+
+    /**
+     * A uniform grid of cubic cells over moving points (ie. entity positions), for radius and
+     * box queries that have to keep up with the points changing every frame.
+     *
+     * Cells are hashed into a fixed number of buckets, so the grid covers unbounded space
+     * with memory proportional to the number of points. The points are stored bucket by
+     * bucket in one array (compressed rows, laid out by a radix sort), along with their
+     * indices, so a query reads each bucket it touches straight through.
+     *
+     * Rebuilding runs across the shared thread pool (see utils/parallel.h). `update` avoids
+     * most of that work when the points move a little: points that stay in their bucket are
+     * moved in place, and the few that change buckets move to a small overflow list, sorted
+     * by bucket, until there are enough of them that a rebuild is cheaper. Either way, the
+     * layout and query results only depend on the points, not on the number of threads.
+     */
+    class SpatialHash {
+    public:
+
+        /**
+         * The index of an entry whose point has moved to the overflow list
+         */
+        static constexpr uint32_t none = UINT32_MAX;
+
+        /**
+         * The number of points each thread takes at a time while building or updating
+         */
+        static constexpr size_t grain = 1 << 14;
+
+        /**
+         * The number of queries each thread takes at a time in batch queries
+         */
+        static constexpr size_t query_grain = 256;
+
+        explicit SpatialHash(float cell_size = 1.0f) : side(cell_size), inverse(1.0f / cell_size) {}
+        SpatialHash(float cell_size, const Point3* points, size_t count) : SpatialHash(cell_size) { this->build(points, count); }
+
+        /**
+         * Rebuilds the grid over an array of points, replacing any previous ones
+         */
+        void build(const Point3* points, size_t count) {
+
+            // Use a power of two buckets, at least one per point
+            uint32_t bucket_count = 1;
+            while (bucket_count < count) bucket_count <<= 1;
+            this->mask = bucket_count - 1;
+            this->buckets.resize(count);
+            this->slots.resize(count);
+            this->entries.resize(count);
+            this->overflow.clear();
+            this->removed = 0;
+
+            // Find each point's bucket, keyed with its index
+            std::vector<uint64_t> keys(count), scratch(count);
+            utils::parallel::for_range(0, count, grain, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; i++) {
+                    uint32_t bucket = this->_bucket(points[i]);
+                    this->buckets[i] = bucket;
+                    keys[i] = (uint64_t(bucket) << 32) | i;
+                }
+            });
+
+            // Sort them by bucket, a few bits at a time. The sort is stable, so each bucket
+            // stays in index order.
+            uint32_t bits = 0;
+            while ((uint32_t(1) << bits) < bucket_count) bits++;
+            size_t blocks = (count + grain - 1) / grain;
+            std::vector<uint32_t> histograms(blocks * _radix);
+            for (uint32_t shift = 32; shift < 32 + bits; shift += _radix_bits) {
+
+                // Count the digits in each block
+                utils::parallel::for_range(0, blocks, 1, [&](size_t first, size_t last) {
+                    for (size_t block = first; block < last; block++) {
+                        uint32_t* histogram = histograms.data() + block * _radix;
+                        std::fill(histogram, histogram + _radix, 0);
+                        size_t end = std::min(count, (block + 1) * grain);
+                        for (size_t i = block * grain; i < end; i++) histogram[(keys[i] >> shift) & (_radix - 1)]++;
+                    }
+                });
+
+                // Each block writes each digit after the same digit of the blocks before it
+                uint32_t offset = 0;
+                for (size_t digit = 0; digit < _radix; digit++) {
+                    for (size_t block = 0; block < blocks; block++) {
+                        uint32_t digit_count = histograms[block * _radix + digit];
+                        histograms[block * _radix + digit] = offset;
+                        offset += digit_count;
+                    }
+                }
+                utils::parallel::for_range(0, blocks, 1, [&](size_t first, size_t last) {
+                    for (size_t block = first; block < last; block++) {
+                        uint32_t* cursors = histograms.data() + block * _radix;
+                        size_t end = std::min(count, (block + 1) * grain);
+                        for (size_t i = block * grain; i < end; i++) scratch[cursors[(keys[i] >> shift) & (_radix - 1)]++] = keys[i];
+                    }
+                });
+                keys.swap(scratch);
+
+            }
+
+            // Lay out the entries, and start each bucket at its first entry
+            this->offsets.resize(size_t(bucket_count) + 1);
+            utils::parallel::for_range(0, count, grain, [&](size_t begin, size_t end) {
+                for (size_t slot = begin; slot < end; slot++) {
+                    uint32_t id = uint32_t(keys[slot]), bucket = uint32_t(keys[slot] >> 32);
+                    this->entries[slot] = { points[id], id };
+                    this->slots[id] = uint32_t(slot);
+                    uint32_t previous = slot == 0 ? 0 : uint32_t(keys[slot - 1] >> 32) + 1;
+                    for (uint32_t empty = previous; empty <= bucket; empty++) this->offsets[empty] = uint32_t(slot);
+                }
+            });
+            uint32_t last = count == 0 ? 0 : uint32_t(keys[count - 1] >> 32) + 1;
+            for (uint32_t bucket = last; bucket <= bucket_count; bucket++) this->offsets[bucket] = uint32_t(count);
+
+        }
+
+        /**
+         * Moves the points to new positions. The array must be the same size as the last
+         * build. This is much cheaper than a rebuild when few points change buckets.
+         */
+        void update(const Point3* points) {
+            size_t count = this->buckets.size();
+
+            // Points that stay in their bucket move in place, and the rest are collected in
+            // order
+            size_t blocks = (count + grain - 1) / grain;
+            std::vector<std::vector<uint32_t>> moved(blocks);
+            utils::parallel::for_range(0, blocks, 1, [&](size_t first, size_t last) {
+                for (size_t block = first; block < last; block++) {
+                    size_t end = std::min(count, (block + 1) * grain);
+                    for (size_t i = block * grain; i < end; i++) {
+                        if (this->_bucket(points[i]) != this->buckets[i]) moved[block].push_back(uint32_t(i));
+                        else this->_entry(uint32_t(i)).point = points[i];
+                    }
+                }
+            });
+
+            // Rebuild if too many entries would be left empty
+            size_t moved_out = 0;
+            for (const std::vector<uint32_t>& block : moved) {
+                for (uint32_t i : block) moved_out += this->slots[i] < this->entries.size();
+            }
+            if (this->removed + moved_out > count / 8) {
+                this->build(points, count);
+                return;
+            }
+
+            // Otherwise empty the old entries of the points that moved, and re-sort the
+            // overflow with them in their new buckets
+            for (const std::vector<uint32_t>& block : moved) {
+                for (uint32_t i : block) {
+                    this->_entry(i).id = none;
+                    this->buckets[i] = this->_bucket(points[i]);
+                }
+            }
+            this->removed += moved_out;
+            this->overflow.erase(std::remove_if(this->overflow.begin(), this->overflow.end(), [](const _Entry& entry) {
+                return entry.id == none;
+            }), this->overflow.end());
+            for (const std::vector<uint32_t>& block : moved) {
+                for (uint32_t i : block) this->overflow.push_back({ points[i], i });
+            }
+            std::sort(this->overflow.begin(), this->overflow.end(), [&](const _Entry& a, const _Entry& b) {
+                return this->buckets[a.id] < this->buckets[b.id] || (this->buckets[a.id] == this->buckets[b.id] && a.id < b.id);
+            });
+            for (size_t slot = 0; slot < this->overflow.size(); slot++) {
+                this->slots[this->overflow[slot].id] = uint32_t(this->entries.size() + slot);
+            }
+
+        }
+
+        size_t size() const { return this->buckets.size(); }
+        float cell_size() const { return this->side; }
+
+        /**
+         * Finds every point within `radius` of `center` (by `utils::point::distance2`),
+         * replacing the contents of `out` with their indices in increasing order
+         */
+        void within(const Point3& center, float radius, std::vector<uint32_t>& out) const {
+            float radius2 = radius * radius;
+            Point3 low, high;
+            for (uint8_t c = 0; c < 3; c++) {
+                low.set(c, center.get(c) - radius);
+                high.set(c, center.get(c) + radius);
+            }
+            this->_query(low, high, out, [&](const Point3& point) {
+                return utils::point::distance2(center, point) <= radius2;
+            });
+        }
+
+        /**
+         * Finds every point inside a box (by `Aabb3::contains`), replacing the contents of
+         * `out` with their indices in increasing order
+         */
+        void within(const Aabb3& box, std::vector<uint32_t>& out) const {
+            this->_query(box.min, box.max, out, [&](const Point3& point) {
+                return box.contains(point);
+            });
+        }
+
+        /**
+         * Finds every point within `radius` of each center, across the thread pool. The
+         * indices around center `i` are `indices[offsets[i]]` up to `indices[offsets[i + 1]]`,
+         * in increasing order.
+         */
+        void within(const Point3* centers, size_t count, float radius, std::vector<uint32_t>& offsets, std::vector<uint32_t>& indices) const {
+
+            // Each block of queries collects its own results
+            size_t blocks = (count + query_grain - 1) / query_grain;
+            std::vector<std::vector<uint32_t>> found(blocks);
+            offsets.assign(count + 1, 0);
+            utils::parallel::for_range(0, blocks, 1, [&](size_t first, size_t last) {
+                std::vector<uint32_t> around;
+                for (size_t block = first; block < last; block++) {
+                    size_t begin = block * query_grain, end = std::min(count, begin + query_grain);
+                    for (size_t i = begin; i < end; i++) {
+                        this->within(centers[i], radius, around);
+                        found[block].insert(found[block].end(), around.begin(), around.end());
+                        offsets[i + 1] = uint32_t(around.size());
+                    }
+                }
+            });
+
+            // Then they're joined up in order
+            for (size_t i = 0; i < count; i++) offsets[i + 1] += offsets[i];
+            indices.resize(offsets[count]);
+            utils::parallel::for_range(0, blocks, 1, [&](size_t first, size_t last) {
+                for (size_t block = first; block < last; block++) {
+                    std::copy(found[block].begin(), found[block].end(), indices.begin() + offsets[block * query_grain]);
+                }
+            });
+
+        }
+
+    private:
+
+        /**
+         * A point in bucket order, with its index
+         */
+        struct _Entry {
+            Point3 point;
+            uint32_t id;
+        };
+
+        /**
+         * The number of bits of the bucket sorted on in each pass of a rebuild
+         */
+        static constexpr uint32_t _radix_bits = 10;
+        static constexpr size_t _radix = size_t(1) << _radix_bits;
+
+        float side;
+        float inverse;
+        uint32_t mask = 0;
+
+        /**
+         * Where each bucket's entries start, and then the end of the last one
+         */
+        std::vector<uint32_t> offsets;
+
+        /**
+         * The entries in bucket order. Points that have moved to the overflow since the last
+         * build leave their entry behind with an index of `none`.
+         */
+        std::vector<_Entry> entries;
+
+        /**
+         * The entries of points that changed buckets since the last build, sorted by bucket
+         */
+        std::vector<_Entry> overflow;
+
+        /**
+         * The bucket of each point, and where its entry is: an index into `entries`, or past
+         * the end of it into `overflow`
+         */
+        std::vector<uint32_t> buckets;
+        std::vector<uint32_t> slots;
+
+        /**
+         * The number of entries left behind in `entries`
+         */
+        size_t removed = 0;
+
+        _Entry& _entry(uint32_t i) {
+            uint32_t slot = this->slots[i];
+            return slot < this->entries.size() ? this->entries[slot] : this->overflow[slot - this->entries.size()];
+        }
+
+        /**
+         * The cell coordinate along one axis, clamped so far away points don't overflow
+         */
+        int32_t _cell(float value) const {
+            float cell = std::floor(value * this->inverse);
+            if (!(cell > -2147483648.0f)) return INT32_MIN;
+            if (!(cell < 2147483520.0f)) return 2147483520;
+            return int32_t(cell);
+        }
+
+        uint32_t _hash(int32_t x, int32_t y, int32_t z) const {
+            return ((uint32_t(x) * 73856093u) ^ (uint32_t(y) * 19349663u) ^ (uint32_t(z) * 83492791u)) & this->mask;
+        }
+
+        uint32_t _bucket(const Point3& point) const {
+            return this->_hash(this->_cell(point.data[0]), this->_cell(point.data[1]), this->_cell(point.data[2]));
+        }
+
+        /**
+         * Offers `accept` every point in the cells overlapping the box from `low` to `high`,
+         * and collects the indices of those it accepts
+         */
+        template<class Accept>
+        void _query(const Point3& low, const Point3& high, std::vector<uint32_t>& out, const Accept& accept) const {
+            out.clear();
+            if (this->buckets.empty()) return;
+            int32_t from[3], to[3];
+            double cells = 1;
+            for (int c = 0; c < 3; c++) {
+                from[c] = this->_cell(low.data[c]);
+                to[c] = this->_cell(high.data[c]);
+                if (from[c] > to[c]) return;
+                cells *= double(to[c]) - from[c] + 1;
+            }
+
+            // Boxes over more cells than there are buckets are cheaper to answer by checking
+            // every point
+            if (cells > double(this->mask) + 1) {
+                for (const _Entry& entry : this->entries) {
+                    if (entry.id != none && accept(entry.point)) out.push_back(entry.id);
+                }
+                for (const _Entry& entry : this->overflow) {
+                    if (accept(entry.point)) out.push_back(entry.id);
+                }
+                std::sort(out.begin(), out.end());
+                return;
+            }
+
+            // Otherwise check the points in the bucket of each cell. Different cells can share
+            // a bucket, so points are only taken from the bucket of the cell they're in.
+            auto in_cell = [&](const Point3& point, int32_t x, int32_t y, int32_t z) {
+                return this->_cell(point.data[0]) == x && this->_cell(point.data[1]) == y && this->_cell(point.data[2]) == z;
+            };
+            for (int32_t z = from[2]; ; z++) {
+                for (int32_t y = from[1]; ; y++) {
+                    for (int32_t x = from[0]; ; x++) {
+                        uint32_t bucket = this->_hash(x, y, z);
+                        for (uint32_t slot = this->offsets[bucket]; slot < this->offsets[bucket + 1]; slot++) {
+                            const _Entry& entry = this->entries[slot];
+                            if (entry.id != none && accept(entry.point) && in_cell(entry.point, x, y, z)) out.push_back(entry.id);
+                        }
+                        if (!this->overflow.empty()) {
+                            auto first = std::lower_bound(this->overflow.begin(), this->overflow.end(), bucket, [&](const _Entry& entry, uint32_t value) {
+                                return this->buckets[entry.id] < value;
+                            });
+                            for (; first != this->overflow.end() && this->buckets[first->id] == bucket; ++first) {
+                                if (accept(first->point) && in_cell(first->point, x, y, z)) out.push_back(first->id);
+                            }
+                        }
+                        if (x == to[0]) break;
+                    }
+                    if (y == to[1]) break;
+                }
+                if (z == to[2]) break;
+            }
+            std::sort(out.begin(), out.end());
+
+        }
+
+    };
+
+}
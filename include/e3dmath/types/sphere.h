@@ -0,0 +1,38 @@
+#pragma once
+
+#include "vec.h"
+#include "point.h"
+
+namespace e3d {
+
+    /**
+     * A bounding sphere
+     */
+    struct Sphere3 {
+
+        Point3 center;
+        float radius;
+
+        Sphere3() : radius(0) {}
+        Sphere3(const Point3& center, float radius) : center(center), radius(radius) {}
+
+        /**
+         * Checks whether a point is inside the sphere or on its surface
+         */
+        bool contains(const Point3& point) const {
+            Vec3 offset = point - this->center;
+            return offset.get(0) * offset.get(0) + offset.get(1) * offset.get(1) + offset.get(2) * offset.get(2) <= this->radius * this->radius;
+        }
+
+        /**
+         * Checks whether two spheres overlap or touch
+         */
+        bool intersects(const Sphere3& other) const {
+            Vec3 offset = other.center - this->center;
+            float reach = this->radius + other.radius;
+            return offset.get(0) * offset.get(0) + offset.get(1) * offset.get(1) + offset.get(2) * offset.get(2) <= reach * reach;
+        }
+
+    };
+
+}
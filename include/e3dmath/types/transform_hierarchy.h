@@ -0,0 +1,313 @@
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+#include <algorithm>
+#include <vector>
+#include "vec.h"
+#include "quat.h"
+#include "affine.h"
+#include "../utils/quat.h"
+#include "../utils/parallel.h"
+
+namespace e3d {
+
+    /**
+     * A tree of transforms, each with a local translation, rotation and scale relative to its
+     * parent. World transforms are cached, and `update()` only recomputes the ones whose node
+     * or ancestors changed since the last update, so static parts of a scene cost almost
+     * nothing.
+     *
+     * Nodes are stored in flat arrays sorted by depth, so that every parent comes before its
+     * children. Each depth level only reads the level above it, so the nodes within a level
+     * are updated in parallel across the shared thread pool (see utils/parallel.h).
+     *
+     * Nodes are referred to by handles, which stay valid as the storage is re-sorted.
+     */
+    class TransformHierarchy {
+    public:
+
+        /**
+         * A handle to a node
+         */
+        typedef uint32_t Node;
+
+        /**
+         * The parent of root nodes
+         */
+        static constexpr Node none = UINT32_MAX;
+
+        /**
+         * The number of nodes in a level that each thread takes at a time
+         */
+        static constexpr size_t grain = 1 << 12;
+
+        /**
+         * Adds a node with an identity local transform under `parent` (or as a root), and
+         * returns its handle
+         */
+        Node add(Node parent = none) {
+
+            // The new node goes at the end until the next update sorts it into place
+            Node node = Node(this->slot_of.size());
+            uint32_t slot = uint32_t(this->handle_of.size());
+            this->slot_of.push_back(slot);
+            this->parents.push_back(parent);
+            this->handle_of.push_back(node);
+            this->translations.push_back(Vec3());
+            this->rotations.push_back(Quat::identity());
+            this->scales.push_back(Vec3(_ones));
+            this->locals.push_back(Affine3::identity());
+            this->worlds.push_back(Affine3::identity());
+            this->dirty.push_back(1);
+            this->changed.push_back(0);
+            this->layout_dirty = true;
+            this->any_dirty = true;
+            return node;
+
+        }
+
+        /**
+         * Moves a node (and its subtree) under a new parent, or makes it a root. Returns false,
+         * changing nothing, if `parent` is the node itself or one of its descendants.
+         */
+        bool set_parent(Node node, Node parent) {
+
+            // Walk up from the new parent, looking for the node
+            for (Node ancestor = parent; ancestor != none; ancestor = this->parents[ancestor]) {
+                if (ancestor == node) return false;
+            }
+
+            // Attach it, and recompute its world transform on the next update
+            this->parents[node] = parent;
+            this->dirty[this->slot_of[node]] = 1;
+            this->layout_dirty = true;
+            this->any_dirty = true;
+            return true;
+
+        }
+
+        /**
+         * Gets the parent of a node, or `none` for roots
+         */
+        Node parent(Node node) const { return this->parents[node]; }
+
+        /**
+         * The number of nodes
+         */
+        size_t size() const { return this->slot_of.size(); }
+
+        /**
+         * Sets the local translation of a node
+         */
+        void set_translation(Node node, const Vec3& translation) {
+            uint32_t slot = this->_touch(node);
+            this->translations[slot] = translation;
+        }
+
+        /**
+         * Sets the local rotation of a node
+         */
+        void set_rotation(Node node, const Quat& rotation) {
+            uint32_t slot = this->_touch(node);
+            this->rotations[slot] = rotation;
+        }
+
+        /**
+         * Sets the local scale of a node
+         */
+        void set_scale(Node node, const Vec3& scale) {
+            uint32_t slot = this->_touch(node);
+            this->scales[slot] = scale;
+        }
+
+        /**
+         * Sets the whole local transform of a node
+         */
+        void set_local(Node node, const Vec3& translation, const Quat& rotation, const Vec3& scale) {
+            uint32_t slot = this->_touch(node);
+            this->translations[slot] = translation;
+            this->rotations[slot] = rotation;
+            this->scales[slot] = scale;
+        }
+
+        const Vec3& translation(Node node) const { return this->translations[this->slot_of[node]]; }
+        const Quat& rotation(Node node) const { return this->rotations[this->slot_of[node]]; }
+        const Vec3& scale(Node node) const { return this->scales[this->slot_of[node]]; }
+
+        /**
+         * Gets the local transform of a node, as of the last update
+         */
+        const Affine3& local(Node node) const { return this->locals[this->slot_of[node]]; }
+
+        /**
+         * Gets the world transform of a node, as of the last update
+         */
+        const Affine3& world(Node node) const { return this->worlds[this->slot_of[node]]; }
+
+        /**
+         * Whether the last update changed the world transform of a node, ie. to find what
+         * needs uploading to the GPU
+         */
+        bool world_changed(Node node) const { return this->changed[this->slot_of[node]] != 0; }
+
+        /**
+         * Recomputes the world transforms of every changed node and its descendants
+         */
+        void update() {
+
+            // Clear the flags from the last update
+            std::fill(this->changed.begin(), this->changed.end(), 0);
+            if (!this->any_dirty) return;
+
+            // Sort the nodes by depth if the tree changed shape
+            if (this->layout_dirty) this->_sort();
+
+            // Walk down the levels, each one in parallel
+            for (size_t level = 0; level + 1 < this->level_offsets.size(); level++) {
+                utils::parallel::for_range(this->level_offsets[level], this->level_offsets[level + 1], grain, [this](size_t begin, size_t end) {
+                    this->_update_range(begin, end);
+                });
+            }
+            this->any_dirty = false;
+
+        }
+
+    private:
+
+        static constexpr float _ones[3] = { 1, 1, 1 };
+
+        /**
+         * Marks a node as changed, and returns where it's stored
+         */
+        uint32_t _touch(Node node) {
+            uint32_t slot = this->slot_of[node];
+            this->dirty[slot] = 1;
+            this->any_dirty = true;
+            return slot;
+        }
+
+        /**
+         * Updates the nodes stored in [begin, end), which must all be at the same depth
+         */
+        void _update_range(size_t begin, size_t end) {
+            for (size_t slot = begin; slot < end; slot++) {
+
+                // Skip nodes where neither it nor its parent changed
+                uint32_t parent = this->parent_slots[slot];
+                bool parent_changed = parent != UINT32_MAX && this->changed[parent];
+                if (!this->dirty[slot] && !parent_changed) continue;
+
+                // Rebuild the local transform, as translate * rotate * scale
+                if (this->dirty[slot]) {
+                    Affine3 local = utils::quat::to_affine3(this->rotations[slot]);
+                    for (int r = 0; r < 3; r++) {
+                        for (int c = 0; c < 3; c++) local.data[r * 4 + c] *= this->scales[slot].get(c);
+                        local.data[r * 4 + 3] = this->translations[slot].get(r);
+                    }
+                    this->locals[slot] = local;
+                    this->dirty[slot] = 0;
+                }
+
+                // Combine it with the parent
+                this->worlds[slot] = parent == UINT32_MAX ? this->locals[slot] : this->worlds[parent] * this->locals[slot];
+                this->changed[slot] = 1;
+
+            }
+        }
+
+        /**
+         * Reorders the storage so that nodes are sorted by depth, keeping their current order
+         * within each depth
+         */
+        void _sort() {
+
+            // Find the depth of every node, reusing the depths of ancestors already found
+            size_t count = this->size();
+            std::vector<uint32_t> depths(count, UINT32_MAX);
+            std::vector<Node> path;
+            uint32_t max_depth = 0;
+            for (Node node = 0; node < count; node++) {
+                Node cursor = node;
+                while (cursor != none && depths[cursor] == UINT32_MAX) {
+                    path.push_back(cursor);
+                    cursor = this->parents[cursor];
+                }
+                uint32_t depth = cursor == none ? 0 : depths[cursor] + 1;
+                while (!path.empty()) {
+                    depths[path.back()] = depth++;
+                    path.pop_back();
+                }
+                max_depth = std::max(max_depth, depths[node]);
+            }
+
+            // Count the nodes at each depth, then turn the counts into offsets
+            this->level_offsets.assign(max_depth + 2, 0);
+            for (Node node = 0; node < count; node++) this->level_offsets[depths[node] + 1]++;
+            for (size_t level = 1; level < this->level_offsets.size(); level++) this->level_offsets[level] += this->level_offsets[level - 1];
+
+            // Place each node, in its current order, after the others at its depth
+            std::vector<size_t> cursors(this->level_offsets.begin(), this->level_offsets.end() - 1);
+            std::vector<uint32_t> new_slot_of(count);
+            for (uint32_t slot = 0; slot < count; slot++) {
+                Node node = this->handle_of[slot];
+                new_slot_of[node] = uint32_t(cursors[depths[node]]++);
+            }
+
+            // Move the per-node data into the new order
+            std::vector<uint32_t> moves(count);
+            for (uint32_t slot = 0; slot < count; slot++) moves[slot] = new_slot_of[this->handle_of[slot]];
+            _permute(this->handle_of, moves);
+            _permute(this->translations, moves);
+            _permute(this->rotations, moves);
+            _permute(this->scales, moves);
+            _permute(this->locals, moves);
+            _permute(this->worlds, moves);
+            _permute(this->dirty, moves);
+            _permute(this->changed, moves);
+            this->slot_of = new_slot_of;
+
+            // Point each node at where its parent now lives
+            this->parent_slots.resize(count);
+            for (uint32_t slot = 0; slot < count; slot++) {
+                Node parent = this->parents[this->handle_of[slot]];
+                this->parent_slots[slot] = parent == none ? UINT32_MAX : this->slot_of[parent];
+            }
+            this->layout_dirty = false;
+
+        }
+
+        /**
+         * Moves the element in each slot to `moves[slot]`
+         */
+        template<class T>
+        static void _permute(std::vector<T>& values, const std::vector<uint32_t>& moves) {
+            std::vector<T> result(values.size());
+            for (size_t slot = 0; slot < values.size(); slot++) result[moves[slot]] = values[slot];
+            values.swap(result);
+        }
+
+        // Indexed by handle
+        std::vector<uint32_t> slot_of;
+        std::vector<Node> parents;
+
+        // Indexed by slot, sorted by depth
+        std::vector<Node> handle_of;
+        std::vector<uint32_t> parent_slots;
+        std::vector<Vec3> translations;
+        std::vector<Quat> rotations;
+        std::vector<Vec3> scales;
+        std::vector<Affine3> locals;
+        std::vector<Affine3> worlds;
+        std::vector<uint8_t> dirty;
+        std::vector<uint8_t> changed;
+
+        // The first slot of each depth, plus the end
+        std::vector<size_t> level_offsets;
+
+        bool layout_dirty = false;
+        bool any_dirty = false;
+
+    };
+
+}
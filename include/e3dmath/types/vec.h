@@ -10,4 +10,31 @@ namespace e3d {
     typedef Vec<3> Vec3;
     typedef Vec<4> Vec4;
 
+    /**
+     * A Vec3 padded out to 16 bytes, for storing arrays of 3D points or directions that
+     * vector instructions can load one at a time, each with a single aligned load. The
+     * padding is kept zero. Math is done by converting to and from Vec3, which is free once
+     * inlined.
+     */
+    struct Vec3Padded {
+
+        /**
+         * The raw data: x, y, z, then the padding
+         */
+        alignas(16) float data[4];
+
+        constexpr Vec3Padded() : data{} {}
+        constexpr Vec3Padded(float x, float y, float z) : data{ x, y, z, 0 } {}
+        constexpr Vec3Padded(const Vec3& vec) : data{ vec.get(0), vec.get(1), vec.get(2), 0 } {}
+
+        constexpr operator Vec3() const { return Vec3(this->data); }
+
+        constexpr float x() const { return this->data[0]; }
+        constexpr float y() const { return this->data[1]; }
+        constexpr float z() const { return this->data[2]; }
+        constexpr float get(uint8_t index) const { return this->data[index]; }
+        constexpr void set(uint8_t index, float value) { this->data[index] = value; }
+
+    };
+
 }
\ No newline at end of file
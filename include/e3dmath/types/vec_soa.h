@@ -0,0 +1,279 @@
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+#include <algorithm>
+#include "vec.h"
+#include "../simd/aligned.h"
+#include "../simd/lanes.h"
+
+#define E3D_SIMD_KERNELS "kernels/soa.inl"
+#include "../simd/foreach_target.h"
+
+namespace e3d {
+
+    /**
+     * A read-only view over `size` vectors stored as S separate component streams. Views
+     * don't own their memory, so they can point into any buffer (ie. a mapped file).
+     */
+    template<uint8_t S>
+    struct VecSoaView {
+
+        /**
+         * One pointer per component, each to `size` floats
+         */
+        const float* data[S];
+
+        /**
+         * The number of vectors in the view
+         */
+        size_t size;
+
+    };
+
+    /**
+     * A writable view over `size` vectors stored as S separate component streams
+     */
+    template<uint8_t S>
+    struct VecSoaSpan {
+
+        /**
+         * One pointer per component, each to `size` floats
+         */
+        float* data[S];
+
+        /**
+         * The number of vectors in the span
+         */
+        size_t size;
+
+        /**
+         * Converts the span into a read-only view
+         */
+        operator VecSoaView<S>() const {
+            VecSoaView<S> view;
+            for (uint8_t c = 0; c < S; c++) view.data[c] = this->data[c];
+            view.size = this->size;
+            return view;
+        }
+
+    };
+
+    /**
+     * A structure-of-arrays container of S-component vectors. Each component lives in its own
+     * stream (all of the x values, then all of the y values, etc.), so batch kernels can load
+     * the same component of many vectors with a single instruction.
+     *
+     * Every stream starts on a 64-byte boundary and is padded with zeros up to a multiple of
+     * 16 floats.
+     */
+    template<uint8_t S>
+    class VecSoa {
+    public:
+
+        /**
+         * Constructs an empty container
+         */
+        VecSoa() : count(0), stride(0) {}
+
+        /**
+         * Constructs a container of `count` zero vectors
+         */
+        explicit VecSoa(size_t count) : VecSoa() { this->resize(count); }
+
+        /**
+         * Constructs a container from an array of `count` vectors
+         */
+        VecSoa(const Vec<S>* vecs, size_t count) : VecSoa(count) { this->assign(vecs, count); }
+
+        /**
+         * The number of vectors in the container
+         */
+        size_t size() const { return this->count; }
+
+        /**
+         * The number of floats reserved per component stream
+         */
+        size_t capacity() const { return this->stride; }
+
+        /**
+         * Gets the stream holding component `c` of every vector
+         */
+        float* component(uint8_t c) { return this->buffer.data() + c * this->stride; }
+        const float* component(uint8_t c) const { return this->buffer.data() + c * this->stride; }
+
+        float* x() { return this->component(0); }
+        float* y() { return this->component(1); }
+        float* z() { return this->component(2); }
+        float* w() { return this->component(3); }
+        const float* x() const { return this->component(0); }
+        const float* y() const { return this->component(1); }
+        const float* z() const { return this->component(2); }
+        const float* w() const { return this->component(3); }
+
+        /**
+         * Gathers the vector at an index
+         */
+        Vec<S> get(size_t index) const;
+
+        /**
+         * Scatters a vector into an index
+         */
+        void set(size_t index, const Vec<S>& vec);
+
+        /**
+         * Appends a vector to the end of the container
+         */
+        void push_back(const Vec<S>& vec);
+
+        /**
+         * Resizes the container, filling any new vectors with zeros
+         */
+        void resize(size_t count);
+
+        /**
+         * Makes sure there is room for `capacity` vectors without moving the streams
+         */
+        void reserve(size_t capacity);
+
+        /**
+         * Removes all of the vectors, keeping the storage
+         */
+        void clear() { this->resize(0); }
+
+        /**
+         * Replaces the contents with an array of `count` vectors
+         */
+        void assign(const Vec<S>* vecs, size_t count);
+
+        /**
+         * Copies the contents out into an array of `size()` vectors
+         */
+        void to_vecs(Vec<S>* out) const;
+
+        /**
+         * Gets a read-only view of the whole container
+         */
+        VecSoaView<S> view() const;
+
+        /**
+         * Gets a writable view of the whole container
+         */
+        VecSoaSpan<S> span();
+
+        operator VecSoaView<S>() const { return this->view(); }
+
+    private:
+
+        size_t count;
+        size_t stride;
+        simd::aligned_vector<float> buffer;
+
+    };
+
+    typedef VecSoa<3> Vec3Soa;
+    typedef VecSoa<4> Vec4Soa;
+
+    template<uint8_t S>
+    Vec<S> VecSoa<S>::get(size_t index) const {
+        Vec<S> result;
+        for (uint8_t c = 0; c < S; c++) result.set(c, this->component(c)[index]);
+        return result;
+    }
+
+    template<uint8_t S>
+    void VecSoa<S>::set(size_t index, const Vec<S>& vec) {
+        for (uint8_t c = 0; c < S; c++) this->component(c)[index] = vec.get(c);
+    }
+
+    template<uint8_t S>
+    void VecSoa<S>::push_back(const Vec<S>& vec) {
+
+        // Grow geometrically, since growing moves every stream
+        if (this->count == this->stride) this->reserve(std::max(simd::buffer_lanes, this->stride * 2));
+
+        // Append the vector
+        this->count++;
+        this->set(this->count - 1, vec);
+
+    }
+
+    template<uint8_t S>
+    void VecSoa<S>::reserve(size_t capacity) {
+
+        // Get the padded stream length. Streams a multiple of 4 KB apart would all map to the
+        // same cache sets, so those are staggered by one more block of lanes.
+        size_t new_stride = simd::pad_lanes(capacity);
+        if (S > 1 && new_stride > 0 && new_stride * sizeof(float) % 4096 == 0) new_stride += simd::buffer_lanes;
+        if (new_stride <= this->stride) return;
+
+        // Move each stream into the new buffer
+        simd::aligned_vector<float> new_buffer(new_stride * S);
+        for (uint8_t c = 0; c < S; c++) {
+            std::copy_n(this->component(c), this->count, new_buffer.data() + c * new_stride);
+        }
+
+        // Swap in the new buffer
+        this->buffer.swap(new_buffer);
+        this->stride = new_stride;
+
+    }
+
+    template<uint8_t S>
+    void VecSoa<S>::resize(size_t count) {
+
+        // Make room, then zero the vectors between the old and new size
+        this->reserve(count);
+        for (uint8_t c = 0; c < S && count > this->count; c++) {
+            std::fill(this->component(c) + this->count, this->component(c) + count, 0.0f);
+        }
+
+        // Zero anything left past the end when shrinking, so the padding stays zero
+        for (uint8_t c = 0; c < S && count < this->count; c++) {
+            std::fill(this->component(c) + count, this->component(c) + this->count, 0.0f);
+        }
+
+        this->count = count;
+
+    }
+
+    template<uint8_t S>
+    void VecSoa<S>::assign(const Vec<S>* vecs, size_t count) {
+        static_assert(sizeof(Vec<S>) == S * sizeof(float), "Vectors must be tightly packed to convert");
+
+        // Size the streams, then split the components out
+        this->resize(count);
+        if (count == 0) return;
+        float* streams[S];
+        for (uint8_t c = 0; c < S; c++) streams[c] = this->component(c);
+        E3D_SIMD_DISPATCH(soa::from_aos<S>(vecs->data, streams, count));
+
+    }
+
+    template<uint8_t S>
+    void VecSoa<S>::to_vecs(Vec<S>* out) const {
+        static_assert(sizeof(Vec<S>) == S * sizeof(float), "Vectors must be tightly packed to convert");
+
+        // Interleave the streams into the output
+        if (this->count == 0) return;
+        VecSoaView<S> streams = this->view();
+        E3D_SIMD_DISPATCH(soa::to_aos<S>(streams.data, out->data, this->count));
+    }
+
+    template<uint8_t S>
+    VecSoaView<S> VecSoa<S>::view() const {
+        VecSoaView<S> view;
+        for (uint8_t c = 0; c < S; c++) view.data[c] = this->component(c);
+        view.size = this->count;
+        return view;
+    }
+
+    template<uint8_t S>
+    VecSoaSpan<S> VecSoa<S>::span() {
+        VecSoaSpan<S> span;
+        for (uint8_t c = 0; c < S; c++) span.data[c] = this->component(c);
+        span.size = this->count;
+        return span;
+    }
+
+}
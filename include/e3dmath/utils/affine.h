@@ -0,0 +1,205 @@
+#pragma once
+
+#include "../types/affine.h"
+#include "../types/point.h"
+#include "./mat.h"
+
+namespace e3d::utils::affine {
+
+    /**
+     * Creates a translation transform
+     */
+    static constexpr Affine3 affine3_create_translation(float x, float y, float z) {
+        return Affine3::from_mat4(utils::mat::mat4_create_translation(x, y, z));
+    }
+
+    /**
+     * Creates a scaling transform
+     */
+    static constexpr Affine3 affine3_create_scale(float x, float y, float z) {
+        return Affine3::from_mat4(utils::mat::mat4_create_scale(x, y, z));
+    }
+
+    /**
+     * Creates a rotation of `x` radians on the x-axis
+     */
+    static constexpr Affine3 affine3_create_rotation_x(float x) {
+        return Affine3::from_mat4(utils::mat::mat4_create_rotation_x(x));
+    }
+
+    /**
+     * Creates a rotation of `y` radians on the y-axis
+     */
+    static constexpr Affine3 affine3_create_rotation_y(float y) {
+        return Affine3::from_mat4(utils::mat::mat4_create_rotation_y(y));
+    }
+
+    /**
+     * Creates a rotation of `z` radians on the z-axis
+     */
+    static constexpr Affine3 affine3_create_rotation_z(float z) {
+        return Affine3::from_mat4(utils::mat::mat4_create_rotation_z(z));
+    }
+
+    /**
+     * Creates a rotation in YXZ-order, matching `utils::mat::mat4_create_rotation_yxz`
+     */
+    static constexpr Affine3 affine3_create_rotation_yxz(float x, float y, float z) {
+        return Affine3::from_mat4(utils::mat::mat4_create_rotation_yxz(x, y, z));
+    }
+
+    /**
+     * Performs a translation on a transform and returns the result. Like
+     * `utils::mat::mat4_translate`, the translation is applied first, so only the translation
+     * column changes.
+     */
+    static constexpr Affine3 affine3_translate(const Affine3& affine, float x, float y, float z) {
+
+        // Create a copy of the transform
+        Affine3 result(affine);
+
+        // Move the translation by the linear part applied to the offset
+        for (int r = 0; r < 3; r++) {
+            const float* row = affine.data + r * 4;
+            result.data[r * 4 + 3] = row[0] * x + row[1] * y + row[2] * z + row[3];
+        }
+
+        // Return the result
+        return result;
+
+    }
+    static constexpr Affine3 affine3_translate(const Affine3& affine, const Vec3& vec) { return affine3_translate(affine, vec.x(), vec.y(), vec.z()); }
+
+    /**
+     * Performs a scale transformation on a transform and returns the result, scaling the
+     * rows like `utils::mat::mat4_scale`
+     */
+    static constexpr Affine3 affine3_scale(const Affine3& affine, float x, float y, float z) {
+
+        // Create a copy of the transform
+        Affine3 result(affine);
+
+        // Multiply the appropriate components
+        int i = 0;
+        for (; i < 4; i++) result.data[i] *= x;
+        for (; i < 8; i++) result.data[i] *= y;
+        for (; i < 12; i++) result.data[i] *= z;
+
+        // Return the result
+        return result;
+
+    }
+    static constexpr Affine3 affine3_scale(const Affine3& affine, const Vec3& vec) { return affine3_scale(affine, vec.x(), vec.y(), vec.z()); }
+
+    /**
+     * Performs a rotation in YXZ-order on a transform, and then returns the result
+     */
+    static constexpr Affine3 affine3_rotate_yxz(const Affine3& affine, float x, float y, float z) { return affine * affine3_create_rotation_yxz(x, y, z); }
+    static constexpr Affine3 affine3_rotate_yxz(const Affine3& affine, const Vec3& vec) { return affine3_rotate_yxz(affine, vec.x(), vec.y(), vec.z()); }
+
+    /**
+     * Applies a transform to a point, including the translation
+     */
+    static constexpr Point3 apply_point(const Affine3& affine, const Point3& point) {
+
+        // Create the result point
+        Point3 result;
+
+        // Each component is a row applied to (x, y, z, 1)
+        for (int r = 0; r < 3; r++) {
+            const float* row = affine.data + r * 4;
+            result.set(r, row[0] * point.x() + row[1] * point.y() + row[2] * point.z() + row[3]);
+        }
+
+        // Return the result
+        return result;
+
+    }
+
+    /**
+     * Applies a transform to a direction, ignoring the translation
+     */
+    static constexpr Vec3 apply_direction(const Affine3& affine, const Vec3& vec) {
+
+        // Create the result vector
+        Vec3 result;
+
+        // Each component is a row applied to (x, y, z, 0)
+        for (int r = 0; r < 3; r++) {
+            const float* row = affine.data + r * 4;
+            result.set(r, row[0] * vec.x() + row[1] * vec.y() + row[2] * vec.z());
+        }
+
+        // Return the result
+        return result;
+
+    }
+
+    /**
+     * Calculates the inverse of a rigid transform (rotation and translation only). The
+     * rotation is inverted by transposing it, which is cheaper and more accurate than a
+     * general inverse, but the result is wrong if the transform has any scale or shear.
+     */
+    static constexpr Affine3 inverse_rigid(const Affine3& affine) {
+
+        // Create the result transform
+        Affine3 result;
+
+        // Transpose the rotation
+        for (int r = 0; r < 3; r++) {
+            for (int c = 0; c < 3; c++) result.data[r * 4 + c] = affine.data[c * 4 + r];
+        }
+
+        // Undo the translation in the rotated space
+        for (int r = 0; r < 3; r++) {
+            const float* row = result.data + r * 4;
+            result.data[r * 4 + 3] = -(row[0] * affine.data[3] + row[1] * affine.data[7] + row[2] * affine.data[11]);
+        }
+
+        // Return the result
+        return result;
+
+    }
+
+    /**
+     * Calculates the inverse of any affine transform into `out`. Only the 3x3 linear part
+     * needs inverting. Returns false, leaving `out` untouched, if the transform is singular.
+     */
+    static constexpr bool try_inverse(const Affine3& affine, Affine3& out) {
+
+        // Copy out the linear part and invert it
+        Mat<3, 3> linear;
+        for (int r = 0; r < 3; r++) {
+            for (int c = 0; c < 3; c++) linear.data[r * 3 + c] = affine.data[r * 4 + c];
+        }
+        if (!utils::mat::try_inverse(linear, linear)) return false;
+
+        // Create the result from the inverted linear part
+        Affine3 result;
+        for (int r = 0; r < 3; r++) {
+            for (int c = 0; c < 3; c++) result.data[r * 4 + c] = linear.data[r * 3 + c];
+        }
+
+        // Undo the translation in the inverted space
+        for (int r = 0; r < 3; r++) {
+            const float* row = result.data + r * 4;
+            result.data[r * 4 + 3] = -(row[0] * affine.data[3] + row[1] * affine.data[7] + row[2] * affine.data[11]);
+        }
+
+        // Only write the output once the inverse is known to exist
+        out = result;
+        return true;
+
+    }
+
+    /**
+     * Calculates the inverse of any affine transform. A singular transform has no inverse,
+     * so a zero transform is returned instead (use `try_inverse` to tell the two apart).
+     */
+    static constexpr Affine3 inverse(const Affine3& affine) {
+        Affine3 result;
+        try_inverse(affine, result);
+        return result;
+    }
+
+}
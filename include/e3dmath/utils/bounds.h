@@ -0,0 +1,407 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+#include <cstddef>
+#include <cmath>
+#include <vector>
+#include "../types/mat.h"
+#include "../types/vec.h"
+#include "../types/point.h"
+#include "../types/affine.h"
+#include "../types/aabb.h"
+#include "../types/sphere.h"
+#include "../types/vec_soa.h"
+#include "../simd/lanes.h"
+#include "./parallel.h"
+
+#define E3D_SIMD_KERNELS "kernels/bounds.inl"
+#include "../simd/foreach_target.h"
+
+/**
+ * Bounding boxes and spheres of point sets, and transforming boxes. Each pass over the points
+ * is vectorized (see simd/cpu.h) and split across the shared thread pool in fixed blocks (see
+ * utils/parallel.h), so the results don't depend on the number of threads.
+ */
+namespace e3d::utils::bounds {
+
+    /**
+     * The number of points each thread takes at a time
+     */
+    constexpr size_t grain = 1 << 15;
+
+    static void _extents(const float* const* points, float* low, float* high, size_t begin, size_t end) {
+        E3D_SIMD_DISPATCH(bounds::extents(points, low, high, begin, end));
+    }
+
+    static void _extents_aos(const float* points, float* low, float* high, size_t begin, size_t end) {
+        E3D_SIMD_DISPATCH(bounds::extents_aos(points, low, high, begin, end));
+    }
+
+    static void _farthest_block(const float* const* points, const float* center, float& best, size_t& best_index, size_t begin, size_t end) {
+        E3D_SIMD_DISPATCH(bounds::farthest(points, center, best, best_index, begin, end));
+    }
+
+    static size_t _outside_block(const float* const* points, const float* center, float limit, size_t begin, size_t end) {
+        E3D_SIMD_DISPATCH(bounds::outside(points, center, limit, begin, end));
+    }
+
+    template<class Extents>
+    static Aabb3 _aabb(size_t count, Extents extents) {
+
+        // Each block finds its own extents, which are then combined
+        size_t blocks = (count + grain - 1) / grain;
+        std::vector<Aabb3> partials(blocks);
+        parallel::for_range(0, blocks, 1, [&](size_t first, size_t last) {
+            for (size_t block = first; block < last; block++) {
+                float low[3] = { INFINITY, INFINITY, INFINITY };
+                float high[3] = { -INFINITY, -INFINITY, -INFINITY };
+                size_t begin = block * grain;
+                extents(low, high, begin, std::min(count, begin + grain));
+                partials[block] = Aabb3(Point3(low), Point3(high));
+            }
+        });
+        Aabb3 result;
+        for (const Aabb3& partial : partials) result.grow(partial);
+        return result;
+
+    }
+
+    /**
+     * Finds the point in [begin, end) furthest from `center`, the lowest index on ties, and
+     * returns its squared distance
+     */
+    static float _farthest(const VecSoaView<3>& points, const float* center, size_t begin, size_t end, size_t& index) {
+        size_t blocks = (end - begin + grain - 1) / grain;
+        std::vector<float> bests(blocks, -1.0f);
+        std::vector<size_t> indices(blocks, begin);
+        parallel::for_range(0, blocks, 1, [&](size_t first, size_t last) {
+            for (size_t block = first; block < last; block++) {
+                size_t block_begin = begin + block * grain;
+                _farthest_block(points.data, center, bests[block], indices[block], block_begin, std::min(end, block_begin + grain));
+            }
+        });
+        float best = -1.0f;
+        index = begin;
+        for (size_t block = 0; block < blocks; block++) {
+            if (bests[block] <= best) continue;
+            best = bests[block];
+            index = indices[block];
+        }
+        return best;
+    }
+
+    /**
+     * Finds the first point in [begin, end) whose squared distance from `center` is over
+     * `limit`, or returns `end`
+     */
+    static size_t _outside(const VecSoaView<3>& points, const float* center, float limit, size_t begin, size_t end) {
+
+        // Small ranges run inline
+        if (end - begin <= grain) return _outside_block(points.data, center, limit, begin, end);
+
+        // Otherwise scan blocks in parallel, skipping any past a point that's already been found
+        size_t blocks = (end - begin + grain - 1) / grain;
+        std::atomic<size_t> found(end);
+        parallel::for_range(0, blocks, 1, [&](size_t first, size_t last) {
+            for (size_t block = first; block < last; block++) {
+                size_t block_begin = begin + block * grain;
+                if (block_begin >= found.load(std::memory_order_relaxed)) return;
+                size_t block_end = std::min(end, block_begin + grain);
+                size_t index = _outside_block(points.data, center, limit, block_begin, block_end);
+                if (index == block_end) continue;
+                size_t current = found.load(std::memory_order_relaxed);
+                while (index < current && !found.compare_exchange_weak(current, index, std::memory_order_relaxed)) {}
+                return;
+            }
+        });
+        return found.load();
+
+    }
+
+    /**
+     * A sphere being fitted, in double precision
+     */
+    struct _Ball {
+        double center[3];
+        double radius2;
+    };
+
+    static double _distance2(const double* a, const double* b) {
+        double sum = 0;
+        for (int c = 0; c < 3; c++) sum += (a[c] - b[c]) * (a[c] - b[c]);
+        return sum;
+    }
+
+    static void _cross(const double* a, const double* b, double* out) {
+        out[0] = a[1] * b[2] - a[2] * b[1];
+        out[1] = a[2] * b[0] - a[0] * b[2];
+        out[2] = a[0] * b[1] - a[1] * b[0];
+    }
+
+    static double _dot(const double* a, const double* b) {
+        return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+    }
+
+    /**
+     * The smallest sphere through two points
+     */
+    static _Ball _ball(const double* a, const double* b) {
+        _Ball ball;
+        for (int c = 0; c < 3; c++) ball.center[c] = (a[c] + b[c]) * 0.5;
+        ball.radius2 = _distance2(a, b) * 0.25;
+        return ball;
+    }
+
+    /**
+     * The smallest sphere through three points, the circumcircle of their triangle. Collinear
+     * points fall back to the sphere through the two furthest apart.
+     */
+    static _Ball _ball(const double* a, const double* b, const double* c) {
+        double u[3], v[3], w[3];
+        for (int i = 0; i < 3; i++) {
+            u[i] = b[i] - a[i];
+            v[i] = c[i] - a[i];
+        }
+        _cross(u, v, w);
+        double uu = _dot(u, u), vv = _dot(v, v), ww = _dot(w, w);
+        if (ww <= 1e-12 * uu * vv) {
+            _Ball ab = _ball(a, b), ac = _ball(a, c), bc = _ball(b, c);
+            return ab.radius2 >= ac.radius2 && ab.radius2 >= bc.radius2 ? ab : (ac.radius2 >= bc.radius2 ? ac : bc);
+        }
+
+        // Relative to a, the center is ((|u|² v - |v|² u) × (u × v)) / (2 |u × v|²)
+        double side[3], offset[3];
+        for (int i = 0; i < 3; i++) side[i] = uu * v[i] - vv * u[i];
+        _cross(side, w, offset);
+        _Ball ball;
+        for (int i = 0; i < 3; i++) ball.center[i] = a[i] + offset[i] / (2 * ww);
+        ball.radius2 = _distance2(ball.center, a);
+        return ball;
+    }
+
+    /**
+     * Checks whether a point is inside a ball, with a little slack for rounding
+     */
+    static bool _inside(const _Ball& ball, const double* point) {
+        return _distance2(ball.center, point) <= ball.radius2 * (1 + 1e-9);
+    }
+
+    /**
+     * The smallest sphere through four points, their circumsphere. Coplanar points fall back
+     * to the smallest sphere through three of them that contains the fourth.
+     */
+    static _Ball _ball(const double* a, const double* b, const double* c, const double* d) {
+        double u[3], v[3], w[3];
+        for (int i = 0; i < 3; i++) {
+            u[i] = b[i] - a[i];
+            v[i] = c[i] - a[i];
+            w[i] = d[i] - a[i];
+        }
+        double vw[3], wu[3], uv[3];
+        _cross(v, w, vw);
+        _cross(w, u, wu);
+        _cross(u, v, uv);
+        double det = _dot(u, vw);
+        double uu = _dot(u, u), vv = _dot(v, v), ww = _dot(w, w);
+        if (det * det <= 1e-12 * uu * vv * ww) {
+            const double* points[4] = { a, b, c, d };
+            _Ball best;
+            best.radius2 = INFINITY;
+            for (int skip = 0; skip < 4; skip++) {
+                const double* corners[3];
+                for (int i = 0, n = 0; i < 4; i++) {
+                    if (i != skip) corners[n++] = points[i];
+                }
+                _Ball ball = _ball(corners[0], corners[1], corners[2]);
+                if (ball.radius2 < best.radius2 && _inside(ball, points[skip])) best = ball;
+            }
+            return best.radius2 < INFINITY ? best : _ball(a, b, c);
+        }
+
+        // Relative to a, the center is (|u|² (v × w) + |v|² (w × u) + |w|² (u × v)) / (2 u · (v × w))
+        _Ball ball;
+        for (int i = 0; i < 3; i++) ball.center[i] = a[i] + (uu * vw[i] + vv * wu[i] + ww * uv[i]) / (2 * det);
+        ball.radius2 = _distance2(ball.center, a);
+        return ball;
+    }
+
+    /**
+     * Fits a final sphere around `center`, just big enough to hold every point
+     */
+    static Sphere3 _enclose(const VecSoaView<3>& points, const float* center) {
+        size_t index;
+        float radius = std::sqrt(_farthest(points, center, 0, points.size, index));
+        return Sphere3(Point3(center), std::nextafter(radius, INFINITY));
+    }
+
+    /**
+     * Finds the bounding box of SoA points. An empty set gives an empty box.
+     */
+    static Aabb3 aabb(const VecSoaView<3>& points) {
+        return _aabb(points.size, [&](float* low, float* high, size_t begin, size_t end) {
+            _extents(points.data, low, high, begin, end);
+        });
+    }
+
+    /**
+     * Finds the bounding box of an array of points. An empty array gives an empty box.
+     */
+    static Aabb3 aabb(const Point3* points, size_t count) {
+        static_assert(sizeof(Point3) == sizeof(float) * 3, "Points must be tightly packed");
+        return _aabb(count, [&](float* low, float* high, size_t begin, size_t end) {
+            _extents_aos(points[0].data, low, high, begin, end);
+        });
+    }
+
+    /**
+     * Finds a bounding sphere of SoA points by Ritter's method: a sphere across two points
+     * far apart, grown to take in any points left outside. It's fast, and usually no more
+     * than 5-20% larger than the minimal sphere. An empty set gives a zero sphere.
+     */
+    static Sphere3 ritter(const VecSoaView<3>& points) {
+        size_t count = points.size;
+        if (count == 0) return Sphere3();
+
+        // Start from the point furthest from the first, and the one furthest from that
+        size_t a, b;
+        float first[3] = { points.data[0][0], points.data[1][0], points.data[2][0] };
+        _farthest(points, first, 0, count, a);
+        float start[3] = { points.data[0][a], points.data[1][a], points.data[2][a] };
+        _farthest(points, start, 0, count, b);
+        double center[3], radius = 0;
+        for (int c = 0; c < 3; c++) {
+            center[c] = (double(points.data[c][a]) + points.data[c][b]) * 0.5;
+            radius += (double(points.data[c][b]) - points.data[c][a]) * (double(points.data[c][b]) - points.data[c][a]);
+        }
+        radius = std::sqrt(radius) * 0.5;
+
+        // Grow the sphere to reach each point outside it in turn, moving the center just far
+        // enough to keep the far side where it was
+        float rounded[3] = { float(center[0]), float(center[1]), float(center[2]) };
+        for (size_t i = _outside(points, rounded, float(radius * radius), 0, count); i < count;
+            i = _outside(points, rounded, float(radius * radius), i + 1, count)) {
+            double offset[3], distance = 0;
+            for (int c = 0; c < 3; c++) {
+                offset[c] = points.data[c][i] - center[c];
+                distance += offset[c] * offset[c];
+            }
+            distance = std::sqrt(distance);
+            double grown = (radius + distance) * 0.5;
+            for (int c = 0; c < 3; c++) {
+                center[c] += offset[c] * ((grown - radius) / distance);
+                rounded[c] = float(center[c]);
+            }
+            radius = grown;
+        }
+
+        // Shrink the radius to the furthest point from the final center
+        return _enclose(points, rounded);
+
+    }
+
+    /**
+     * Finds the minimal bounding sphere of SoA points, by Welzl's algorithm. The points are
+     * copied and shuffled first (with a fixed seed, so the result is repeatable), which takes
+     * the expected time down to a few passes over them. An empty set gives a zero sphere.
+     */
+    static Sphere3 minimal(const VecSoaView<3>& points) {
+        size_t count = points.size;
+        if (count == 0) return Sphere3();
+
+        // Shuffle the points, relative to the middle of their bounding box to keep the
+        // rounding small
+        Aabb3 box = aabb(points);
+        float middle[3];
+        for (int c = 0; c < 3; c++) middle[c] = box.center().get(c);
+        std::vector<uint32_t> order(count);
+        for (size_t i = 0; i < count; i++) order[i] = uint32_t(i);
+        uint64_t state = 0x9e3779b97f4a7c15ull;
+        for (size_t i = count - 1; i > 0; i--) {
+            state = state * 6364136223846793005ull + 1442695040888963407ull;
+            std::swap(order[i], order[(state >> 33) % (i + 1)]);
+        }
+        Vec3Soa shuffled(count);
+        parallel::for_range(0, count, grain, [&](size_t begin, size_t end) {
+            for (int c = 0; c < 3; c++) {
+                for (size_t i = begin; i < end; i++) shuffled.component(c)[i] = points.data[c][order[i]] - middle[c];
+            }
+        });
+        VecSoaView<3> local = shuffled.view();
+
+        // Each point outside the sphere so far must be on the boundary of the sphere of the
+        // points before it, so refit to those points with it fixed, and so on, up to four
+        // fixed points
+        auto point = [&](size_t i, double* out) {
+            for (int c = 0; c < 3; c++) out[c] = local.data[c][i];
+        };
+        double p[4][3];
+        _Ball ball = { { 0, 0, 0 }, -1 };
+        float center[3] = { 0, 0, 0 };
+        auto outside = [&](size_t begin, size_t end) {
+            for (int c = 0; c < 3; c++) center[c] = float(ball.center[c]);
+            float limit = ball.radius2 < 0 ? -1.0f : float(ball.radius2 * (1 + 1e-5));
+            return _outside(local, center, limit, begin, end);
+        };
+        for (size_t i = outside(0, count); i < count; i = outside(i + 1, count)) {
+            point(i, p[0]);
+            ball = { { p[0][0], p[0][1], p[0][2] }, 0 };
+            for (size_t j = outside(0, i); j < i; j = outside(j + 1, i)) {
+                point(j, p[1]);
+                ball = _ball(p[0], p[1]);
+                for (size_t k = outside(0, j); k < j; k = outside(k + 1, j)) {
+                    point(k, p[2]);
+                    ball = _ball(p[0], p[1], p[2]);
+                    for (size_t l = outside(0, k); l < k; l = outside(l + 1, k)) {
+                        point(l, p[3]);
+                        ball = _ball(p[0], p[1], p[2], p[3]);
+                    }
+                }
+            }
+        }
+
+        // Fit the final radius to the original points
+        for (int c = 0; c < 3; c++) center[c] = float(ball.center[c] + middle[c]);
+        return _enclose(points, center);
+
+    }
+
+    template<class M>
+    static Aabb3 _transform(const M& transform, const Aabb3& box) {
+        if (box.empty()) return box;
+
+        // Each output axis starts at the translation, and takes the smaller and larger ends
+        // of each input axis scaled onto it
+        float low[3], high[3];
+        for (uint8_t r = 0; r < 3; r++) {
+            low[r] = high[r] = transform.get(r, 3);
+            for (uint8_t c = 0; c < 3; c++) {
+                float a = transform.get(r, c) * box.min.get(c);
+                float b = transform.get(r, c) * box.max.get(c);
+                low[r] += std::min(a, b);
+                high[r] += std::max(a, b);
+            }
+        }
+        return Aabb3(Point3(low), Point3(high));
+
+    }
+
+    /**
+     * Finds the bounding box of a transformed box, by Arvo's method: each output axis is
+     * built from the ends of the input axes, which takes 18 multiplications rather than
+     * transforming all 8 corners. The bottom row of the matrix is assumed to be (0, 0, 0, 1),
+     * so projections need their corners transformed one by one instead.
+     */
+    static Aabb3 transform(const Mat4& transform, const Aabb3& box) {
+        return _transform(transform, box);
+    }
+
+    /**
+     * Finds the bounding box of a box under an affine transform, by Arvo's method
+     */
+    static Aabb3 transform(const Affine3& transform, const Aabb3& box) {
+        return _transform(transform, box);
+    }
+
+}
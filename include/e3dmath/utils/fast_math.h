@@ -0,0 +1,220 @@
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+#include <cmath>
+#include <limits>
+#include "../config.h"
+#include "../simd/lanes.h"
+#include "./trig.h"
+#include "./parallel.h"
+
+#define E3D_SIMD_KERNELS "kernels/fast_math.inl"
+#include "../simd/foreach_target.h"
+
+/**
+ * Approximations of the trig and square root functions, for when speed matters more than the
+ * last few bits. Maximum errors over the documented ranges:
+ *
+ *  - `sin`, `cos`, `sincos`: 1e-7 absolute, for |x| <= 8192, growing to 2e-6 by 1e5. |x|
+ *    past 102943 (2^16 * pi / 2), infinity and NaN give NaN.
+ *  - `tan`: the sine over the cosine, so their error divided by |cos x|
+ *  - `rsqrt`: 3e-7 relative, for positive normal x
+ *  - `acos`: 4.5e-7 absolute, over [-1, 1]
+ *  - `atan2`: 3e-7 absolute, for finite inputs. atan2(-0, x) gives 0 or pi, not -0 or -pi.
+ *
+ * The scalar functions run without library calls, and `sin`, `cos`, `sincos` and `tan` can be
+ * used in constant expressions. The batch functions evaluate the same polynomials 4, 8 or 16
+ * at a time (see simd/cpu.h), so they may differ from the scalar ones in the last bit.
+ *
+ * utils::vec, utils::mat and utils::projection take a math policy (see `PreciseMath` and
+ * `FastMath` below) to choose between these and <cmath>.
+ */
+namespace e3d::utils::fast_math {
+
+    /**
+     * The number of values each thread takes at a time in the batch functions
+     */
+    constexpr size_t grain = 1 << 14;
+
+    /**
+     * Calculates the sine and cosine of `x` radians together, sharing the range reduction
+     */
+    static constexpr void sincos(float x, float& s, float& c) {
+
+        // Reduce into [-pi/4, pi/4] by the nearest multiple of pi/2 (rounded like the batch
+        // kernel), in three parts so the products are exact. That only holds below 2^16
+        // multiples, so larger ones (and NaN) give NaN instead.
+        float whole = (x * 0.636619772f + 12582912.0f) - 12582912.0f;
+        bool reducible = whole > -65536.0f && whole < 65536.0f;
+        whole = reducible ? whole : 0.0f;
+        float r = reducible ? x - whole * 1.5703125f : std::numeric_limits<float>::quiet_NaN();
+        r = r - whole * 4.837512969970703125e-4f;
+        r = r - whole * 7.54978995489188216e-8f;
+
+        // Evaluate both polynomials
+        float z = r * r;
+        float sin_r = ((-1.9515295891e-4f * z + 8.3321608736e-3f) * z - 1.6666654611e-1f) * (z * r) + r;
+        float cos_r = ((2.443315711809948e-5f * z - 1.388731625493765e-3f) * z + 4.166664568298827e-2f) * (z * z) + (1.0f - 0.5f * z);
+
+        // Swap and negate them for the quadrant, written without branches, since the quadrant
+        // is often unpredictable
+        int32_t q = int32_t(whole);
+        const float values[2] = { sin_r, cos_r };
+        s = values[q & 1] * float(1 - (q & 2));
+        c = values[(q & 1) ^ 1] * float(1 - ((q + 1) & 2));
+
+    }
+
+    /**
+     * Calculates the sines and cosines of three angles, ie. Euler angles. These are three
+     * scalar calls, which inline; packing them into one register costs more than it saves.
+     */
+    static constexpr void sincos3(const float* x, float* s, float* c) {
+        for (int i = 0; i < 3; i++) sincos(x[i], s[i], c[i]);
+    }
+
+    static constexpr float sin(float x) {
+        float s = 0, c = 0;
+        sincos(x, s, c);
+        return s;
+    }
+
+    static constexpr float cos(float x) {
+        float s = 0, c = 0;
+        sincos(x, s, c);
+        return c;
+    }
+
+    static constexpr float tan(float x) {
+        float s = 0, c = 0;
+        sincos(x, s, c);
+        return s / c;
+    }
+
+    /**
+     * Calculates 1 / sqrt(x), from the hardware estimate refined by a Newton step. Without SSE
+     * it's exact.
+     */
+    static float rsqrt(float x) {
+#if E3D_SIMD_X86 && defined(__SSE__)
+        float estimate = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x)));
+
+        // Halve after multiplying, so 0.5 * x can't underflow for the smallest x
+        return estimate * (1.5f - x * estimate * estimate * 0.5f);
+#else
+        return 1.0f / std::sqrt(x);
+#endif
+    }
+
+    /**
+     * Calculates the arc cosine of `x`, as sqrt(1 - |x|) times a polynomial
+     */
+    static float acos(float x) {
+        float a = std::fabs(x);
+        float p = ((((((-0.0012624911f * a + 0.0066700901f) * a - 0.0170881256f) * a + 0.0308918810f) * a
+            - 0.0501743046f) * a + 0.0889789874f) * a - 0.2145988016f) * a + 1.5707963050f;
+        float result = std::sqrt(1.0f - a) * p;
+        return x < 0 ? 3.14159265f - result : result;
+    }
+
+    /**
+     * Calculates the angle of the point (x, y) from the x-axis, in [-pi, pi]
+     */
+    static float atan2(float y, float x) {
+
+        // The arc tangent of the smaller over the larger, so the ratio is in [0, 1]
+        float abs_y = std::fabs(y), abs_x = std::fabs(x);
+        float high = abs_x > abs_y ? abs_x : abs_y;
+        float a = high == 0 ? 0 : (abs_x < abs_y ? abs_x : abs_y) / high;
+        float z = a * a;
+        float p = (((((((0.0028662257f * z - 0.0161657367f) * z + 0.0429096138f) * z - 0.0752896400f) * z
+            + 0.1065626393f) * z - 0.1420889944f) * z + 0.1999355085f) * z - 0.3333314528f);
+        float t = p * z * a + a;
+
+        // Then unfold it into the right octant
+        if (abs_y > abs_x) t = 1.57079633f - t;
+        if (x < 0) t = 3.14159265f - t;
+        return y < 0 ? -t : t;
+
+    }
+
+    static void _sincos(const float* x, float* s, float* c, size_t begin, size_t end) {
+        E3D_SIMD_DISPATCH(fast_math::sincos(x, s, c, begin, end));
+    }
+
+    static void _acos(const float* x, float* out, size_t begin, size_t end) {
+        E3D_SIMD_DISPATCH(fast_math::acos(x, out, begin, end));
+    }
+
+    static void _atan2(const float* y, const float* x, float* out, size_t begin, size_t end) {
+        E3D_SIMD_DISPATCH(fast_math::atan2(y, x, out, begin, end));
+    }
+
+    /**
+     * Calculates the sine and cosine of `count` angles. `s` or `c` may be `x`.
+     */
+    static void sincos(const float* x, float* s, float* c, size_t count) {
+        parallel::for_range(0, count, grain, [&](size_t begin, size_t end) { _sincos(x, s, c, begin, end); });
+    }
+
+    /**
+     * Calculates the arc cosine of `count` values. `out` may be `x`.
+     */
+    static void acos(const float* x, float* out, size_t count) {
+        parallel::for_range(0, count, grain, [&](size_t begin, size_t end) { _acos(x, out, begin, end); });
+    }
+
+    /**
+     * Calculates `count` angles from their (x, y) coordinates. `out` may be `y` or `x`.
+     */
+    static void atan2(const float* y, const float* x, float* out, size_t count) {
+        parallel::for_range(0, count, grain, [&](size_t begin, size_t end) { _atan2(y, x, out, begin, end); });
+    }
+
+}
+
+namespace e3d {
+
+    /**
+     * A math policy calling through to <cmath> (and utils::trig in constant expressions)
+     */
+    struct PreciseMath {
+        static constexpr bool approximate = false;
+        static constexpr void sincos(float x, float& s, float& c) {
+            s = utils::trig::sin(x);
+            c = utils::trig::cos(x);
+        }
+        static constexpr void sincos3(const float* x, float* s, float* c) {
+            for (int i = 0; i < 3; i++) sincos(x[i], s[i], c[i]);
+        }
+        static constexpr float tan(float x) { return utils::trig::tan(x); }
+        static float rsqrt(float x) { return 1.0f / std::sqrt(x); }
+        static float acos(float x) { return std::acos(x); }
+        static float atan2(float y, float x) { return std::atan2(y, x); }
+    };
+
+    /**
+     * A math policy using the approximations in utils::fast_math
+     */
+    struct FastMath {
+        static constexpr bool approximate = true;
+        static constexpr void sincos(float x, float& s, float& c) { utils::fast_math::sincos(x, s, c); }
+        static constexpr void sincos3(const float* x, float* s, float* c) { utils::fast_math::sincos3(x, s, c); }
+        static constexpr float tan(float x) { return utils::fast_math::tan(x); }
+        static float rsqrt(float x) { return utils::fast_math::rsqrt(x); }
+        static float acos(float x) { return utils::fast_math::acos(x); }
+        static float atan2(float y, float x) { return utils::fast_math::atan2(y, x); }
+    };
+
+    /**
+     * The policy used when a call doesn't pass one. Define E3D_FAST_MATH before including
+     * e3dmath to make it `FastMath`; individual calls can still pass `PreciseMath()`.
+     */
+#ifdef E3D_FAST_MATH
+    using DefaultMath = FastMath;
+#else
+    using DefaultMath = PreciseMath;
+#endif
+
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstddef>
+#include <cmath>
+#include <vector>
+#include "../types/mat.h"
+#include "../types/vec.h"
+#include "../types/point.h"
+#include "../types/frustum.h"
+#include "../types/vec_soa.h"
+#include "../simd/lanes.h"
+#include "./parallel.h"
+
+#define E3D_SIMD_KERNELS "kernels/frustum.inl"
+#include "../simd/foreach_target.h"
+
+/**
+ * View frustum planes and visibility culling. Bounding spheres and axis-aligned boxes are
+ * culled in batches from SoA streams, a register at a time (see simd/cpu.h) and across the
+ * shared thread pool (see utils/parallel.h), into a compact list of the visible indices.
+ *
+ * The tests are conservative: a volume is culled only if it's entirely behind one of the
+ * planes, so some volumes just outside the corners of the frustum are kept.
+ */
+namespace e3d::utils::frustum {
+
+    /**
+     * The number of volumes each thread takes at a time
+     */
+    constexpr size_t grain = 1 << 14;
+
+    static size_t _spheres(const float* planes, const float* const* centers, const float* radii, uint32_t* out, size_t begin, size_t end) {
+        E3D_SIMD_DISPATCH(frustum::spheres(planes, centers, radii, out, begin, end));
+    }
+
+    static size_t _boxes(const float* planes, const float* const* mins, const float* const* maxs, uint32_t* out, size_t begin, size_t end) {
+        E3D_SIMD_DISPATCH(frustum::boxes(planes, mins, maxs, out, begin, end));
+    }
+
+    /**
+     * Extracts the planes of the view volume of a view-projection matrix, which maps points
+     * as column vectors to clip space with -w <= x, y, z <= w (as the matrices from
+     * utils::projection do)
+     */
+    static Frustum extract(const Mat4& view_projection) {
+
+        // Each plane is the last row of the matrix plus or minus one of the others
+        Frustum frustum;
+        for (uint8_t side = 0; side < 6; side++) {
+            uint8_t row = side / 2;
+            float sign = side % 2 == 0 ? 1.0f : -1.0f;
+            float length = 0;
+            for (uint8_t c = 0; c < 4; c++) {
+                float value = view_projection.get(3, c) + sign * view_projection.get(row, c);
+                frustum.planes[side].set(c, value);
+                if (c < 3) length += value * value;
+            }
+
+            // Normalize the plane, so it measures distances
+            if (length > 0) {
+                float inverse_length = 1.0f / std::sqrt(length);
+                for (uint8_t c = 0; c < 4; c++) frustum.planes[side].set(c, frustum.planes[side].get(c) * inverse_length);
+            }
+        }
+
+        // Return the frustum
+        return frustum;
+
+    }
+
+    /**
+     * The signed distance of a point from a plane, positive on the side its normal points to
+     */
+    static float distance(const Vec4& plane, const Point3& point) {
+        float result = plane.get(0) * point.get(0) + plane.get(3);
+        result = plane.get(1) * point.get(1) + result;
+        return plane.get(2) * point.get(2) + result;
+    }
+
+    /**
+     * Checks whether any of a bounding sphere might be inside the frustum
+     */
+    static bool visible(const Frustum& frustum, const Point3& center, float radius) {
+        for (const Vec4& plane : frustum.planes) {
+            if (!(distance(plane, center) >= -radius)) return false;
+        }
+        return true;
+    }
+
+    /**
+     * Checks whether any of an axis-aligned box might be inside the frustum
+     */
+    static bool visible(const Frustum& frustum, const Point3& min, const Point3& max) {
+        for (const Vec4& plane : frustum.planes) {
+
+            // Test the corner furthest along the plane's normal
+            Point3 corner;
+            for (uint8_t c = 0; c < 3; c++) corner.set(c, plane.get(c) >= 0 ? max.get(c) : min.get(c));
+            if (!(distance(plane, corner) >= 0)) return false;
+
+        }
+        return true;
+    }
+
+    template<class Cull>
+    static size_t _cull(size_t count, uint32_t* out, Cull cull) {
+
+        // Cull fixed blocks in parallel, each into its own part of the output
+        size_t blocks = (count + grain - 1) / grain;
+        std::vector<size_t> visible(blocks);
+        parallel::for_range(0, blocks, 1, [&](size_t first, size_t last) {
+            for (size_t block = first; block < last; block++) {
+                size_t begin = block * grain;
+                visible[block] = cull(out + begin, begin, std::min(count, begin + grain));
+            }
+        });
+
+        // Close up the gaps between the blocks
+        size_t total = 0;
+        for (size_t block = 0; block < blocks; block++) {
+            uint32_t* begin = out + block * grain;
+            if (out + total != begin) std::copy(begin, begin + visible[block], out + total);
+            total += visible[block];
+        }
+        return total;
+
+    }
+
+    /**
+     * Culls bounding spheres, writing the indices of those that might be visible to `out` in
+     * increasing order, and returns how many there are. `out` needs room for one index per
+     * sphere.
+     */
+    static size_t cull(const Frustum& frustum, const VecSoaView<3>& centers, const float* radii, uint32_t* out) {
+        float planes[24];
+        for (uint8_t p = 0; p < 6; p++) {
+            for (uint8_t c = 0; c < 4; c++) planes[p * 4 + c] = frustum.planes[p].get(c);
+        }
+        return _cull(centers.size, out, [&](uint32_t* block_out, size_t begin, size_t end) {
+            return _spheres(planes, centers.data, radii, block_out, begin, end);
+        });
+    }
+
+    /**
+     * Culls axis-aligned boxes given by their minimum and maximum corners, writing the
+     * indices of those that might be visible to `out` in increasing order, and returns how
+     * many there are. `out` needs room for one index per box.
+     */
+    static size_t cull(const Frustum& frustum, const VecSoaView<3>& mins, const VecSoaView<3>& maxs, uint32_t* out) {
+        float planes[24];
+        for (uint8_t p = 0; p < 6; p++) {
+            for (uint8_t c = 0; c < 4; c++) planes[p * 4 + c] = frustum.planes[p].get(c);
+        }
+        return _cull(mins.size, out, [&](uint32_t* block_out, size_t begin, size_t end) {
+            return _boxes(planes, mins.data, maxs.data, block_out, begin, end);
+        });
+    }
+
+}
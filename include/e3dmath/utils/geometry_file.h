@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "../types/vec_soa.h"
+#include "../types/mesh.h"
+#include "../types/aabb.h"
+#include "../types/geometry_file.h"
+#include "./bounds.h"
+
+/**
+ * Writes geometry files, which GeometryFile maps back in without copying (see
+ * types/geometry_file.h). Writes return false if the file can't be written or a stream's
+ * name is too long, and may leave a partial file behind.
+ */
+namespace e3d::utils::geometry_file {
+
+    /**
+     * A stream to write: a name of at most 23 characters, and its elements
+     */
+    struct Stream {
+        const char* name;
+        GeometryFile::Type type;
+        const void* data;
+        size_t count;
+    };
+
+    static Stream stream(const char* name, const float* data, size_t count) {
+        return { name, GeometryFile::float32, data, count };
+    }
+
+    static Stream stream(const char* name, const uint32_t* data, size_t count) {
+        return { name, GeometryFile::uint32, data, count };
+    }
+
+    /**
+     * Writes zeros up to the next multiple of the alignment
+     */
+    static bool _pad(FILE* file, uint64_t& offset) {
+        static const uint8_t zeros[GeometryFile::alignment] = {};
+        size_t padding = size_t((GeometryFile::alignment - offset % GeometryFile::alignment) % GeometryFile::alignment);
+        offset += padding;
+        return padding == 0 || std::fwrite(zeros, 1, padding, file) == padding;
+    }
+
+    /**
+     * Writes any set of streams, with the bounds to record in the header
+     */
+    static bool write(const char* path, const Stream* streams, size_t count, const Aabb3& bounds) {
+
+        // Lay the streams out after the header and section table
+        GeometryFile::Header header = {};
+        std::memcpy(header.magic, GeometryFile::magic, sizeof(header.magic));
+        header.version = GeometryFile::version;
+        header.section_count = uint32_t(count);
+        for (uint8_t c = 0; c < 3; c++) {
+            header.bounds_min[c] = bounds.min.get(c);
+            header.bounds_max[c] = bounds.max.get(c);
+        }
+        std::vector<GeometryFile::Section> sections(count);
+        uint64_t offset = sizeof(GeometryFile::Header) + sizeof(GeometryFile::Section) * count;
+        for (size_t i = 0; i < count; i++) {
+            size_t length = std::strlen(streams[i].name);
+            if (length >= sizeof(sections[i].name)) return false;
+            std::memcpy(sections[i].name, streams[i].name, length);
+            sections[i].type = streams[i].type;
+            sections[i].offset = (offset + GeometryFile::alignment - 1) / GeometryFile::alignment * GeometryFile::alignment;
+            sections[i].count = streams[i].count;
+            offset = sections[i].offset + streams[i].count * 4;
+        }
+        header.file_size = (offset + GeometryFile::alignment - 1) / GeometryFile::alignment * GeometryFile::alignment;
+
+        // Then write everything out in order
+        FILE* file = std::fopen(path, "wb");
+        if (file == nullptr) return false;
+        bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1;
+        ok = ok && (count == 0 || std::fwrite(sections.data(), sizeof(GeometryFile::Section), count, file) == count);
+        offset = sizeof(GeometryFile::Header) + sizeof(GeometryFile::Section) * count;
+        for (size_t i = 0; i < count && ok; i++) {
+            ok = _pad(file, offset) && std::fwrite(streams[i].data, 4, streams[i].count, file) == streams[i].count;
+            offset += streams[i].count * 4;
+        }
+        ok = ok && _pad(file, offset);
+        return std::fclose(file) == 0 && ok;
+
+    }
+
+    /**
+     * Writes a point cloud, along with any other per-point streams
+     */
+    static bool write(const char* path, const VecSoaView<3>& points, const Stream* extra = nullptr, size_t extra_count = 0) {
+        std::vector<Stream> streams;
+        for (uint8_t c = 0; c < 3; c++) streams.push_back(stream(GeometryFile::position_names[c], points.data[c], points.size));
+        streams.insert(streams.end(), extra, extra + extra_count);
+        return write(path, streams.data(), streams.size(), bounds::aabb(points));
+    }
+
+    /**
+     * Writes a mesh, with its texture coordinates if it has any, along with any other
+     * streams
+     */
+    static bool write(const char* path, const MeshView& mesh, const Stream* extra = nullptr, size_t extra_count = 0) {
+        std::vector<Stream> streams;
+        for (uint8_t c = 0; c < 3; c++) streams.push_back(stream(GeometryFile::position_names[c], mesh.positions.data[c], mesh.positions.size));
+        if (mesh.uvs.size > 0) {
+            for (uint8_t c = 0; c < 2; c++) streams.push_back(stream(GeometryFile::uv_names[c], mesh.uvs.data[c], mesh.uvs.size));
+        }
+        streams.push_back(stream(GeometryFile::index_name, mesh.indices, mesh.triangle_count * 3));
+        streams.insert(streams.end(), extra, extra + extra_count);
+        return write(path, streams.data(), streams.size(), bounds::aabb(mesh.positions));
+    }
+
+}
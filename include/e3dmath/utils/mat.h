@@ -1,81 +1,308 @@
 #pragma once
 
 #include "../types/mat.h"
+#include "./trig.h"
+#include "./fast_math.h"
 #include <cmath>
 
 namespace e3d::utils::mat {
 
     /**
-     * Performs determinant calculation on a matrix from raw data
+     * Absolute value that can be used in constant expressions
      */
-    static float _det(const float* data, uint8_t size) {
+    static constexpr float _abs(float value) {
+        return value < 0 ? -value : value;
+    }
 
-        // If the number of rows is zero
-        if (size == 0) return 0;
-        
-        // If the number of rows is one
-        if (size == 1) return data[0];
+    /**
+     * Factors a square matrix, in place, into PA = LU using partial pivoting. Afterwards `data`
+     * holds U on and above the diagonal and the multipliers of L (whose diagonal is all ones)
+     * below it, and row `i` of the factorization is row `perm[i]` of the original. `sign` is
+     * set to the sign of the permutation. Returns false if the matrix is singular.
+     */
+    template<uint8_t R>
+    static constexpr bool _lu_decompose(float* data, uint8_t* perm, float& sign) {
 
-        // Start the sum at zero
-        float sum = 0;
+        // Start with the identity permutation
+        for (int i = 0; i < R; i++) perm[i] = i;
+        sign = 1;
 
-        // Create the submatrix
-        float subdata[(size - 1) * (size - 1)];
+        // Eliminate one column at a time
+        for (int k = 0; k < R; k++) {
 
-        // Loop through the columns
-        for (uint8_t cursor_c = 0; cursor_c < size; cursor_c++) {
+            // Find the row with the largest value in this column
+            int pivot = k;
+            for (int r = k + 1; r < R; r++) {
+                if (_abs(data[r * R + k]) > _abs(data[pivot * R + k])) pivot = r;
+            }
 
-            // Get the value at the index
-            float cursor_value = data[cursor_c];
+            // If the whole column is zero, the matrix is singular
+            if (data[pivot * R + k] == 0) return false;
 
-            // Loop through the columns and fill up the subdata array
-            for (uint8_t c = 0; c < size; c++) {
+            // Swap the pivot row into place
+            if (pivot != k) {
+                for (int c = 0; c < R; c++) {
+                    float temp = data[k * R + c];
+                    data[k * R + c] = data[pivot * R + c];
+                    data[pivot * R + c] = temp;
+                }
+                uint8_t temp = perm[k];
+                perm[k] = perm[pivot];
+                perm[pivot] = temp;
+                sign = -sign;
+            }
 
-                // If this is on the cursor column, skip it
-                if (c == cursor_c) continue;
+            // Subtract the pivot row from every row below it
+            float pivot_value = data[k * R + k];
+            for (int r = k + 1; r < R; r++) {
+                float factor = data[r * R + k] / pivot_value;
+                data[r * R + k] = factor;
+                for (int c = k + 1; c < R; c++) data[r * R + c] -= factor * data[k * R + c];
+            }
 
-                // Get the submatrix column index
-                uint8_t sub_c = c < cursor_c ? c : (c - 1);
+        }
 
-                // Loop through the rows
-                for (uint8_t r = 0; r < size - 1; r++) {
+        // The factorization succeeded
+        return true;
 
-                    // Copy the value over
-                    subdata[r * (size - 1) + sub_c] = data[(r + 1) * size + c];
+    }
 
-                }
+    /**
+     * Solves LUx = Pb for each of the `C` columns of `b` using a factorization from
+     * `_lu_decompose`, writing the solutions into `out`
+     */
+    template<uint8_t R, uint8_t C>
+    static constexpr void _lu_solve(const float* lu, const uint8_t* perm, const float* b, float* out) {
+        for (int col = 0; col < C; col++) {
+
+            // Forward substitution through L, reading b in pivoted order
+            for (int r = 0; r < R; r++) {
+                float sum = b[perm[r] * C + col];
+                for (int c = 0; c < r; c++) sum -= lu[r * R + c] * out[c * C + col];
+                out[r * C + col] = sum;
+            }
 
+            // Back substitution through U
+            for (int r = R - 1; r >= 0; r--) {
+                float sum = out[r * C + col];
+                for (int c = r + 1; c < R; c++) sum -= lu[r * R + c] * out[c * C + col];
+                out[r * C + col] = sum / lu[r * R + r];
             }
 
-            // Calculate this partial
-            float partial = cursor_value * _det(subdata, size - 1);
+        }
+    }
 
-            // Add to / subtract from the sum
-            sum += (cursor_c % 2 == 0) ? partial : -partial;
+    /**
+     * Calculates the determinant of the provided matrix. Determinant can be thought of as the
+     * scalar effect the matrix would have on the vector space, if used as a transformation.
+     *
+     * Matrices up to 4x4 use closed-form expressions; larger ones use an LU factorization,
+     * which takes O(n^3) time instead of the O(n!) of cofactor expansion. These read the data
+     * as stored, since a column-major matrix is stored as its transpose, which has the same
+     * determinant.
+     */
+    template<uint8_t R, Order O>
+    static constexpr float determinant(const Mat<R, R, O>& mat) {
+        const float* m = mat.data;
+        if constexpr (R == 1) {
+            return m[0];
+        } else if constexpr (R == 2) {
+            return m[0] * m[3] - m[1] * m[2];
+        } else if constexpr (R == 3) {
+            return m[0] * (m[4] * m[8] - m[5] * m[7])
+                - m[1] * (m[3] * m[8] - m[5] * m[6])
+                + m[2] * (m[3] * m[7] - m[4] * m[6]);
+        } else if constexpr (R == 4) {
+
+            // Determinants of the 2x2 blocks in the top two and bottom two rows
+            float s0 = m[0] * m[5] - m[4] * m[1];
+            float s1 = m[0] * m[6] - m[4] * m[2];
+            float s2 = m[0] * m[7] - m[4] * m[3];
+            float s3 = m[1] * m[6] - m[5] * m[2];
+            float s4 = m[1] * m[7] - m[5] * m[3];
+            float s5 = m[2] * m[7] - m[6] * m[3];
+            float c5 = m[10] * m[15] - m[14] * m[11];
+            float c4 = m[9] * m[15] - m[13] * m[11];
+            float c3 = m[9] * m[14] - m[13] * m[10];
+            float c2 = m[8] * m[15] - m[12] * m[11];
+            float c1 = m[8] * m[14] - m[12] * m[10];
+            float c0 = m[8] * m[13] - m[12] * m[9];
+
+            // Combine them with the Laplace expansion along the first two rows
+            return s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+
+        } else {
+
+            // Factor a copy, then multiply the pivots
+            Mat<R, R, O> lu = mat;
+            uint8_t perm[R] = {};
+            float sign = 1;
+            if (!_lu_decompose<R>(lu.data, perm, sign)) return 0;
+            float det = sign;
+            for (int i = 0; i < R; i++) det *= lu.data[i * R + i];
+            return det;
+
+        }
+    }
+
+    /**
+     * Calculates the inverse of a matrix into `out`. Returns false, leaving `out` untouched,
+     * if the matrix is singular.
+     *
+     * Like `determinant`, this works on the data as stored: the inverse of a transpose is the
+     * transpose of the inverse, so column-major matrices come out in column-major order.
+     */
+    template<uint8_t R, Order O>
+    static constexpr bool try_inverse(const Mat<R, R, O>& mat, Mat<R, R, O>& out) {
+        const float* m = mat.data;
+        Mat<R, R, O> result;
+        if constexpr (R == 1) {
+
+            // The reciprocal
+            if (m[0] == 0) return false;
+            result.data[0] = 1.0f / m[0];
+
+        } else if constexpr (R == 2) {
+
+            // Swap the diagonal, negate the rest and divide by the determinant
+            float det = determinant(mat);
+            if (det == 0) return false;
+            float inv = 1.0f / det;
+            result.data[0] = m[3] * inv;
+            result.data[1] = -m[1] * inv;
+            result.data[2] = -m[2] * inv;
+            result.data[3] = m[0] * inv;
+
+        } else if constexpr (R == 3) {
+
+            // Cofactors of the first row double as the terms of the determinant
+            float c00 = m[4] * m[8] - m[5] * m[7];
+            float c01 = m[5] * m[6] - m[3] * m[8];
+            float c02 = m[3] * m[7] - m[4] * m[6];
+            float det = m[0] * c00 + m[1] * c01 + m[2] * c02;
+            if (det == 0) return false;
+            float inv = 1.0f / det;
+
+            // The inverse is the transposed cofactor matrix over the determinant
+            result.data[0] = c00 * inv;
+            result.data[1] = (m[2] * m[7] - m[1] * m[8]) * inv;
+            result.data[2] = (m[1] * m[5] - m[2] * m[4]) * inv;
+            result.data[3] = c01 * inv;
+            result.data[4] = (m[0] * m[8] - m[2] * m[6]) * inv;
+            result.data[5] = (m[2] * m[3] - m[0] * m[5]) * inv;
+            result.data[6] = c02 * inv;
+            result.data[7] = (m[1] * m[6] - m[0] * m[7]) * inv;
+            result.data[8] = (m[0] * m[4] - m[1] * m[3]) * inv;
+
+        } else if constexpr (R == 4) {
+
+            // The same 2x2 blocks as the determinant
+            float s0 = m[0] * m[5] - m[4] * m[1];
+            float s1 = m[0] * m[6] - m[4] * m[2];
+            float s2 = m[0] * m[7] - m[4] * m[3];
+            float s3 = m[1] * m[6] - m[5] * m[2];
+            float s4 = m[1] * m[7] - m[5] * m[3];
+            float s5 = m[2] * m[7] - m[6] * m[3];
+            float c5 = m[10] * m[15] - m[14] * m[11];
+            float c4 = m[9] * m[15] - m[13] * m[11];
+            float c3 = m[9] * m[14] - m[13] * m[10];
+            float c2 = m[8] * m[15] - m[12] * m[11];
+            float c1 = m[8] * m[14] - m[12] * m[10];
+            float c0 = m[8] * m[13] - m[12] * m[9];
+            float det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+            if (det == 0) return false;
+            float inv = 1.0f / det;
+
+            // Each element of the adjugate is a 3x3 minor, expanded over the blocks
+            result.data[0] = (m[5] * c5 - m[6] * c4 + m[7] * c3) * inv;
+            result.data[1] = (-m[1] * c5 + m[2] * c4 - m[3] * c3) * inv;
+            result.data[2] = (m[13] * s5 - m[14] * s4 + m[15] * s3) * inv;
+            result.data[3] = (-m[9] * s5 + m[10] * s4 - m[11] * s3) * inv;
+            result.data[4] = (-m[4] * c5 + m[6] * c2 - m[7] * c1) * inv;
+            result.data[5] = (m[0] * c5 - m[2] * c2 + m[3] * c1) * inv;
+            result.data[6] = (-m[12] * s5 + m[14] * s2 - m[15] * s1) * inv;
+            result.data[7] = (m[8] * s5 - m[10] * s2 + m[11] * s1) * inv;
+            result.data[8] = (m[4] * c4 - m[5] * c2 + m[7] * c0) * inv;
+            result.data[9] = (-m[0] * c4 + m[1] * c2 - m[3] * c0) * inv;
+            result.data[10] = (m[12] * s4 - m[13] * s2 + m[15] * s0) * inv;
+            result.data[11] = (-m[8] * s4 + m[9] * s2 - m[11] * s0) * inv;
+            result.data[12] = (-m[4] * c3 + m[5] * c1 - m[6] * c0) * inv;
+            result.data[13] = (m[0] * c3 - m[1] * c1 + m[2] * c0) * inv;
+            result.data[14] = (-m[12] * s3 + m[13] * s1 - m[14] * s0) * inv;
+            result.data[15] = (m[8] * s3 - m[9] * s1 + m[10] * s0) * inv;
+
+        } else {
+
+            // Factor a copy, then solve against the identity
+            Mat<R, R, O> lu = mat;
+            uint8_t perm[R] = {};
+            float sign = 1;
+            if (!_lu_decompose<R>(lu.data, perm, sign)) return false;
+            _lu_solve<R, R>(lu.data, perm, Mat<R, R>::identity().data, result.data);
 
         }
 
-        // Return the sum
-        return sum;
+        // Only write the output once the inverse is known to exist
+        out = result;
+        return true;
 
     }
 
     /**
-     * Calculates the determinant of the provided matrix. Determinant can be thought of as the
-     * scalar effect the matrix would have on the vector space, if used as a transformation.
+     * Calculates the inverse of a matrix. A singular matrix has no inverse, so a zero matrix
+     * is returned instead (use `try_inverse` to tell the two apart).
      */
-    template<uint8_t R>
-    static float determinant(const Mat<R, R>& mat) {
-        return _det(mat.data, R);
+    template<uint8_t R, Order O>
+    static constexpr Mat<R, R, O> inverse(const Mat<R, R, O>& mat) {
+        Mat<R, R, O> result;
+        try_inverse(mat, result);
+        return result;
+    }
+
+    /**
+     * Solves `a * x = b` for `x` into `out`, where `b` is a vector or a matrix with one
+     * right-hand side per column. Uses an LU factorization with partial pivoting, which is
+     * more accurate than multiplying by the inverse. Returns false, leaving `out` untouched,
+     * if `a` is singular. Column-major inputs are converted to row-major first.
+     */
+    template<uint8_t R, uint8_t C, Order OA, Order OB>
+    static constexpr bool try_solve(const Mat<R, R, OA>& a, const Mat<R, C, OB>& b, Mat<R, C, OB>& out) {
+
+        // Factor a row-major copy of the system
+        Mat<R, R> lu = a;
+        uint8_t perm[R] = {};
+        float sign = 1;
+        if (!_lu_decompose<R>(lu.data, perm, sign)) return false;
+
+        // Substitute each right-hand side through the factors
+        const Mat<R, C> rhs = b;
+        Mat<R, C> result;
+        _lu_solve<R, C>(lu.data, perm, rhs.data, result.data);
+        out = result;
+        return true;
+
+    }
+
+    /**
+     * Solves `a * x = b` for `x`, where `b` is a vector or a matrix with one right-hand side
+     * per column. A zero result is returned if `a` is singular (see `try_solve`).
+     */
+    template<uint8_t R, uint8_t C, Order OA, Order OB>
+    static constexpr Mat<R, C, OB> solve(const Mat<R, R, OA>& a, const Mat<R, C, OB>& b) {
+        Mat<R, C, OB> result;
+        try_solve(a, b, result);
+        return result;
     }
 
     /**
-     * Creates a translation matrix
+     * Creates a translation matrix. Like the other builders, it can be created in either order,
+     * ie. `mat4_create_translation<Order::col_major>(x, y, z)` for a `Mat4c`.
      */
-    static Mat4 mat4_create_translation(float x, float y, float z) {
+    template<Order O = Order::row_major>
+    static constexpr Mat<4, 4, O> mat4_create_translation(float x, float y, float z) {
 
         // Create an identity matrix
-        Mat4 result = Mat4::identity();
+        Mat<4, 4, O> result = Mat<4, 4, O>::identity();
 
         // Set the translation values
         result.set(0, 3, x);
@@ -90,22 +317,34 @@ namespace e3d::utils::mat {
     /**
      * Performs a translation on a matrix and returns the result
      */
-    static Mat4 mat4_translate(const Mat4& mat, float x, float y, float z) {
+    template<Order O>
+    static constexpr Mat<4, 4, O> mat4_translate(const Mat<4, 4, O>& mat, float x, float y, float z) {
 
         // Multiply with the translation matrix
-        return mat * mat4_create_translation(x, y, z);
+        return mat * mat4_create_translation<O>(x, y, z);
 
     }
-    static Mat4 mat4_translate(const Mat4& mat, const Vec4& vec) { return mat4_translate(mat, vec.x(), vec.y(), vec.z()); }
-    static Mat4 mat4_translate(const Mat4& mat, const Vec3& vec) { return mat4_translate(mat, vec.x(), vec.y(), vec.z()); }
+    template<Order O>
+    static constexpr Mat<4, 4, O> mat4_translate(const Mat<4, 4, O>& mat, const Vec4& vec) { return mat4_translate(mat, vec.x(), vec.y(), vec.z()); }
+    template<Order O>
+    static constexpr Mat<4, 4, O> mat4_translate(const Mat<4, 4, O>& mat, const Vec3& vec) { return mat4_translate(mat, vec.x(), vec.y(), vec.z()); }
+
+    /**
+     * Row-major overloads, which also take expressions like `m * 2.0f` (those evaluate to a
+     * `Mat4`, and can't be deduced as a `Mat<4, 4, O>`)
+     */
+    static constexpr Mat4 mat4_translate(const Mat4& mat, float x, float y, float z) { return mat4_translate<Order::row_major>(mat, x, y, z); }
+    static constexpr Mat4 mat4_translate(const Mat4& mat, const Vec4& vec) { return mat4_translate<Order::row_major>(mat, vec); }
+    static constexpr Mat4 mat4_translate(const Mat4& mat, const Vec3& vec) { return mat4_translate<Order::row_major>(mat, vec); }
 
     /**
      * Creates a matrix for scaling transformations
      */
-    static Mat4 mat4_create_scale(float x, float y, float z) {
+    template<Order O = Order::row_major>
+    static constexpr Mat<4, 4, O> mat4_create_scale(float x, float y, float z) {
 
         // Create the matrix
-        Mat4 mat = Mat4::identity();
+        Mat<4, 4, O> mat = Mat<4, 4, O>::identity();
 
         // Assign the components
         mat.set(0, 0, x);
@@ -120,35 +359,55 @@ namespace e3d::utils::mat {
     /**
      * Performs a scale transformation on a matrix and returns the result
      */
-    static Mat4 mat4_scale(const Mat4& mat, float x, float y, float z) {
+    template<Order O>
+    static constexpr Mat<4, 4, O> mat4_scale(const Mat<4, 4, O>& mat, float x, float y, float z) {
 
         // Create a copy of the matrix
-        Mat4 result(mat);
-
-        // Multiply the appropriate components
-        int i = 0;
-        for (; i < 4; i++) result.data[i] *= x;
-        for (; i < 8; i++) result.data[i] *= y;
-        for (; i < 12; i++) result.data[i] *= z;
+        Mat<4, 4, O> result(mat);
+
+        // Multiply the appropriate components: the first three rows, which are contiguous in
+        // a row-major matrix and strided in a column-major one
+        if constexpr (O == Order::row_major) {
+            int i = 0;
+            for (; i < 4; i++) result.data[i] *= x;
+            for (; i < 8; i++) result.data[i] *= y;
+            for (; i < 12; i++) result.data[i] *= z;
+        } else {
+            for (int i = 0; i < 16; i += 4) {
+                result.data[i] *= x;
+                result.data[i + 1] *= y;
+                result.data[i + 2] *= z;
+            }
+        }
 
         // Return the result
         return result;
 
     }
-    static Mat4 mat4_scale(const Mat4& mat, const Vec4& vec) { return mat4_scale(mat, vec.x(), vec.y(), vec.z()); }
-    static Mat4 mat4_scale(const Mat4& mat, const Vec3& vec) { return mat4_scale(mat, vec.x(), vec.y(), vec.z()); }
+    template<Order O>
+    static constexpr Mat<4, 4, O> mat4_scale(const Mat<4, 4, O>& mat, const Vec4& vec) { return mat4_scale(mat, vec.x(), vec.y(), vec.z()); }
+    template<Order O>
+    static constexpr Mat<4, 4, O> mat4_scale(const Mat<4, 4, O>& mat, const Vec3& vec) { return mat4_scale(mat, vec.x(), vec.y(), vec.z()); }
+
+    /**
+     * Row-major overloads, which also take expressions (see `mat4_translate`)
+     */
+    static constexpr Mat4 mat4_scale(const Mat4& mat, float x, float y, float z) { return mat4_scale<Order::row_major>(mat, x, y, z); }
+    static constexpr Mat4 mat4_scale(const Mat4& mat, const Vec4& vec) { return mat4_scale<Order::row_major>(mat, vec); }
+    static constexpr Mat4 mat4_scale(const Mat4& mat, const Vec3& vec) { return mat4_scale<Order::row_major>(mat, vec); }
 
     /**
      * Creates a rotation matrix for rotation of `x` radians on the x-axis
      */
-    static Mat4 mat4_create_rotation_x(float x) {
+    template<Order O = Order::row_major, class Math = DefaultMath>
+    static constexpr Mat<4, 4, O> mat4_create_rotation_x(float x, Math = Math()) {
 
         // Create the identity matrix
-        Mat4 result = Mat4::identity();
+        Mat<4, 4, O> result = Mat<4, 4, O>::identity();
 
         // Calculate the trig values
-        float sin_theta = sinf(x);
-        float cos_theta = cosf(x);
+        float sin_theta = 0, cos_theta = 0;
+        Math::sincos(x, sin_theta, cos_theta);
 
         // Fill in the rotation values
         result.set(1, 1, cos_theta);
@@ -164,14 +423,15 @@ namespace e3d::utils::mat {
     /**
      * Creates a rotation matrix for rotation of `y` radians on the y-axis
      */
-    static Mat4 mat4_create_rotation_y(float y) {
+    template<Order O = Order::row_major, class Math = DefaultMath>
+    static constexpr Mat<4, 4, O> mat4_create_rotation_y(float y, Math = Math()) {
 
         // Create the identity matrix
-        Mat4 result = Mat4::identity();
+        Mat<4, 4, O> result = Mat<4, 4, O>::identity();
 
         // Calculate the trig values
-        float sin_theta = sinf(y);
-        float cos_theta = cosf(y);
+        float sin_theta = 0, cos_theta = 0;
+        Math::sincos(y, sin_theta, cos_theta);
 
         // Fill in the rotation values
         result.set(0, 0, cos_theta);
@@ -187,14 +447,15 @@ namespace e3d::utils::mat {
     /**
      * Creates a rotation matrix for rotation of `z` radians on the z-axis
      */
-    static Mat4 mat4_create_rotation_z(float z) {
+    template<Order O = Order::row_major, class Math = DefaultMath>
+    static constexpr Mat<4, 4, O> mat4_create_rotation_z(float z, Math = Math()) {
 
         // Create the identity matrix
-        Mat4 result = Mat4::identity();
+        Mat<4, 4, O> result = Mat<4, 4, O>::identity();
 
         // Calculate the trig values
-        float sin_theta = sinf(z);
-        float cos_theta = cosf(z);
+        float sin_theta = 0, cos_theta = 0;
+        Math::sincos(z, sin_theta, cos_theta);
 
         // Fill in the rotation values
         result.set(0, 0, cos_theta);
@@ -210,46 +471,60 @@ namespace e3d::utils::mat {
     /**
      * Performs a rotate transformation on the matrix in YXZ-order, and then returns the result
      */
-    static Mat4 mat4_create_rotation_yxz(float x, float y, float z) {
+    template<Order O = Order::row_major, class Math = DefaultMath>
+    static constexpr Mat<4, 4, O> mat4_create_rotation_yxz(float x, float y, float z, Math = Math()) {
 
         // Create the result matrix
-        Mat4 mat;
+        Mat<4, 4, O> mat;
 
         // Calculate the trig values
-        const float cx = cosf(x);
-        const float sx = sinf(x);
-        const float cy = cosf(y);
-        const float sy = sinf(y);
-        const float cz = cosf(z);
-        const float sz = sinf(z);
+        const float angles[3] = { x, y, z };
+        float sines[3] = {}, cosines[3] = {};
+        Math::sincos3(angles, sines, cosines);
+        const float cx = cosines[0], sx = sines[0];
+        const float cy = cosines[1], sy = sines[1];
+        const float cz = cosines[2], sz = sines[2];
 
         // Insert the values to the matrix
-        mat.data[0] = (cy * cz) + (sx * sy * sz);
-        mat.data[1] = cx * sz;
-        mat.data[2] = (cy * sx * sz) - (cz * sy);
-        mat.data[3] = 0.0;
+        mat.set(0, 0, (cy * cz) + (sx * sy * sz));
+        mat.set(0, 1, cx * sz);
+        mat.set(0, 2, (cy * sx * sz) - (cz * sy));
+        mat.set(0, 3, 0.0);
         
-        mat.data[4] = (cz * sx * sy) - (cy * sz);
-        mat.data[5] = cx * cz;
-        mat.data[6] = (cy * cz * sx) + (sy * sz);
-        mat.data[7] = 0.0;
+        mat.set(1, 0, (cz * sx * sy) - (cy * sz));
+        mat.set(1, 1, cx * cz);
+        mat.set(1, 2, (cy * cz * sx) + (sy * sz));
+        mat.set(1, 3, 0.0);
         
-        mat.data[8] = cx * sy;
-        mat.data[9] = -sx;
-        mat.data[10] = cx * cy;
-        mat.data[11] = 0.0;
+        mat.set(2, 0, cx * sy);
+        mat.set(2, 1, -sx);
+        mat.set(2, 2, cx * cy);
+        mat.set(2, 3, 0.0);
         
-        mat.data[12] = 0.0;
-        mat.data[13] = 0.0;
-        mat.data[14] = 0.0;
-        mat.data[15] = 1.0;
+        mat.set(3, 0, 0.0);
+        mat.set(3, 1, 0.0);
+        mat.set(3, 2, 0.0);
+        mat.set(3, 3, 1.0);
         
         // Return the matrix
         return mat;
 
     }
-    static Mat4 mat4_rotate_yxz(const Mat4& mat, float x, float y, float z) { return mat * mat4_create_rotation_yxz(x, y, z); }
-    static Mat4 mat4_rotate_yxz(const Mat4& mat, const Vec4& vec) { return mat4_rotate_yxz(mat, vec.x(), vec.y(), vec.z()); }
-    static Mat4 mat4_rotate_yxz(const Mat4& mat, const Vec3& vec) { return mat4_rotate_yxz(mat, vec.x(), vec.y(), vec.z()); }
+    template<Order O, class Math = DefaultMath>
+    static constexpr Mat<4, 4, O> mat4_rotate_yxz(const Mat<4, 4, O>& mat, float x, float y, float z, Math math = Math()) { return mat * mat4_create_rotation_yxz<O>(x, y, z, math); }
+    template<Order O, class Math = DefaultMath>
+    static constexpr Mat<4, 4, O> mat4_rotate_yxz(const Mat<4, 4, O>& mat, const Vec4& vec, Math math = Math()) { return mat4_rotate_yxz(mat, vec.x(), vec.y(), vec.z(), math); }
+    template<Order O, class Math = DefaultMath>
+    static constexpr Mat<4, 4, O> mat4_rotate_yxz(const Mat<4, 4, O>& mat, const Vec3& vec, Math math = Math()) { return mat4_rotate_yxz(mat, vec.x(), vec.y(), vec.z(), math); }
+
+    /**
+     * Row-major overloads, which also take expressions (see `mat4_translate`)
+     */
+    template<class Math = DefaultMath>
+    static constexpr Mat4 mat4_rotate_yxz(const Mat4& mat, float x, float y, float z, Math math = Math()) { return mat4_rotate_yxz<Order::row_major>(mat, x, y, z, math); }
+    template<class Math = DefaultMath>
+    static constexpr Mat4 mat4_rotate_yxz(const Mat4& mat, const Vec4& vec, Math math = Math()) { return mat4_rotate_yxz<Order::row_major>(mat, vec, math); }
+    template<class Math = DefaultMath>
+    static constexpr Mat4 mat4_rotate_yxz(const Mat4& mat, const Vec3& vec, Math math = Math()) { return mat4_rotate_yxz<Order::row_major>(mat, vec, math); }
 
 };
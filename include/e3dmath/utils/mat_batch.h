@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+#include <algorithm>
+#include "../types/mat_batch.h"
+#include "../simd/lanes.h"
+
+#define E3D_SIMD_KERNELS "kernels/mat_batch.inl"
+#include "../simd/foreach_target.h"
+
+/**
+ * Batch versions of the matrix operations in types/mat.h and utils/mat.h, operating on
+ * `MatBatch` streams. These process 4, 8 or 16 matrices per instruction depending on the SIMD
+ * level (see simd/cpu.h).
+ *
+ * With SSE2 the results are bit-for-bit identical to the same operation on each `Mat`. With
+ * AVX2 and AVX-512 the matrix products are fused multiply-adds, so they may differ in the last
+ * bits. Determinants and inverses are never fused, so they stay identical at every level.
+ *
+ * Output buffers must hold `size` elements. `multiply` may write over either of its inputs
+ * and `inverse` over its input; `transpose` must not alias.
+ */
+namespace e3d::utils::mat_batch {
+
+    /**
+     * Multiplies each pair of matrices
+     */
+    template<uint8_t R, uint8_t K, uint8_t C>
+    static void multiply(const MatBatchView<R, K>& left, const MatBatchView<K, C>& right, const MatBatchSpan<R, C>& out) {
+        E3D_SIMD_DISPATCH(mat_batch::multiply<R, K, C>(left.data, right.data, out.data, left.size));
+    }
+
+    /**
+     * Multiplies each matrix with the vector at the same index. `out` may be `vecs` when the
+     * matrices are square.
+     */
+    template<uint8_t R, uint8_t C>
+    static void multiply(const MatBatchView<R, C>& mats, const VecSoaView<C>& vecs, const VecSoaSpan<R>& out) {
+        E3D_SIMD_DISPATCH(mat_batch::transform<R, C>(mats.data, vecs.data, out.data, mats.size));
+    }
+
+    /**
+     * Transposes each matrix. Every element is its own stream, so this only copies streams.
+     */
+    template<uint8_t R, uint8_t C>
+    static void transpose(const MatBatchView<R, C>& mats, const MatBatchSpan<C, R>& out) {
+        for (uint8_t r = 0; r < R; r++) {
+            for (uint8_t c = 0; c < C; c++) std::copy_n(mats.element(r, c), mats.size, out.element(c, r));
+        }
+    }
+
+    /**
+     * Calculates the determinant of each matrix. Only closed-form sizes (up to 4x4) are
+     * supported; use utils::mat::determinant for larger ones.
+     */
+    template<uint8_t R>
+    static void determinant(const MatBatchView<R, R>& mats, float* out) {
+        static_assert(R >= 2 && R <= 4, "Batch determinants are only available for 2x2, 3x3 and 4x4 matrices");
+        E3D_SIMD_DISPATCH(mat_batch::determinant<R>(mats.data, out, mats.size));
+    }
+
+    /**
+     * Calculates the inverse of each matrix. Singular matrices have no inverse, so they become
+     * zero matrices, exactly when utils::mat::inverse would zero them. Returns the number of
+     * singular matrices.
+     */
+    template<uint8_t R>
+    static size_t inverse(const MatBatchView<R, R>& mats, const MatBatchSpan<R, R>& out) {
+        static_assert(R >= 2 && R <= 4, "Batch inverses are only available for 2x2, 3x3 and 4x4 matrices");
+        E3D_SIMD_DISPATCH(mat_batch::inverse<R>(mats.data, out.data, mats.size));
+    }
+
+}
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstddef>
+#include <cmath>
+#include "../types/mesh.h"
+#include "../types/vec_soa.h"
+#include "../simd/lanes.h"
+#include "./parallel.h"
+#include "./vec_soa.h"
+
+#define E3D_SIMD_KERNELS "kernels/mesh.inl"
+#include "../simd/foreach_target.h"
+
+/**
+ * Normals and tangents for indexed triangle meshes. The per-triangle work is vectorized (see
+ * simd/cpu.h), and everything is split across the shared thread pool (see utils/parallel.h).
+ *
+ * Per-vertex results are gathered from the triangles around each vertex, in a fixed order,
+ * so they don't depend on the number of threads.
+ */
+namespace e3d::utils::mesh {
+
+    /**
+     * The number of triangles or vertices each thread takes at a time
+     */
+    constexpr size_t grain = 1 << 14;
+
+    static void _face_normals(const float* const* positions, const uint32_t* indices, float* const* out, bool normalize, size_t begin, size_t end) {
+        E3D_SIMD_DISPATCH(mesh::face_normals(positions, indices, out, normalize, begin, end));
+    }
+
+    static float _face_areas(const float* const* positions, const uint32_t* indices, float* out, size_t begin, size_t end) {
+        E3D_SIMD_DISPATCH(mesh::face_areas(positions, indices, out, begin, end));
+    }
+
+    static void _face_tangents(const float* const* positions, const float* const* uvs, const uint32_t* indices,
+        float* const* s_out, float* const* t_out, size_t begin, size_t end) {
+        E3D_SIMD_DISPATCH(mesh::face_tangents(positions, uvs, indices, s_out, t_out, begin, end));
+    }
+
+    /**
+     * Finds the triangles around each vertex
+     */
+    static MeshAdjacency build_adjacency(const MeshView& mesh) {
+        MeshAdjacency adjacency;
+        size_t corners = mesh.triangle_count * 3;
+
+        // Count the triangles at each vertex, then turn the counts into offsets
+        adjacency.offsets.assign(mesh.positions.size + 1, 0);
+        for (size_t i = 0; i < corners; i++) adjacency.offsets[mesh.indices[i] + 1]++;
+        for (size_t v = 0; v < mesh.positions.size; v++) adjacency.offsets[v + 1] += adjacency.offsets[v];
+
+        // Place each triangle after the others at the same vertex
+        std::vector<uint32_t> cursors(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+        adjacency.triangles.resize(corners);
+        for (size_t i = 0; i < corners; i++) adjacency.triangles[cursors[mesh.indices[i]]++] = uint32_t(i / 3);
+
+        // Return the adjacency
+        return adjacency;
+    }
+
+    /**
+     * Calculates the unit normal of each triangle into `out`, which must hold
+     * `triangle_count` vectors. Degenerate triangles get a zero normal.
+     */
+    static void face_normals(const MeshView& mesh, const VecSoaSpan<3>& out) {
+        parallel::for_range(0, mesh.triangle_count, grain, [&](size_t begin, size_t end) {
+            _face_normals(mesh.positions.data, mesh.indices, out.data, true, begin, end);
+        });
+    }
+
+    /**
+     * Calculates the area of each triangle into `out`, and returns the surface area of the
+     * whole mesh. `out` may be null if only the total is needed. The total is summed in the
+     * same order however many threads there are.
+     */
+    static float area(const MeshView& mesh, float* out = nullptr) {
+
+        // Sum fixed blocks of triangles in parallel
+        size_t blocks = (mesh.triangle_count + grain - 1) / grain;
+        std::vector<double> totals(blocks);
+        parallel::for_range(0, blocks, 1, [&](size_t begin, size_t end) {
+            for (size_t block = begin; block < end; block++) {
+                size_t first = block * grain, last = std::min(mesh.triangle_count, first + grain);
+                totals[block] = _face_areas(mesh.positions.data, mesh.indices, out, first, last);
+            }
+        });
+
+        // Add up the blocks
+        double total = 0;
+        for (double block_total : totals) total += block_total;
+        return float(total);
+
+    }
+
+    /**
+     * Calculates the normal of each vertex into `out`, which must hold a vector per vertex.
+     * Each is the average of the normals of the triangles around it, weighted by their area.
+     * Vertices with no triangles get a zero normal.
+     */
+    static void vertex_normals(const MeshView& mesh, const MeshAdjacency& adjacency, const VecSoaSpan<3>& out) {
+
+        // The cross product of each triangle, whose length is twice its area
+        Vec3Soa weighted(mesh.triangle_count);
+        VecSoaSpan<3> weighted_span = weighted.span();
+        parallel::for_range(0, mesh.triangle_count, grain, [&](size_t begin, size_t end) {
+            _face_normals(mesh.positions.data, mesh.indices, weighted_span.data, false, begin, end);
+        });
+
+        // Sum them around each vertex, then normalize
+        parallel::for_range(0, mesh.positions.size, grain, [&](size_t begin, size_t end) {
+            for (size_t v = begin; v < end; v++) {
+                float sum[3] = { 0, 0, 0 };
+                for (uint32_t i = adjacency.offsets[v]; i < adjacency.offsets[v + 1]; i++) {
+                    uint32_t tri = adjacency.triangles[i];
+                    for (int c = 0; c < 3; c++) sum[c] += weighted_span.data[c][tri];
+                }
+                for (int c = 0; c < 3; c++) out.data[c][v] = sum[c];
+            }
+            VecSoaSpan<3> chunk;
+            for (int c = 0; c < 3; c++) chunk.data[c] = out.data[c] + begin;
+            chunk.size = end - begin;
+            vec_soa::normalize(VecSoaView<3>(chunk), chunk);
+        });
+
+    }
+
+    /**
+     * Calculates the normal of each vertex, building the adjacency on the way
+     */
+    static void vertex_normals(const MeshView& mesh, const VecSoaSpan<3>& out) {
+        vertex_normals(mesh, build_adjacency(mesh), out);
+    }
+
+    /**
+     * Calculates a tangent for each vertex into `out`, pointing along increasing u on the
+     * surface. The mesh needs texture coordinates, and `normals` should come from
+     * `vertex_normals`.
+     *
+     * xyz is the unit tangent, made perpendicular to the normal. w is 1 or -1, the handedness
+     * of the texture mapping, so that `cross(normal, tangent.xyz) * w` is the bitangent.
+     */
+    static void tangents(const MeshView& mesh, const MeshAdjacency& adjacency, const VecSoaView<3>& normals, const VecSoaSpan<4>& out) {
+
+        // The directions of increasing u and v across each triangle
+        Vec3Soa s_dirs(mesh.triangle_count), t_dirs(mesh.triangle_count);
+        VecSoaSpan<3> s_span = s_dirs.span(), t_span = t_dirs.span();
+        parallel::for_range(0, mesh.triangle_count, grain, [&](size_t begin, size_t end) {
+            _face_tangents(mesh.positions.data, mesh.uvs.data, mesh.indices, s_span.data, t_span.data, begin, end);
+        });
+
+        // Sum them around each vertex, then make the tangent perpendicular to the normal
+        parallel::for_range(0, mesh.positions.size, grain, [&](size_t begin, size_t end) {
+            for (size_t v = begin; v < end; v++) {
+
+                // Gather the triangle directions
+                float s[3] = { 0, 0, 0 }, t[3] = { 0, 0, 0 };
+                for (uint32_t i = adjacency.offsets[v]; i < adjacency.offsets[v + 1]; i++) {
+                    uint32_t tri = adjacency.triangles[i];
+                    for (int c = 0; c < 3; c++) {
+                        s[c] += s_span.data[c][tri];
+                        t[c] += t_span.data[c][tri];
+                    }
+                }
+
+                // Gram-Schmidt: remove the part along the normal, then normalize
+                float n[3] = { normals.data[0][v], normals.data[1][v], normals.data[2][v] };
+                float n_dot_s = n[0] * s[0] + n[1] * s[1] + n[2] * s[2];
+                float tangent[3];
+                for (int c = 0; c < 3; c++) tangent[c] = s[c] - n[c] * n_dot_s;
+                float mag = sqrtf(tangent[0] * tangent[0] + tangent[1] * tangent[1] + tangent[2] * tangent[2]);
+                float scale = mag > 0.00001f ? 1.0f / mag : 0.0f;
+                for (int c = 0; c < 3; c++) out.data[c][v] = tangent[c] * scale;
+
+                // The handedness is whether cross(n, s) points along t
+                float bitangent[3] = { n[1] * s[2] - n[2] * s[1], n[2] * s[0] - n[0] * s[2], n[0] * s[1] - n[1] * s[0] };
+                out.data[3][v] = bitangent[0] * t[0] + bitangent[1] * t[1] + bitangent[2] * t[2] < 0 ? -1.0f : 1.0f;
+
+            }
+        });
+
+    }
+
+    /**
+     * Calculates a tangent for each vertex, building the adjacency on the way
+     */
+    static void tangents(const MeshView& mesh, const VecSoaView<3>& normals, const VecSoaSpan<4>& out) {
+        tangents(mesh, build_adjacency(mesh), normals, out);
+    }
+
+}
@@ -0,0 +1,797 @@
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cinttypes>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../types/vec_soa.h"
+#include "../types/mesh.h"
+#include "./parallel.h"
+
+/**
+ * Imports Wavefront OBJ and PLY (ASCII and binary, either byte order) files into meshes and
+ * SoA point buffers.
+ *
+ * Files are read a window at a time, so memory for the file itself stays bounded however
+ * large it is. Each window of text is split into chunks on line breaks, which are parsed
+ * across the shared thread pool (see utils/parallel.h) with std::from_chars and then
+ * appended in order, so the result is the same however many threads do the work. Binary PLY
+ * vertices are decoded in parallel straight into place.
+ *
+ * Polygons are split into fans of triangles. OBJ normals, groups and materials are skipped,
+ * as are PLY elements and properties other than vertex positions, texture coordinates and
+ * face indices. Loads replace the contents of the output, and return false if the file can't
+ * be read or is malformed, leaving the output partly filled.
+ */
+namespace e3d::utils::mesh_import {
+
+    /**
+     * The number of bytes of input held in memory at a time. Lines and binary records must
+     * fit in one window.
+     */
+    constexpr size_t window_size = 1 << 26;
+
+    /**
+     * The number of bytes of text each thread parses at a time
+     */
+    constexpr size_t grain = 1 << 20;
+
+    /**
+     * The texture coordinate index of an OBJ corner without one
+     */
+    constexpr uint32_t _none = UINT32_MAX;
+
+    /**
+     * Where input comes from: a file, or a buffer already in memory
+     */
+    struct _Source {
+        FILE* file = nullptr;
+        const char* data = nullptr;
+        size_t length = 0;
+    };
+
+    /**
+     * Feeds the input through `process(data, size, eof)`. It returns how many bytes it used,
+     * or SIZE_MAX if the input is malformed. Buffers are handed over whole; files are read a
+     * window at a time, with whatever wasn't used carried over to the start of the next.
+     * Returns false if `process` fails, or can't use anything from a full window.
+     */
+    template<class Process>
+    static bool _stream(_Source& source, Process&& process) {
+        if (source.file == nullptr) return process(source.data, source.length, true) == source.length;
+        std::unique_ptr<char[]> window(new char[window_size]);
+        size_t filled = 0;
+        while (true) {
+            filled += std::fread(window.get() + filled, 1, window_size - filled, source.file);
+            bool eof = filled < window_size;
+            size_t used = process(window.get(), filled, eof);
+            if (used == SIZE_MAX || (used == 0 && filled == window_size)) return false;
+            std::memmove(window.get(), window.get() + used, filled - used);
+            filled -= used;
+            if (eof) return filled == 0;
+        }
+    }
+
+    /**
+     * The length of the whole lines at the start of `text`, or all of it at the end of the
+     * input
+     */
+    static size_t _whole_lines(const char* text, size_t size, bool eof) {
+        if (eof) return size;
+        while (size > 0 && text[size - 1] != '\n') size--;
+        return size;
+    }
+
+    /**
+     * Splits text into chunks of about `grain` bytes that end on line breaks
+     */
+    static void _split(const char* text, size_t size, std::vector<size_t>& bounds) {
+        bounds.assign(1, 0);
+        while (bounds.back() < size) {
+            size_t end = std::min(size, bounds.back() + grain);
+            const void* newline = end < size ? std::memchr(text + end, '\n', size - end) : nullptr;
+            end = newline ? static_cast<const char*>(newline) - text + 1 : size;
+            bounds.push_back(end);
+        }
+    }
+
+    static const char* _skip_spaces(const char* p, const char* end) {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) p++;
+        return p;
+    }
+
+    static const char* _line_end(const char* p, const char* end) {
+        const void* newline = std::memchr(p, '\n', end - p);
+        return newline ? static_cast<const char*>(newline) : end;
+    }
+
+    /**
+     * Parses a float, skipping any spaces before it
+     */
+    static bool _float(const char*& p, const char* end, float& out) {
+        p = _skip_spaces(p, end);
+        if (p < end && *p == '+') p++;
+        std::from_chars_result result = std::from_chars(p, end, out);
+        if (result.ec == std::errc::result_out_of_range) {
+
+            // Let strtof round values too small or large for a float to zero or infinity
+            char token[64] = {};
+            std::memcpy(token, p, std::min<size_t>(result.ptr - p, sizeof(token) - 1));
+            out = std::strtof(token, nullptr);
+        } else if (result.ec != std::errc()) {
+            return false;
+        }
+        p = result.ptr;
+        return true;
+    }
+
+    /**
+     * Parses an integer, skipping any spaces before it
+     */
+    static bool _integer(const char*& p, const char* end, int64_t& out) {
+        p = _skip_spaces(p, end);
+        if (p < end && *p == '+') p++;
+        std::from_chars_result result = std::from_chars(p, end, out);
+        if (result.ec != std::errc()) return false;
+        p = result.ptr;
+        return true;
+    }
+
+    /**
+     * Appends SoA streams to a container, growing it geometrically
+     */
+    template<uint8_t S>
+    static void _append(VecSoa<S>& out, const std::vector<float>* streams) {
+        size_t begin = out.size(), count = streams[0].size();
+        if (count == 0) return;
+        if (begin + count > out.capacity()) out.reserve(std::max(begin + count, out.capacity() * 2));
+        out.resize(begin + count);
+        for (uint8_t c = 0; c < S; c++) std::copy(streams[c].begin(), streams[c].end(), out.component(c) + begin);
+    }
+
+    /**
+     * What one chunk of an OBJ file holds. Corner indices are zero-based; those written
+     * relative to the end of the file so far are counted from the start of the chunk, and
+     * listed so the vertices before the chunk can be added once they're known.
+     */
+    struct _ObjChunk {
+
+        std::vector<float> positions[3];
+        std::vector<float> uvs[2];
+        std::vector<uint32_t> corners;
+        std::vector<uint32_t> uv_corners;
+        std::vector<size_t> relative;
+        std::vector<size_t> uv_relative;
+        bool ok;
+
+        void clear() {
+            for (std::vector<float>& stream : this->positions) stream.clear();
+            for (std::vector<float>& stream : this->uvs) stream.clear();
+            this->corners.clear();
+            this->uv_corners.clear();
+            this->relative.clear();
+            this->uv_relative.clear();
+            this->ok = true;
+        }
+
+    };
+
+    /**
+     * Parses one face corner, `v`, `v/vt`, `v//vn` or `v/vt/vn`, into zero-based indices
+     */
+    static bool _obj_corner(const char*& p, const char* end, _ObjChunk& chunk, uint32_t& position, uint32_t& uv, bool& relative, bool& uv_relative) {
+        int64_t index;
+        if (!_integer(p, end, index) || index == 0) return false;
+        relative = index < 0;
+        position = uint32_t(relative ? int64_t(chunk.positions[0].size()) + index : index - 1);
+        uv = _none;
+        uv_relative = false;
+        if (p >= end || *p != '/') return true;
+        p++;
+        if (p < end && *p != '/') {
+            if (!_integer(p, end, index) || index == 0) return false;
+            uv_relative = index < 0;
+            uv = uint32_t(uv_relative ? int64_t(chunk.uvs[0].size()) + index : index - 1);
+        }
+        if (p >= end || *p != '/') return true;
+        p++;
+        return _integer(p, end, index);
+    }
+
+    /**
+     * Parses the lines of an OBJ chunk
+     */
+    static void _obj_chunk(const char* p, const char* end, bool faces, _ObjChunk& chunk) {
+        chunk.clear();
+        uint32_t first = 0, first_uv = 0, previous = 0, previous_uv = 0;
+        bool first_relative = false, first_uv_relative = false, previous_relative = false, previous_uv_relative = false;
+        while (p < end) {
+            const char* line_end = _line_end(p, end);
+            p = _skip_spaces(p, line_end);
+            if (line_end - p >= 2 && p[0] == 'v' && (p[1] == ' ' || p[1] == '\t')) {
+
+                // Vertex positions
+                p++;
+                float value[3];
+                for (int c = 0; c < 3 && chunk.ok; c++) chunk.ok = _float(p, line_end, value[c]);
+                for (int c = 0; c < 3; c++) chunk.positions[c].push_back(value[c]);
+
+            } else if (line_end - p >= 3 && p[0] == 'v' && p[1] == 't' && (p[2] == ' ' || p[2] == '\t')) {
+
+                // Texture coordinates, where v defaults to 0
+                p += 2;
+                float value[2] = { 0, 0 };
+                chunk.ok = chunk.ok && _float(p, line_end, value[0]);
+                const char* next = _skip_spaces(p, line_end);
+                if (next < line_end) chunk.ok = chunk.ok && _float(p, line_end, value[1]);
+                for (int c = 0; c < 2; c++) chunk.uvs[c].push_back(value[c]);
+
+            } else if (faces && line_end - p >= 2 && p[0] == 'f' && (p[1] == ' ' || p[1] == '\t')) {
+
+                // Faces, split into a fan around their first corner
+                p++;
+                size_t count = 0;
+                while (chunk.ok && (p = _skip_spaces(p, line_end)) < line_end) {
+                    uint32_t position, uv;
+                    bool relative, uv_relative;
+                    chunk.ok = _obj_corner(p, line_end, chunk, position, uv, relative, uv_relative);
+                    if (!chunk.ok) break;
+                    if (count == 0) {
+                        first = position, first_uv = uv, first_relative = relative, first_uv_relative = uv_relative;
+                    } else if (count >= 2) {
+                        const uint32_t corners[3] = { first, previous, position }, uvs[3] = { first_uv, previous_uv, uv };
+                        const bool relatives[3] = { first_relative, previous_relative, relative };
+                        const bool uv_relatives[3] = { first_uv_relative, previous_uv_relative, uv_relative };
+                        for (int k = 0; k < 3; k++) {
+                            if (relatives[k]) chunk.relative.push_back(chunk.corners.size());
+                            if (uv_relatives[k]) chunk.uv_relative.push_back(chunk.corners.size());
+                            chunk.corners.push_back(corners[k]);
+                            chunk.uv_corners.push_back(uvs[k]);
+                        }
+                    }
+                    previous = position, previous_uv = uv, previous_relative = relative, previous_uv_relative = uv_relative;
+                    count++;
+                }
+                chunk.ok = chunk.ok && count >= 3;
+
+            }
+            if (!chunk.ok) return;
+            p = line_end + 1;
+        }
+    }
+
+    /**
+     * Gives each vertex the texture coordinates its corners use, copying any vertex whose
+     * corners use more than one
+     */
+    static void _obj_uvs(Mesh& out, const std::vector<float>* uvs, const std::vector<uint32_t>& uv_corners) {
+        size_t vertices = out.positions.size();
+        std::vector<uint32_t> vertex_uvs(vertices, _none);
+        std::vector<bool> assigned(vertices, false);
+        std::unordered_map<uint64_t, uint32_t> copies;
+        for (size_t i = 0; i < out.indices.size(); i++) {
+            uint32_t vertex = out.indices[i], uv = uv_corners[i];
+            if (!assigned[vertex]) {
+                assigned[vertex] = true;
+                vertex_uvs[vertex] = uv;
+            } else if (vertex_uvs[vertex] != uv) {
+                uint64_t key = uint64_t(vertex) << 32 | uv;
+                auto found = copies.find(key);
+                if (found == copies.end()) {
+                    found = copies.emplace(key, uint32_t(out.positions.size())).first;
+                    out.positions.push_back(out.positions.get(vertex));
+                    vertex_uvs.push_back(uv);
+                }
+                out.indices[i] = found->second;
+            }
+        }
+        out.uvs.resize(out.positions.size());
+        for (size_t v = 0; v < vertex_uvs.size(); v++) {
+            if (vertex_uvs[v] == _none) continue;
+            for (uint8_t c = 0; c < 2; c++) out.uvs.component(c)[v] = uvs[c][vertex_uvs[v]];
+        }
+    }
+
+    static bool _obj(_Source& source, Mesh& out, bool faces) {
+        out = Mesh();
+        std::vector<float> uvs[2];
+        std::vector<uint32_t> uv_corners;
+        std::vector<size_t> bounds;
+        std::vector<_ObjChunk> chunks;
+
+        // Parse each window in chunks, then append them in order
+        bool ok = _stream(source, [&](const char* text, size_t size, bool eof) -> size_t {
+            size_t used = _whole_lines(text, size, eof);
+            _split(text, used, bounds);
+            size_t count = bounds.size() - 1;
+            if (chunks.size() < count) chunks.resize(count);
+            parallel::for_range(0, count, 1, [&](size_t first, size_t last) {
+                for (size_t i = first; i < last; i++) _obj_chunk(text + bounds[i], text + bounds[i + 1], faces, chunks[i]);
+            });
+            for (size_t i = 0; i < count; i++) {
+                _ObjChunk& chunk = chunks[i];
+                if (!chunk.ok) return SIZE_MAX;
+                uint32_t base = uint32_t(out.positions.size()), uv_base = uint32_t(uvs[0].size());
+                size_t corner_base = out.indices.size();
+                _append(out.positions, chunk.positions);
+                for (int c = 0; c < 2; c++) uvs[c].insert(uvs[c].end(), chunk.uvs[c].begin(), chunk.uvs[c].end());
+                out.indices.insert(out.indices.end(), chunk.corners.begin(), chunk.corners.end());
+                uv_corners.insert(uv_corners.end(), chunk.uv_corners.begin(), chunk.uv_corners.end());
+                for (size_t corner : chunk.relative) out.indices[corner_base + corner] += base;
+                for (size_t corner : chunk.uv_relative) uv_corners[corner_base + corner] += uv_base;
+            }
+            return used;
+        });
+        if (!ok) return false;
+
+        // Check every corner refers to something
+        size_t vertices = out.positions.size(), uv_count = uvs[0].size();
+        bool any_uvs = false;
+        for (size_t i = 0; i < out.indices.size(); i++) {
+            if (out.indices[i] >= vertices) return false;
+            if (uv_corners[i] != _none && uv_corners[i] >= uv_count) return false;
+            any_uvs = any_uvs || uv_corners[i] != _none;
+        }
+        if (any_uvs) _obj_uvs(out, uvs, uv_corners);
+        return true;
+    }
+
+    /**
+     * The types of PLY properties
+     */
+    enum _PlyType { _int8, _uint8, _int16, _uint16, _int32, _uint32, _float32, _float64, _invalid };
+
+    static _PlyType _ply_type(const std::string& name) {
+        if (name == "char" || name == "int8") return _int8;
+        if (name == "uchar" || name == "uint8") return _uint8;
+        if (name == "short" || name == "int16") return _int16;
+        if (name == "ushort" || name == "uint16") return _uint16;
+        if (name == "int" || name == "int32") return _int32;
+        if (name == "uint" || name == "uint32") return _uint32;
+        if (name == "float" || name == "float32") return _float32;
+        if (name == "double" || name == "float64") return _float64;
+        return _invalid;
+    }
+
+    static size_t _ply_size(_PlyType type) {
+        static const size_t sizes[] = { 1, 1, 2, 2, 4, 4, 4, 8, 0 };
+        return sizes[type];
+    }
+
+    /**
+     * Reads a binary value of any type, swapping its bytes if the file's order isn't ours
+     */
+    static double _ply_value(const char* p, _PlyType type, bool swap) {
+        unsigned char bytes[8];
+        size_t size = _ply_size(type);
+        std::memcpy(bytes, p, size);
+        if (swap) std::reverse(bytes, bytes + size);
+        switch (type) {
+            case _int8: { int8_t v; std::memcpy(&v, bytes, 1); return v; }
+            case _uint8: { uint8_t v; std::memcpy(&v, bytes, 1); return v; }
+            case _int16: { int16_t v; std::memcpy(&v, bytes, 2); return v; }
+            case _uint16: { uint16_t v; std::memcpy(&v, bytes, 2); return v; }
+            case _int32: { int32_t v; std::memcpy(&v, bytes, 4); return v; }
+            case _uint32: { uint32_t v; std::memcpy(&v, bytes, 4); return v; }
+            case _float32: { float v; std::memcpy(&v, bytes, 4); return v; }
+            case _float64: { double v; std::memcpy(&v, bytes, 8); return v; }
+            default: return 0;
+        }
+    }
+
+    struct _PlyProperty {
+        std::string name;
+        _PlyType type;
+        _PlyType count_type;
+        bool list;
+    };
+
+    struct _PlyElement {
+        std::string name;
+        size_t count;
+        std::vector<_PlyProperty> properties;
+
+        /**
+         * The size of each binary record, or 0 if they hold lists and vary
+         */
+        size_t stride;
+    };
+
+    /**
+     * What a PLY file holds, and how far through its elements reading is
+     */
+    struct _Ply {
+
+        enum Format { ascii, binary_little_endian, binary_big_endian, unknown } format = unknown;
+        bool swap = false;
+        std::vector<_PlyElement> elements;
+
+        /**
+         * The vertex and face elements, and which of their properties hold the positions,
+         * texture coordinates and indices, or -1 if they're missing
+         */
+        int vertex = -1, face = -1;
+        int coordinates[5] = { -1, -1, -1, -1, -1 };
+        int indices = -1;
+
+        /**
+         * The element being read, and how many of its records are done
+         */
+        size_t element = 0;
+        size_t record = 0;
+
+        bool header(const char* text, size_t size) {
+            const char* p = text, *end = text + size;
+            size_t line = 0;
+            while (p < end) {
+                const char* line_end = _line_end(p, end);
+                std::vector<std::string> words;
+                for (const char* q = p; (q = _skip_spaces(q, line_end)) < line_end;) {
+                    const char* word_end = q;
+                    while (word_end < line_end && *word_end != ' ' && *word_end != '\t' && *word_end != '\r') word_end++;
+                    words.emplace_back(q, word_end);
+                    q = word_end;
+                }
+                p = line_end + 1;
+                if (line++ == 0) {
+                    if (words.size() != 1 || words[0] != "ply") return false;
+                } else if (words.empty() || words[0] == "comment" || words[0] == "obj_info") {
+                    continue;
+                } else if (words[0] == "format" && words.size() >= 2) {
+                    if (words[1] == "ascii") this->format = ascii;
+                    else if (words[1] == "binary_little_endian") this->format = binary_little_endian;
+                    else if (words[1] == "binary_big_endian") this->format = binary_big_endian;
+                    else return false;
+                } else if (words[0] == "element" && words.size() == 3) {
+                    this->elements.push_back({ words[1], size_t(std::strtoull(words[2].c_str(), nullptr, 10)), {}, 0 });
+                } else if (words[0] == "property" && words.size() == 3 && !this->elements.empty()) {
+                    this->elements.back().properties.push_back({ words[2], _ply_type(words[1]), _invalid, false });
+                    if (_ply_type(words[1]) == _invalid) return false;
+                } else if (words[0] == "property" && words.size() == 5 && words[1] == "list" && !this->elements.empty()) {
+                    this->elements.back().properties.push_back({ words[4], _ply_type(words[3]), _ply_type(words[2]), true });
+                    if (_ply_type(words[2]) == _invalid || _ply_type(words[3]) == _invalid) return false;
+                } else if (words[0] == "end_header") {
+                    return this->format != unknown && this->_layout();
+                } else {
+                    return false;
+                }
+            }
+            return false;
+        }
+
+        bool _layout() {
+            const uint16_t probe = 1;
+            bool little = *reinterpret_cast<const uint8_t*>(&probe) == 1;
+            this->swap = this->format != ascii && (this->format == binary_little_endian) != little;
+
+            // Work out the binary records, and find the properties we read
+            static const char* names[5][4] = {
+                { "x", "x", "x", "x" },
+                { "y", "y", "y", "y" },
+                { "z", "z", "z", "z" },
+                { "u", "s", "texture_u", "texture_s" },
+                { "v", "t", "texture_v", "texture_t" }
+            };
+            for (size_t e = 0; e < this->elements.size(); e++) {
+                _PlyElement& element = this->elements[e];
+                for (const _PlyProperty& property : element.properties) {
+                    if (property.list) {
+                        element.stride = 0;
+                        break;
+                    }
+                    element.stride += _ply_size(property.type);
+                }
+                for (size_t i = 0; i < element.properties.size(); i++) {
+                    const _PlyProperty& property = element.properties[i];
+                    if (element.name == "vertex" && !property.list) {
+                        this->vertex = int(e);
+                        for (int c = 0; c < 5; c++) {
+                            for (const char* name : names[c]) {
+                                if (property.name == name && this->coordinates[c] < 0) this->coordinates[c] = int(i);
+                            }
+                        }
+                    }
+                    if (element.name == "face" && property.list && (property.name == "vertex_indices" || property.name == "vertex_index")) {
+                        this->face = int(e);
+                        this->indices = int(i);
+                    }
+                }
+            }
+            return this->vertex >= 0 && this->coordinates[0] >= 0 && this->coordinates[1] >= 0 && this->coordinates[2] >= 0;
+        }
+
+        bool has_uvs() const { return this->coordinates[3] >= 0 && this->coordinates[4] >= 0; }
+
+    };
+
+    /**
+     * Splits a polygon into a fan of triangles on the end of `out`
+     */
+    static bool _fan(const uint32_t* corners, size_t count, size_t vertices, std::vector<uint32_t>& out) {
+        if (count < 3) return false;
+        for (size_t k = 0; k < count; k++) {
+            if (corners[k] >= vertices) return false;
+        }
+        for (size_t k = 1; k + 1 < count; k++) {
+            out.push_back(corners[0]);
+            out.push_back(corners[k]);
+            out.push_back(corners[k + 1]);
+        }
+        return true;
+    }
+
+    /**
+     * Reads the ASCII body of a PLY file a window at a time
+     */
+    static size_t _ply_ascii(_Ply& ply, Mesh& out, bool faces, const char* text, size_t size, bool eof,
+        std::vector<size_t>& bounds, std::vector<std::vector<uint32_t>>& triangles) {
+
+        // Count the lines in each chunk, to find where each one starts in the file
+        size_t used = _whole_lines(text, size, eof);
+        _split(text, used, bounds);
+        size_t count = bounds.size() - 1;
+        std::vector<size_t> lines(count + 1, 0);
+        parallel::for_range(0, count, 1, [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; i++) {
+                const char* p = text + bounds[i], *end = text + bounds[i + 1];
+                for (; p < end; p = _line_end(p, end) + 1) lines[i + 1]++;
+            }
+        });
+        for (size_t i = 0; i < count; i++) lines[i + 1] += lines[i];
+
+        // Then parse them
+        if (triangles.size() < count) triangles.resize(count);
+        std::vector<char> ok(count, 1);
+        const size_t element = ply.element, record = ply.record;
+        const size_t vertices = ply.elements[ply.vertex].count;
+        parallel::for_range(0, count, 1, [&](size_t first, size_t last) {
+            std::vector<uint32_t> corners;
+            for (size_t i = first; i < last; i++) {
+                triangles[i].clear();
+
+                // Find the element of the chunk's first line
+                size_t e = element, r = record + lines[i];
+                while (e < ply.elements.size() && r >= ply.elements[e].count) r -= ply.elements[e++].count;
+
+                const char* p = text + bounds[i], *end = text + bounds[i + 1];
+                for (; p < end && e < ply.elements.size(); p++) {
+                    const char* line_end = _line_end(p, end);
+                    const _PlyElement& current = ply.elements[e];
+                    if (int(e) == ply.vertex) {
+                        for (size_t k = 0; k < current.properties.size() && ok[i]; k++) {
+                            float value;
+                            ok[i] = _float(p, line_end, value);
+                            for (int c = 0; c < 5; c++) {
+                                if (ply.coordinates[c] != int(k)) continue;
+                                if (c < 3) out.positions.component(c)[r] = value;
+                                else if (ply.has_uvs()) out.uvs.component(c - 3)[r] = value;
+                            }
+                        }
+                    } else if (int(e) == ply.face && faces) {
+                        for (size_t k = 0; k < current.properties.size() && ok[i]; k++) {
+                            int64_t items;
+                            float value;
+                            if (!current.properties[k].list) {
+                                ok[i] = _float(p, line_end, value);
+                                continue;
+                            }
+                            ok[i] = _integer(p, line_end, items) && items >= 0;
+                            corners.clear();
+                            for (int64_t item = 0; item < items && ok[i]; item++) {
+                                int64_t index;
+                                ok[i] = _integer(p, line_end, index) && index >= 0;
+                                corners.push_back(uint32_t(std::min<int64_t>(index, UINT32_MAX)));
+                            }
+                            if (ok[i] && int(k) == ply.indices) ok[i] = _fan(corners.data(), corners.size(), vertices, triangles[i]);
+                        }
+                    }
+                    if (!ok[i]) break;
+                    p = line_end;
+                    if (++r == current.count) {
+                        e++;
+                        r = 0;
+                        while (e < ply.elements.size() && ply.elements[e].count == 0) e++;
+                    }
+                }
+            }
+        });
+
+        // Append the triangles in order, and move on past the lines
+        for (size_t i = 0; i < count; i++) {
+            if (!ok[i]) return SIZE_MAX;
+            out.indices.insert(out.indices.end(), triangles[i].begin(), triangles[i].end());
+        }
+        size_t r = ply.record + lines[count];
+        while (ply.element < ply.elements.size() && r >= ply.elements[ply.element].count) r -= ply.elements[ply.element++].count;
+        ply.record = ply.element < ply.elements.size() ? r : 0;
+        return used;
+
+    }
+
+    /**
+     * Reads the binary body of a PLY file a window at a time
+     */
+    static size_t _ply_binary(_Ply& ply, Mesh& out, bool faces, const char* data, size_t size) {
+        size_t used = 0;
+        const size_t vertices = ply.elements[ply.vertex].count;
+        std::vector<uint32_t> corners;
+        while (ply.element < ply.elements.size()) {
+            const _PlyElement& element = ply.elements[ply.element];
+            size_t remaining = element.count - ply.record;
+            if (element.stride > 0) {
+
+                // Records of a fixed size: take as many as are here, decoding vertices in
+                // parallel straight into place
+                size_t count = std::min(remaining, (size - used) / element.stride);
+                if (int(ply.element) == ply.vertex) {
+                    size_t offsets[5];
+                    for (int c = 0; c < 5; c++) {
+                        offsets[c] = 0;
+                        for (int k = 0; k < ply.coordinates[c]; k++) offsets[c] += _ply_size(element.properties[k].type);
+                    }
+                    const char* records = data + used;
+                    size_t first_record = ply.record;
+                    parallel::for_range(0, count, grain / element.stride + 1, [&](size_t begin, size_t end) {
+                        for (size_t i = begin; i < end; i++) {
+                            const char* record = records + i * element.stride;
+                            for (int c = 0; c < 5; c++) {
+                                if (ply.coordinates[c] < 0 || (c >= 3 && !ply.has_uvs())) continue;
+                                float value = float(_ply_value(record + offsets[c], element.properties[ply.coordinates[c]].type, ply.swap));
+                                if (c < 3) out.positions.component(c)[first_record + i] = value;
+                                else out.uvs.component(c - 3)[first_record + i] = value;
+                            }
+                        }
+                    });
+                }
+                used += count * element.stride;
+                ply.record += count;
+                if (ply.record < element.count) return used;
+
+            } else {
+
+                // Records holding lists, one at a time
+                for (; ply.record < element.count; ply.record++) {
+                    size_t at = used;
+                    for (size_t k = 0; k < element.properties.size(); k++) {
+                        const _PlyProperty& property = element.properties[k];
+                        if (!property.list) {
+                            at += _ply_size(property.type);
+                            continue;
+                        }
+                        if (at + _ply_size(property.count_type) > size) return used;
+                        double items = _ply_value(data + at, property.count_type, ply.swap);
+                        if (!(items >= 0)) return SIZE_MAX;
+                        at += _ply_size(property.count_type);
+                        size_t item_size = _ply_size(property.type);
+                        if (at + size_t(items) * item_size > size) return used;
+                        if (int(ply.element) == ply.face && int(k) == ply.indices && faces) {
+                            corners.clear();
+                            for (size_t item = 0; item < size_t(items); item++) {
+                                double index = _ply_value(data + at + item * item_size, property.type, ply.swap);
+                                corners.push_back(index >= 0 && index < double(UINT32_MAX) ? uint32_t(index) : UINT32_MAX);
+                            }
+                            if (!_fan(corners.data(), corners.size(), vertices, out.indices)) return SIZE_MAX;
+                        }
+                        at += size_t(items) * item_size;
+                    }
+                    if (at > size) return used;
+                    used = at;
+                }
+
+            }
+            ply.element++;
+            ply.record = 0;
+        }
+        return used;
+    }
+
+    static bool _ply(_Source& source, Mesh& out, bool faces) {
+        out = Mesh();
+        _Ply ply;
+        bool started = false;
+        std::vector<size_t> bounds;
+        std::vector<std::vector<uint32_t>> triangles;
+        bool ok = _stream(source, [&](const char* data, size_t size, bool eof) -> size_t {
+
+            // Read the header from the start of the first window, and size the output
+            size_t used = 0;
+            if (!started) {
+                const char* marker = nullptr;
+                for (const char* p = data; p < data + size && marker == nullptr; p = _line_end(p, data + size) + 1) {
+                    if (size_t(data + size - p) >= 10 && std::memcmp(p, "end_header", 10) == 0) marker = p;
+                }
+                if (marker == nullptr) return eof ? SIZE_MAX : 0;
+                used = _line_end(marker, data + size) + 1 - data;
+                if (used > size || !ply.header(data, used)) return SIZE_MAX;
+                started = true;
+                out.positions.resize(ply.elements[ply.vertex].count);
+                if (ply.has_uvs()) out.uvs.resize(ply.elements[ply.vertex].count);
+                if (faces && ply.face >= 0) out.indices.reserve(ply.elements[ply.face].count * 3);
+                while (ply.element < ply.elements.size() && ply.elements[ply.element].count == 0) ply.element++;
+            }
+
+            // Then as much of the body as there is
+            if (ply.element == ply.elements.size()) return size;
+            size_t body = ply.format == _Ply::ascii
+                ? _ply_ascii(ply, out, faces, data + used, size - used, eof, bounds, triangles)
+                : _ply_binary(ply, out, faces, data + used, size - used);
+            if (body == SIZE_MAX) return SIZE_MAX;
+            if (eof && ply.element < ply.elements.size()) return SIZE_MAX;
+            return used + body;
+
+        });
+        return ok && started && ply.element == ply.elements.size();
+    }
+
+    static bool _load(const char* path, Mesh& out, bool faces, bool (*load)(_Source&, Mesh&, bool)) {
+        _Source source;
+        source.file = std::fopen(path, "rb");
+        if (source.file == nullptr) return false;
+        bool ok = load(source, out, faces);
+        return std::fclose(source.file) == 0 && ok;
+    }
+
+    static bool _parse(const char* data, size_t length, Mesh& out, bool faces, bool (*load)(_Source&, Mesh&, bool)) {
+        _Source source;
+        source.data = data;
+        source.length = length;
+        return load(source, out, faces);
+    }
+
+    /**
+     * Loads an OBJ file into a mesh. Vertices whose corners use different texture coordinates
+     * are duplicated, so that each vertex has one.
+     */
+    static bool load_obj(const char* path, Mesh& out) {
+        return _load(path, out, true, _obj);
+    }
+
+    /**
+     * Loads just the vertex positions of an OBJ file
+     */
+    static bool load_obj(const char* path, Vec3Soa& out) {
+        Mesh mesh;
+        bool ok = _load(path, mesh, false, _obj);
+        out = std::move(mesh.positions);
+        return ok;
+    }
+
+    /**
+     * Parses OBJ text that's already in memory into a mesh
+     */
+    static bool parse_obj(const char* text, size_t length, Mesh& out) {
+        return _parse(text, length, out, true, _obj);
+    }
+
+    /**
+     * Loads a PLY file into a mesh. A point cloud gives a mesh without triangles.
+     */
+    static bool load_ply(const char* path, Mesh& out) {
+        return _load(path, out, true, _ply);
+    }
+
+    /**
+     * Loads just the vertex positions of a PLY file
+     */
+    static bool load_ply(const char* path, Vec3Soa& out) {
+        Mesh mesh;
+        bool ok = _load(path, mesh, false, _ply);
+        out = std::move(mesh.positions);
+        return ok;
+    }
+
+    /**
+     * Parses a PLY file that's already in memory into a mesh
+     */
+    static bool parse_ply(const char* data, size_t length, Mesh& out) {
+        return _parse(data, length, out, true, _ply);
+    }
+
+}
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace e3d::utils::parallel {
+
+    /**
+     * A fixed set of worker threads pulling tasks from a shared queue
+     */
+    class ThreadPool {
+    public:
+
+        /**
+         * Starts `workers` threads. Zero is allowed, in which case all work runs on the caller.
+         */
+        explicit ThreadPool(size_t workers) : stopping(false) {
+            for (size_t i = 0; i < workers; i++) this->threads.emplace_back([this]() { this->work(); });
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        /**
+         * Finishes the queued tasks and joins the workers
+         */
+        ~ThreadPool() {
+            {
+                std::lock_guard<std::mutex> lock(this->mutex);
+                this->stopping = true;
+            }
+            this->wake.notify_all();
+            for (std::thread& thread : this->threads) thread.join();
+        }
+
+        /**
+         * The number of worker threads, not counting callers that help out
+         */
+        size_t size() const { return this->threads.size(); }
+
+        /**
+         * Queues a task to run on one of the workers
+         */
+        void submit(std::function<void()> task) {
+            {
+                std::lock_guard<std::mutex> lock(this->mutex);
+                this->tasks.push_back(std::move(task));
+            }
+            this->wake.notify_one();
+        }
+
+    private:
+
+        void work() {
+            while (true) {
+
+                // Wait for a task, or for the pool to shut down
+                std::function<void()> task;
+                {
+                    std::unique_lock<std::mutex> lock(this->mutex);
+                    this->wake.wait(lock, [this]() { return this->stopping || !this->tasks.empty(); });
+                    if (this->tasks.empty()) return;
+                    task = std::move(this->tasks.front());
+                    this->tasks.pop_front();
+                }
+
+                // Run it outside of the lock
+                task();
+
+            }
+        }
+
+        std::vector<std::thread> threads;
+        std::deque<std::function<void()>> tasks;
+        std::mutex mutex;
+        std::condition_variable wake;
+        bool stopping;
+
+    };
+
+    /**
+     * The pool shared by every parallel algorithm in the library. It has one worker less than
+     * the number of hardware threads, since callers always work alongside it. The E3D_THREADS
+     * environment variable overrides the total number of threads (ie. 1 runs everything on
+     * the calling thread).
+     */
+    inline ThreadPool& pool() {
+        static ThreadPool shared([]() -> size_t {
+            const char* env = std::getenv("E3D_THREADS");
+            long threads = env != nullptr ? std::atol(env) : long(std::thread::hardware_concurrency());
+            return threads > 1 ? size_t(threads - 1) : 0;
+        }());
+        return shared;
+    }
+
+    /**
+     * The number of threads that parallel algorithms spread their work over
+     */
+    inline size_t thread_count() {
+        return pool().size() + 1;
+    }
+
+    /**
+     * Splits [begin, end) into chunks of at least `grain` items and calls `fn(chunk_begin,
+     * chunk_end)` for each one, across the shared pool and the calling thread. Blocks until
+     * every chunk is done. Chunks may run in any order, and `fn` must not throw.
+     *
+     * Calling this from inside `fn` is allowed: the caller always processes chunks itself, so
+     * nested loops can't deadlock waiting on a busy pool.
+     */
+    template<class Fn>
+    void for_range(size_t begin, size_t end, size_t grain, Fn&& fn) {
+
+        // Small ranges, or a single thread, just run inline
+        size_t count = end > begin ? end - begin : 0;
+        size_t threads = thread_count();
+        grain = std::max<size_t>(grain, 1);
+        if (count == 0) return;
+        if (count <= grain || threads == 1) {
+            fn(begin, end);
+            return;
+        }
+
+        // A few chunks per thread keeps them busy when chunks take uneven time
+        size_t chunks = std::min((count + grain - 1) / grain, threads * 4);
+        size_t chunk_size = (count + chunks - 1) / chunks;
+        chunks = (count + chunk_size - 1) / chunk_size;
+
+        // Shared state outlives this call, since helpers may start after the work is done
+        struct Job {
+            std::atomic<size_t> next { 0 };
+            std::atomic<size_t> done { 0 };
+            std::mutex mutex;
+            std::condition_variable finished;
+        };
+        std::shared_ptr<Job> job = std::make_shared<Job>();
+
+        // Claims and runs chunks until there are none left
+        auto run = [job, chunks, chunk_size, begin, end, &fn]() {
+            size_t chunk;
+            while ((chunk = job->next.fetch_add(1)) < chunks) {
+                size_t chunk_begin = begin + chunk * chunk_size;
+                fn(chunk_begin, std::min(end, chunk_begin + chunk_size));
+                if (job->done.fetch_add(1) + 1 == chunks) {
+                    std::lock_guard<std::mutex> lock(job->mutex);
+                    job->finished.notify_all();
+                }
+            }
+        };
+
+        // Recruit helpers, work on the calling thread too, then wait for stragglers
+        size_t helpers = std::min(chunks - 1, pool().size());
+        for (size_t i = 0; i < helpers; i++) pool().submit(run);
+        run();
+        std::unique_lock<std::mutex> lock(job->mutex);
+        job->finished.wait(lock, [&job, chunks]() { return job->done.load() == chunks; });
+
+    }
+
+}
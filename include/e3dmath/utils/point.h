@@ -25,6 +25,31 @@ namespace e3d::utils::point {
         );
     }
 
+    /**
+     * Calculates the squared distance between two points, which orders points the same way as
+     * `distance` without taking a square root
+     */
+    template<uint8_t S>
+    static float distance2(const Point<S>& left, const Point<S>& right) {
+        Vec<S> offset = between(left, right);
+        return e3d::utils::vec::dot(offset, offset);
+    }
+
+    /**
+     * Overloads taking unevaluated expressions for either point
+     */
+    template<class L, class Rt, uint8_t S>
+    static Vec<S> between(const MatExpr<L, S, 1>& from, const MatExpr<Rt, S, 1>& to) {
+        return to - from;
+    }
+
+    template<class L, class Rt, uint8_t S>
+    static float distance(const MatExpr<L, S, 1>& left, const MatExpr<Rt, S, 1>& right) {
+        return e3d::utils::vec::magnitude(
+            between(left, right)
+        );
+    }
+
     /**
      * Calculates the normal vector from the provided triangle. This is not templated
      * because cross-product is always a three-dimensional operation, and the number
@@ -1,11 +1,29 @@
 #pragma once
 
+#include <algorithm>
 #include <cinttypes>
+#include <cmath>
+#include <vector>
 #include "../types/polygon.h"
+#include "../simd/lanes.h"
 #include "./point.h"
+#include "./parallel.h"
+
+#define E3D_SIMD_KERNELS "kernels/polygon.inl"
+#include "../simd/foreach_target.h"
 
 namespace e3d::utils::polygon {
 
+    /**
+     * The number of polygons in each block of the batch functions
+     */
+    constexpr size_t batch_grain = 1 << 14;
+
+    template<uint8_t P, uint8_t S>
+    static float _batch_area_kernel(const float* polys, bool sign, float* out, size_t begin, size_t end) {
+        E3D_SIMD_DISPATCH(polygon::area<P, S>(polys, sign, out, begin, end));
+    }
+
     /**
      * Calculates the normal vector from the provided triangle. This is not templated
      * because cross-product is always a three-dimensional operation, and the number
@@ -23,43 +41,116 @@ namespace e3d::utils::polygon {
     }
 
     /**
-     * Calculates the area of a polygon
+     * Calculates twice the signed area of a 2D polygon, by the shoelace formula. It's
+     * positive when the points are counter-clockwise.
      */
-    template<uint8_t P, uint8_t S>
-    static float area(const Polygon<P, S>& poly) {
+    template<uint8_t P>
+    static float _twice_signed_area(const Polygon<P, 2>& poly) {
 
-        // The total area
+        // Fan out from the first point, which keeps the products small for polygons far
+        // from the origin
         float sum = 0;
+        Vec2 a = poly.points[1] - poly.points[0];
+        for (uint8_t i = 2; i < P; i++) {
+            Vec2 b = poly.points[i] - poly.points[0];
+            sum += a.data[0] * b.data[1] - b.data[0] * a.data[1];
+            a = b;
+        }
+        return sum;
 
-        // Save the side_b value after each, and reuse it for side_a on the next iteration.
-        // This is an optimization and is not a requirement of the underlying math.
-        float side_b;
+    }
 
-        // Loop through all of the points
-        for (uint8_t i = 1; i < P - 1; i++) {
+    /**
+     * Calculates the signed area of a 2D polygon. It's positive when the points are
+     * counter-clockwise, and negative when they're clockwise.
+     */
+    template<uint8_t P>
+    static float signed_area(const Polygon<P, 2>& poly) {
+        return _twice_signed_area(poly) * 0.5f;
+    }
+
+    /**
+     * Calculates the area of a polygon. 2D polygons use the shoelace formula, and planar 3D
+     * polygons the length of their vector area (the sum of the cross products fanned from
+     * the first point), so both work for concave polygons. Other dimensions add up the
+     * triangles fanned from the first point.
+     */
+    template<uint8_t P, uint8_t S>
+    static float area(const Polygon<P, S>& poly) {
 
-            // Get the length to the two points
-            float side_a = i == 1
-                ? e3d::utils::point::distance(poly.points[0], poly.points[i])
-                : side_b;
+        // The shoelace formula
+        if constexpr (S == 2) return fabsf(_twice_signed_area(poly)) * 0.5f;
+
+        // The vector area
+        else if constexpr (S == 3) {
+            float n[3] = { 0, 0, 0 };
+            Vec3 a = poly.points[1] - poly.points[0];
+            for (uint8_t i = 2; i < P; i++) {
+                Vec3 b = poly.points[i] - poly.points[0];
+                n[0] += a.data[1] * b.data[2] - a.data[2] * b.data[1];
+                n[1] += a.data[2] * b.data[0] - a.data[0] * b.data[2];
+                n[2] += a.data[0] * b.data[1] - a.data[1] * b.data[0];
+                a = b;
+            }
+            return sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]) * 0.5f;
+        }
 
-            // Get the side-b value
-            side_b = e3d::utils::point::distance(poly.points[0], poly.points[i + 1]);
+        // Each triangle's area from its edges, by Lagrange's identity:
+        // |a x b|^2 = |a|^2 |b|^2 - (a . b)^2
+        else {
+            float sum = 0;
+            Vec<S> a = poly.points[1] - poly.points[0];
+            for (uint8_t i = 2; i < P; i++) {
+                Vec<S> b = poly.points[i] - poly.points[0];
+                float aa = e3d::utils::vec::dot(a, a), bb = e3d::utils::vec::dot(b, b), ab = e3d::utils::vec::dot(a, b);
+                sum += sqrtf(fmaxf(aa * bb - ab * ab, 0.0f)) * 0.5f;
+                a = b;
+            }
+            return sum;
+        }
 
-            // Calculate the area between them
-            float between_edge = e3d::utils::point::distance(poly.points[i], poly.points[i + 1]);
+    }
 
-            // Calculate half of the permieter
-            float hp = (side_a + side_b + between_edge) * 0.5f;
+    template<uint8_t P, uint8_t S>
+    static float _batch_area(const Polygon<P, S>* polys, size_t count, bool sign, float* out) {
+        static_assert(S == 2 || S == 3, "Batch areas are only possible in 2 or 3 dimensions");
+        static_assert(sizeof(Polygon<P, S>) == sizeof(float) * P * S, "Polygons must be tightly packed");
+        const float* data = polys[0].points[0].data;
+
+        // Fixed blocks, so the total is summed in the same order however many threads there are
+        size_t blocks = (count + batch_grain - 1) / batch_grain;
+        std::vector<double> totals(blocks);
+        e3d::utils::parallel::for_range(0, blocks, 1, [&](size_t begin, size_t end) {
+            for (size_t block = begin; block < end; block++) {
+                size_t first = block * batch_grain, last = std::min(count, first + batch_grain);
+                totals[block] = _batch_area_kernel<P, S>(data, sign, out, first, last);
+            }
+        });
 
-            // Lastly, calculate the area of this triangle
-            sum += sqrtf(hp * (hp - side_a) * (hp - side_b) * (hp - between_edge));
+        // Add up the blocks
+        double total = 0;
+        for (double block_total : totals) total += block_total;
+        return float(total);
 
-        }
+    }
 
-        // Return the sum area
-        return sum;
+    /**
+     * Calculates the area of each polygon in an array into `out`, and returns the total.
+     * `out` may be null if only the total is needed. Polygons are processed 4, 8 or 16 at a
+     * time depending on the SIMD level, across the thread pool.
+     */
+    template<uint8_t P, uint8_t S>
+    static float area(const Polygon<P, S>* polys, size_t count, float* out = nullptr) {
+        return count == 0 ? 0.0f : _batch_area(polys, count, false, out);
+    }
 
+    /**
+     * Calculates the signed area of each 2D polygon in an array into `out`, and returns the
+     * total. `out` may be null if only the total is needed.
+     */
+    template<uint8_t P>
+    static float signed_area(const Polygon<P, 2>* polys, size_t count, float* out = nullptr) {
+        return count == 0 ? 0.0f : _batch_area(polys, count, true, out);
     }
 
     /**
@@ -1,20 +1,24 @@
 #pragma once
 
 #include "../types/mat.h"
+#include "./trig.h"
+#include "./fast_math.h"
 #include <cmath>
 
 namespace e3d::utils::projection {
 
     /**
-     * Creates a perspective projection matrix
+     * Creates a perspective projection matrix. Pass `Order::col_major` for one that can be
+     * uploaded to the GPU as is.
      */
-    static Mat4 mat4_create_perspective(float fov, float ratio, float near, float far) {
+    template<Order O = Order::row_major, class Math = DefaultMath>
+    static constexpr Mat<4, 4, O> mat4_create_perspective(float fov, float ratio, float near, float far, Math = Math()) {
 
         // Calculate the correct scale for the display, vertically
-        float tanfov = tanf(fov / 2.0f * M_PI / 180.0f);
+        float tanfov = Math::tan(fov / 2.0f * M_PI / 180.0f);
 
         // Create the result matrix
-        Mat4 mat = Mat4::zeros();
+        Mat<4, 4, O> mat = Mat<4, 4, O>::zeros();
         mat.set(0, 0, 1.0f / (ratio * tanfov));
         mat.set(1, 1, 1.0f / tanfov);
         mat.set(2, 2, -(far + near) / (far - near));
@@ -29,10 +33,11 @@ namespace e3d::utils::projection {
     /**
      * Creates an orthographic projection matrix
      */
-    static Mat4 mat4_create_orthographic(float left, float right, float bottom, float top, float near, float far) {
+    template<Order O = Order::row_major>
+    static constexpr Mat<4, 4, O> mat4_create_orthographic(float left, float right, float bottom, float top, float near, float far) {
 
         // Create the result matrix
-        Mat4 mat = Mat4::zeros();
+        Mat<4, 4, O> mat = Mat<4, 4, O>::zeros();
         mat.set(0, 0, 2.0f / (right - left));
         mat.set(1, 1, 2.0f / (top - bottom));
         mat.set(2, 2, -2.0f / (far - near));
@@ -0,0 +1,296 @@
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+#include <cmath>
+#include "../types/quat.h"
+#include "../types/affine.h"
+#include "../simd/lanes.h"
+#include "./trig.h"
+#include "./vec.h"
+#include "./parallel.h"
+
+#define E3D_SIMD_KERNELS "kernels/quat.inl"
+#include "../simd/foreach_target.h"
+
+namespace e3d::utils::quat {
+
+    /**
+     * The number of quaternions each thread takes at a time in the batch functions
+     */
+    constexpr size_t grain = 1 << 14;
+
+    /**
+     * Creates a rotation of `angle` radians around a unit-length axis
+     */
+    static constexpr Quat quat_create_axis_angle(const Vec3& axis, float angle) {
+        float s = trig::sin(angle * 0.5f);
+        return Quat(axis.get(0) * s, axis.get(1) * s, axis.get(2) * s, trig::cos(angle * 0.5f));
+    }
+
+    /**
+     * Creates a rotation of `x` radians on the x-axis
+     */
+    static constexpr Quat quat_create_rotation_x(float x) {
+        return Quat(trig::sin(x * 0.5f), 0, 0, trig::cos(x * 0.5f));
+    }
+
+    /**
+     * Creates a rotation of `y` radians on the y-axis
+     */
+    static constexpr Quat quat_create_rotation_y(float y) {
+        return Quat(0, trig::sin(y * 0.5f), 0, trig::cos(y * 0.5f));
+    }
+
+    /**
+     * Creates a rotation of `z` radians on the z-axis
+     */
+    static constexpr Quat quat_create_rotation_z(float z) {
+        return Quat(0, 0, trig::sin(z * 0.5f), trig::cos(z * 0.5f));
+    }
+
+    /**
+     * Creates the same rotation as `utils::mat::mat4_create_rotation_yxz`. That matrix is the
+     * transpose of Ry * Rx * Rz, so this is the conjugate of qy * qx * qz, which expands to
+     * the product of the three inverse rotations in reverse.
+     */
+    static constexpr Quat quat_create_rotation_yxz(float x, float y, float z) {
+        return quat_create_rotation_z(-z) * quat_create_rotation_x(-x) * quat_create_rotation_y(-y);
+    }
+
+    /**
+     * Calculates the dot product of two quaternions
+     */
+    static constexpr float dot(const Quat& left, const Quat& right) {
+        return left.x() * right.x() + left.y() * right.y() + left.z() * right.z() + left.w() * right.w();
+    }
+
+    /**
+     * Scales a quaternion to unit length. A (near) zero quaternion becomes the identity.
+     */
+    static Quat normalize(const Quat& quat) {
+
+        // Get the magnitude
+        float mag = sqrtf(dot(quat, quat));
+
+        // If the magnitude is zero, there's no rotation to keep
+        if (mag <= 0.00001) return Quat::identity();
+
+        // Divide each component by the magnitude
+        return Quat(quat.x() / mag, quat.y() / mag, quat.z() / mag, quat.w() / mag);
+
+    }
+
+    /**
+     * Calculates the inverse of a quaternion. For unit quaternions, `conjugate()` gives the
+     * same result for less work.
+     */
+    static constexpr Quat inverse(const Quat& quat) {
+        float length_squared = dot(quat, quat);
+        if (length_squared == 0) return Quat();
+        Quat conj = quat.conjugate();
+        return Quat(conj.x() / length_squared, conj.y() / length_squared, conj.z() / length_squared, conj.w() / length_squared);
+    }
+
+    /**
+     * Rotates a vector by a unit quaternion. This costs 15 multiplications, against 9 for an
+     * existing 3x3 matrix, but skips building the matrix when a rotation is used only once.
+     */
+    static constexpr Vec3 rotate(const Quat& quat, const Vec3& vec) {
+
+        // t = 2 * cross(q.xyz, v)
+        Vec3 axis = quat.xyz();
+        Vec3 t = utils::vec::cross(axis, vec) * 2.0f;
+
+        // v' = v + w * t + cross(q.xyz, t)
+        return vec + t * quat.w() + utils::vec::cross(axis, t);
+
+    }
+
+    /**
+     * Converts a unit quaternion into a rotation matrix
+     */
+    template<Order O = Order::row_major>
+    static constexpr Mat<4, 4, O> to_mat4(const Quat& quat) {
+
+        // Get the products of the components
+        const float x = quat.x(), y = quat.y(), z = quat.z(), w = quat.w();
+        const float xx = x * x, yy = y * y, zz = z * z;
+        const float xy = x * y, xz = x * z, yz = y * z;
+        const float wx = w * x, wy = w * y, wz = w * z;
+
+        // Create the matrix
+        Mat<4, 4, O> result;
+        result.set(0, 0, 1 - 2 * (yy + zz));
+        result.set(0, 1, 2 * (xy - wz));
+        result.set(0, 2, 2 * (xz + wy));
+        result.set(1, 0, 2 * (xy + wz));
+        result.set(1, 1, 1 - 2 * (xx + zz));
+        result.set(1, 2, 2 * (yz - wx));
+        result.set(2, 0, 2 * (xz - wy));
+        result.set(2, 1, 2 * (yz + wx));
+        result.set(2, 2, 1 - 2 * (xx + yy));
+        result.set(3, 3, 1);
+
+        // Return the result
+        return result;
+
+    }
+
+    /**
+     * Converts a unit quaternion into an affine rotation
+     */
+    static constexpr Affine3 to_affine3(const Quat& quat) {
+        return Affine3::from_mat4(to_mat4(quat));
+    }
+
+    /**
+     * Extracts the rotation from the top-left 3x3 of a matrix, which must be a pure rotation
+     * (orthonormal, with no scale)
+     */
+    static Quat from_mat4(const Mat4& mat) {
+
+        // Pick the largest of the four diagonal combinations, to divide by something large
+        const float* m = mat.data;
+        float trace = m[0] + m[5] + m[10];
+        Quat result;
+        if (trace > 0) {
+            float s = sqrtf(trace + 1) * 2;
+            result = Quat((m[9] - m[6]) / s, (m[2] - m[8]) / s, (m[4] - m[1]) / s, s * 0.25f);
+        } else if (m[0] > m[5] && m[0] > m[10]) {
+            float s = sqrtf(1 + m[0] - m[5] - m[10]) * 2;
+            result = Quat(s * 0.25f, (m[1] + m[4]) / s, (m[2] + m[8]) / s, (m[9] - m[6]) / s);
+        } else if (m[5] > m[10]) {
+            float s = sqrtf(1 + m[5] - m[0] - m[10]) * 2;
+            result = Quat((m[1] + m[4]) / s, s * 0.25f, (m[6] + m[9]) / s, (m[2] - m[8]) / s);
+        } else {
+            float s = sqrtf(1 + m[10] - m[0] - m[5]) * 2;
+            result = Quat((m[2] + m[8]) / s, (m[6] + m[9]) / s, s * 0.25f, (m[4] - m[1]) / s);
+        }
+
+        // Clean up rounding in the input
+        return normalize(result);
+
+    }
+
+    /**
+     * Extracts the rotation from an affine transform with no scale
+     */
+    static Quat from_affine3(const Affine3& affine) {
+        return from_mat4(affine.to_mat4());
+    }
+
+    /**
+     * Blends two unit quaternions linearly and normalizes the result, taking the shorter way
+     * around. Cheaper than `slerp`, but the angular speed isn't constant across `t`.
+     */
+    static Quat nlerp(const Quat& from, const Quat& to, float t) {
+
+        // Flip the target onto the same hemisphere
+        float sign = dot(from, to) < 0 ? -1.0f : 1.0f;
+
+        // Blend each component, in the same order as the batch kernel
+        float values[4];
+        for (int i = 0; i < 4; i++) values[i] = t * (to.data[i] * sign - from.data[i]) + from.data[i];
+
+        // Normalize the result
+        float mag = sqrtf(values[0] * values[0] + values[1] * values[1] + values[2] * values[2] + values[3] * values[3]);
+        return Quat(values[0] / mag, values[1] / mag, values[2] / mag, values[3] / mag);
+
+    }
+
+    /**
+     * Blends two unit quaternions along the arc between them, at constant angular speed,
+     * taking the shorter way around
+     */
+    static Quat slerp(const Quat& from, const Quat& to, float t) {
+
+        // Flip the target onto the same hemisphere
+        float cos_theta = dot(from, to);
+        float sign = cos_theta < 0 ? -1.0f : 1.0f;
+        cos_theta = std::fabs(cos_theta);
+
+        // Very close rotations would divide by nearly zero, and blend linearly just as well
+        float weight_from = 1 - t;
+        float weight_to = t;
+        if (cos_theta < 0.9999995f) {
+            float theta = acosf(cos_theta);
+            float sin_theta = sinf(theta);
+            weight_from = sinf((1 - t) * theta) / sin_theta;
+            weight_to = sinf(t * theta) / sin_theta;
+        }
+        weight_to *= sign;
+
+        // Blend the two rotations
+        return Quat(
+            weight_from * from.x() + weight_to * to.x(),
+            weight_from * from.y() + weight_to * to.y(),
+            weight_from * from.z() + weight_to * to.z(),
+            weight_from * from.w() + weight_to * to.w()
+        );
+
+    }
+
+    static void _multiply(const float* a, const float* b, float* out, size_t begin, size_t end) {
+        E3D_SIMD_DISPATCH(quat::multiply(a, b, out, begin, end));
+    }
+
+    static void _nlerp(const float* a, const float* b, const float* t, bool per_element, float* out, size_t begin, size_t end) {
+        E3D_SIMD_DISPATCH(quat::nlerp(a, b, t, per_element, out, begin, end));
+    }
+
+    static void _slerp(const float* a, const float* b, const float* t, bool per_element, float* out, size_t begin, size_t end) {
+        E3D_SIMD_DISPATCH(quat::slerp(a, b, t, per_element, out, begin, end));
+    }
+
+    /**
+     * Multiplies `count` pairs of quaternions, `out[i] = a[i] * b[i]`. With SSE2 the results
+     * are bit-for-bit identical to `Quat::multiply`; with AVX2 and AVX-512 the sums are fused
+     * multiply-adds. `out` may be `a` or `b`.
+     */
+    static void multiply(const Quat* a, const Quat* b, Quat* out, size_t count) {
+        parallel::for_range(0, count, grain, [&](size_t begin, size_t end) {
+            _multiply(reinterpret_cast<const float*>(a), reinterpret_cast<const float*>(b), reinterpret_cast<float*>(out), begin, end);
+        });
+    }
+
+    /**
+     * Blends `count` pairs of quaternions with `nlerp`, all by the same amount `t`. With SSE2
+     * the results are bit-for-bit identical to `nlerp`. `out` may be `from` or `to`.
+     */
+    static void nlerp(const Quat* from, const Quat* to, float t, Quat* out, size_t count) {
+        parallel::for_range(0, count, grain, [&](size_t begin, size_t end) {
+            _nlerp(reinterpret_cast<const float*>(from), reinterpret_cast<const float*>(to), &t, false, reinterpret_cast<float*>(out), begin, end);
+        });
+    }
+
+    /**
+     * Blends `count` pairs of quaternions with `nlerp`, each by its own amount `t[i]`
+     */
+    static void nlerp(const Quat* from, const Quat* to, const float* t, Quat* out, size_t count) {
+        parallel::for_range(0, count, grain, [&](size_t begin, size_t end) {
+            _nlerp(reinterpret_cast<const float*>(from), reinterpret_cast<const float*>(to), t, true, reinterpret_cast<float*>(out), begin, end);
+        });
+    }
+
+    /**
+     * Blends `count` pairs of quaternions along their arcs, all by the same amount `t`. The
+     * arc weights come from a polynomial instead of trig calls (see simd/kernels/quat.inl),
+     * which is within 2e-7 of the exact weights used by `slerp`. `out` may be `from` or `to`.
+     */
+    static void slerp(const Quat* from, const Quat* to, float t, Quat* out, size_t count) {
+        parallel::for_range(0, count, grain, [&](size_t begin, size_t end) {
+            _slerp(reinterpret_cast<const float*>(from), reinterpret_cast<const float*>(to), &t, false, reinterpret_cast<float*>(out), begin, end);
+        });
+    }
+
+    /**
+     * Blends `count` pairs of quaternions along their arcs, each by its own amount `t[i]`
+     */
+    static void slerp(const Quat* from, const Quat* to, const float* t, Quat* out, size_t count) {
+        parallel::for_range(0, count, grain, [&](size_t begin, size_t end) {
+            _slerp(reinterpret_cast<const float*>(from), reinterpret_cast<const float*>(to), t, true, reinterpret_cast<float*>(out), begin, end);
+        });
+    }
+
+}
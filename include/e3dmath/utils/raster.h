@@ -0,0 +1,357 @@
+#pragma once
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstddef>
+#include <cmath>
+#include <vector>
+#include "../types/mat.h"
+#include "../types/point.h"
+#include "../types/polygon.h"
+#include "../types/mesh.h"
+#include "../types/depth_buffer.h"
+#include "../simd/lanes.h"
+#include "./parallel.h"
+#include "./transform.h"
+
+#define E3D_SIMD_KERNELS "kernels/raster.inl"
+#include "../simd/foreach_target.h"
+
+/**
+ * A software rasterizer for depth and visibility maps. Triangles are transformed into clip
+ * space by a view-projection matrix (see utils/projection.h), clipped against the view
+ * volume, divided through by w and mapped onto the pixels of a DepthBuffer, with normalized
+ * device coordinate y = 1 at the top row and depth running from 0 at the near plane to 1 at
+ * the far one.
+ *
+ * Work happens in two passes across the shared thread pool (see utils/parallel.h). First,
+ * fixed blocks of triangles are clipped, set up and sorted into bins by the square tiles of
+ * the screen they touch. Then each tile is drawn by one thread, which goes through the
+ * triangles in its bins in order and evaluates their edge functions a register of pixels at a
+ * time (see simd/cpu.h).
+ *
+ * A pixel is covered when its center is inside a triangle. Vertices are snapped to 1/256 of a
+ * pixel, and the two triangles on either side of an edge evaluate exactly the same edge
+ * function with opposite signs, so pixels along shared edges are drawn exactly once, with
+ * exact zeros going to the triangle the edge is on the top or left of. Triangles are
+ * double-sided, and a pixel only takes a triangle if it's strictly nearer than what's there,
+ * so the image is the same however many threads draw it, and depth ties go to the lowest
+ * triangle index.
+ */
+namespace e3d::utils::raster {
+
+    /**
+     * The width and height of a screen tile, in pixels
+     */
+    constexpr size_t tile_size = 64;
+
+    /**
+     * The number of triangles each thread sets up and bins at a time
+     */
+    constexpr size_t grain = 1 << 12;
+
+    /**
+     * The fraction of a pixel that screen positions are snapped to. Snapped positions stay
+     * exact as floats for targets up to 32768 pixels across.
+     */
+    constexpr float subpixels = 256.0f;
+
+    /**
+     * A clipped triangle in screen space: pixel positions and depths of its corners, its
+     * depth gradient, and the pixels whose centers it might cover
+     */
+    struct _Triangle {
+        float x[3];
+        float y[3];
+        float z[3];
+        float dzdx;
+        float dzdy;
+        float sign;
+        uint32_t id;
+        uint32_t x0, x1, y0, y1;
+    };
+
+    /**
+     * The triangles of one block, and the ones in each tile, in compressed sparse row form
+     */
+    struct _Bins {
+        std::vector<_Triangle> triangles;
+        std::vector<uint32_t> offsets;
+        std::vector<uint32_t> entries;
+    };
+
+    static void _clip(const float* mat, const float* const* positions, float* const* out, size_t begin, size_t end) {
+        E3D_SIMD_DISPATCH(raster::clip(mat, positions, out, begin, end));
+    }
+
+    static void _triangle(const float* edges, uint32_t top_left, const float* plane, uint32_t id,
+        size_t x0, size_t x1, size_t y0, size_t y1, float* depth, uint32_t* ids) {
+        E3D_SIMD_DISPATCH(raster::triangle(edges, top_left, plane, id, x0, x1, y0, y1, tile_size, depth, ids));
+    }
+
+    /**
+     * Where the edge from `a` to `b` crosses a clipping plane, given their distances from it.
+     * It's always worked out from the lesser endpoint, so both triangles sharing an edge get
+     * exactly the same point.
+     */
+    static void _intersect(const float* a, float da, const float* b, float db, float* out) {
+        if (std::lexicographical_compare(b, b + 4, a, a + 4)) {
+            std::swap(a, b);
+            std::swap(da, db);
+        }
+        float t = da / (da - db);
+        for (int c = 0; c < 4; c++) out[c] = a[c] + t * (b[c] - a[c]);
+    }
+
+    /**
+     * The distance of a clip space point inside each plane of the view volume, -w <= x, y, z
+     * <= w
+     */
+    static float _inside(const float* point, int plane) {
+        return plane % 2 == 0 ? point[3] + point[plane / 2] : point[3] - point[plane / 2];
+    }
+
+    /**
+     * Rounds a screen position to the nearest subpixel. Adding and taking away 1.5 * 2^52
+     * leaves a double rounded to a whole number, without a call into the math library.
+     */
+    static float _snap(float position) {
+        const double magic = 6755399441055744.0;
+        return float((double(position) * subpixels + magic) - magic) / subpixels;
+    }
+
+    /**
+     * Clips a triangle of clip space corners against the view volume and appends what's left
+     * of it to `out`, as a fan of screen space triangles
+     */
+    static void _setup(const float (&corners)[3][4], uint32_t id, size_t width, size_t height, std::vector<_Triangle>& out) {
+
+        // Find the planes the corners are outside, and drop the triangle if they're all
+        // outside one of them
+        uint32_t outside = 0;
+        for (int plane = 0; plane < 6; plane++) {
+            int count = 0;
+            for (int k = 0; k < 3; k++) count += _inside(corners[k], plane) >= 0 ? 0 : 1;
+            if (count == 3) return;
+            if (count > 0) outside |= 1u << plane;
+        }
+
+        // Clip against each plane that cuts it
+        float polygons[2][9][4];
+        size_t count = 3;
+        for (int k = 0; k < 3; k++) std::copy(corners[k], corners[k] + 4, polygons[0][k]);
+        int current = 0;
+        for (int plane = 0; plane < 6; plane++) {
+            if (!(outside & (1u << plane))) continue;
+            float (*in)[4] = polygons[current];
+            float (*next)[4] = polygons[1 - current];
+            size_t kept = 0;
+            for (size_t k = 0; k < count; k++) {
+                const float* a = in[k];
+                const float* b = in[(k + 1) % count];
+                float da = _inside(a, plane), db = _inside(b, plane);
+                if (da >= 0) std::copy(a, a + 4, next[kept++]);
+                if ((da >= 0) != (db >= 0)) _intersect(a, da, b, db, next[kept++]);
+            }
+            count = kept;
+            current = 1 - current;
+            if (count < 3) return;
+        }
+
+        // Divide through by w, map onto the pixels and snap
+        float x[9], y[9], z[9];
+        const float (*polygon)[4] = polygons[current];
+        for (size_t k = 0; k < count; k++) {
+            float w = polygon[k][3];
+            if (!(w > 0)) return;
+            float half = 0.5f / w;
+            x[k] = _snap((polygon[k][0] * half + 0.5f) * float(width));
+            y[k] = _snap((0.5f - polygon[k][1] * half) * float(height));
+            z[k] = polygon[k][2] * half + 0.5f;
+        }
+
+        // Split it into a fan
+        for (size_t k = 1; k + 1 < count; k++) {
+            _Triangle tri;
+            size_t fan[3] = { 0, k, k + 1 };
+            for (int c = 0; c < 3; c++) {
+                tri.x[c] = x[fan[c]];
+                tri.y[c] = y[fan[c]];
+                tri.z[c] = z[fan[c]];
+            }
+
+            // Skip it if it has no area, and otherwise find its depth gradient. Snapped
+            // positions make the area exact in double precision.
+            double ux = double(tri.x[1]) - tri.x[0], uy = double(tri.y[1]) - tri.y[0], uz = double(tri.z[1]) - tri.z[0];
+            double vx = double(tri.x[2]) - tri.x[0], vy = double(tri.y[2]) - tri.y[0], vz = double(tri.z[2]) - tri.z[0];
+            double area = ux * vy - vx * uy;
+            if (area == 0) continue;
+            double inverse_area = 1.0 / area;
+            tri.dzdx = float((uz * vy - vz * uy) * inverse_area);
+            tri.dzdy = float((ux * vz - vx * uz) * inverse_area);
+            tri.sign = area > 0 ? 1 : -1;
+            tri.id = id;
+
+            // Find the pixels whose centers it might cover
+            float low_x = std::min({ tri.x[0], tri.x[1], tri.x[2] }), high_x = std::max({ tri.x[0], tri.x[1], tri.x[2] });
+            float low_y = std::min({ tri.y[0], tri.y[1], tri.y[2] }), high_y = std::max({ tri.y[0], tri.y[1], tri.y[2] });
+            double x0 = std::max(std::ceil(low_x - 0.5), 0.0), x1 = std::min(std::floor(high_x - 0.5), double(width) - 1);
+            double y0 = std::max(std::ceil(low_y - 0.5), 0.0), y1 = std::min(std::floor(high_y - 0.5), double(height) - 1);
+            if (x0 > x1 || y0 > y1) continue;
+            tri.x0 = uint32_t(x0);
+            tri.x1 = uint32_t(x1) + 1;
+            tri.y0 = uint32_t(y0);
+            tri.y1 = uint32_t(y1) + 1;
+            out.push_back(tri);
+        }
+
+    }
+
+    /**
+     * Draws the parts of a triangle inside the tile whose top-left pixel is (tx, ty)
+     */
+    static void _draw(const _Triangle& tri, size_t tx, size_t ty, size_t width, size_t height, float* depth, uint32_t* ids) {
+
+        // Work out each edge function relative to the tile, from the lesser of its endpoints
+        // so that the triangle on the other side gets exactly the same one
+        float edges[9];
+        uint32_t top_left = 0;
+        for (int k = 0; k < 3; k++) {
+            int j = (k + 1) % 3;
+            bool reversed = tri.y[j] < tri.y[k] || (tri.y[j] == tri.y[k] && tri.x[j] < tri.x[k]);
+            int p = reversed ? j : k, q = reversed ? k : j;
+            double px = double(tri.x[p]) - double(tx), py = double(tri.y[p]) - double(ty);
+            double qx = double(tri.x[q]) - double(tx), qy = double(tri.y[q]) - double(ty);
+            double sign = reversed ? -tri.sign : tri.sign;
+            float a = float(sign * (py - qy)), b = float(sign * (qx - px));
+            edges[k * 3 + 0] = a;
+            edges[k * 3 + 1] = b;
+            edges[k * 3 + 2] = float(sign * (px * qy - py * qx));
+            if (a > 0 || (a == 0 && b > 0)) top_left |= 1u << k;
+        }
+
+        // And its depth
+        float plane[3] = {
+            tri.dzdx,
+            tri.dzdy,
+            float(tri.z[0] + double(tri.dzdx) * (double(tx) - tri.x[0]) + double(tri.dzdy) * (double(ty) - tri.y[0]))
+        };
+
+        // Then draw the pixels it might cover within the tile
+        size_t x0 = std::max<size_t>(tri.x0, tx) - tx, x1 = std::min<size_t>({ tri.x1, tx + tile_size, width }) - tx;
+        size_t y0 = std::max<size_t>(tri.y0, ty) - ty, y1 = std::min<size_t>({ tri.y1, ty + tile_size, height }) - ty;
+        _triangle(edges, top_left, plane, tri.id, x0, x1, y0, y1, depth, ids);
+
+    }
+
+    template<class Corners>
+    static void _render(size_t count, const Corners& corners, DepthBuffer& target) {
+        size_t width = target.width, height = target.height;
+        if (count == 0 || width == 0 || height == 0) return;
+        size_t tiles_x = (width + tile_size - 1) / tile_size, tiles_y = (height + tile_size - 1) / tile_size;
+        size_t tiles = tiles_x * tiles_y;
+
+        // Set up fixed blocks of triangles, and sort each block's into the tiles they touch
+        size_t blocks = (count + grain - 1) / grain;
+        std::vector<_Bins> bins(blocks);
+        parallel::for_range(0, blocks, 1, [&](size_t first, size_t last) {
+            float clip[3][4];
+            for (size_t block = first; block < last; block++) {
+                _Bins& bin = bins[block];
+                size_t begin = block * grain, end = std::min(count, begin + grain);
+                bin.triangles.reserve(end - begin);
+                for (size_t i = begin; i < end; i++) {
+                    corners(i, clip);
+                    _setup(clip, uint32_t(i), width, height, bin.triangles);
+                }
+
+                // Count the triangles in each tile, then list them in order
+                bin.offsets.assign(tiles + 1, 0);
+                for (const _Triangle& tri : bin.triangles) {
+                    for (size_t y = tri.y0 / tile_size; y <= (tri.y1 - 1) / tile_size; y++) {
+                        for (size_t x = tri.x0 / tile_size; x <= (tri.x1 - 1) / tile_size; x++) bin.offsets[y * tiles_x + x + 1]++;
+                    }
+                }
+                for (size_t tile = 0; tile < tiles; tile++) bin.offsets[tile + 1] += bin.offsets[tile];
+                std::vector<uint32_t> next(bin.offsets.begin(), bin.offsets.end() - 1);
+                bin.entries.resize(bin.offsets[tiles]);
+                for (size_t t = 0; t < bin.triangles.size(); t++) {
+                    const _Triangle& tri = bin.triangles[t];
+                    for (size_t y = tri.y0 / tile_size; y <= (tri.y1 - 1) / tile_size; y++) {
+                        for (size_t x = tri.x0 / tile_size; x <= (tri.x1 - 1) / tile_size; x++) bin.entries[next[y * tiles_x + x]++] = uint32_t(t);
+                    }
+                }
+            }
+        });
+
+        // Draw each tile into a copy of its pixels, going through the blocks in order
+        parallel::for_range(0, tiles, 1, [&](size_t first, size_t last) {
+            alignas(64) float depth[tile_size * tile_size];
+            alignas(64) uint32_t ids[tile_size * tile_size];
+            uint32_t* tile_ids = target.has_ids() ? ids : nullptr;
+            for (size_t tile = first; tile < last; tile++) {
+                bool empty = true;
+                for (const _Bins& bin : bins) empty = empty && bin.offsets[tile] == bin.offsets[tile + 1];
+                if (empty) continue;
+                size_t tx = tile % tiles_x * tile_size, ty = tile / tiles_x * tile_size;
+                size_t columns = std::min(tile_size, width - tx), rows = std::min(tile_size, height - ty);
+                for (size_t y = 0; y < rows; y++) {
+                    std::copy_n(target.depth.data() + (ty + y) * width + tx, columns, depth + y * tile_size);
+                    if (tile_ids) std::copy_n(target.ids.data() + (ty + y) * width + tx, columns, ids + y * tile_size);
+                }
+                for (const _Bins& bin : bins) {
+                    for (uint32_t e = bin.offsets[tile]; e < bin.offsets[tile + 1]; e++) {
+                        _draw(bin.triangles[bin.entries[e]], tx, ty, width, height, depth, tile_ids);
+                    }
+                }
+                for (size_t y = 0; y < rows; y++) {
+                    std::copy_n(depth + y * tile_size, columns, target.depth.data() + (ty + y) * width + tx);
+                    if (tile_ids) std::copy_n(ids + y * tile_size, columns, target.ids.data() + (ty + y) * width + tx);
+                }
+            }
+        });
+
+    }
+
+    /**
+     * Draws the triangles of a mesh into `target`, keeping whichever is nearest at each
+     * pixel. Pixels take the index of the triangle drawn there, if the target keeps them.
+     * Nothing is cleared first, so several draws can share one target.
+     */
+    static void draw(const MeshView& mesh, const Mat4& view_projection, DepthBuffer& target) {
+
+        // Transform the vertices into clip space
+        size_t vertices = mesh.positions.size;
+        std::vector<float> clip(vertices * 4);
+        float* streams[4] = { clip.data(), clip.data() + vertices, clip.data() + vertices * 2, clip.data() + vertices * 3 };
+        parallel::for_range(0, vertices, transform::grain, [&](size_t begin, size_t end) {
+            _clip(view_projection.data, mesh.positions.data, streams, begin, end);
+        });
+
+        // Then draw the triangles between them
+        _render(mesh.triangle_count, [&](size_t i, float (&corners)[3][4]) {
+            for (int k = 0; k < 3; k++) {
+                uint32_t vertex = mesh.indices[i * 3 + k];
+                for (int c = 0; c < 4; c++) corners[k][c] = streams[c][vertex];
+            }
+        }, target);
+
+    }
+
+    /**
+     * Draws an array of triangles into `target`, like the mesh version
+     */
+    static void draw(const Tri3* triangles, size_t count, const Mat4& view_projection, DepthBuffer& target) {
+        const float* m = view_projection.data;
+        _render(count, [&](size_t i, float (&corners)[3][4]) {
+            for (int k = 0; k < 3; k++) {
+                const Point3& point = triangles[i].points[k];
+                for (int r = 0; r < 4; r++) {
+                    const float* row = m + r * 4;
+                    corners[k][r] = ((row[0] * point.data[0] + row[1] * point.data[1]) + row[2] * point.data[2]) + row[3];
+                }
+            }
+        }, target);
+    }
+
+}
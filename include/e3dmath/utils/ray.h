@@ -0,0 +1,216 @@
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+#include <cmath>
+#include <vector>
+#include "../types/vec.h"
+#include "../types/point.h"
+#include "../types/polygon.h"
+#include "../types/ray.h"
+#include "../types/vec_soa.h"
+#include "../simd/lanes.h"
+#include "./vec.h"
+#include "./parallel.h"
+
+#define E3D_SIMD_KERNELS "kernels/ray.inl"
+#include "../simd/foreach_target.h"
+
+/**
+ * Ray/triangle intersection by the Möller–Trumbore algorithm. Triangles are double-sided, and
+ * a hit counts if its distance along the ray is within [0, t_max].
+ *
+ * Besides single rays, there are packet versions that test a register of rays against one
+ * triangle, or one ray against a register of triangles, 4, 8 or 16 at a time depending on the
+ * SIMD level (see simd/cpu.h). Rays in packets are SoA streams, and triangles are read
+ * straight from arrays of Tri3. Large batches are split across the shared thread pool (see
+ * utils/parallel.h).
+ *
+ * With SSE2 the packet results are bit-for-bit identical to `intersect` on each pair; with
+ * AVX2 and AVX-512 the dot products are fused multiply-adds.
+ */
+namespace e3d::utils::ray {
+
+    /**
+     * The number of ray/triangle tests each thread takes at a time
+     */
+    constexpr size_t grain = 1 << 14;
+
+    /**
+     * The index of a miss
+     */
+    constexpr uint32_t none = UINT32_MAX;
+
+    static void _rays(const float* const* origins, const float* const* directions, const float* tri, float t_max,
+        float* t, float* u, float* v, size_t begin, size_t end) {
+        E3D_SIMD_DISPATCH(ray::rays(origins, directions, tri, t_max, t, u, v, begin, end));
+    }
+
+    static void _triangles(const float* ray, const float* tris, float t_max, float* t, float* u, float* v, size_t begin, size_t end) {
+        E3D_SIMD_DISPATCH(ray::triangles(ray, tris, t_max, t, u, v, begin, end));
+    }
+
+    static void _closest(const float* ray, const float* tris, float* best, uint32_t& best_index, size_t begin, size_t end) {
+        E3D_SIMD_DISPATCH(ray::closest(ray, tris, best, best_index, begin, end));
+    }
+
+    static void _closest_rays(const float* const* origins, const float* const* directions, const float* tris, size_t count, float t_max,
+        float* t, float* u, float* v, uint32_t* index, size_t begin, size_t end) {
+        E3D_SIMD_DISPATCH(ray::closest_rays(origins, directions, tris, count, t_max, t, u, v, index, begin, end));
+    }
+
+    static void _flatten(const Ray3& ray, float* out) {
+        for (int c = 0; c < 3; c++) {
+            out[c] = ray.origin.get(c);
+            out[3 + c] = ray.direction.get(c);
+        }
+    }
+
+    /**
+     * Intersects a ray with a triangle. On a hit, fills in the distance and barycentric
+     * coordinates of `hit`, and leaves its triangle index alone.
+     */
+    static bool intersect(const Ray3& ray, const Tri3& tri, RayHit& hit, float t_max = INFINITY) {
+
+        // Rays parallel to the triangle miss it
+        Vec3 e1 = tri.points[1] - tri.points[0];
+        Vec3 e2 = tri.points[2] - tri.points[0];
+        Vec3 p = e3d::utils::vec::cross(ray.direction, e2);
+        float det = e3d::utils::vec::dot(e1, p);
+        if (det == 0) return false;
+        float inverse_det = 1.0f / det;
+
+        // Find the barycentric coordinates, and check they're inside the triangle
+        Vec3 s = ray.origin - tri.points[0];
+        float u = e3d::utils::vec::dot(s, p) * inverse_det;
+        if (u < 0 || u > 1) return false;
+        Vec3 q = e3d::utils::vec::cross(s, e1);
+        float v = e3d::utils::vec::dot(ray.direction, q) * inverse_det;
+        if (v < 0 || u + v > 1) return false;
+
+        // Find the distance, which must be in range
+        float t = e3d::utils::vec::dot(e2, q) * inverse_det;
+        if (t < 0 || t > t_max) return false;
+        hit.t = t;
+        hit.u = u;
+        hit.v = v;
+        return true;
+
+    }
+
+    /**
+     * Intersects a packet of rays with one triangle. Each ray's distance and barycentric
+     * coordinates go in `t`, `u` and `v`, with misses at a distance of infinity.
+     */
+    static void intersect(const VecSoaView<3>& origins, const VecSoaView<3>& directions, const Tri3& tri,
+        float* t, float* u, float* v, float t_max = INFINITY) {
+
+        // The first corner and the edges from it
+        float edges[9];
+        for (int c = 0; c < 3; c++) {
+            edges[c] = tri.points[0].get(c);
+            edges[3 + c] = tri.points[1].get(c) - tri.points[0].get(c);
+            edges[6 + c] = tri.points[2].get(c) - tri.points[0].get(c);
+        }
+
+        // Test the rays
+        parallel::for_range(0, origins.size, grain, [&](size_t begin, size_t end) {
+            _rays(origins.data, directions.data, edges, t_max, t, u, v, begin, end);
+        });
+
+    }
+
+    /**
+     * Intersects one ray with each of `count` triangles. Each triangle's distance and
+     * barycentric coordinates go in `t`, `u` and `v`, with misses at a distance of infinity.
+     */
+    static void intersect(const Ray3& ray, const Tri3* tris, size_t count, float* t, float* u, float* v, float t_max = INFINITY) {
+        static_assert(sizeof(Tri3) == sizeof(float) * 9, "Triangles must be tightly packed");
+        float flat[6];
+        _flatten(ray, flat);
+        parallel::for_range(0, count, grain, [&](size_t begin, size_t end) {
+            _triangles(flat, tris[0].points[0].data, t_max, t, u, v, begin, end);
+        });
+    }
+
+    /**
+     * Finds the closest of `count` triangles that the ray hits, ie. to pick from a small
+     * scene without building a BVH. The hit's triangle is an index into `tris`, and ties go
+     * to the lowest index.
+     */
+    static bool closest(const Ray3& ray, const Tri3* tris, size_t count, RayHit& hit, float t_max = INFINITY) {
+        static_assert(sizeof(Tri3) == sizeof(float) * 9, "Triangles must be tightly packed");
+        float flat[6];
+        _flatten(ray, flat);
+
+        // Find the closest hit in fixed blocks, so ties are broken the same however many
+        // threads there are
+        size_t blocks = (count + grain - 1) / grain;
+        std::vector<float> bests(blocks * 3, t_max);
+        std::vector<uint32_t> indices(blocks, none);
+        parallel::for_range(0, blocks, 1, [&](size_t first, size_t last) {
+            for (size_t block = first; block < last; block++) {
+                size_t begin = block * grain;
+                _closest(flat, tris[0].points[0].data, &bests[block * 3], indices[block], begin, std::min(count, begin + grain));
+            }
+        });
+
+        // Take the closest block, the earliest on ties
+        hit.triangle = none;
+        for (size_t block = 0; block < blocks; block++) {
+            if (indices[block] == none || (hit.triangle != none && bests[block * 3] >= hit.t)) continue;
+            hit.t = bests[block * 3];
+            hit.u = bests[block * 3 + 1];
+            hit.v = bests[block * 3 + 2];
+            hit.triangle = indices[block];
+        }
+        return hit.triangle != none;
+
+    }
+
+    /**
+     * Finds the closest of `count` triangles that each ray in a packet hits. Misses get a
+     * distance of `t_max` and a triangle of `none`.
+     */
+    static void closest(const VecSoaView<3>& origins, const VecSoaView<3>& directions, const Tri3* tris, size_t count, RayHit* hits, float t_max = INFINITY) {
+        static_assert(sizeof(Tri3) == sizeof(float) * 9, "Triangles must be tightly packed");
+        size_t rays = origins.size;
+
+        // Without any triangles every ray misses, and there's no triangle data to point at
+        if (count == 0) {
+            for (size_t i = 0; i < rays; i++) {
+                hits[i].t = t_max;
+                hits[i].u = hits[i].v = 0;
+                hits[i].triangle = none;
+            }
+            return;
+        }
+
+        // Each thread takes enough rays for roughly `grain` tests
+        size_t ray_grain = std::max<size_t>(1, grain / std::max<size_t>(1, count));
+        parallel::for_range(0, rays, ray_grain, [&](size_t begin, size_t end) {
+
+            // Find the hits into SoA scratch space, then copy them out
+            size_t size = end - begin;
+            std::vector<float> scratch(size * 3);
+            std::vector<uint32_t> indices(size);
+            const float* chunk_origins[3];
+            const float* chunk_directions[3];
+            for (int c = 0; c < 3; c++) {
+                chunk_origins[c] = origins.data[c] + begin;
+                chunk_directions[c] = directions.data[c] + begin;
+            }
+            _closest_rays(chunk_origins, chunk_directions, tris[0].points[0].data, count, t_max,
+                scratch.data(), scratch.data() + size, scratch.data() + size * 2, indices.data(), 0, size);
+            for (size_t i = 0; i < size; i++) {
+                hits[begin + i].t = scratch[i];
+                hits[begin + i].u = scratch[size + i];
+                hits[begin + i].v = scratch[size * 2 + i];
+                hits[begin + i].triangle = indices[i];
+            }
+
+        });
+
+    }
+
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+#include "../types/mat.h"
+#include "../types/point.h"
+#include "../types/vec_soa.h"
+#include "../simd/lanes.h"
+#include "./parallel.h"
+
+#define E3D_SIMD_KERNELS "kernels/transform.inl"
+#include "../simd/foreach_target.h"
+
+/**
+ * Applies one matrix to large buffers of points and vectors. The work is vectorized (see
+ * simd/cpu.h) and split across the shared thread pool (see utils/parallel.h).
+ *
+ * With SSE2 the results are bit-for-bit identical to `mat * utils::vec::resize<4>(...)` with
+ * the matching w, signs of zero included; with AVX2 and AVX-512 the sums are fused
+ * multiply-adds.
+ *
+ * `src` and `dst` may be the same buffer, but must not otherwise overlap.
+ */
+namespace e3d::utils::transform {
+
+    /**
+     * The number of vectors each thread takes at a time. Smaller inputs run on the caller.
+     */
+    constexpr size_t grain = 1 << 15;
+
+    static void _aos3(const float* mat, const float* src, float* dst, size_t begin, size_t end, bool point) {
+        if (point) { E3D_SIMD_DISPATCH(transform::aos3<true>(mat, src, dst, begin, end)); }
+        else { E3D_SIMD_DISPATCH(transform::aos3<false>(mat, src, dst, begin, end)); }
+    }
+
+    static void _padded3(const float* mat, const float* src, float* dst, size_t begin, size_t end, bool point) {
+        if (point) { E3D_SIMD_DISPATCH(transform::padded3<true>(mat, src, dst, begin, end)); }
+        else { E3D_SIMD_DISPATCH(transform::padded3<false>(mat, src, dst, begin, end)); }
+    }
+
+    static void _aos4(const float* mat, const float* src, float* dst, size_t begin, size_t end) {
+        E3D_SIMD_DISPATCH(transform::aos4(mat, src, dst, begin, end));
+    }
+
+    static void _soa3(const float* mat, const float* const* src, float* const* dst, size_t begin, size_t end, bool point) {
+        if (point) { E3D_SIMD_DISPATCH(transform::soa3<true>(mat, src, dst, begin, end)); }
+        else { E3D_SIMD_DISPATCH(transform::soa3<false>(mat, src, dst, begin, end)); }
+    }
+
+    static void _soa4(const float* mat, const float* const* src, float* const* dst, size_t begin, size_t end) {
+        E3D_SIMD_DISPATCH(transform::soa4(mat, src, dst, begin, end));
+    }
+
+    /**
+     * Transforms `count` points, treating each as (x, y, z, 1) and keeping xyz of the result.
+     * No perspective divide is done.
+     */
+    static void transform_points(const Mat4& mat, const Point3* src, Point3* dst, size_t count) {
+        parallel::for_range(0, count, grain, [&](size_t begin, size_t end) {
+            _aos3(mat.data, reinterpret_cast<const float*>(src), reinterpret_cast<float*>(dst), begin, end, true);
+        });
+    }
+
+    /**
+     * Transforms `count` directions, treating each as (x, y, z, 0) so translation is ignored
+     */
+    static void transform_directions(const Mat4& mat, const Vec3* src, Vec3* dst, size_t count) {
+        parallel::for_range(0, count, grain, [&](size_t begin, size_t end) {
+            _aos3(mat.data, reinterpret_cast<const float*>(src), reinterpret_cast<float*>(dst), begin, end, false);
+        });
+    }
+
+    /**
+     * Transforms `count` 4-component vectors with their own w
+     */
+    static void transform_vecs(const Mat4& mat, const Vec4* src, Vec4* dst, size_t count) {
+        parallel::for_range(0, count, grain, [&](size_t begin, size_t end) {
+            _aos4(mat.data, reinterpret_cast<const float*>(src), reinterpret_cast<float*>(dst), begin, end);
+        });
+    }
+
+    /**
+     * Transforms `count` padded points, treating each as (x, y, z, 1). Each point is one
+     * aligned 16-byte load, so this skips the shuffling that packed points need.
+     */
+    static void transform_points(const Mat4& mat, const Point3Padded* src, Point3Padded* dst, size_t count) {
+        parallel::for_range(0, count, grain, [&](size_t begin, size_t end) {
+            _padded3(mat.data, reinterpret_cast<const float*>(src), reinterpret_cast<float*>(dst), begin, end, true);
+        });
+    }
+
+    /**
+     * Transforms `count` padded directions, treating each as (x, y, z, 0)
+     */
+    static void transform_directions(const Mat4& mat, const Vec3Padded* src, Vec3Padded* dst, size_t count) {
+        parallel::for_range(0, count, grain, [&](size_t begin, size_t end) {
+            _padded3(mat.data, reinterpret_cast<const float*>(src), reinterpret_cast<float*>(dst), begin, end, false);
+        });
+    }
+
+    /**
+     * Transforms SoA points, treating each as (x, y, z, 1)
+     */
+    static void transform_points(const Mat4& mat, const VecSoaView<3>& src, const VecSoaSpan<3>& dst) {
+        parallel::for_range(0, src.size, grain, [&](size_t begin, size_t end) {
+            _soa3(mat.data, src.data, dst.data, begin, end, true);
+        });
+    }
+
+    /**
+     * Transforms SoA directions, treating each as (x, y, z, 0)
+     */
+    static void transform_directions(const Mat4& mat, const VecSoaView<3>& src, const VecSoaSpan<3>& dst) {
+        parallel::for_range(0, src.size, grain, [&](size_t begin, size_t end) {
+            _soa3(mat.data, src.data, dst.data, begin, end, false);
+        });
+    }
+
+    /**
+     * Transforms SoA 4-component vectors with their own w
+     */
+    static void transform_vecs(const Mat4& mat, const VecSoaView<4>& src, const VecSoaSpan<4>& dst) {
+        parallel::for_range(0, src.size, grain, [&](size_t begin, size_t end) {
+            _soa4(mat.data, src.data, dst.data, begin, end);
+        });
+    }
+
+}
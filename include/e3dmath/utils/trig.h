@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cmath>
+#include "../config.h"
+
+/**
+ * Trig functions that can be used in constant expressions. At runtime they call straight
+ * through to <cmath>, so results are unchanged. At compile-time they are evaluated with a
+ * double precision series, which rounds to the same float as <cmath> in all but rare cases
+ * (and is then off by one bit).
+ */
+namespace e3d::utils::trig {
+
+    /**
+     * Sine of an angle in [-pi/2, pi/2], as a Taylor series
+     */
+    static constexpr double _sin_reduced(double x) {
+        double term = x;
+        double sum = x;
+        for (int i = 1; i < 12; i++) {
+            term *= -x * x / ((2 * i) * (2 * i + 1));
+            sum += term;
+        }
+        return sum;
+    }
+
+    /**
+     * Sine of any angle, reduced into [-pi/2, pi/2] first
+     */
+    static constexpr double _sin(double x) {
+
+        // Wrap into [-pi, pi]
+        constexpr double tau = 2.0 * M_PI;
+        double turns = x / tau;
+        long long whole = (long long)(turns < 0 ? turns - 0.5 : turns + 0.5);
+        x -= double(whole) * tau;
+
+        // Mirror into [-pi/2, pi/2], since sin(pi - x) = sin(x)
+        if (x > M_PI / 2) x = M_PI - x;
+        if (x < -M_PI / 2) x = -M_PI - x;
+        return _sin_reduced(x);
+
+    }
+
+    /**
+     * Calculates the sine of `x` radians
+     */
+    static constexpr float sin(float x) {
+        if (!E3D_CONSTANT_EVALUATED()) return sinf(x);
+        return float(_sin(x));
+    }
+
+    /**
+     * Calculates the cosine of `x` radians
+     */
+    static constexpr float cos(float x) {
+        if (!E3D_CONSTANT_EVALUATED()) return cosf(x);
+        return float(_sin(double(x) + M_PI / 2));
+    }
+
+    /**
+     * Calculates the tangent of `x` radians
+     */
+    static constexpr float tan(float x) {
+        if (!E3D_CONSTANT_EVALUATED()) return tanf(x);
+        return float(_sin(x) / _sin(double(x) + M_PI / 2));
+    }
+
+}
@@ -2,12 +2,13 @@
 
 #include <cinttypes>
 #include "../types/vec.h"
+#include "./fast_math.h"
 
 namespace e3d::utils::vec {
 
     template<uint8_t S>
-    static Vec<S> i_axis(uint8_t index) {
-        float values[S];
+    static constexpr Vec<S> i_axis(uint8_t index) {
+        float values[S] = {};
         for (uint8_t i = 0; i < S; i++) {
             values[i] = i == index ? 1.0 : 0.0;
         }
@@ -15,19 +16,19 @@ namespace e3d::utils::vec {
     }
 
     template<uint8_t S>
-    static Vec<S> x_axis() { return i_axis<S>(0); }
+    static constexpr Vec<S> x_axis() { return i_axis<S>(0); }
 
     template<uint8_t S>
-    static Vec<S> y_axis() { return i_axis<S>(1); }
+    static constexpr Vec<S> y_axis() { return i_axis<S>(1); }
 
     template<uint8_t S>
-    static Vec<S> z_axis() { return i_axis<S>(2); }
+    static constexpr Vec<S> z_axis() { return i_axis<S>(2); }
 
     /**
      * Calculates the dot product of two vectors
      */
     template<uint8_t S>
-    static float dot(const Vec<S>& left, const Vec<S>& right) {
+    static constexpr float dot(const Vec<S>& left, const Vec<S>& right) {
 
         // Start at zero
         float dot = 0;
@@ -44,7 +45,7 @@ namespace e3d::utils::vec {
      * Calculates the cross product of two vectors
      */
     template<uint8_t S>
-    static Vec<S> cross(const Vec<S>& left, const Vec<S>& right) {
+    static constexpr Vec<S> cross(const Vec<S>& left, const Vec<S>& right) {
         static_assert(S == 3, "Cross product only possible in 3-dimensions");
 
         // Create the result vector
@@ -87,8 +88,21 @@ namespace e3d::utils::vec {
 
     }
 
-    template<uint8_t S>
-    static Vec<S> normalize(const Vec<S>& vec) {
+    /**
+     * Scales a vector to unit length. A vector with a magnitude of (nearly) zero becomes a zero
+     * vector. With `FastMath` it's multiplied by an approximate reciprocal square root instead
+     * of divided by its magnitude, unless its squared magnitude overflows a float (components
+     * past about 1e19), where it takes the precise path.
+     */
+    template<uint8_t S, class Math = DefaultMath>
+    static Vec<S> normalize(const Vec<S>& vec, Math = Math()) {
+
+        // Fast: scale by the reciprocal square root of the squared magnitude
+        if constexpr (Math::approximate) {
+            float sum = dot(vec, vec);
+            if (sum <= 0.00001f * 0.00001f) return Vec<S>::zeros();
+            if (sum <= std::numeric_limits<float>::max()) return vec * Math::rsqrt(sum);
+        }
 
         // Get the magnitude of the matrix
         float mag = magnitude(vec);
@@ -102,7 +116,7 @@ namespace e3d::utils::vec {
     }
 
     template<uint8_t Sto, uint8_t Sfrom>
-    static Vec<Sto> resize(const Vec<Sfrom>& vec) {
+    static constexpr Vec<Sto> resize(const Vec<Sfrom>& vec) {
 
         // Create the new vector
         Vec<Sto> result;
@@ -119,14 +133,30 @@ namespace e3d::utils::vec {
     }
 
     /**
-     * Calculates the angle between two vectors
+     * Calculates the angle between two vectors. With `FastMath` the cosine is found with an
+     * approximate reciprocal square root of each squared magnitude and clamped to [-1, 1]
+     * before the arc cosine. Its error is magnified for (nearly) parallel vectors, where the
+     * arc cosine is steepest: up to 1e-3 radians, against 5e-4 with `PreciseMath`. Squared
+     * magnitudes outside the normal float range (magnitudes past about 1e-19 to 1e19) take
+     * the precise path.
      */
-    template<uint8_t S>
-    static float angle_between(const Vec<S>& left, const Vec<S>& right) {
+    template<uint8_t S, class Math = DefaultMath>
+    static float angle_between(const Vec<S>& left, const Vec<S>& right, Math = Math()) {
 
         // Get the dot product
         float dot_product = dot(left, right);
 
+        // Fast: multiply by both reciprocal magnitudes, separately so that their product can't
+        // overflow or underflow
+        if constexpr (Math::approximate) {
+            float left2 = dot(left, left), right2 = dot(right, right);
+            constexpr float lowest = std::numeric_limits<float>::min(), highest = std::numeric_limits<float>::max();
+            if (left2 >= lowest && left2 <= highest && right2 >= lowest && right2 <= highest) {
+                float cos_theta = dot_product * Math::rsqrt(left2) * Math::rsqrt(right2);
+                return Math::acos(cos_theta < -1 ? -1 : cos_theta > 1 ? 1 : cos_theta);
+            }
+        }
+
         // Divide it by the magnitudes
         float cos_theta = dot_product / magnitude(left) / magnitude(right);
 
@@ -135,4 +165,38 @@ namespace e3d::utils::vec {
 
     }
 
+    /**
+     * Overloads taking unevaluated expressions (ie. `normalize(a - b)`). Each evaluates its
+     * arguments once and calls through to the function above.
+     */
+    template<class L, class Rt, uint8_t S>
+    static constexpr float dot(const MatExpr<L, S, 1>& left, const MatExpr<Rt, S, 1>& right) {
+        return dot<S>(eval(left), eval(right));
+    }
+
+    template<class L, class Rt, uint8_t S>
+    static constexpr Vec<S> cross(const MatExpr<L, S, 1>& left, const MatExpr<Rt, S, 1>& right) {
+        return cross<S>(eval(left), eval(right));
+    }
+
+    template<class E, uint8_t S>
+    static float magnitude(const MatExpr<E, S, 1>& vec) {
+        return magnitude<S>(eval(vec));
+    }
+
+    template<class E, uint8_t S, class Math = DefaultMath>
+    static Vec<S> normalize(const MatExpr<E, S, 1>& vec, Math math = Math()) {
+        return normalize<S>(eval(vec), math);
+    }
+
+    template<uint8_t Sto, class E, uint8_t Sfrom>
+    static constexpr Vec<Sto> resize(const MatExpr<E, Sfrom, 1>& vec) {
+        return resize<Sto, Sfrom>(eval(vec));
+    }
+
+    template<class L, class Rt, uint8_t S, class Math = DefaultMath>
+    static float angle_between(const MatExpr<L, S, 1>& left, const MatExpr<Rt, S, 1>& right, Math math = Math()) {
+        return angle_between<S>(eval(left), eval(right), math);
+    }
+
 }
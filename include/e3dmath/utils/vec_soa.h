@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cinttypes>
+#include "../types/vec_soa.h"
+#include "../simd/lanes.h"
+#include "./fast_math.h"
+
+#define E3D_SIMD_KERNELS "kernels/vec_soa.inl"
+#include "../simd/foreach_target.h"
+
+/**
+ * Batch versions of the functions in utils/vec.h, operating on SoA streams. These process 4,
+ * 8 or 16 vectors per instruction depending on the SIMD level (see simd/cpu.h).
+ *
+ * With SSE2 the results are bit-for-bit identical to calling utils::vec on each vector. With
+ * AVX2 and AVX-512 the sums are fused multiply-adds, so they may differ in the last bit.
+ * `normalize` multiplies by a float reciprocal where utils::vec rounds it through a double,
+ * which can also differ in the last bit.
+ *
+ * Output buffers must hold `size` elements and must not alias the inputs, except that
+ * `normalize` may write over its input.
+ */
+namespace e3d::utils::vec_soa {
+
+    /**
+     * Calculates the dot product of each pair of vectors
+     */
+    template<uint8_t S>
+    static void dot(const VecSoaView<S>& left, const VecSoaView<S>& right, float* out) {
+        E3D_SIMD_DISPATCH(vec_soa::dot<S>(left.data, right.data, out, left.size));
+    }
+
+    /**
+     * Calculates the cross product of each pair of vectors
+     */
+    template<uint8_t S>
+    static void cross(const VecSoaView<S>& left, const VecSoaView<S>& right, const VecSoaSpan<S>& out) {
+        static_assert(S == 3, "Cross product only possible in 3-dimensions");
+        E3D_SIMD_DISPATCH(vec_soa::cross(left.data, right.data, out.data, left.size));
+    }
+
+    /**
+     * Calculates the magnitude of each vector
+     */
+    template<uint8_t S>
+    static void magnitude(const VecSoaView<S>& vecs, float* out) {
+        E3D_SIMD_DISPATCH(vec_soa::magnitude<S>(vecs.data, out, vecs.size));
+    }
+
+    /**
+     * Normalizes each vector. Vectors with a magnitude of (nearly) zero become zero vectors.
+     */
+    template<uint8_t S>
+    static void normalize(const VecSoaView<S>& vecs, const VecSoaSpan<S>& out) {
+        E3D_SIMD_DISPATCH(vec_soa::normalize<S>(vecs.data, out.data, vecs.size));
+    }
+
+    template<uint8_t S>
+    static void _cos_between_clamped(const VecSoaView<S>& left, const VecSoaView<S>& right, float* out) {
+        E3D_SIMD_DISPATCH(vec_soa::cos_between_clamped<S>(left.data, right.data, out, left.size));
+    }
+
+    /**
+     * Calculates the angle between each pair of vectors, in radians. With `FastMath` the
+     * cosines are clamped to [-1, 1] and go through the batch arc cosine in utils::fast_math,
+     * rather than <cmath> one at a time.
+     */
+    template<uint8_t S, class Math = DefaultMath>
+    static void angle_between(const VecSoaView<S>& left, const VecSoaView<S>& right, float* out, Math = Math()) {
+
+        // Fast: both halves vectorized
+        if constexpr (Math::approximate) {
+            _cos_between_clamped(left, right, out);
+            fast_math::acos(out, out, left.size);
+            return;
+        }
+
+        E3D_SIMD_DISPATCH(vec_soa::angle_between<S>(left.data, right.data, out, left.size));
+
+    }
+
+}
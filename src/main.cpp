@@ -83,27 +83,30 @@ int main() {
     std::cout << mat1 << std::endl;
     std::cout << "det (1): " << utils::mat::determinant(mat1) << std::endl << std::endl;
 
-    Mat<2, 2> mat2 ((float[]) {
+    const float mat2_values[] = {
         4, -3,
         3, -5
-    });
+    };
+    Mat<2, 2> mat2 (mat2_values);
     std::cout << mat2 << std::endl;
     std::cout << "det (-11): " << utils::mat::determinant(mat2) << std::endl << std::endl;
 
-    Mat<3, 3> mat3 ((float[]) {
+    const float mat3_values[] = {
         2, -3, 1,
         2, 0, -1,
         1, 4, 5
-    });
+    };
+    Mat<3, 3> mat3 (mat3_values);
     std::cout << mat3 << std::endl;
     std::cout << "det (49): " << utils::mat::determinant(mat3) << std::endl << std::endl;
 
-    Mat4 mat4 ((float[]) {
+    const float mat4_values[] = {
         3, 0, 2, -1,
         1, 2, 0, -2,
         4, 0, 6, -3,
         5, 0, 2, 0
-    });
+    };
+    Mat4 mat4 (mat4_values);
     std::cout << mat4 << std::endl;
     std::cout << "det (20): " << utils::mat::determinant(mat4) << std::endl;
 